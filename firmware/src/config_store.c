@@ -399,6 +399,7 @@ bool ConfigStore_Initialize(void)
     _ConfigStoreLock = CreatorSemaphore_New(1, 0);
     if (_ConfigStoreLock)
     {
+        CreatorSemaphore_SetName(_ConfigStoreLock, "ConfigStoreLock");
         CreatorSemaphore_Release(_ConfigStoreLock, 1);
         result = true;
     }
@@ -41,6 +41,9 @@
 #define HTTP_CONTENTTYPE_CREATOR_DEVICESERVER	"application/xml; application/vnd.imgtec.com.device-server+xml; charset=utf-8"
 #define HTTP_CONTENTTYPE_CREATOR_NETWORKCONFIG	"application/xml; application/vnd.imgtec.com.network-config+xml; charset=utf-8"
 
+// Stack buffer for XML responses - large enough for typical responses, which then need no heap allocation
+#define RESPONSE_BUFFER_SIZE			(384)
+
 #define DEFAULT_ACTIVITYLOG_PAGESIZE	(5)
 #define MAX_ACTIVITYLOG_PAGESIZE		(5)
 
@@ -92,7 +95,9 @@ static void GetDeviceInfo(CreatorHTTPServerRequest request)
         // Read device configuration
         if (ConfigStore_Config_Read() && ConfigStore_Config_IsValid())
         {
-            StringBuilder responseBody = StringBuilder_New(256);
+            char responseBuffer[RESPONSE_BUFFER_SIZE];
+            StringBuilderStorage responseStorage;
+            StringBuilder responseBody = StringBuilder_Init(&responseStorage, responseBuffer, sizeof(responseBuffer));
             if (responseBody)
             {
                 //
@@ -153,7 +158,9 @@ static void GetDeviceName(CreatorHTTPServerRequest request)
         // Read device configuration
         if (ConfigStore_Config_Read() && ConfigStore_Config_IsValid())
         {
-            StringBuilder responseBody = StringBuilder_New(256);
+            char responseBuffer[RESPONSE_BUFFER_SIZE];
+            StringBuilderStorage responseStorage;
+            StringBuilder responseBody = StringBuilder_Init(&responseStorage, responseBuffer, sizeof(responseBuffer));
             if (responseBody)
             {
                 //
@@ -188,7 +195,9 @@ static void GetDeviceServer(CreatorHTTPServerRequest request)
         // Read device server configuration
         if (ConfigStore_DeviceServerConfig_Read() && ConfigStore_DeviceServerConfig_IsValid())
         {
-            StringBuilder responseBody = StringBuilder_New(256);
+            char responseBuffer[RESPONSE_BUFFER_SIZE];
+            StringBuilderStorage responseStorage;
+            StringBuilder responseBody = StringBuilder_Init(&responseStorage, responseBuffer, sizeof(responseBuffer));
             if (responseBody)
             {
                 //
@@ -246,7 +255,9 @@ static void GetNetworkConfig(CreatorHTTPServerRequest request)
         // Read device configuration
         if (ConfigStore_Config_Read() && ConfigStore_Config_IsValid())
         {
-            StringBuilder responseBody = StringBuilder_New(256);
+            char responseBuffer[RESPONSE_BUFFER_SIZE];
+            StringBuilderStorage responseStorage;
+            StringBuilder responseBody = StringBuilder_Init(&responseStorage, responseBuffer, sizeof(responseBuffer));
             if (responseBody)
             {
                 //
@@ -29,7 +29,10 @@
 #include "string_builder.h"
 
 #include "creator/creator_console.h"
+#include "creator/core/common_messaging_main.h"
 #include "creator/core/creator_list.h"
+#include "creator/core/creator_memalloc.h"
+#include "creator/core/creator_threading.h"
 
 #include "tcpip/tcpip.h"
 #include "driver/wifi/mrf24w/drv_wifi.h"
@@ -48,6 +51,10 @@ typedef enum
     setshow_cmd_versions,
     setshow_cmd_wifire_details,
     setshow_cmd_saved_values,
+    setshow_cmd_lock_statistics,
+    setshow_cmd_memory,
+    setshow_cmd_memtrace,
+    setshow_cmd_receive_buffers,
 
     setshow_cmd__max
 } setShowCommand;
@@ -80,6 +87,10 @@ extern bool g_CommandTimeOut;
 static void StandardCommands_GetDeviceServerConfig(void);    
 static void StandardCommands_SetDeviceServerConfig(void);
 static void StandardCommands_SetNetworkConfig(void);    
+static void StandardCommands_ShowLockStatistics(void);
+static void StandardCommands_ShowMemory(void);
+static void StandardCommands_ShowMemTrace(void);
+static void StandardCommands_ShowReceiveBuffers(void);
 static void StandardCommands_ShowWiFireDetails(void);
 
 static setShowCommandInfo setShowCommands[setshow_cmd__max] =
@@ -89,7 +100,11 @@ static setShowCommandInfo setShowCommands[setshow_cmd__max] =
  {"network_config", StandardCommands_SetNetworkConfig, StandardCommands_GetNetworkConfig},
  {"server_config",  StandardCommands_SetDeviceServerConfig, StandardCommands_GetDeviceServerConfig},
  {"versions",       NULL,                              StandardCommands_GetVersions},
- {"wifire_details", NULL,                              StandardCommands_ShowWiFireDetails}
+ {"wifire_details", NULL,                              StandardCommands_ShowWiFireDetails},
+ {"lock_stats",     NULL,                              StandardCommands_ShowLockStatistics},
+ {"memory",         NULL,                              StandardCommands_ShowMemory},
+ {"memtrace",       NULL,                              StandardCommands_ShowMemTrace},
+ {"rx_buffers",     NULL,                              StandardCommands_ShowReceiveBuffers}
 };
 
 
@@ -1227,3 +1242,102 @@ static void StandardCommands_ShowWiFireDetails(void)
         CreatorConsole_Printf(LINE_TERM LINE_TERM);
     }
 }
+
+static void StandardCommands_PrintLockStatistics(const CreatorLockStatistics *statistics, void *context)
+{
+    CreatorConsole_Printf("%-20s %8u %8u %10u %8u %10u %8u" LINE_TERM, statistics->Name ? statistics->Name : "(unnamed)",
+            statistics->AcquireCount, statistics->ContendedCount, (uint) statistics->TotalWaitTime, statistics->MaxWaitTime,
+            (uint) statistics->TotalHoldTime, statistics->MaxHoldTime);
+}
+
+static void StandardCommands_ShowLockStatistics(void)
+{
+    CreatorConsole_Printf("%-20s %8s %8s %10s %8s %10s %8s" LINE_TERM, "Lock (times in us)", "Acquired", "Contend",
+            "WaitTotal", "WaitMax", "HoldTotal", "HoldMax");
+    if (CreatorLockProfiling_GetStatistics(StandardCommands_PrintLockStatistics, NULL) == 0)
+        CreatorConsole_Printf("No lock statistics, build with CREATOR_LOCK_PROFILING to enable" LINE_TERM);
+    CreatorConsole_Printf(LINE_TERM);
+}
+
+static void StandardCommands_ShowMemory(void)
+{
+    CreatorMemStatistics statistics;
+    CreatorMemStatistics total;
+    int tag;
+    memset(&total, 0, sizeof(total));
+    CreatorConsole_Printf("%-8s %10s %10s %8s %10s %8s" LINE_TERM, "Tag", "LiveBytes", "PeakBytes", "Live", "Total", "Failed");
+    for (tag = 0; tag < CreatorMemTag_Max; tag++)
+    {
+        if (!Creator_MemGetStatistics((CreatorMemTag) tag, &statistics))
+        {
+            CreatorConsole_Printf("No memory statistics, build with CREATOR_MEMALLOC_ACCOUNTING to enable" LINE_TERM LINE_TERM);
+            return;
+        }
+        CreatorConsole_Printf("%-8s %10u %10u %8u %10u %8u" LINE_TERM, Creator_MemGetTagName((CreatorMemTag) tag),
+                (uint) statistics.LiveBytes, (uint) statistics.PeakBytes, statistics.LiveAllocations,
+                statistics.TotalAllocations, statistics.FailedAllocations);
+        total.LiveBytes += statistics.LiveBytes;
+        total.LiveAllocations += statistics.LiveAllocations;
+        total.TotalAllocations += statistics.TotalAllocations;
+        total.FailedAllocations += statistics.FailedAllocations;
+        int bucket;
+        for (bucket = 0; bucket < CREATOR_MEM_SIZE_BUCKETS; bucket++)
+            total.SizeHistogram[bucket] += statistics.SizeHistogram[bucket];
+    }
+    // Peaks of different tags happen at different times, so there is no total peak
+    CreatorConsole_Printf("%-8s %10u %10s %8u %10u %8u" LINE_TERM LINE_TERM, "total", (uint) total.LiveBytes, "-",
+            total.LiveAllocations, total.TotalAllocations, total.FailedAllocations);
+
+    CreatorConsole_Printf("Allocation sizes:" LINE_TERM);
+    int bucket;
+    uint bucketSize = 16;
+    for (bucket = 0; bucket < CREATOR_MEM_SIZE_BUCKETS; bucket++)
+    {
+        if (bucket < (CREATOR_MEM_SIZE_BUCKETS - 1))
+            CreatorConsole_Printf("  <= %-6u %10u" LINE_TERM, bucketSize, total.SizeHistogram[bucket]);
+        else
+            CreatorConsole_Printf("  >  %-6u %10u" LINE_TERM, bucketSize >> 1, total.SizeHistogram[bucket]);
+        bucketSize <<= 1;
+    }
+    CreatorConsole_Printf(LINE_TERM);
+}
+
+static void StandardCommands_PrintMemTrace(const CreatorMemTraceRecord *records, unsigned int count, void *context)
+{
+    // One record per line as hex, memtrace_replay -x reads the captured console output
+    char line[(sizeof(CreatorMemTraceRecord) * 2) + 1];
+    unsigned int index;
+    for (index = 0; index < count; index++)
+    {
+        const uint8 *bytes = (const uint8 *) &records[index];
+        uint byteIndex;
+        for (byteIndex = 0; byteIndex < sizeof(CreatorMemTraceRecord); byteIndex++)
+        {
+            line[byteIndex * 2] = "0123456789abcdef"[bytes[byteIndex] >> 4];
+            line[(byteIndex * 2) + 1] = "0123456789abcdef"[bytes[byteIndex] & 0x0F];
+        }
+        line[sizeof(line) - 1] = '\0';
+        CreatorConsole_Printf("MT %s" LINE_TERM, line);
+    }
+}
+
+static void StandardCommands_ShowMemTrace(void)
+{
+    if (Creator_MemTraceDrain(StandardCommands_PrintMemTrace, NULL) == 0)
+        CreatorConsole_Printf("No heap trace records (tracing needs a CREATOR_MEMALLOC_TRACE build)" LINE_TERM);
+    CreatorConsole_Printf(LINE_TERM);
+}
+
+static void StandardCommands_ShowReceiveBuffers(void)
+{
+    CreatorCommonMessaging_ReceiveBufferStatistics statistics;
+    CreatorCommonMessaging_GetReceiveBufferStatistics(&statistics);
+    CreatorConsole_Printf("%-16s %8u" LINE_TERM, "In use", statistics.InUse);
+    CreatorConsole_Printf("%-16s %8u" LINE_TERM, "Peak in use", statistics.PeakInUse);
+    CreatorConsole_Printf("%-16s %8u" LINE_TERM, "Idle", statistics.Idle);
+    if (statistics.Capacity)
+        CreatorConsole_Printf("%-16s %8u" LINE_TERM, "Static pool", statistics.Capacity);
+    CreatorConsole_Printf("%-16s %8u" LINE_TERM, "Borrowed", statistics.Borrowed);
+    CreatorConsole_Printf("%-16s %8u" LINE_TERM, "Heap allocated", statistics.HeapAllocations);
+    CreatorConsole_Printf("%-16s %8u" LINE_TERM LINE_TERM, "Failed", statistics.Failed);
+}
@@ -20,26 +20,29 @@
  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***********************************************************************************************************************/
 
+
 /*! \file string_builder.c
  *  \brief APIs for manipulating dynamically growing C-strings
  */
 
 #include "stdio.h"
 #include "string.h"
+#include "stdarg.h"
+#include "stdint.h"
 #include "creator/core/creator_memalloc.h"
 #include "string_builder.h"
 
 #define     INITIAL_SIZE				(32)
 #define     GROWTH_FACTOR				(2)
 
+#define     FLAG_OWNS_BUILDER			(0x01)		// Builder (and its initial buffer) was allocated by StringBuilder_New
+#define     FLAG_OWNS_BUFFER			(0x02)		// Str was allocated separately, after the initial buffer was outgrown
+
+#define     MAX_DECIMAL_PLACES			(9)
+
 
 // Dynamic string implementation datatype
-typedef struct
-{
-    char* Str;					// Pointer to allocated buffer
-    unsigned int StrSize;		// dynamically allocated buffer size
-    unsigned int Length;		// Portion of the buffer that is utilised
-} StringBuilderImpl;
+typedef StringBuilderStorage StringBuilderImpl;
 
 
 //
@@ -48,6 +51,10 @@ typedef struct
 typedef StringBuilderImpl* DynamicString;
 
 
+static bool Grow(DynamicString string, unsigned int requiredSize);
+static void AppendData(DynamicString string, const char *data, unsigned int length);
+
+
 //
 // Public interfaces
 //
@@ -79,41 +86,97 @@ StringBuilder StringBuilder_Append(StringBuilder dynString, const char* str)
     DynamicString string = (DynamicString) dynString;
     if (string && str)
     {
-        unsigned int addedLength = strlen((char*) str);
-
-        if (addedLength == 0)
-            return dynString;
+        AppendData(string, str, strlen(str));
+    }
+    return (StringBuilder) string;
+}
 
-        if ((string->Length + addedLength + 1) <= string->StrSize)
+StringBuilder StringBuilder_AppendFormat(StringBuilder dynString, const char* format, ...)
+{
+    DynamicString string = (DynamicString) dynString;
+    if (string && format)
+    {
+        va_list args;
+        va_start(args, format);
+        unsigned int available = string->StrSize - string->Length;
+        int addedLength = vsnprintf(string->Str + string->Length, available, format, args);
+        va_end(args);
+        if (addedLength > 0)
         {
-            memcpy(string->Str + string->Length, str, sizeof(char) * addedLength + 1);	// include the null character from 'str'
-            string->Length += addedLength;
+            if ((unsigned int) addedLength >= available)
+            {
+                // Didn't fit - grow once to the exact size and format again
+                if (Grow(string, string->Length + addedLength + 1))
+                {
+                    va_start(args, format);
+                    vsnprintf(string->Str + string->Length, addedLength + 1, format, args);
+                    va_end(args);
+                    string->Length += addedLength;
+                }
+                else
+                {
+                    string->Str[string->Length] = '\0';		// discard the truncated output
+                }
+            }
+            else
+            {
+                string->Length += addedLength;
+            }
         }
         else
         {
-            // Scale the buffer
-            unsigned iterations = 1;
+            string->Str[string->Length] = '\0';
+        }
+    }
+    return (StringBuilder) string;
+}
 
-            while ((string->StrSize * GROWTH_FACTOR * iterations) <= (string->Length + addedLength + 1))
-                iterations++;
+StringBuilder StringBuilder_AppendFloat(StringBuilder dynString, double value, unsigned int decimalPlaces)
+{
+    DynamicString string = (DynamicString) dynString;
+    if (string)
+    {
+        if (decimalPlaces > MAX_DECIMAL_PLACES)
+            decimalPlaces = MAX_DECIMAL_PLACES;
 
-            // Grow the string
-            unsigned int newStrSize = (GROWTH_FACTOR * iterations) * string->StrSize;
-            char *newBuf = (char*) Creator_MemAlloc(sizeof(char) * newStrSize);
-            if (newBuf)
-            {
-                memcpy(newBuf, string->Str, string->StrSize);
-                memset(newBuf + string->StrSize, 0, newStrSize - string->StrSize);
-                memcpy(newBuf + string->Length, str, addedLength + 1);
+        // Values that don't fit the fixed-point path (NaN, infinity, very large) fall back to printf formatting
+        if (!(value > -4294967296.0 && value < 4294967296.0))
+            return StringBuilder_AppendFormat(dynString, "%.*f", decimalPlaces, value);
 
-                string->StrSize = newStrSize;
-                string->Length += addedLength;
-                Creator_MemFree((void **) &string->Str);
-                string->Str = newBuf;
-            }
+        // sign + 10 integer digits + '.' + 9 decimal places
+        char str[21];
+        char *position = str + sizeof(str);
+        uint32_t scale = 1;
+        unsigned int index;
+        for (index = 0; index < decimalPlaces; index++)
+            scale *= 10;
+
+        bool negative = value < 0;
+        if (negative)
+            value = -value;
+
+        // Round once at the requested precision, then split into integer and fractional parts
+        uint64_t scaled = (uint64_t) (value * scale + 0.5);
+        uint64_t integerPart = scaled / scale;
+        uint32_t fractionPart = (uint32_t) (scaled % scale);
+
+        for (index = 0; index < decimalPlaces; index++)
+        {
+            *--position = (char) ('0' + (fractionPart % 10));
+            fractionPart /= 10;
         }
-    }
+        if (decimalPlaces > 0)
+            *--position = '.';
+        do
+        {
+            *--position = (char) ('0' + (integerPart % 10));
+            integerPart /= 10;
+        } while (integerPart);
+        if (negative && scaled)
+            *--position = '-';
 
+        AppendData(string, position, (str + sizeof(str)) - position);
+    }
     return (StringBuilder) string;
 }
 
@@ -122,11 +185,18 @@ StringBuilder StringBuilder_AppendInt(StringBuilder dynString, int value)
     DynamicString string = (DynamicString) dynString;
     if (string)
     {
-        // 32-bits gives a 10-digit number + 1 for the null-terminator
+        // 32-bits gives a sign + 10-digit number, written backwards from the end of the buffer
         char str[11];
-        memset(str, 0, sizeof(str));
-        sprintf((char*) str, (const char*) "%d", value);
-        string = StringBuilder_Append(string, str);
+        char *position = str + sizeof(str);
+        unsigned int magnitude = (value < 0) ? (0u - (unsigned int) value) : (unsigned int) value;
+        do
+        {
+            *--position = (char) ('0' + (magnitude % 10));
+            magnitude /= 10;
+        } while (magnitude);
+        if (value < 0)
+            *--position = '-';
+        AppendData(string, position, (str + sizeof(str)) - position);
     }
     return (StringBuilder) string;
 }
@@ -139,47 +209,119 @@ StringBuilder StringBuilder_Clear(StringBuilder dynString)
     {
         if (string->Str)
         {
-            memset(string->Str, 0, sizeof(char) * string->StrSize);
+            string->Str[0] = '\0';
             string->Length = 0;
         }
     }
     return string;
 }
 
+StringBuilder StringBuilder_Init(StringBuilderStorage *storage, char *buffer, unsigned int bufferSize)
+{
+    StringBuilder result = 0;
+    if (storage && buffer && bufferSize > 0)
+    {
+        storage->Str = buffer;
+        storage->Str[0] = '\0';
+        storage->StrSize = bufferSize;
+        storage->Length = 0;
+        storage->Flags = 0;
+        result = (StringBuilder) storage;
+    }
+    return result;
+}
+
 StringBuilder StringBuilder_New(unsigned int initialSize)
 {
     StringBuilder result = 0;
     unsigned int initSize = initialSize ? initialSize : INITIAL_SIZE;
 
-    DynamicString newString = Creator_MemAlloc(sizeof(StringBuilderImpl));
+    // Initial buffer is stored inline, straight after the builder
+    DynamicString newString = Creator_MemAlloc(sizeof(StringBuilderImpl) + sizeof(char) * initSize);
     if (newString)
     {
-        newString->Str = Creator_MemAlloc(sizeof(char) * initSize);
-        if (newString->Str)
-        {
-            memset(newString->Str, 0, sizeof(char) * initSize);
-            newString->Length = 0;
-            newString->StrSize = sizeof(char) * initSize;
-            result = (StringBuilder) newString;
-        }
-        else
-        {
-            Creator_MemFree((void **) &newString);
-        }
+        StringBuilder_Init(newString, (char *) (newString + 1), initSize);
+        newString->Flags = FLAG_OWNS_BUILDER;
+        result = (StringBuilder) newString;
     }
 
     return result;
 }
 
+bool StringBuilder_Reserve(StringBuilder dynString, unsigned int length)
+{
+    bool result = false;
+    DynamicString string = (DynamicString) dynString;
+    if (string)
+    {
+        result = (length + 1 <= string->StrSize) || Grow(string, length + 1);
+    }
+    return result;
+}
+
 void StringBuilder_Free(StringBuilder *dynString)
 {
     DynamicString string = (DynamicString) *dynString;
-    if (string && string->Str)
+    if (string)
     {
-        Creator_MemFree((void **) &string->Str);
+        if (string->Flags & FLAG_OWNS_BUFFER)
+        {
+            Creator_MemFree((void **) &string->Str);
+        }
+        string->Str = NULL;
         string->Length = 0;
         string->StrSize = 0;
 
-        Creator_MemFree((void **) dynString);
+        if (string->Flags & FLAG_OWNS_BUILDER)
+            Creator_MemFree((void **) dynString);
+        else
+            *dynString = NULL;
+    }
+}
+
+
+//
+// Private functions
+//
+
+
+static void AppendData(DynamicString string, const char *data, unsigned int length)
+{
+    if (length == 0)
+        return;
+
+    if ((string->Length + length + 1) <= string->StrSize || Grow(string, string->Length + length + 1))
+    {
+        memcpy(string->Str + string->Length, data, sizeof(char) * length);
+        string->Length += length;
+        string->Str[string->Length] = '\0';
+    }
+}
+
+static bool Grow(DynamicString string, unsigned int requiredSize)
+{
+    // Scale the buffer
+    unsigned int newStrSize = string->StrSize ? string->StrSize : INITIAL_SIZE;
+    while (newStrSize < requiredSize)
+        newStrSize *= GROWTH_FACTOR;
+
+    char *newBuf;
+    if (string->Flags & FLAG_OWNS_BUFFER)
+    {
+        newBuf = (char*) Creator_MemRealloc(string->Str, sizeof(char) * newStrSize);
+    }
+    else
+    {
+        // Still using the initial (inline or caller-provided) buffer - move to the heap
+        newBuf = (char*) Creator_MemAlloc(sizeof(char) * newStrSize);
+        if (newBuf)
+            memcpy(newBuf, string->Str, string->Length + 1);
+    }
+    if (newBuf)
+    {
+        string->Str = newBuf;
+        string->StrSize = newStrSize;
+        string->Flags |= FLAG_OWNS_BUFFER;
     }
+    return newBuf != NULL;
 }
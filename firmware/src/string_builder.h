@@ -36,17 +36,37 @@
 #ifndef __DYNSTRING_H_
 #define __DYNSTRING_H_
 
+#include <stdbool.h>
+
 /*
  * A dynamically growing string type.
  *
+ * Builders created with StringBuilder_New keep their initial buffer in the same allocation as the builder itself.
+ * Builders created with StringBuilder_Init live in caller-provided storage (typically on the stack) and only touch the
+ * heap if the content outgrows the caller's buffer. Either kind must be released with StringBuilder_Free.
  */
 
 typedef void* StringBuilder;
 
+// Storage for a builder created with StringBuilder_Init - treat as opaque
+typedef struct
+{
+    char* Str;					// Current buffer (initial buffer or heap allocated after growth)
+    unsigned int StrSize;		// Buffer size
+    unsigned int Length;		// Portion of the buffer that is utilised
+    unsigned char Flags;
+} StringBuilderStorage;
+
 
 // Add characters to a dynamic string
 StringBuilder StringBuilder_Append(StringBuilder dynString, const char* str);
 
+// Add printf-style formatted text to a dynamic string (formatted directly into the string's buffer)
+StringBuilder StringBuilder_AppendFormat(StringBuilder dynString, const char* format, ...);
+
+// Add a floating point value with a fixed number of decimal places (at most 9) to a dynamic string
+StringBuilder StringBuilder_AppendFloat(StringBuilder dynString, double value, unsigned int decimalPlaces);
+
 // Add an signed integer to a dynamic string
 StringBuilder StringBuilder_AppendInt(StringBuilder dynString, int value);
 
@@ -65,9 +85,18 @@ const char* StringBuilder_GetCString(StringBuilder dynString);
 // Returns: string length, or -1 if invalid
 int StringBuilder_GetLength(StringBuilder dynString);
 
+// Create a dynamic string in caller-provided storage, initially using 'buffer' (of 'bufferSize' bytes) for its content
+StringBuilder StringBuilder_Init(StringBuilderStorage *storage, char *buffer, unsigned int bufferSize);
+
 // Create a new dynamic string with the specified initial size
 // Set 'initialSize' to 0 to use default
 StringBuilder StringBuilder_New(unsigned int initialSize);
 
+//
+// Make sure the dynamic string can hold 'length' characters (plus null-terminator) without growing again
+//
+// Returns: false if the buffer could not be grown
+bool StringBuilder_Reserve(StringBuilder dynString, unsigned int length);
+
 
 #endif // __DYNSTRING_H_
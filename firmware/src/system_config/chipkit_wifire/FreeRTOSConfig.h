@@ -104,6 +104,7 @@
 #define configUSE_NEWLIB_REENTRANT              0
 #define configENABLE_BACKWARD_COMPATIBILITY     0
 #define configUSE_TASK_FPU_SUPPORT              0
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS 1
 
 /* Hook function related definitions. */
 #define configUSE_IDLE_HOOK                     0
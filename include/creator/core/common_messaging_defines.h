@@ -34,7 +34,10 @@ extern "C" {
 #define CREATOR_TCP         1
 #define CREATOR_TLS         2
 #define CREATOR_UDP         3
-#define CREATOR_MAX_CONNECTIONS  3
+// Connection control blocks - the HTTP client pool (MAX_HTTP_CONNECTIONS) needs one per pooled connection
+#ifndef CREATOR_MAX_CONNECTIONS
+#define CREATOR_MAX_CONNECTIONS  4
+#endif
 #define CREATOR_MAX_PACKET_LEN   1500
 #define CMP_TASK_STACK_SIZE  0	// Beware - SIP callbacks can send SSL messages!
 #define CMP_TASK_PRIORITY  2
@@ -31,8 +31,28 @@ extern "C" {
 #include "common_messaging_defines.h"
 #include "creator/core/base_types.h"
 
+struct DataBufferImpl;
+
+/*
+ * Occupancy of the receive buffers that connections borrow while parsing incoming data
+ */
+typedef struct
+{
+    uint InUse;                 // buffers currently lent to connections
+    uint PeakInUse;
+    uint Idle;                  // buffers kept ready for the next loan
+    uint Capacity;              // size of the static pool, 0 if buffers come from the heap
+    uint Borrowed;              // loans since start-up
+    uint HeapAllocations;       // loans that had to allocate from the heap
+    uint Failed;                // loans refused for lack of memory (data left in the socket until the next poll)
+} CreatorCommonMessaging_ReceiveBufferStatistics;
+
 uint32 CreatorCommonMessaging_GetHostByName(const char *hostName);
 bool CreatorCommonMessaging_SendRequest(void *connectionInformation, char *sendBuffer, uint16 sendBufferLength, ushort responseTimeout);
+// Send the contents of a (chunked) DataBuffer segment by segment, without copying it into a contiguous buffer
+bool CreatorCommonMessaging_SendDataBuffer(void *connectionInformation, struct DataBufferImpl *sendBuffer, ushort responseTimeout);
+// (Re)start the response timeout, e.g. when another response is still expected after one has finished (pipelined requests)
+void CreatorCommonMessaging_ExpectResponse(void *connectionInformation, ushort responseTimeout);
 
 void *CreatorCommonMessaging_CreateConnection(CreatorCommonMessaging_ConnectionInformation *connectionInformation, CreatorCommonMessaging_ProtocolCallBack protocolCallBack, void *callbackContext);
 void CreatorCommonMessaging_DeleteConnection(void *connectionInformation);
@@ -42,6 +62,7 @@ void CreatorCommonMessaging_ChangeConnectionCallBack(void * connectionInformatio
 void CreatorCommonMessaging_Initialise(void);
 void CreatorCommonMessaging_Shutdown(void);
 
+void CreatorCommonMessaging_GetReceiveBufferStatistics(CreatorCommonMessaging_ReceiveBufferStatistics *statistics);
 void CreatorCommonMessaging_IPAddressToString(uint address, char *dest);
 void CreatorCommonMessaging_LockTCP(void);
 void CreatorCommonMessaging_UnLockTCP(void);
@@ -0,0 +1,94 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+
+/*! \file creator_arena.h
+ */
+
+
+#ifndef CREATOR_ARENA_H_
+#define CREATOR_ARENA_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stddef.h>
+#include "creator/core/creator_memalloc.h"
+
+/**
+ * \class CreatorArena
+ * Request-scoped bump allocator.
+ *
+ * Allocations are carved sequentially out of fixed-size chunks and are never freed individually: everything is released
+ * at once by CreatorArena_Reset or CreatorArena_Free. The first chunk is part of the arena's own allocation, so a request
+ * whose temporaries fit in it costs a single heap allocation.
+ */
+typedef struct CreatorArenaImpl *CreatorArena;
+
+/**
+ * \memberof CreatorArena
+ * Allocate memory from the arena. The result is 8-byte aligned and stays valid until the arena is reset or freed.
+ *
+ * @param self arena to allocate from
+ * @param size number of bytes to allocate
+ * @return pointer to the memory, or NULL if a new chunk could not be allocated
+ */
+void *CreatorArena_Alloc(CreatorArena self, size_t size);
+
+/**
+ * \memberof CreatorArena
+ * Copy a null-terminated string into the arena.
+ *
+ * @param self arena to allocate from
+ * @param text string to copy
+ * @return copy of text, or NULL if text is NULL or the arena is out of memory
+ */
+char *CreatorArena_DuplicateString(CreatorArena self, const char *text);
+
+/**
+ * \memberof CreatorArena
+ * Release all chunks and the arena itself. Sets *self to NULL.
+ */
+void CreatorArena_Free(CreatorArena *self);
+
+/**
+ * \memberof CreatorArena
+ * Create a new arena.
+ *
+ * @param chunkSize size of each chunk; requests larger than this get a chunk of their own
+ * @param tag heap accounting tag charged for the arena's chunks
+ */
+CreatorArena CreatorArena_New(size_t chunkSize, CreatorMemTag tag);
+
+/**
+ * \memberof CreatorArena
+ * Discard all allocations, keeping only the first chunk for reuse.
+ */
+void CreatorArena_Reset(CreatorArena self);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CREATOR_ARENA_H_ */
@@ -0,0 +1,125 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+/** @file */
+
+#ifndef CREATOR_HASHMAP_H_
+#define CREATOR_HASHMAP_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "creator/core/base_types.h"
+
+/**
+ * \class CreatorHashMap
+ * Open-addressing hash map from string or pointer keys to values.
+ *
+ * Keys are not copied: a string key must stay valid for as long as it is in the map (typically it points into the
+ * value). The map is not thread-safe.
+ */
+typedef struct CreatorHashMapImpl *CreatorHashMap;
+
+typedef enum
+{
+    CreatorHashMapKeyType_Pointer,              ///< keys are compared by address
+    CreatorHashMapKeyType_String,               ///< keys are null-terminated strings, compared with strcmp
+    CreatorHashMapKeyType_StringIgnoreCase      ///< keys are null-terminated strings, compared with strcasecmp
+} CreatorHashMapKeyType;
+
+/**
+ * \memberof CreatorHashMap
+ * Check if the map has an entry for key.
+ *
+ * @param self map to check
+ * @param key key to find
+ */
+bool CreatorHashMap_Contains(CreatorHashMap self, const void *key);
+
+void CreatorHashMap_Free(CreatorHashMap *self);
+
+/**
+ * \memberof CreatorHashMap
+ * Get the value stored for key.
+ *
+ * @param self map to check
+ * @param key key to find
+ * @return value, or NULL if there is no entry for key
+ */
+void *CreatorHashMap_Get(CreatorHashMap self, const void *key);
+
+/**
+ * \memberof CreatorHashMap
+ * Get number of entries in map.
+ *
+ * @param self map to check
+ */
+uint CreatorHashMap_GetCount(CreatorHashMap self);
+
+/**
+ * \memberof CreatorHashMap
+ * Iterate over the entries of the map. Set *position to 0 before the first call. The map must not be modified
+ * while it is being iterated.
+ *
+ * @param self map to iterate
+ * @param position iteration state
+ * @param key (optional) receives the key of the next entry
+ * @param value (optional) receives the value of the next entry
+ * @return false when there are no more entries
+ */
+bool CreatorHashMap_GetNext(CreatorHashMap self, uint *position, const void **key, void **value);
+
+/**
+ * \memberof CreatorHashMap
+ * Create new instance of a hash map.
+ *
+ * @param keyType how keys are hashed and compared
+ * @param initialCapacity number of entries that can be added before map will need to grow
+ */
+CreatorHashMap CreatorHashMap_New(CreatorHashMapKeyType keyType, uint initialCapacity);
+
+/**
+ * \memberof CreatorHashMap
+ * Add or replace the entry for key.
+ *
+ * @param self map to add to
+ * @param key key of entry (not copied)
+ * @param value value to store
+ * @return false if the map could not grow
+ */
+bool CreatorHashMap_Put(CreatorHashMap self, const void *key, void *value);
+
+/**
+ * \memberof CreatorHashMap
+ * Remove the entry for key.
+ *
+ * @param self map to remove entry from
+ * @param key key of entry
+ * @return value of the removed entry, or NULL if there was none
+ */
+void *CreatorHashMap_Remove(CreatorHashMap self, const void *key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CREATOR_HASHMAP_H_ */
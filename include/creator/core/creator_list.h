@@ -100,6 +100,24 @@ bool CreatorList_Remove(CreatorList self, void *item);
  */
 void *CreatorList_RemoveAt(CreatorList self, uint index);
 
+/**
+ * \memberof CreatorList
+ * Remove selected item from list in constant time by moving the last item into its place (does not preserve order).
+ *
+ * @param self list to remove item from
+ * @param index index of item in list
+ */
+void *CreatorList_RemoveAtUnordered(CreatorList self, uint index);
+
+/**
+ * \memberof CreatorList
+ * Remove item from list by moving the last item into its place (does not preserve order).
+ *
+ * @param self list to remove item from
+ * @param item item to remove from list
+ */
+bool CreatorList_RemoveUnordered(CreatorList self, void *item);
+
 #ifdef __cplusplus
 }
 #endif
@@ -29,6 +29,74 @@ extern "C" {
 #endif
 
 #include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Subsystem an allocation is accounted to, see \ref Creator_MemAllocWithTag
+ */
+typedef enum
+{
+    CreatorMemTag_Other = 0,
+    CreatorMemTag_HTTP,
+    CreatorMemTag_XML,
+    CreatorMemTag_TLS,
+    CreatorMemTag_LWM2M,
+    CreatorMemTag_Log,
+    CreatorMemTag_Max
+} CreatorMemTag;
+
+/**
+ * Allocation sizes are counted in power of two buckets: up to 16, 32, 64, 128, 256, 512 and 1024 bytes, then larger
+ */
+#define CREATOR_MEM_SIZE_BUCKETS    (8)
+
+/**
+ * Heap usage of one \ref CreatorMemTag, recorded by a CREATOR_MEMALLOC_ACCOUNTING build
+ */
+typedef struct
+{
+    size_t LiveBytes;
+    size_t PeakBytes;
+    unsigned int LiveAllocations;
+    unsigned int TotalAllocations;
+    unsigned int FailedAllocations;
+    unsigned int SizeHistogram[CREATOR_MEM_SIZE_BUCKETS];
+} CreatorMemStatistics;
+
+/**
+ * Kind of heap event in a \ref CreatorMemTraceRecord
+ */
+typedef enum
+{
+    CreatorMemTraceEvent_Start = 0,     ///< first record of a trace, Size is the trace format version
+    CreatorMemTraceEvent_Alloc,         ///< Address is 0 if the allocation failed
+    CreatorMemTraceEvent_Free,
+    CreatorMemTraceEvent_Realloc,       ///< Address resized to NewAddress (0 if the resize failed)
+    CreatorMemTraceEvent_Dropped        ///< trace buffer was full, Size records were lost before this one
+} CreatorMemTraceEvent;
+
+#define CREATOR_MEM_TRACE_VERSION   (1)
+
+/**
+ * Heap event recorded by a CREATOR_MEMALLOC_TRACE build. A trace is a plain sequence of these 20 byte records in the
+ * target's byte order (little-endian on all supported targets), see lib/libcreatorcore/tools/memtrace_replay.
+ */
+typedef struct
+{
+    uint32_t Timestamp;     ///< milliseconds since start-up
+    uint32_t Address;       ///< block address (low 32 bits)
+    uint32_t NewAddress;    ///< Realloc only
+    uint32_t Size;          ///< requested size in bytes
+    uint8_t Event;          ///< \ref CreatorMemTraceEvent
+    uint8_t Tag;            ///< \ref CreatorMemTag (Alloc only)
+    uint16_t Reserved;
+} CreatorMemTraceRecord;
+
+/**
+ * Receives records drained from the trace buffer, see \ref Creator_MemTraceDrain
+ */
+typedef void (*CreatorMemTrace_Writer)(const CreatorMemTraceRecord *records, unsigned int count, void *context);
 
 /**
  * \brief Returns a newly allocated buffer of \a size bytes.
@@ -38,6 +106,17 @@ extern "C" {
  */
 void *Creator_MemAlloc(size_t size);
 
+/**
+ * \brief Returns a newly allocated buffer of \a size bytes, accounted to \a tag.
+ *
+ * Reallocating the buffer keeps its tag. Without CREATOR_MEMALLOC_ACCOUNTING this is \ref Creator_MemAlloc.
+ *
+ * @param size number of bytes that the buffer should return
+ * @param tag subsystem the buffer is accounted to
+ * @return NULL if that buffer couldn't be allocated
+ */
+void *Creator_MemAllocWithTag(size_t size, CreatorMemTag tag);
+
 /**
  * \brief Returns a newly allocated and cleared buffer of \a blockCount * \a blockSize bytes.
  *
@@ -67,6 +146,34 @@ void *Creator_MemRealloc(void *buffer, size_t size);
  */
 void Creator_MemFree(void **buffer);
 
+/**
+ * Get the heap usage accounted to a tag.
+ *
+ * @param tag subsystem to report
+ * @param statistics filled in with the usage of \a tag
+ * @return false if not built with CREATOR_MEMALLOC_ACCOUNTING (\a statistics is cleared)
+ */
+bool Creator_MemGetStatistics(CreatorMemTag tag, CreatorMemStatistics *statistics);
+
+/**
+ * @param tag subsystem tag
+ * @return printable name of \a tag
+ */
+const char *Creator_MemGetTagName(CreatorMemTag tag);
+
+/**
+ * \brief Hands the buffered heap trace to \a writer and empties the buffer.
+ *
+ * Records are buffered in a fixed-size ring (CREATOR_MEMALLOC_TRACE_RECORDS) that must be drained before it fills up,
+ * otherwise a \ref CreatorMemTraceEvent_Dropped record marks the gap. \a writer is called without any lock held and may
+ * allocate; records it causes are left for the next drain.
+ *
+ * @param writer called with successive batches of records
+ * @param context passed to \a writer
+ * @return number of records written, 0 if not built with CREATOR_MEMALLOC_TRACE
+ */
+unsigned int Creator_MemTraceDrain(CreatorMemTrace_Writer writer, void *context);
+
 /**
  * Free a previously allocated buffer
  *
@@ -90,6 +90,17 @@ CreatorQueue CreatorQueue_New(unsigned initialCapacity);
  */
 CreatorQueue CreatorQueue_NewBlocking(unsigned initialCapacity);
 
+/**
+ * \memberof CreatorQueue
+ * Create new instance of a bounded, lock-free, multi-producer/multi-consumer blocking queue.
+ *
+ * The queue does not grow: enqueuing fails when it is full. Dequeuing only blocks (on a semaphore)
+ * when the queue is empty.
+ *
+ * @param capacity maximum number of items in the queue (rounded up to a power of two)
+ */
+CreatorQueue CreatorQueue_NewLockFree(unsigned capacity);
+
 
 #ifdef __cplusplus
 }
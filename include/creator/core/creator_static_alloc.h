@@ -0,0 +1,136 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+
+/*! \file creator_static_alloc.h
+ *  \brief Configuration of the CREATOR_STATIC_ALLOC build and the fixed-block pools it uses.
+ *
+ * With CREATOR_STATIC_ALLOC defined, the long-lived buffers of the core I/O paths (connection receive buffers, HTTP
+ * request messages and the scheduler task table) come from statically sized storage, so their worst-case RAM use is
+ * fixed at link time and start-up does no heap allocation for them. Each size below can be overridden from the compiler
+ * command line. Thread stacks stay on the FreeRTOS heap: static task creation needs a FreeRTOS V9+ kernel.
+ */
+
+#ifndef CREATOR_STATIC_ALLOC_H_
+#define CREATOR_STATIC_ALLOC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "creator/core/common_messaging_defines.h"
+
+// Shared receive buffers, borrowed by a connection only while it parses incoming data (or holds a partial header)
+#ifndef CREATOR_STATIC_RECEIVE_BUFFERS
+#define CREATOR_STATIC_RECEIVE_BUFFERS      (4)
+#endif
+
+// Slots in the task scheduler's table, which cannot grow in a static build
+#ifndef CREATOR_STATIC_SCHEDULER_TASKS
+#define CREATOR_STATIC_SCHEDULER_TASKS      (32)
+#endif
+
+// DataBuffers (one per in-flight HTTP request) and their chunks; 16 chunks hold two 2KB requests
+#ifndef CREATOR_STATIC_DATABUFFERS
+#define CREATOR_STATIC_DATABUFFERS          (4)
+#endif
+#ifndef CREATOR_STATIC_DATABUFFER_CHUNKS
+#define CREATOR_STATIC_DATABUFFER_CHUNKS    (16)
+#endif
+
+
+/**
+ * \class CreatorStaticPool
+ * Fixed number of equally sized blocks in static storage.
+ *
+ * Unlike other classes the structure is visible, so that a pool can be defined statically with CREATOR_STATIC_POOL; its
+ * fields must only be accessed through the functions below. Blocks are 8-byte aligned.
+ */
+typedef struct
+{
+    uint8_t *Blocks;
+    uint8_t *InUse;
+    size_t BlockSize;
+    unsigned int BlockCount;
+    unsigned int UsedCount;
+    unsigned int PeakCount;
+    unsigned int FailedCount;
+} CreatorStaticPool;
+
+/**
+ * Pool occupancy, see \ref CreatorStaticPool_GetStatistics
+ */
+typedef struct
+{
+    unsigned int BlockCount;
+    unsigned int UsedCount;
+    unsigned int PeakCount;
+    unsigned int FailedCount;       ///< allocations made while the pool was full
+} CreatorStaticPoolStatistics;
+
+#define CREATOR_STATIC_POOL_BLOCK_SIZE(blockSize)   ((((size_t)(blockSize)) + 7) & ~(size_t)7)
+
+/**
+ * Define a static pool named \a name of \a blockCount blocks of \a blockSize bytes.
+ */
+#define CREATOR_STATIC_POOL(name, blockSize, blockCount) \
+    static uint64_t name##Storage[((blockCount) * CREATOR_STATIC_POOL_BLOCK_SIZE(blockSize)) / sizeof(uint64_t)]; \
+    static uint8_t name##InUse[(blockCount)]; \
+    static CreatorStaticPool name = { (uint8_t *)name##Storage, name##InUse, CREATOR_STATIC_POOL_BLOCK_SIZE(blockSize), (blockCount), 0, 0, 0 }
+
+/**
+ * \memberof CreatorStaticPool
+ * Take a block from the pool.
+ *
+ * @return block, or NULL if all blocks are in use (counted as a failed allocation)
+ */
+void *CreatorStaticPool_Alloc(CreatorStaticPool *self);
+
+/**
+ * \memberof CreatorStaticPool
+ * Check whether \a block belongs to the pool, so callers that fall back to the heap know how to release it.
+ */
+bool CreatorStaticPool_Contains(const CreatorStaticPool *self, const void *block);
+
+/**
+ * \memberof CreatorStaticPool
+ * Return a block to the pool.
+ *
+ * @return false if \a block does not belong to the pool
+ */
+bool CreatorStaticPool_Free(CreatorStaticPool *self, void *block);
+
+/**
+ * \memberof CreatorStaticPool
+ * Get a snapshot of the pool's occupancy.
+ */
+void CreatorStaticPool_GetStatistics(const CreatorStaticPool *self, CreatorStaticPoolStatistics *statistics);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CREATOR_STATIC_ALLOC_H_ */
@@ -29,6 +29,7 @@ extern "C" {
 #endif
 
 #include "creator/core/base_types.h"
+#include "creator/core/creator_threadpool.h"
 
 typedef uint CreatorTaskID;
 
@@ -42,6 +43,28 @@ typedef void (*CreatorScheduler_TaskCallback)(CreatorTaskID taskID, void *contex
 
 #define CREATOR_TASKID_INVALID (0)
 
+/**
+ * Execution mode of a scheduled task.
+ */
+typedef enum
+{
+    CreatorSchedulerTaskFlags_Serial = 0,       ///< run on the scheduler thread (default)
+    CreatorSchedulerTaskFlags_Concurrent = 1    ///< hand off to the scheduler thread pool, see \ref CreatorScheduler_SetThreadPool
+} CreatorSchedulerTaskFlags;
+
+/**
+ * Execution statistics of a scheduled task, all times in milliseconds.
+ */
+typedef struct
+{
+    uint ExecutionCount;
+    uint LastExecutionTime;
+    uint MaxExecutionTime;
+    uint64 TotalExecutionTime;
+    uint LastDispatchLag;       ///< time between the task becoming due and its callback starting
+    uint MaxDispatchLag;
+} CreatorSchedulerTaskStatistics;
+
 /**
  * \brief Initializes the task scheduler library.
  *
@@ -62,6 +85,17 @@ bool CreatorScheduler_Initialise(void);
  */
 CreatorTaskID CreatorScheduler_ScheduleTask(CreatorScheduler_TaskCallback executor, void *context, ulong delayBeforeExecution, bool continuous);
 
+/**
+ * Schedule a task for execution with a delay in milliseconds.
+ *
+ * @param executor the method that will execute the task
+ * @param context context pointer that will be passed to \a executor
+ * @param delayInMilliseconds delay in milliseconds before the execution must be triggered
+ * @param continuous if true, the task will be executed every \a delayInMilliseconds
+ * @return the identifier of the task
+ */
+CreatorTaskID CreatorScheduler_ScheduleTaskMs(CreatorScheduler_TaskCallback executor, void *context, ulong delayInMilliseconds, bool continuous);
+
 /**
  * \brief Sets a tasks recurrant execution interval.
  *
@@ -72,6 +106,16 @@ CreatorTaskID CreatorScheduler_ScheduleTask(CreatorScheduler_TaskCallback execut
  */
 void CreatorScheduler_SetTaskInterval(CreatorTaskID taskID, ulong delayBeforeExecution);
 
+/**
+ * \brief Sets a tasks recurrant execution interval in milliseconds.
+ *
+ * The next execution is rescheduled \a intervalInMilliseconds from now.
+ *
+ * @param taskID the identifier returned by \ref CreatorScheduler_ScheduleTask or \ref CreatorScheduler_ScheduleTaskMs
+ * @param intervalInMilliseconds delay in milliseconds before execution is triggered
+ */
+void CreatorScheduler_SetTaskIntervalMs(CreatorTaskID taskID, ulong intervalInMilliseconds);
+
 
 /**
  * \brief Removes a task from scheduling.
@@ -83,6 +127,36 @@ void CreatorScheduler_SetTaskInterval(CreatorTaskID taskID, ulong delayBeforeExe
  */
 void CreatorScheduler_UnscheduleTask(CreatorTaskID taskID);
 
+/**
+ * \brief Gets execution statistics of a task.
+ *
+ * @param taskID the identifier returned by \ref CreatorScheduler_ScheduleTask
+ * @param statistics filled in with the statistics of the task
+ * @return true if the task is scheduled, false otherwise
+ */
+bool CreatorScheduler_GetTaskStatistics(CreatorTaskID taskID, CreatorSchedulerTaskStatistics *statistics);
+
+/**
+ * \brief Sets how a task is executed.
+ *
+ * Serial tasks run one at a time on the scheduler thread. Concurrent tasks are handed to the thread pool set with
+ * \ref CreatorScheduler_SetThreadPool so long running tasks do not delay other tasks. A task never overlaps itself:
+ * a recurrence that becomes due while the previous execution is still running is skipped.
+ *
+ * @param taskID the identifier returned by \ref CreatorScheduler_ScheduleTask
+ * @param flags combination of \ref CreatorSchedulerTaskFlags
+ */
+void CreatorScheduler_SetTaskFlags(CreatorTaskID taskID, uint flags);
+
+/**
+ * \brief Sets the thread pool that concurrent tasks are executed on.
+ *
+ * Without a thread pool (the default) all tasks run on the scheduler thread. The pool must outlive the scheduler.
+ *
+ * @param threadPool pool to execute concurrent tasks on, or NULL
+ */
+void CreatorScheduler_SetThreadPool(CreatorThreadPool threadPool);
+
 /**
  * \brief Frees the task scheduler library.
  *
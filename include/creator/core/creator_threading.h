@@ -67,6 +67,15 @@ void CreatorSemaphore_Wait(CreatorSemaphore self, uint tokens);
  */
 bool CreatorSemaphore_WaitFor(CreatorSemaphore self, uint tokens, uint milliseconds);
 
+/**
+ * \memberof CreatorSemaphore
+ * Names a semaphore for lock profiling, does nothing unless built with CREATOR_LOCK_PROFILING.
+ *
+ * @param self semaphore to name
+ * @param name name to report the semaphore's statistics under (not copied)
+ */
+void CreatorSemaphore_SetName(CreatorSemaphore self, const char *name);
+
 /**
  * \memberof CreatorSemaphore
  * Releases \a tokens into the semaphore.
@@ -85,6 +94,177 @@ void CreatorSemaphore_Release(CreatorSemaphore self, uint tokens);
 void CreatorSemaphore_Free(CreatorSemaphore *self);
 
 
+/**
+ * \class CreatorLockStatistics
+ * Usage of a mutex or semaphore recorded by a CREATOR_LOCK_PROFILING build. Times are in microseconds.
+ *
+ * Hold time runs from the first token taken until all taken tokens are released, so it is only meaningful for
+ * semaphores used as locks.
+ */
+typedef struct
+{
+    const char *Name;
+    uint AcquireCount;
+    uint ContendedCount;
+    uint64 TotalWaitTime;
+    uint MaxWaitTime;
+    uint64 TotalHoldTime;
+    uint MaxHoldTime;
+} CreatorLockStatistics;
+
+/**
+ * \memberof CreatorLockStatistics
+ * Called once per profiled lock by \ref CreatorLockProfiling_GetStatistics
+ * @param statistics snapshot of the lock's statistics
+ * @param context context passed to \ref CreatorLockProfiling_GetStatistics
+ */
+typedef void (*CreatorLockProfiling_Callback)(const CreatorLockStatistics *statistics, void *context);
+
+/**
+ * \memberof CreatorLockStatistics
+ * Logs the statistics of every profiled lock (nothing unless built with CREATOR_LOCK_PROFILING).
+ */
+void CreatorLockProfiling_Dump(void);
+
+/**
+ * \memberof CreatorLockStatistics
+ * Reports the statistics of every profiled lock. The callback is given a snapshot taken before the first call.
+ *
+ * @param callback method called for each lock
+ * @param context parameter to pass to the \a callback
+ * @return number of locks reported, always 0 unless built with CREATOR_LOCK_PROFILING
+ */
+uint CreatorLockProfiling_GetStatistics(CreatorLockProfiling_Callback callback, void *context);
+
+/**
+ * \memberof CreatorLockStatistics
+ * Clears the statistics of every profiled lock.
+ */
+void CreatorLockProfiling_Reset(void);
+
+/**
+ * \class CreatorMutex
+ * Abstract mutual exclusion lock from platform specific implementation
+ *
+ * Lighter than a CreatorSemaphore with one token. A mutex must be unlocked by the thread that locked it and is not
+ * recursive. Where the platform supports it the mutex uses priority inheritance.
+ */
+typedef void *CreatorMutex;
+
+/**
+ * \memberof CreatorMutex
+ * Creates a new (unlocked) mutex.
+ *
+ * @return the handler to the mutex
+ */
+CreatorMutex CreatorMutex_New(void);
+
+/**
+ * \memberof CreatorMutex
+ * Waits until the mutex can be locked.
+ *
+ * @param self mutex to lock
+ */
+void CreatorMutex_Lock(CreatorMutex self);
+
+/**
+ * \memberof CreatorMutex
+ * Waits up to specified timeout until the mutex can be locked.
+ *
+ * @param self mutex to lock
+ * @param milliseconds number of milliseconds to wait for
+ * @return whether successfully locked the mutex
+ */
+bool CreatorMutex_LockFor(CreatorMutex self, uint milliseconds);
+
+/**
+ * \memberof CreatorMutex
+ * Names a mutex for lock profiling, does nothing unless built with CREATOR_LOCK_PROFILING.
+ *
+ * @param self mutex to name
+ * @param name name to report the mutex's statistics under (not copied)
+ */
+void CreatorMutex_SetName(CreatorMutex self, const char *name);
+
+/**
+ * \memberof CreatorMutex
+ * Unlocks a mutex locked by the calling thread.
+ *
+ * @param self mutex to unlock
+ */
+void CreatorMutex_Unlock(CreatorMutex self);
+
+/**
+ * \memberof CreatorMutex
+ * Frees the resources allocated to a given mutex.
+ *
+ * @param self mutex to free
+ */
+void CreatorMutex_Free(CreatorMutex *self);
+
+
+/**
+ * \class CreatorCondition
+ * Abstract condition variable from platform specific implementation
+ *
+ * Always used together with a CreatorMutex protecting the condition's state. Waiters must re-check their predicate
+ * after waking. Signal and Broadcast must be called with the mutex locked.
+ */
+typedef void *CreatorCondition;
+
+/**
+ * \memberof CreatorCondition
+ * Creates a new condition variable.
+ *
+ * @return the handler to the condition variable
+ */
+CreatorCondition CreatorCondition_New(void);
+
+/**
+ * \memberof CreatorCondition
+ * Atomically unlocks \a mutex and waits until the condition is signalled, then locks \a mutex again.
+ *
+ * @param self condition to wait on
+ * @param mutex mutex locked by the calling thread
+ */
+void CreatorCondition_Wait(CreatorCondition self, CreatorMutex mutex);
+
+/**
+ * \memberof CreatorCondition
+ * Same as \ref CreatorCondition_Wait but gives up after the specified timeout (measured on a monotonic clock).
+ *
+ * @param self condition to wait on
+ * @param mutex mutex locked by the calling thread
+ * @param milliseconds number of milliseconds to wait for
+ * @return false if the wait timed out
+ */
+bool CreatorCondition_WaitFor(CreatorCondition self, CreatorMutex mutex, uint milliseconds);
+
+/**
+ * \memberof CreatorCondition
+ * Wakes one thread waiting on the condition.
+ *
+ * @param self condition to signal
+ */
+void CreatorCondition_Signal(CreatorCondition self);
+
+/**
+ * \memberof CreatorCondition
+ * Wakes all threads waiting on the condition.
+ *
+ * @param self condition to broadcast
+ */
+void CreatorCondition_Broadcast(CreatorCondition self);
+
+/**
+ * \memberof CreatorCondition
+ * Frees the resources allocated to a given condition variable.
+ *
+ * @param self condition to free
+ */
+void CreatorCondition_Free(CreatorCondition *self);
+
+
 
 /**
  * \class CreatorThread
@@ -45,6 +45,35 @@ typedef void *CreatorThreadPool;
  */
 typedef void (*CreatorThreadPool_Callback)(void *context);
 
+/**
+ * \class CreatorFuture
+ * Completion handle for a task submitted with \ref CreatorThreadPool_Submit
+ */
+typedef void *CreatorFuture;
+
+/**
+ * \memberof CreatorFuture
+ * Task to execute for a future, the value returned is the result of the future
+ * @param context context passed to \ref CreatorThreadPool_Submit
+ */
+typedef void *(*CreatorFuture_Callback)(void *context);
+
+/**
+ * \memberof CreatorFuture
+ * Continuation called once a future completes or is cancelled
+ * @param future future that finished, valid until the continuation returns
+ * @param context context passed to \ref CreatorFuture_SetContinuation
+ */
+typedef void (*CreatorFuture_Continuation)(CreatorFuture future, void *context);
+
+typedef enum
+{
+    CreatorFutureState_Pending = 0,
+    CreatorFutureState_Running,
+    CreatorFutureState_Completed,
+    CreatorFutureState_Cancelled
+} CreatorFutureState;
+
 
 /**
  * \memberof CreatorThreadPool
@@ -77,6 +106,99 @@ CreatorThreadPool CreatorThreadPool_New(uint minThreads, uint maxThreads, uint p
  */
 bool CreatorThreadPool_AddTask(CreatorThreadPool self, CreatorThreadPool_Callback runnable, void *context);
 
+/**
+ * \memberof CreatorThreadPool
+ * \brief Add a batch of tasks to be executed by thread pool.
+ *
+ * All tasks are queued before the workers are woken with a single call.
+ *
+ * @param self thread pool to execute tasks on.
+ * @param runnables array of \a count methods/tasks that will be executed by thread pool.
+ * @param contexts array of \a count parameters to pass to each runnable (may be NULL).
+ * @param count number of tasks to add.
+ * @return number of tasks added, tasks are added in order so the first n were successful
+ */
+uint CreatorThreadPool_AddTasks(CreatorThreadPool self, CreatorThreadPool_Callback *runnables, void **contexts, uint count);
+
+/**
+ * \memberof CreatorThreadPool
+ * \brief Add a task to be executed by thread pool and get a handle to its result.
+ *
+ * The returned future must be released with \ref CreatorFuture_Free, it may be freed before the task has run.
+ *
+ * @param self thread pool to execute task on.
+ * @param runnable method/task that will be executed by thread pool.
+ * @param context parameter to pass to the \a runnable.
+ * @return future for the task, or NULL if the task could not be added
+ */
+CreatorFuture CreatorThreadPool_Submit(CreatorThreadPool self, CreatorFuture_Callback runnable, void *context);
+
+/**
+ * \memberof CreatorFuture
+ * \brief Cancel a future whose task has not started yet.
+ *
+ * @param self future to cancel
+ * @return true if the task will not run, false if it is already running or finished
+ */
+bool CreatorFuture_Cancel(CreatorFuture self);
+
+/**
+ * \memberof CreatorFuture
+ * \brief Release the caller's reference to a future.
+ *
+ * @param self future to free
+ */
+void CreatorFuture_Free(CreatorFuture *self);
+
+/**
+ * \memberof CreatorFuture
+ * \brief Get the value returned by the task.
+ *
+ * @param self future to query
+ * @return task result, or NULL if the future has not completed
+ */
+void *CreatorFuture_GetResult(CreatorFuture self);
+
+/**
+ * \memberof CreatorFuture
+ * @param self future to query
+ * @return current state of the future
+ */
+CreatorFutureState CreatorFuture_GetState(CreatorFuture self);
+
+/**
+ * \memberof CreatorFuture
+ * \brief Set a method to call once the future completes or is cancelled.
+ *
+ * The continuation runs on the thread that finishes the future, or on the calling thread if the future has already
+ * finished. Only one continuation can be set.
+ *
+ * @param self future to continue from
+ * @param continuation method to call
+ * @param context parameter to pass to the \a continuation
+ * @return false if a continuation was already set
+ */
+bool CreatorFuture_SetContinuation(CreatorFuture self, CreatorFuture_Continuation continuation, void *context);
+
+/**
+ * \memberof CreatorFuture
+ * \brief Wait until the future completes or is cancelled.
+ *
+ * @param self future to wait on
+ * @return true if the task completed, false if it was cancelled
+ */
+bool CreatorFuture_Wait(CreatorFuture self);
+
+/**
+ * \memberof CreatorFuture
+ * \brief Wait until the future completes, is cancelled or the timeout expires.
+ *
+ * @param self future to wait on
+ * @param milliseconds maximum time to wait
+ * @return true if the task completed within the timeout
+ */
+bool CreatorFuture_WaitFor(CreatorFuture self, uint milliseconds);
+
 #ifdef __cplusplus
 }
 #endif
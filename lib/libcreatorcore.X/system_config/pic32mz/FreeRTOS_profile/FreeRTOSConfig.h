@@ -111,6 +111,7 @@
 #define configUSE_MALLOC_FAILED_HOOK            1
 #define configUSE_APPLICATION_TASK_TAG          0
 #define configUSE_COUNTING_SEMAPHORES           1
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS 1
 #define configGENERATE_RUN_TIME_STATS           0
 
 /* Co-routine definitions. */
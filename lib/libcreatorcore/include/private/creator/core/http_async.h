@@ -0,0 +1,84 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+
+#ifndef HTTP_ASYNC_H_
+#define HTTP_ASYNC_H_
+
+#include <stdbool.h>
+#include "creator/core/base_types.h"
+#include "creator/core/creator_httpmethod.h"
+#include "creator/core/creator_httpstatus.h"
+#include "creator/core/creator_object.h"
+#include "creator/core/creator_threadpool.h"
+#include "creator/core/errortype.h"
+
+/*
+ * Asynchronous CreatorHTTP_Call. The request is built and sent by a worker of the thread pool set with
+ * CreatorHTTP_SetAsyncThreadPool, and no thread waits for the response: when it arrives a worker parses it (retrying
+ * once after a network failure, as CreatorHTTP_Call does) and calls the callback.
+ */
+
+typedef uint CreatorHTTPCallID;
+
+/**
+ * Called on a worker thread once an asynchronous call has finished.
+ *
+ * @param callID call returned by \ref CreatorHTTP_CallAsync
+ * @param context context passed to \ref CreatorHTTP_CallAsync
+ * @param success result CreatorHTTP_Call would have returned
+ * @param response deserialised response (attached to the call's memory manager), or NULL
+ * @param status HTTP status of the response
+ * @param error error CreatorHTTP_Call would have left in CreatorThread_GetLastError
+ */
+typedef void (*CreatorHTTP_CallCallback)(CreatorHTTPCallID callID, void *context, bool success, CreatorObject response, CreatorHTTPStatus status,
+        CreatorErrorType error);
+
+/**
+ * Start a call without waiting for it. At most CreatorHTTP_SetMaxAsyncCalls calls run at once, later ones are queued.
+ *
+ * The URL is copied before returning. memoryManager and bodyData must stay valid until the callback has been called
+ * (or the call has been cancelled).
+ *
+ * @return identifier of the call, or 0 if it could not be started (no thread pool, no memory) - see CreatorThread_GetLastError
+ */
+CreatorHTTPCallID CreatorHTTP_CallAsync(CreatorMemoryManager memoryManager, CreatorHTTPMethod httpMethod, char *url, CreatorType expectedType,
+        CreatorObject bodyData, CreatorHTTP_CallCallback callback, void *context);
+
+/**
+ * Cancel an asynchronous call. A call that has already been sent can't be withdrawn, but its response is dropped.
+ *
+ * @return true if the callback will not be called, false if it has been (or is being) called
+ */
+bool CreatorHTTP_CancelCall(CreatorHTTPCallID callID);
+
+/**
+ * Set the thread pool asynchronous calls run on (not owned). Set a pool before the first call, and NULL once no calls
+ * are outstanding to release the call list lock.
+ */
+void CreatorHTTP_SetAsyncThreadPool(CreatorThreadPool threadPool);
+
+/**
+ * Set how many asynchronous calls may be in flight at once (default HTTP_MAX_ASYNC_CALLS).
+ */
+void CreatorHTTP_SetMaxAsyncCalls(uint maxCalls);
+
+#endif /* HTTP_ASYNC_H_ */
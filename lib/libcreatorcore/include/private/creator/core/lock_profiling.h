@@ -0,0 +1,81 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+
+#ifndef LOCK_PROFILING_H_
+#define LOCK_PROFILING_H_
+
+#include "creator/core/base_types.h"
+#include "creator/core/creator_threading.h"
+
+#ifdef FREERTOS
+#include "FreeRTOS.h"
+#include "semphr.h"
+#endif
+
+#ifdef CREATOR_LOCK_PROFILING
+
+/*
+ * Profiling record embedded in each mutex/semaphore of a CREATOR_LOCK_PROFILING build. Records are linked into a
+ * global registry from creation until the lock is freed. Times are in microseconds.
+ */
+typedef struct LockProfile
+{
+    CreatorLockStatistics Statistics;
+    uint Holders;
+    uint AcquiredAt;
+    struct LockProfile *Next;
+    struct LockProfile *Previous;
+} LockProfile;
+
+#ifdef FREERTOS
+/*
+ * FreeRTOS mutexes/semaphores are plain handles, profiling builds wrap the handle so the profile travels with it
+ */
+typedef struct
+{
+    xSemaphoreHandle Handle;
+    LockProfile Profile;
+} ProfiledLock;
+
+#define LOCK_HANDLE(self)   (((ProfiledLock *)(self))->Handle)
+#define LOCK_PROFILE(self)  (&((ProfiledLock *)(self))->Profile)
+#endif
+
+void LockProfile_Acquired(LockProfile *profile, bool contended, uint waitStart, uint tokens);
+
+uint LockProfile_GetTime(void);
+
+void LockProfile_Register(LockProfile *profile);
+
+void LockProfile_Released(LockProfile *profile, uint tokens);
+
+void LockProfile_SetName(LockProfile *profile, const char *name);
+
+void LockProfile_Unregister(LockProfile *profile);
+
+#elif defined(FREERTOS)
+
+#define LOCK_HANDLE(self)   ((xSemaphoreHandle)(self))
+
+#endif
+
+#endif /* LOCK_PROFILING_H_ */
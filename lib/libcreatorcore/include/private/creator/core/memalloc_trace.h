@@ -0,0 +1,49 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+
+#ifndef MEMALLOC_TRACE_H_
+#define MEMALLOC_TRACE_H_
+
+#include "creator/core/creator_memalloc.h"
+
+/*
+ * Hooks for the Creator_MemAlloc backends, compiled out unless CREATOR_MEMALLOC_TRACE is defined. Each event is
+ * appended to a static ring buffer, so tracing itself never allocates.
+ */
+
+#ifdef CREATOR_MEMALLOC_TRACE
+
+void MemTrace_Record(CreatorMemTraceEvent event, const void *address, const void *newAddress, size_t size, CreatorMemTag tag);
+
+#define MEMTRACE_ALLOC(address, size, tag)          MemTrace_Record(CreatorMemTraceEvent_Alloc, (address), NULL, (size), (tag))
+#define MEMTRACE_FREE(address)                      MemTrace_Record(CreatorMemTraceEvent_Free, (address), NULL, 0, CreatorMemTag_Other)
+#define MEMTRACE_REALLOC(address, newAddress, size) MemTrace_Record(CreatorMemTraceEvent_Realloc, (address), (newAddress), (size), CreatorMemTag_Other)
+
+#else
+
+#define MEMTRACE_ALLOC(address, size, tag)
+#define MEMTRACE_FREE(address)
+#define MEMTRACE_REALLOC(address, newAddress, size)
+
+#endif
+
+#endif /* MEMALLOC_TRACE_H_ */
@@ -34,12 +34,30 @@ typedef enum
     CreatorHTTPError_None,
     CreatorHTTPError_Unspecified,       //an error occurred, but no-one knows what it was
     CreatorHTTPError_Timeout,
-    CreatorHTTPError_NetworkFailure
+    CreatorHTTPError_NetworkFailure,
+    CreatorHTTPError_ContentDecoding    //the compressed response body could not be decoded (not worth re-sending)
 } CreatorHTTPError;
 
 
 typedef void *CreatorHTTPRequest;
 
+/**
+ * Connection pool usage (see \ref CreatorHTTP_GetConnectionPoolStatistics).
+ */
+typedef struct
+{
+    unsigned int Connections;   // pool size (open or not)
+    unsigned int Open;          // connections currently open
+    unsigned int Busy;          // connections currently owned by a request
+    unsigned int Hits;          // requests that reused an open connection
+    unsigned int Misses;        // requests that needed a new connection
+    unsigned int Evictions;     // idle connections to another host dropped to make room
+    unsigned int Reaped;        // idle connections closed by the inactivity timeout
+    unsigned int Waits;         // times a request had to wait for a connection to be released
+    unsigned int Pipelined;     // requests sent while an earlier response on the same connection was outstanding
+    unsigned int PipelineFallbacks; // connections dropped with more than one request outstanding
+} CreatorHTTPConnectionPoolStatistics;
+
 /**
  * Called when (if) the HTTP response code was received.
  *
@@ -80,6 +98,36 @@ typedef void (*CreatorHTTPRequest_DataCallback)(CreatorHTTPRequest request, void
  */
 typedef void (*CreatorHTTPRequest_FinishCallback)(CreatorHTTPRequest request, void *context, CreatorHTTPError error);
 
+/**
+ * Called for each piece of a streamed request body (see \ref CreatorHTTPRequest_SetBodyProducer).
+ *
+ * @param request http request instance.
+ * @param context context passed to \ref CreatorHTTPRequest_SetBodyProducer
+ * @param offset position in the body of the data wanted. Starts again at 0 if the request is re-sent.
+ * @param buffer buffer to fill
+ * @param bufferSize size of \a buffer
+ * @return number of bytes written to \a buffer, 0 at the end of the body, or -1 to abort the request.
+ */
+typedef int (*CreatorHTTPRequest_BodyProducer)(CreatorHTTPRequest request, void *context, size_t offset, char *buffer, size_t bufferSize);
+
+/**
+ * \brief Set up the HTTP client (connection pool and idle connection reaping).
+ */
+void CreatorHTTP_Initialise(void);
+
+/**
+ * \brief Close all connections and release the HTTP client.
+ */
+void CreatorHTTP_Shutdown(void);
+
+/**
+ * \brief Get connection pool usage counters.
+ *
+ * @param statistics receives the counters
+ * @return false if the HTTP client has no connection pool (or is not initialised).
+ */
+bool CreatorHTTP_GetConnectionPoolStatistics(CreatorHTTPConnectionPoolStatistics *statistics);
+
 /**
  * \brief Add a request header to an existing HTTP handler.
  *
@@ -119,6 +167,29 @@ void CreatorHTTPRequest_Send(CreatorHTTPRequest self);
  */
 void CreatorHTTPRequest_SetBody(CreatorHTTPRequest self, const void *body, size_t bodySize);
 
+/**
+ * \brief Sets the body of a request, gzip compressed (with a Content-Encoding header) where that makes it smaller.
+ *
+ * Only for servers known to accept compressed request bodies. The body is sent as given when the HTTP client is built
+ * without zlib (HAVE_LIBZ), or if compression doesn't save anything.
+ *
+ * @param self HTTP handler returned by \ref CreatorHTTPRequest_New
+ * @param body data to be sent
+ * @param bodySize length of \a body
+ */
+void CreatorHTTPRequest_SetCompressedBody(CreatorHTTPRequest self, const void *body, size_t bodySize);
+
+/**
+ * \brief Streams the body of a request, instead of \ref CreatorHTTPRequest_SetBody.
+ *
+ * The body is sent with chunked transfer encoding as \a producer supplies it, so its length need not be known and it is
+ * never held in memory as a whole.
+ *
+ * @param self HTTP handler returned by \ref CreatorHTTPRequest_New
+ * @param producer called (while the request is sent) for each piece of the body
+ * @param context pointer passed to \a producer
+ */
+void CreatorHTTPRequest_SetBodyProducer(CreatorHTTPRequest self, CreatorHTTPRequest_BodyProducer producer, void *context);
 
 /**
  * \brief Frees/Releases the resources associated with the request handler.
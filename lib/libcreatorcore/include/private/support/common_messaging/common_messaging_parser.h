@@ -40,6 +40,9 @@ typedef struct
     bool IsPacketBegining;
     bool IsContentReadingInProgress;
     ushort LengthOfRemainingContent;
+    bool IsChunked;                     // body uses chunked transfer encoding (still set while the trailer is read)
+    uchar ChunkState;
+    uint32 LengthOfRemainingChunk;
     ushort TemporaryDataBufferLength;
     uchar TransportType;
     uint32 ConnectionDestinationAddress;
@@ -51,8 +54,15 @@ typedef struct
     void *SSLSession;
 } CreatorCommonMessaging_ControlBlock;
 
+// Borrow a CREATOR_MAX_PACKET_LEN (+1 for a terminator) receive buffer from the shared pool (see common_messaging_buffers.c), and return it
+char *CreatorCommonMessaging_NewReceiveBuffer(void);
+void CreatorCommonMessaging_FreeReceiveBuffer(char **buffer);
+
 void CreatorCommonMessaging_Receive(CreatorCommonMessaging_ControlBlock *controlBlock);
 int32 CreatorCommonMessaging_HandleContent(CreatorCommonMessaging_ControlBlock *controlBlock, char *contentBuffer, int *length);
+// Decode as much of a chunked body as is in the buffer, returning the bytes consumed (or -1 if the framing is invalid)
+int32 CreatorCommonMessaging_HandleChunkedContent(CreatorCommonMessaging_ControlBlock *controlBlock, char *contentBuffer, int *length);
+// Returns -1 if the message is malformed (the connection can't be resynchronised and should be dropped)
 int CreatorCommonMessaging_ParseMessage(CreatorCommonMessaging_ControlBlock *controlBlock, char *dataBuffer, int bufferLength);
 
 #endif
@@ -27,19 +27,43 @@
 #include <stddef.h>
 #include <stdbool.h>
 
+/*
+ * A DataBuffer is a list of fixed-size chunks (DATABUFFER_CHUNK_SIZE bytes, the largest size class of the allocator
+ * pool) rather than one contiguous block, so appending never reallocates or moves existing data. Use a
+ * DataBufferIterator to walk the contents in place; DataBuffer_GetBufferData flattens into a single new allocation.
+ */
+#define DATABUFFER_CHUNK_SIZE   (256)
+
 typedef struct DataBufferImpl DataBuffer;
 
+typedef struct DataBufferChunkImpl DataBufferChunk;
+
+typedef struct
+{
+    const DataBufferChunk *pChunk;
+} DataBufferIterator;
+
 void DataBuffer_Free(DataBuffer **buffer);
 
 void *DataBuffer_GetBufferData(DataBuffer *buffer, bool takeOwnership);
 
 size_t DataBuffer_GetDataSize(DataBuffer *buffer);
 
+/*
+ * Position iterator at the first segment of buffer. The buffer must not be written to while it is being iterated.
+ */
+void DataBuffer_GetIterator(DataBuffer *buffer, DataBufferIterator *iterator);
+
 DataBuffer *DataBuffer_New(void);
 
 bool DataBuffer_Write(DataBuffer *buffer, const void *data, size_t dataSize);
 
 bool DataBuffer_WriteCString(DataBuffer *buffer, const char *data);
 
+/*
+ * Get the next contiguous segment of data (iovec style). Returns false when there are no more segments.
+ */
+bool DataBufferIterator_Next(DataBufferIterator *iterator, const void **data, size_t *dataSize);
+
 
 #endif /* DATA_BUFFER_H_ */
@@ -0,0 +1,56 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+
+#ifndef MEM_POOL_H_
+#define MEM_POOL_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Size-class pool allocator. Requests up to MEMPOOL_MAX_BLOCK_SIZE bytes are served from per-class free lists that
+ * are only held for a few instructions, larger requests go to the heap. Pool memory is carved out of slabs taken
+ * from the heap on demand and is never returned to it.
+ *
+ * Every block carries a small header, so a block must be freed/reallocated with the pool functions. The header also
+ * holds the requested size and a caller defined tag (kept by realloc).
+ */
+
+#define MEMPOOL_MAX_BLOCK_SIZE      (256)
+
+void *MemPool_Alloc(size_t size);
+
+void *MemPool_Calloc(size_t blockCount, size_t blockSize);
+
+void MemPool_Free(void *block);
+
+size_t MemPool_GetBlockSize(void *block);
+
+size_t MemPool_GetSize(void *block);
+
+unsigned char MemPool_GetTag(void *block);
+
+void *MemPool_Realloc(void *block, size_t size);
+
+void MemPool_SetTag(void *block, unsigned char tag);
+
+#endif /* MEM_POOL_H_ */
@@ -118,6 +118,8 @@ void CreatorCore_Shutdown()
 {
     if (_IsInitialised)
     {
+        // Report lock usage while logging is still available
+        CreatorLockProfiling_Dump();
         CreatorScheduler_Shutdown();
         CreatorNVS_Shutdown();
         CreatorLog_Shutdown();
@@ -0,0 +1,135 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+
+#include "creator/core/creator_arena.h"
+#include "creator/core/base_types.h"
+#include <string.h>
+#include <stdint.h>
+
+#define ARENA_ALIGNMENT (8)
+#define ARENA_ALIGN(size) (((size) + (ARENA_ALIGNMENT - 1)) & ~((size_t)ARENA_ALIGNMENT - 1))
+
+typedef struct ArenaChunk
+{
+    struct ArenaChunk *Next;
+    size_t Size;
+    size_t Used;
+} ArenaChunk;
+
+#define CHUNK_DATA(chunk) ((uint8_t *)(chunk) + ARENA_ALIGN(sizeof(ArenaChunk)))
+
+struct CreatorArenaImpl
+{
+    ArenaChunk *Current;        // chunk currently being allocated from; extra chunks link back towards First
+    size_t ChunkSize;
+    CreatorMemTag Tag;
+    ArenaChunk First;           // data of the first chunk follows the arena header
+};
+
+#define ARENA_HEADER_SIZE ARENA_ALIGN(sizeof(struct CreatorArenaImpl))
+
+static void FreeExtraChunks(CreatorArena self)
+{
+    ArenaChunk *chunk = self->Current;
+    while (chunk != &self->First)
+    {
+        ArenaChunk *next = chunk->Next;
+        Creator_MemFree((void **)&chunk);
+        chunk = next;
+    }
+    self->Current = &self->First;
+}
+
+void *CreatorArena_Alloc(CreatorArena self, size_t size)
+{
+    void *result = NULL;
+    if (self)
+    {
+        size = ARENA_ALIGN(size ? size : 1);
+        ArenaChunk *chunk = self->Current;
+        if (chunk->Size - chunk->Used < size)
+        {
+            size_t chunkSize = (size > self->ChunkSize) ? size : self->ChunkSize;
+            chunk = (ArenaChunk *)Creator_MemAllocWithTag(ARENA_ALIGN(sizeof(ArenaChunk)) + chunkSize, self->Tag);
+            if (!chunk)
+                return NULL;
+            chunk->Size = chunkSize;
+            chunk->Used = 0;
+            chunk->Next = self->Current;
+            self->Current = chunk;
+        }
+        if (chunk == &self->First)
+            result = (uint8_t *)self + ARENA_HEADER_SIZE + chunk->Used;
+        else
+            result = CHUNK_DATA(chunk) + chunk->Used;
+        chunk->Used += size;
+    }
+    return result;
+}
+
+char *CreatorArena_DuplicateString(CreatorArena self, const char *text)
+{
+    char *result = NULL;
+    if (text)
+    {
+        size_t length = strlen(text) + 1;
+        result = (char *)CreatorArena_Alloc(self, length);
+        if (result)
+            memcpy(result, text, length);
+    }
+    return result;
+}
+
+void CreatorArena_Free(CreatorArena *self)
+{
+    if (self && *self)
+    {
+        FreeExtraChunks(*self);
+        Creator_MemFree((void **)self);
+    }
+}
+
+CreatorArena CreatorArena_New(size_t chunkSize, CreatorMemTag tag)
+{
+    CreatorArena result = NULL;
+    chunkSize = ARENA_ALIGN(chunkSize ? chunkSize : 256);
+    result = (CreatorArena)Creator_MemAllocWithTag(ARENA_HEADER_SIZE + chunkSize, tag);
+    if (result)
+    {
+        result->Current = &result->First;
+        result->ChunkSize = chunkSize;
+        result->Tag = tag;
+        result->First.Next = NULL;
+        result->First.Size = chunkSize;
+        result->First.Used = 0;
+    }
+    return result;
+}
+
+void CreatorArena_Reset(CreatorArena self)
+{
+    if (self)
+    {
+        FreeExtraChunks(self);
+        self->First.Used = 0;
+    }
+}
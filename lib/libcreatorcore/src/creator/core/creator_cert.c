@@ -24,7 +24,7 @@
 #include <string.h>
 #include "creator/core/base_types.h"
 #include "creator/core/base_types_methods.h"
-#include "creator/core/creator_list.h"
+#include "creator/core/creator_hashmap.h"
 #include "creator/core/creator_memalloc.h"
 
 
@@ -37,26 +37,14 @@ typedef struct DomainCertImpl
     char *Certificate;
 }*DomainCert;
 
-static CreatorList _Certificates = NULL;
+static CreatorHashMap _Certificates = NULL;       // Domain (case-insensitive) -> DomainCert
 
 DomainCert CreatorCert_FindCertificate(const char *domain)
 {
     DomainCert result = NULL;
-    if (_Certificates)
+    if (_Certificates && domain)
     {
-        uint index;
-        for (index = 0; index < CreatorList_GetCount(_Certificates); index++)
-        {
-            DomainCert domainCert = (DomainCert)CreatorList_GetItem(_Certificates, index);
-            if (domainCert)
-            {
-                if (strcasecmp(domain, domainCert->Domain) == 0)
-                {
-                    result = domainCert;
-                    break;
-                }
-            }
-        }
+        result = (DomainCert)CreatorHashMap_Get(_Certificates, domain);
     }
     return result;
 }
@@ -83,7 +71,7 @@ char *CreatorCert_GetCertificate(const char *domain)
 bool CreatorCert_Initialise(void)
 {
     bool result = false;
-    _Certificates = CreatorList_New(5);
+    _Certificates = CreatorHashMap_New(CreatorHashMapKeyType_StringIgnoreCase, 5);
     if (_Certificates)
     {
         DomainCert domainCert = (DomainCert)Creator_MemAlloc(sizeof(struct DomainCertImpl));
@@ -91,7 +79,7 @@ bool CreatorCert_Initialise(void)
         {
             domainCert->Domain = (char *)DEFAULT_DOMAIN;
             domainCert->Certificate = (char *)DEFAULT_CA_CERT_CHAIN;
-            CreatorList_Add(_Certificates, (void *)domainCert);
+            CreatorHashMap_Put(_Certificates, domainCert->Domain, (void *)domainCert);
             result = true;
         }
     }
@@ -121,7 +109,7 @@ bool CreatorCert_SetCertificate(const char *domain, const char *certificate)
             {
                 domainCert->Domain = CreatorString_Duplicate(domain);
                 domainCert->Certificate = CreatorString_Duplicate(certificate);
-                CreatorList_Add(_Certificates, (void *)domainCert);
+                CreatorHashMap_Put(_Certificates, domainCert->Domain, (void *)domainCert);
                 result = true;
             }
         }
@@ -133,10 +121,10 @@ void CreatorCert_Shutdown(void)
 {
     if (_Certificates)
     {
-        uint index;
-        for (index = 0; index < CreatorList_GetCount(_Certificates); index++)
+        uint position = 0;
+        DomainCert domainCert;
+        while (CreatorHashMap_GetNext(_Certificates, &position, NULL, (void **)&domainCert))
         {
-            DomainCert domainCert = (DomainCert)CreatorList_GetItem(_Certificates, index);
             if (domainCert)
             {
                 if (domainCert->Domain && domainCert->Domain != DEFAULT_DOMAIN)
@@ -146,7 +134,7 @@ void CreatorCert_Shutdown(void)
                 Creator_MemFree((void **)&domainCert);
             }
         }
-        CreatorList_Free(&_Certificates, false);
+        CreatorHashMap_Free(&_Certificates);
     }
 }
 
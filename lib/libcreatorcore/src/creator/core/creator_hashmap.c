@@ -0,0 +1,291 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+
+#include "creator/core/creator_hashmap.h"
+#include "creator/core/creator_memalloc.h"
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <stdint.h>
+
+#define MINIMUM_CAPACITY    (8)
+
+typedef struct
+{
+    const void *Key;            // NULL if slot is empty, _Tombstone if entry was removed
+    void *Value;
+    uint32_t Hash;
+} HashMapEntry;
+
+struct CreatorHashMapImpl
+{
+    CreatorHashMapKeyType KeyType;
+    uint Capacity;              // always a power of two
+    uint Count;
+    uint Tombstones;
+    HashMapEntry *Entries;
+};
+
+static const char _Tombstone[1];
+
+static HashMapEntry *FindEntry(CreatorHashMap self, const void *key, uint32_t hash, bool forInsert);
+static uint32_t HashKey(CreatorHashMap self, const void *key);
+static bool KeysEqual(CreatorHashMap self, const void *key1, const void *key2);
+static bool Resize(CreatorHashMap self, uint capacity);
+
+bool CreatorHashMap_Contains(CreatorHashMap self, const void *key)
+{
+    bool result = false;
+    if (self && key)
+    {
+        result = (FindEntry(self, key, HashKey(self, key), false) != NULL);
+    }
+    return result;
+}
+
+void CreatorHashMap_Free(CreatorHashMap *self)
+{
+    if (self && *self)
+    {
+        CreatorHashMap map = *self;
+        if (map->Entries)
+            Creator_MemFree((void **)&map->Entries);
+        Creator_MemFree((void **)self);
+    }
+}
+
+void *CreatorHashMap_Get(CreatorHashMap self, const void *key)
+{
+    void *result = NULL;
+    if (self && key)
+    {
+        HashMapEntry *entry = FindEntry(self, key, HashKey(self, key), false);
+        if (entry)
+            result = entry->Value;
+    }
+    return result;
+}
+
+uint CreatorHashMap_GetCount(CreatorHashMap self)
+{
+    uint result = 0;
+    if (self)
+    {
+        result = self->Count;
+    }
+    return result;
+}
+
+bool CreatorHashMap_GetNext(CreatorHashMap self, uint *position, const void **key, void **value)
+{
+    bool result = false;
+    if (self && position)
+    {
+        while (*position < self->Capacity)
+        {
+            HashMapEntry *entry = &self->Entries[(*position)++];
+            if (entry->Key && entry->Key != _Tombstone)
+            {
+                if (key)
+                    *key = entry->Key;
+                if (value)
+                    *value = entry->Value;
+                result = true;
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+CreatorHashMap CreatorHashMap_New(CreatorHashMapKeyType keyType, uint initialCapacity)
+{
+    CreatorHashMap result = Creator_MemAlloc(sizeof(struct CreatorHashMapImpl));
+    if (result)
+    {
+        memset(result, 0, sizeof(struct CreatorHashMapImpl));
+        result->KeyType = keyType;
+        // keep the load factor at or below 3/4
+        uint capacity = MINIMUM_CAPACITY;
+        while (capacity * 3 < initialCapacity * 4)
+            capacity <<= 1;
+        if (!Resize(result, capacity))
+            Creator_MemFree((void **)&result);
+    }
+    return result;
+}
+
+bool CreatorHashMap_Put(CreatorHashMap self, const void *key, void *value)
+{
+    bool result = false;
+    if (self && key)
+    {
+        uint32_t hash = HashKey(self, key);
+        HashMapEntry *entry = FindEntry(self, key, hash, false);
+        if (entry)
+        {
+            entry->Value = value;
+            result = true;
+        }
+        else
+        {
+            if ((self->Count + self->Tombstones + 1) * 4 > self->Capacity * 3)
+            {
+                // grow if mostly live entries, otherwise rehash in place to clear out removed entries
+                uint capacity = ((self->Count + 1) * 2 > self->Capacity) ? self->Capacity << 1 : self->Capacity;
+                if (!Resize(self, capacity))
+                    return false;
+            }
+            entry = FindEntry(self, key, hash, true);
+            if (entry->Key == _Tombstone)
+                self->Tombstones--;
+            entry->Key = key;
+            entry->Value = value;
+            entry->Hash = hash;
+            self->Count++;
+            result = true;
+        }
+    }
+    return result;
+}
+
+void *CreatorHashMap_Remove(CreatorHashMap self, const void *key)
+{
+    void *result = NULL;
+    if (self && key)
+    {
+        HashMapEntry *entry = FindEntry(self, key, HashKey(self, key), false);
+        if (entry)
+        {
+            result = entry->Value;
+            entry->Key = _Tombstone;
+            entry->Value = NULL;
+            self->Count--;
+            self->Tombstones++;
+        }
+    }
+    return result;
+}
+
+// Linear probing. Returns the matching entry, or NULL if not found. If forInsert, returns the slot the key should be
+// inserted into instead (the first removed entry on the probe path, else the empty slot that ended the search).
+static HashMapEntry *FindEntry(CreatorHashMap self, const void *key, uint32_t hash, bool forInsert)
+{
+    HashMapEntry *firstTombstone = NULL;
+    uint mask = self->Capacity - 1;
+    uint index = hash & mask;
+    while (true)
+    {
+        HashMapEntry *entry = &self->Entries[index];
+        if (!entry->Key)
+        {
+            if (forInsert)
+                return firstTombstone ? firstTombstone : entry;
+            return NULL;
+        }
+        if (entry->Key == _Tombstone)
+        {
+            if (!firstTombstone)
+                firstTombstone = entry;
+        }
+        else if (!forInsert && entry->Hash == hash && KeysEqual(self, entry->Key, key))
+        {
+            return entry;
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+static uint32_t HashKey(CreatorHashMap self, const void *key)
+{
+    uint32_t hash;
+    if (self->KeyType == CreatorHashMapKeyType_Pointer)
+    {
+        // mix the address bits so that aligned pointers spread over the table
+        uintptr_t value = (uintptr_t)key;
+        hash = (uint32_t)value ^ (uint32_t)((uint64_t)value >> 32);
+        hash ^= hash >> 16;
+        hash *= 0x45D9F3B;
+        hash ^= hash >> 16;
+    }
+    else
+    {
+        // FNV-1a
+        const unsigned char *text = (const unsigned char *)key;
+        bool ignoreCase = (self->KeyType == CreatorHashMapKeyType_StringIgnoreCase);
+        hash = 2166136261u;
+        while (*text)
+        {
+            hash ^= ignoreCase ? (uint32_t)tolower(*text) : (uint32_t)*text;
+            hash *= 16777619u;
+            text++;
+        }
+    }
+    return hash;
+}
+
+static bool KeysEqual(CreatorHashMap self, const void *key1, const void *key2)
+{
+    bool result;
+    switch (self->KeyType)
+    {
+        case CreatorHashMapKeyType_String:
+            result = (strcmp((const char *)key1, (const char *)key2) == 0);
+            break;
+        case CreatorHashMapKeyType_StringIgnoreCase:
+            result = (strcasecmp((const char *)key1, (const char *)key2) == 0);
+            break;
+        default:
+            result = (key1 == key2);
+            break;
+    }
+    return result;
+}
+
+static bool Resize(CreatorHashMap self, uint capacity)
+{
+    bool result = false;
+    size_t size = capacity * sizeof(HashMapEntry);
+    HashMapEntry *entries = Creator_MemAlloc(size);
+    if (entries)
+    {
+        memset(entries, 0, size);
+        HashMapEntry *oldEntries = self->Entries;
+        uint oldCapacity = self->Capacity;
+        self->Entries = entries;
+        self->Capacity = capacity;
+        self->Tombstones = 0;
+        uint index;
+        for (index = 0; index < oldCapacity; index++)
+        {
+            HashMapEntry *entry = &oldEntries[index];
+            if (entry->Key && entry->Key != _Tombstone)
+            {
+                *FindEntry(self, entry->Key, entry->Hash, true) = *entry;
+            }
+        }
+        if (oldEntries)
+            Creator_MemFree((void **)&oldEntries);
+        result = true;
+    }
+    return result;
+}
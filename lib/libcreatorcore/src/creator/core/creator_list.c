@@ -64,10 +64,12 @@ bool CreatorList_Add(CreatorList self, void *item)
         uint count = self->Used + 1;
         if (count > self->Size)
         {
-            void **newItems = Creator_MemRealloc(self->Items, (self->Size + 5) * sizeof(void *));
+            // grow geometrically so that adding n items costs O(n) copies overall
+            uint newSize = (self->Size < 5) ? 10 : self->Size + (self->Size >> 1);
+            void **newItems = Creator_MemRealloc(self->Items, newSize * sizeof(void *));
             if (newItems)
             {
-                self->Size += 5;
+                self->Size = newSize;
                 self->Items = newItems;
             }
         }
@@ -139,11 +141,7 @@ bool CreatorList_Remove(CreatorList self, void *item)
         if (result)
         {
             self->Used--;
-            uint moveIndex;
-            for (moveIndex = index; moveIndex < self->Used; moveIndex++)
-            {
-                self->Items[moveIndex] = self->Items[moveIndex + 1];
-            }
+            memmove(&self->Items[index], &self->Items[index + 1], (self->Used - index) * sizeof(void *));
         }
     }
     return result;
@@ -158,10 +156,41 @@ void *CreatorList_RemoveAt(CreatorList self, uint index)
         {
             result = self->Items[index];
             self->Used--;
-            uint moveIndex;
-            for (moveIndex = index; moveIndex < self->Used; moveIndex++)
+            memmove(&self->Items[index], &self->Items[index + 1], (self->Used - index) * sizeof(void *));
+        }
+    }
+    return result;
+}
+
+void *CreatorList_RemoveAtUnordered(CreatorList self, uint index)
+{
+    void *result = NULL;
+    if (self)
+    {
+        if (index < self->Used)
+        {
+            result = self->Items[index];
+            self->Used--;
+            self->Items[index] = self->Items[self->Used];
+        }
+    }
+    return result;
+}
+
+bool CreatorList_RemoveUnordered(CreatorList self, void *item)
+{
+    bool result = false;
+    if (self)
+    {
+        uint index;
+        for (index = 0; index < self->Used; index++)
+        {
+            if (self->Items[index] == item)
             {
-                self->Items[moveIndex] = self->Items[moveIndex + 1];
+                self->Used--;
+                self->Items[index] = self->Items[self->Used];
+                result = true;
+                break;
             }
         }
     }
@@ -0,0 +1,230 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+
+/*! \file creator_lock_profiling.c
+ *  \brief LibCreatorCore lock contention and hold-time profiling.
+ */
+
+#include <string.h>
+
+#include "creator/core/creator_debug.h"
+#include "creator/core/creator_memalloc.h"
+#include "creator/core/creator_threading.h"
+#include "creator/core/lock_profiling.h"
+
+#ifdef CREATOR_LOCK_PROFILING
+
+#ifdef FREERTOS
+#include "FreeRTOS.h"
+#include "task.h"
+#include "creator/core/creator_timer.h"
+// The registry is a leaf lock taken from inside the profiled locks, so it cannot be a CreatorMutex itself
+#define LOCK_REGISTRY()     taskENTER_CRITICAL()
+#define UNLOCK_REGISTRY()   taskEXIT_CRITICAL()
+#else
+#include <pthread.h>
+#include <time.h>
+static pthread_mutex_t _RegistryLock = PTHREAD_MUTEX_INITIALIZER;
+#define LOCK_REGISTRY()     pthread_mutex_lock(&_RegistryLock)
+#define UNLOCK_REGISTRY()   pthread_mutex_unlock(&_RegistryLock)
+#endif
+
+static LockProfile *_Profiles = NULL;
+static uint _ProfileCount = 0;
+
+static CreatorLockStatistics *GetSnapshot(uint *count);
+
+void LockProfile_Acquired(LockProfile *profile, bool contended, uint waitStart, uint tokens)
+{
+    uint now = LockProfile_GetTime();
+    LOCK_REGISTRY();
+    profile->Statistics.AcquireCount++;
+    if (contended)
+    {
+        uint waitTime = now - waitStart;
+        profile->Statistics.ContendedCount++;
+        profile->Statistics.TotalWaitTime += waitTime;
+        if (waitTime > profile->Statistics.MaxWaitTime)
+            profile->Statistics.MaxWaitTime = waitTime;
+    }
+    if (profile->Holders == 0)
+        profile->AcquiredAt = now;
+    profile->Holders += tokens;
+    UNLOCK_REGISTRY();
+}
+
+uint LockProfile_GetTime(void)
+{
+#ifdef FREERTOS
+    // Tick resolution, wait and hold times shorter than a tick read as zero
+    return (uint)(((uint64)CreatorTimer_GetTickCount() * 1000000) / CreatorTimer_GetTicksPerSecond());
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint)((now.tv_sec * 1000000) + (now.tv_nsec / 1000));
+#endif
+}
+
+void LockProfile_Register(LockProfile *profile)
+{
+    memset(profile, 0, sizeof(LockProfile));
+    LOCK_REGISTRY();
+    profile->Next = _Profiles;
+    if (_Profiles)
+        _Profiles->Previous = profile;
+    _Profiles = profile;
+    _ProfileCount++;
+    UNLOCK_REGISTRY();
+}
+
+void LockProfile_Released(LockProfile *profile, uint tokens)
+{
+    uint now = LockProfile_GetTime();
+    LOCK_REGISTRY();
+    // Semaphores used for signalling are released without being taken first
+    if (profile->Holders > 0)
+    {
+        profile->Holders = (tokens < profile->Holders) ? (profile->Holders - tokens) : 0;
+        if (profile->Holders == 0)
+        {
+            uint holdTime = now - profile->AcquiredAt;
+            profile->Statistics.TotalHoldTime += holdTime;
+            if (holdTime > profile->Statistics.MaxHoldTime)
+                profile->Statistics.MaxHoldTime = holdTime;
+        }
+    }
+    UNLOCK_REGISTRY();
+}
+
+void LockProfile_SetName(LockProfile *profile, const char *name)
+{
+    LOCK_REGISTRY();
+    profile->Statistics.Name = name;
+    UNLOCK_REGISTRY();
+}
+
+void LockProfile_Unregister(LockProfile *profile)
+{
+    LOCK_REGISTRY();
+    if (profile->Previous)
+        profile->Previous->Next = profile->Next;
+    else
+        _Profiles = profile->Next;
+    if (profile->Next)
+        profile->Next->Previous = profile->Previous;
+    _ProfileCount--;
+    UNLOCK_REGISTRY();
+}
+
+void CreatorLockProfiling_Dump(void)
+{
+    uint count;
+    CreatorLockStatistics *statistics = GetSnapshot(&count);
+    if (statistics)
+    {
+        uint index;
+        Creator_Log(CreatorLogLevel_Info, "Lock profile (%d locks, times in us):", count);
+        for (index = 0; index < count; index++)
+        {
+            CreatorLockStatistics *lock = &statistics[index];
+            // Unnamed locks that were never contended are just noise
+            if (lock->Name || (lock->ContendedCount > 0))
+            {
+                Creator_Log(CreatorLogLevel_Info, "  %s: acquired %d, contended %d, wait total %d max %d, hold total %d max %d",
+                        lock->Name ? lock->Name : "(unnamed)", lock->AcquireCount, lock->ContendedCount,
+                        (uint)lock->TotalWaitTime, lock->MaxWaitTime, (uint)lock->TotalHoldTime, lock->MaxHoldTime);
+            }
+        }
+        Creator_MemFree((void **)&statistics);
+    }
+}
+
+uint CreatorLockProfiling_GetStatistics(CreatorLockProfiling_Callback callback, void *context)
+{
+    uint count = 0;
+    CreatorLockStatistics *statistics = GetSnapshot(&count);
+    if (statistics)
+    {
+        uint index;
+        if (callback)
+        {
+            for (index = 0; index < count; index++)
+                callback(&statistics[index], context);
+        }
+        Creator_MemFree((void **)&statistics);
+    }
+    return count;
+}
+
+void CreatorLockProfiling_Reset(void)
+{
+    LockProfile *profile;
+    LOCK_REGISTRY();
+    for (profile = _Profiles; profile; profile = profile->Next)
+    {
+        const char *name = profile->Statistics.Name;
+        memset(&profile->Statistics, 0, sizeof(CreatorLockStatistics));
+        profile->Statistics.Name = name;
+    }
+    UNLOCK_REGISTRY();
+}
+
+/*
+ * Copy the statistics so they can be reported without holding the registry (logging takes locks of its own)
+ */
+static CreatorLockStatistics *GetSnapshot(uint *count)
+{
+    CreatorLockStatistics *result = NULL;
+    uint size = _ProfileCount + 8;
+    *count = 0;
+    result = (CreatorLockStatistics *)Creator_MemAlloc(sizeof(CreatorLockStatistics) * size);
+    if (result)
+    {
+        LockProfile *profile;
+        LOCK_REGISTRY();
+        for (profile = _Profiles; profile && (*count < size); profile = profile->Next)
+        {
+            result[(*count)++] = profile->Statistics;
+        }
+        UNLOCK_REGISTRY();
+    }
+    return result;
+}
+
+#else
+
+void CreatorLockProfiling_Dump(void)
+{
+
+}
+
+uint CreatorLockProfiling_GetStatistics(CreatorLockProfiling_Callback callback, void *context)
+{
+    return 0;
+}
+
+void CreatorLockProfiling_Reset(void)
+{
+
+}
+
+#endif
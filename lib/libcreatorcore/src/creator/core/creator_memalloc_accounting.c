@@ -0,0 +1,126 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+
+/*! \file creator_memalloc_accounting.c
+ *  \brief LibCreatorCore heap accounting per subsystem tag.
+ */
+
+#include <string.h>
+
+#include "creator/core/base_types.h"
+#include "creator/core/creator_memalloc.h"
+#include "creator/core/memalloc_accounting.h"
+
+static const char *_TagNames[CreatorMemTag_Max] = { "other", "http", "xml", "tls", "lwm2m", "log" };
+
+#ifdef CREATOR_MEMALLOC_ACCOUNTING
+
+static CreatorMemStatistics _Statistics[CreatorMemTag_Max];
+
+static CreatorMemStatistics *GetStatistics(CreatorMemTag tag);
+static void UpdatePeak(CreatorMemStatistics *statistics, size_t liveBytes);
+
+void MemAccounting_Allocated(CreatorMemTag tag, size_t size)
+{
+    CreatorMemStatistics *statistics = GetStatistics(tag);
+    uint bucket = 0;
+    size_t bucketSize = 16;
+    while ((bucket < (CREATOR_MEM_SIZE_BUCKETS - 1)) && (size > bucketSize))
+    {
+        bucket++;
+        bucketSize <<= 1;
+    }
+    __atomic_add_fetch(&statistics->LiveAllocations, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&statistics->TotalAllocations, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&statistics->SizeHistogram[bucket], 1, __ATOMIC_RELAXED);
+    UpdatePeak(statistics, __atomic_add_fetch(&statistics->LiveBytes, size, __ATOMIC_RELAXED));
+}
+
+void MemAccounting_Failed(CreatorMemTag tag)
+{
+    __atomic_add_fetch(&GetStatistics(tag)->FailedAllocations, 1, __ATOMIC_RELAXED);
+}
+
+void MemAccounting_Freed(CreatorMemTag tag, size_t size)
+{
+    CreatorMemStatistics *statistics = GetStatistics(tag);
+    __atomic_sub_fetch(&statistics->LiveAllocations, 1, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&statistics->LiveBytes, size, __ATOMIC_RELAXED);
+}
+
+void MemAccounting_Resized(CreatorMemTag tag, size_t oldSize, size_t newSize)
+{
+    CreatorMemStatistics *statistics = GetStatistics(tag);
+    if (newSize > oldSize)
+        UpdatePeak(statistics, __atomic_add_fetch(&statistics->LiveBytes, newSize - oldSize, __ATOMIC_RELAXED));
+    else
+        __atomic_sub_fetch(&statistics->LiveBytes, oldSize - newSize, __ATOMIC_RELAXED);
+}
+
+bool Creator_MemGetStatistics(CreatorMemTag tag, CreatorMemStatistics *statistics)
+{
+    bool result = false;
+    if (statistics)
+    {
+        if (tag < CreatorMemTag_Max)
+        {
+            // Counters are read one by one, they may be a few allocations apart
+            memcpy(statistics, &_Statistics[tag], sizeof(CreatorMemStatistics));
+            result = true;
+        }
+        else
+        {
+            memset(statistics, 0, sizeof(CreatorMemStatistics));
+        }
+    }
+    return result;
+}
+
+static CreatorMemStatistics *GetStatistics(CreatorMemTag tag)
+{
+    return &_Statistics[(tag < CreatorMemTag_Max) ? tag : CreatorMemTag_Other];
+}
+
+static void UpdatePeak(CreatorMemStatistics *statistics, size_t liveBytes)
+{
+    size_t peakBytes = __atomic_load_n(&statistics->PeakBytes, __ATOMIC_RELAXED);
+    while ((liveBytes > peakBytes)
+            && !__atomic_compare_exchange_n(&statistics->PeakBytes, &peakBytes, liveBytes, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+#else
+
+bool Creator_MemGetStatistics(CreatorMemTag tag, CreatorMemStatistics *statistics)
+{
+    if (statistics)
+        memset(statistics, 0, sizeof(CreatorMemStatistics));
+    return false;
+}
+
+#endif
+
+const char *Creator_MemGetTagName(CreatorMemTag tag)
+{
+    return (tag < CreatorMemTag_Max) ? _TagNames[tag] : "unknown";
+}
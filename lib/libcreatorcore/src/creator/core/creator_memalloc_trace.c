@@ -0,0 +1,162 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+
+/*! \file creator_memalloc_trace.c
+ *  \brief LibCreatorCore heap event tracing, for replaying allocation patterns off-target.
+ */
+
+#include <string.h>
+
+#include "creator/core/base_types.h"
+#include "creator/core/creator_memalloc.h"
+#include "creator/core/memalloc_trace.h"
+
+#ifdef CREATOR_MEMALLOC_TRACE
+
+#ifndef CREATOR_MEMALLOC_TRACE_RECORDS
+#define CREATOR_MEMALLOC_TRACE_RECORDS  (512)
+#endif
+
+// Records handed to the writer per batch (copied to the stack so the writer runs without the lock)
+#define DRAIN_BATCH_SIZE    (16)
+
+#ifdef FREERTOS
+#include "FreeRTOS.h"
+#include "task.h"
+// Called from inside the allocator, so the lock cannot be a CreatorMutex (which would allocate and recurse)
+#define LOCK_TRACE()        taskENTER_CRITICAL()
+#define UNLOCK_TRACE()      taskEXIT_CRITICAL()
+#define GetTime()           ((uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS))
+#else
+#include <pthread.h>
+#include <time.h>
+static pthread_mutex_t _TraceLock = PTHREAD_MUTEX_INITIALIZER;
+#define LOCK_TRACE()        pthread_mutex_lock(&_TraceLock)
+#define UNLOCK_TRACE()      pthread_mutex_unlock(&_TraceLock)
+static uint32_t GetTime(void);
+#endif
+
+static CreatorMemTraceRecord _Records[CREATOR_MEMALLOC_TRACE_RECORDS];
+static uint _First = 0;         // oldest buffered record
+static uint _Count = 0;
+static uint _Dropped = 0;       // records lost since the buffer filled up
+static bool _Started = false;
+
+static void AppendRecord(uint32_t time, CreatorMemTraceEvent event, uint32_t address, uint32_t newAddress, uint32_t size, uint8_t tag);
+
+void MemTrace_Record(CreatorMemTraceEvent event, const void *address, const void *newAddress, size_t size, CreatorMemTag tag)
+{
+    uint32_t now = GetTime();
+    LOCK_TRACE();
+    if (!_Started)
+    {
+        _Started = true;
+        AppendRecord(now, CreatorMemTraceEvent_Start, 0, 0, CREATOR_MEM_TRACE_VERSION, 0);
+    }
+    // Keep a slot free for the Dropped marker, so the gap is recorded where it happened
+    if (_Dropped || (_Count + 1 >= CREATOR_MEMALLOC_TRACE_RECORDS))
+    {
+        if (_Count + 2 <= CREATOR_MEMALLOC_TRACE_RECORDS && _Dropped)
+        {
+            AppendRecord(now, CreatorMemTraceEvent_Dropped, 0, 0, _Dropped, 0);
+            _Dropped = 0;
+        }
+        else
+        {
+            _Dropped++;
+            UNLOCK_TRACE();
+            return;
+        }
+    }
+    AppendRecord(now, event, (uint32_t)(uintptr_t)address, (uint32_t)(uintptr_t)newAddress, (uint32_t)size, (uint8_t)tag);
+    UNLOCK_TRACE();
+}
+
+uint Creator_MemTraceDrain(CreatorMemTrace_Writer writer, void *context)
+{
+    uint result = 0;
+    CreatorMemTraceRecord batch[DRAIN_BATCH_SIZE];
+    uint remaining;
+    if (!writer)
+        return 0;
+
+    // Only drain what is buffered now, records caused by the writer itself are left for the next drain
+    LOCK_TRACE();
+    remaining = _Count;
+    if (_Dropped && (_Count < CREATOR_MEMALLOC_TRACE_RECORDS))
+    {
+        AppendRecord(GetTime(), CreatorMemTraceEvent_Dropped, 0, 0, _Dropped, 0);
+        _Dropped = 0;
+        remaining++;
+    }
+    UNLOCK_TRACE();
+
+    while (remaining > 0)
+    {
+        uint count = 0;
+        LOCK_TRACE();
+        while ((count < DRAIN_BATCH_SIZE) && (count < remaining))
+        {
+            batch[count++] = _Records[_First];
+            _First = (_First + 1) % CREATOR_MEMALLOC_TRACE_RECORDS;
+            _Count--;
+        }
+        UNLOCK_TRACE();
+        writer(batch, count, context);
+        remaining -= count;
+        result += count;
+    }
+    return result;
+}
+
+static void AppendRecord(uint32_t time, CreatorMemTraceEvent event, uint32_t address, uint32_t newAddress, uint32_t size, uint8_t tag)
+{
+    CreatorMemTraceRecord *record = &_Records[(_First + _Count) % CREATOR_MEMALLOC_TRACE_RECORDS];
+    record->Timestamp = time;
+    record->Address = address;
+    record->NewAddress = newAddress;
+    record->Size = size;
+    record->Event = (uint8_t)event;
+    record->Tag = tag;
+    record->Reserved = 0;
+    _Count++;
+}
+
+#ifndef FREERTOS
+static uint32_t GetTime(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((now.tv_sec * 1000) + (now.tv_nsec / 1000000));
+}
+#endif
+
+#else
+
+uint Creator_MemTraceDrain(CreatorMemTrace_Writer writer, void *context)
+{
+    (void)writer;
+    (void)context;
+    return 0;
+}
+
+#endif
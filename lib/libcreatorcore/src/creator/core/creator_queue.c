@@ -33,17 +33,36 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#define MIN_LOCKFREE_CAPACITY   (2)
+
+typedef struct
+{
+    uint Sequence;
+    void *Item;
+} LockFreeCell;
+
 struct CreatorQueueImpl
 {
     uint Size;
     uint Used;
     uint Head;
     uint Tail;
-    CreatorSemaphore QueueLock;
+    CreatorMutex QueueLock;
     void **Items;
     CreatorSemaphore WaitForItem;
+    // Lock-free (bounded MPMC ring) variant, QueueLock and Items are unused
+    bool LockFree;
+    uint Mask;
+    LockFreeCell *Cells;
+    uint EnqueuePosition;
+    uint DequeuePosition;
+    uint Waiters;
 };
 
+static void *LockFreeDequeue(CreatorQueue self, bool wait, uint milliseconds);
+static bool LockFreeEnqueue(CreatorQueue self, void *item);
+static bool LockFreeTryDequeue(CreatorQueue self, void **item);
+
 CreatorQueue CreatorQueue_New(unsigned initialCapacity)
 {
     CreatorQueue result = NULL;
@@ -56,7 +75,9 @@ CreatorQueue CreatorQueue_New(unsigned initialCapacity)
         result->Head = 0;
         result->Tail = 0;
         result->WaitForItem = NULL;
-        result->QueueLock = CreatorSemaphore_New(1, 0);
+        result->LockFree = false;
+        result->Cells = NULL;
+        result->QueueLock = CreatorMutex_New();
         if (result->QueueLock)
         {
             size_t size = sizeof(void*) * initialCapacity;
@@ -91,12 +112,48 @@ CreatorQueue CreatorQueue_NewBlocking(unsigned initialCapacity)
     return result;
 }
 
+CreatorQueue CreatorQueue_NewLockFree(unsigned capacity)
+{
+    CreatorQueue result = Creator_MemAlloc(sizeof(struct CreatorQueueImpl));
+    if (result)
+    {
+        memset(result, 0, sizeof(struct CreatorQueueImpl));
+        uint size = MIN_LOCKFREE_CAPACITY;
+        while (size < capacity)
+            size <<= 1;
+        result->LockFree = true;
+        result->Mask = size - 1;
+        result->Size = size;
+        result->Cells = Creator_MemAlloc(sizeof(LockFreeCell) * size);
+        // One wake-up token per cell (all taken), so several enqueues can wake as many blocked consumers
+        result->WaitForItem = CreatorSemaphore_New(size, size);
+        if (result->Cells && result->WaitForItem)
+        {
+            uint index;
+            for (index = 0; index < size; index++)
+            {
+                result->Cells[index].Sequence = index;
+                result->Cells[index].Item = NULL;
+            }
+        }
+        else
+        {
+            CreatorQueue_Free(&result);
+        }
+    }
+    return result;
+}
+
 bool CreatorQueue_Enqueue(CreatorQueue self, void* item)
 {
     bool result = false;
-    if (self)
+    if (self && self->LockFree)
     {
-        CreatorSemaphore_Wait(self->QueueLock, 1);
+        result = LockFreeEnqueue(self, item);
+    }
+    else if (self)
+    {
+        CreatorMutex_Lock(self->QueueLock);
         int count = self->Used + 1;
         if (count > self->Size)
         {
@@ -132,7 +189,7 @@ bool CreatorQueue_Enqueue(CreatorQueue self, void* item)
             self->Tail = (self->Tail + 1) % self->Size;
             result = true;
         }
-        CreatorSemaphore_Release(self->QueueLock, 1);
+        CreatorMutex_Unlock(self->QueueLock);
         if (self->WaitForItem)
             CreatorSemaphore_Release(self->WaitForItem, 1);
     }
@@ -142,12 +199,16 @@ bool CreatorQueue_Enqueue(CreatorQueue self, void* item)
 void* CreatorQueue_Dequeue(CreatorQueue self)
 {
     void* result = NULL;
-    if (self)
+    if (self && self->LockFree)
+    {
+        result = LockFreeDequeue(self, true, 0);
+    }
+    else if (self)
     {
         bool dequeuedItem = false;
         do
         {
-            CreatorSemaphore_Wait(self->QueueLock, 1);
+            CreatorMutex_Lock(self->QueueLock);
             if (self->Used > 0)
             {
                 result = self->Items[self->Head];
@@ -155,7 +216,7 @@ void* CreatorQueue_Dequeue(CreatorQueue self)
                 self->Head = (self->Head + 1) % self->Size;
                 dequeuedItem = true;
             }
-            CreatorSemaphore_Release(self->QueueLock, 1);
+            CreatorMutex_Unlock(self->QueueLock);
             if (self->WaitForItem && !dequeuedItem)
             {
                 CreatorSemaphore_Wait(self->WaitForItem, 1);
@@ -168,13 +229,17 @@ void* CreatorQueue_Dequeue(CreatorQueue self)
 void* CreatorQueue_DequeueWaitFor(CreatorQueue self, uint milliseconds)
 {
     void* result = NULL;
-    if (self)
+    if (self && self->LockFree)
+    {
+        result = LockFreeDequeue(self, false, milliseconds);
+    }
+    else if (self)
     {
         bool dequeuedItem = false;
         int count = 0;
         do
         {
-            CreatorSemaphore_Wait(self->QueueLock, 1);
+            CreatorMutex_Lock(self->QueueLock);
             if (self->Used > 0)
             {
                 result = self->Items[self->Head];
@@ -182,7 +247,7 @@ void* CreatorQueue_DequeueWaitFor(CreatorQueue self, uint milliseconds)
                 self->Head = (self->Head + 1) % self->Size;
                 dequeuedItem = true;
             }
-            CreatorSemaphore_Release(self->QueueLock, 1);
+            CreatorMutex_Unlock(self->QueueLock);
             if (self->WaitForItem && !dequeuedItem && (count == 0))
             {
                 CreatorSemaphore_WaitFor(self->WaitForItem, 1, milliseconds);
@@ -196,11 +261,19 @@ void* CreatorQueue_DequeueWaitFor(CreatorQueue self, uint milliseconds)
 int CreatorQueue_GetCount(CreatorQueue self)
 {
     int result = 0;
-    if (self)
+    if (self && self->LockFree)
     {
-        CreatorSemaphore_Wait(self->QueueLock, 1);
+        uint dequeuePosition = __atomic_load_n(&self->DequeuePosition, __ATOMIC_ACQUIRE);
+        uint enqueuePosition = __atomic_load_n(&self->EnqueuePosition, __ATOMIC_ACQUIRE);
+        result = (int)(enqueuePosition - dequeuePosition);
+        if (result < 0)
+            result = 0;
+    }
+    else if (self)
+    {
+        CreatorMutex_Lock(self->QueueLock);
         result = self->Used;
-        CreatorSemaphore_Release(self->QueueLock, 1);
+        CreatorMutex_Unlock(self->QueueLock);
     }
     return result;
 }
@@ -218,8 +291,112 @@ void CreatorQueue_Free(CreatorQueue *self)
             CreatorThread_SleepMilliseconds(NULL, 1);
             CreatorSemaphore_Free(&waitForItem);
         }
-        CreatorSemaphore_Free(&queue->QueueLock);
-        Creator_MemFree((void **)&queue->Items);
+        if (queue->QueueLock)
+            CreatorMutex_Free(&queue->QueueLock);
+        if (queue->Items)
+            Creator_MemFree((void **)&queue->Items);
+        if (queue->Cells)
+            Creator_MemFree((void **)&queue->Cells);
         Creator_MemFree((void **)self);
     }
 }
+
+static void *LockFreeDequeue(CreatorQueue self, bool wait, uint milliseconds)
+{
+    void *result = NULL;
+    bool dequeuedItem = LockFreeTryDequeue(self, &result);
+    int count = 0;
+    while (!dequeuedItem && self->WaitForItem && (wait || (count < 1)))
+    {
+        // Register as a waiter before re-checking so an enqueue can never slip between the check and the wait
+        __atomic_fetch_add(&self->Waiters, 1, __ATOMIC_SEQ_CST);
+        dequeuedItem = LockFreeTryDequeue(self, &result);
+        if (!dequeuedItem && self->WaitForItem)
+        {
+            if (wait)
+                CreatorSemaphore_Wait(self->WaitForItem, 1);
+            else
+                CreatorSemaphore_WaitFor(self->WaitForItem, 1, milliseconds);
+            dequeuedItem = LockFreeTryDequeue(self, &result);
+        }
+        __atomic_fetch_sub(&self->Waiters, 1, __ATOMIC_SEQ_CST);
+        count++;
+    }
+    return result;
+}
+
+static bool LockFreeEnqueue(CreatorQueue self, void *item)
+{
+    bool result = false;
+    LockFreeCell *cell;
+    uint position = __atomic_load_n(&self->EnqueuePosition, __ATOMIC_RELAXED);
+    for (;;)
+    {
+        cell = &self->Cells[position & self->Mask];
+        uint sequence = __atomic_load_n(&cell->Sequence, __ATOMIC_ACQUIRE);
+        int difference = (int)(sequence - position);
+        if (difference == 0)
+        {
+            if (__atomic_compare_exchange_n(&self->EnqueuePosition, &position, position + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                result = true;
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            // Full
+            break;
+        }
+        else
+        {
+            position = __atomic_load_n(&self->EnqueuePosition, __ATOMIC_RELAXED);
+        }
+    }
+    if (result)
+    {
+        cell->Item = item;
+        __atomic_store_n(&cell->Sequence, position + 1, __ATOMIC_RELEASE);
+        // Only touch the semaphore when a consumer is (about to be) blocked on an empty queue
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&self->Waiters, __ATOMIC_RELAXED) > 0 && self->WaitForItem)
+            CreatorSemaphore_Release(self->WaitForItem, 1);
+    }
+    return result;
+}
+
+static bool LockFreeTryDequeue(CreatorQueue self, void **item)
+{
+    bool result = false;
+    LockFreeCell *cell;
+    uint position = __atomic_load_n(&self->DequeuePosition, __ATOMIC_RELAXED);
+    for (;;)
+    {
+        cell = &self->Cells[position & self->Mask];
+        uint sequence = __atomic_load_n(&cell->Sequence, __ATOMIC_ACQUIRE);
+        int difference = (int)(sequence - (position + 1));
+        if (difference == 0)
+        {
+            if (__atomic_compare_exchange_n(&self->DequeuePosition, &position, position + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                result = true;
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            // Empty
+            break;
+        }
+        else
+        {
+            position = __atomic_load_n(&self->DequeuePosition, __ATOMIC_RELAXED);
+        }
+    }
+    if (result)
+    {
+        *item = cell->Item;
+        __atomic_store_n(&cell->Sequence, position + self->Mask + 1, __ATOMIC_RELEASE);
+    }
+    return result;
+}
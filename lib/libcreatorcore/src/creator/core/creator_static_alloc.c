@@ -0,0 +1,110 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+
+/*! \file creator_static_alloc.c
+ *  \brief LibCreatorCore fixed-block pools in static storage, see creator_static_alloc.h.
+ */
+
+#include <string.h>
+
+#include "creator/core/creator_static_alloc.h"
+
+#ifdef FREERTOS
+#include "FreeRTOS.h"
+#include "task.h"
+// Pools are short scans of a few bytes, a critical section is cheaper than a CreatorMutex (which itself allocates)
+#define LOCK_POOLS()        taskENTER_CRITICAL()
+#define UNLOCK_POOLS()      taskEXIT_CRITICAL()
+#else
+#include <pthread.h>
+static pthread_mutex_t _PoolLock = PTHREAD_MUTEX_INITIALIZER;
+#define LOCK_POOLS()        pthread_mutex_lock(&_PoolLock)
+#define UNLOCK_POOLS()      pthread_mutex_unlock(&_PoolLock)
+#endif
+
+void *CreatorStaticPool_Alloc(CreatorStaticPool *self)
+{
+    void *result = NULL;
+    if (self)
+    {
+        LOCK_POOLS();
+        if (self->UsedCount < self->BlockCount)
+        {
+            unsigned int index;
+            for (index = 0; index < self->BlockCount; index++)
+            {
+                if (!self->InUse[index])
+                {
+                    self->InUse[index] = 1;
+                    self->UsedCount++;
+                    if (self->UsedCount > self->PeakCount)
+                        self->PeakCount = self->UsedCount;
+                    result = self->Blocks + (index * self->BlockSize);
+                    break;
+                }
+            }
+        }
+        else
+        {
+            self->FailedCount++;
+        }
+        UNLOCK_POOLS();
+    }
+    return result;
+}
+
+bool CreatorStaticPool_Contains(const CreatorStaticPool *self, const void *block)
+{
+    const uint8_t *address = (const uint8_t *)block;
+    return self && address && (address >= self->Blocks) && (address < self->Blocks + (self->BlockCount * self->BlockSize));
+}
+
+bool CreatorStaticPool_Free(CreatorStaticPool *self, void *block)
+{
+    bool result = false;
+    if (CreatorStaticPool_Contains(self, block))
+    {
+        unsigned int index = (unsigned int)(((uint8_t *)block - self->Blocks) / self->BlockSize);
+        LOCK_POOLS();
+        if (self->InUse[index])
+        {
+            self->InUse[index] = 0;
+            self->UsedCount--;
+        }
+        UNLOCK_POOLS();
+        result = true;
+    }
+    return result;
+}
+
+void CreatorStaticPool_GetStatistics(const CreatorStaticPool *self, CreatorStaticPoolStatistics *statistics)
+{
+    if (self && statistics)
+    {
+        LOCK_POOLS();
+        statistics->BlockCount = self->BlockCount;
+        statistics->UsedCount = self->UsedCount;
+        statistics->PeakCount = self->PeakCount;
+        statistics->FailedCount = self->FailedCount;
+        UNLOCK_POOLS();
+    }
+}
@@ -25,27 +25,87 @@
  */
 
 #include "creator/core/base_types.h"
-#include "creator/core/creator_queue.h"
-#include "creator/core/creator_list.h"
 #include "creator/core/creator_memalloc.h"
+#include "creator/core/creator_random.h"
 #include "creator/core/creator_threading.h"
 #include "creator/core/creator_threadpool.h"
+#include "creator/core/creator_timer.h"
 #include <string.h>
 #include <stdint.h>
 #include <stdio.h>
 
-typedef struct
+#define INITIAL_DEQUE_SIZE      (8)
+#define MAX_PENDING_WAKEUPS     (0x7FFF)
+#define IDLE_WAIT_TIME          (2000)
+#define TASK_BLOCK_SIZE         (16)
+
+typedef struct ThreadPoolTask
 {
     CreatorThreadPool_Callback Runnable;
     void *RunnableContext;
+    struct ThreadPoolTask *Next;
 } ThreadPoolTask;
 
+/*
+ * Task nodes are owned by the pool and recycled through a free list. Blocks of nodes are only allocated when the
+ * free list runs dry, so submitting a task does not touch the heap in steady state.
+ */
+typedef struct ThreadPoolTaskBlock
+{
+    struct ThreadPoolTaskBlock *Next;
+    ThreadPoolTask Tasks[TASK_BLOCK_SIZE];
+} ThreadPoolTaskBlock;
+
+/*
+ * A future is shared by the submitter and the queued task, each holds a reference and the last one to let go frees
+ * it. Continuations are called outside the lock so they can wait on or submit other futures.
+ */
+typedef struct FutureImpl
+{
+    CreatorMutex Lock;
+    CreatorCondition Finished;
+    CreatorFuture_Callback Runnable;
+    void *RunnableContext;
+    void *Result;
+    CreatorFutureState State;
+    CreatorFuture_Continuation Continuation;
+    void *ContinuationContext;
+    uint References;
+} Future;
+
+struct ThreadPoolImpl;
 
+/*
+ * Each worker owns a deque of tasks. The owner pushes and pops at the tail (LIFO, cache friendly), idle workers steal
+ * from the head of a random victim (FIFO, oldest task first). Every deque has its own lock so workers only contend
+ * when they actually touch the same deque.
+ */
 typedef struct
 {
-    CreatorQueue Tasks;
-    CreatorList Threads;
-    CreatorSemaphore Lock;
+    struct ThreadPoolImpl *ThreadPool;
+    CreatorThread Thread;
+    uint ThreadID;
+    bool Started;
+    CreatorMutex DequeLock;
+    ThreadPoolTask **Tasks;
+    uint Size;                  // always a power of two
+    uint Head;
+    uint Tail;
+    uint Used;
+    uint RandomState;
+} ThreadPoolWorker;
+
+typedef struct ThreadPoolImpl
+{
+    ThreadPoolWorker *Workers;
+    CreatorMutex Lock;
+    CreatorSemaphore WorkAvailable;
+    CreatorMutex FreeTasksLock;
+    ThreadPoolTask *FreeTasks;
+    ThreadPoolTaskBlock *TaskBlocks;
+    uint ThreadCount;
+    uint IdleCount;
+    uint NextWorker;
     uint MinThreads;
     uint MaxThreads;
     uint Priority;
@@ -54,41 +114,40 @@ typedef struct
 } ThreadPool;
 
 static void executeTask(CreatorThread thread, void *context);
+static bool CancelFuture(Future *future);
+static void FinishFuture(Future *future, CreatorFutureState state, void *result);
+static void ReleaseFuture(Future *future);
+static void RunFuture(void *context);
+static uint AllocateTasks(ThreadPool *threadPool, ThreadPoolTask **tasks, uint count);
+static void FreeTasks(ThreadPool *threadPool, ThreadPoolTask *tasks);
+static void FreeThreadPool(ThreadPool *threadPool);
+static ThreadPoolWorker *GetAddWorker(ThreadPool *threadPool);
+static ThreadPoolWorker *GetCurrentWorker(ThreadPool *threadPool);
+static ThreadPoolTask *PopTask(ThreadPoolWorker *worker);
+static bool PushTask(ThreadPoolWorker *worker, ThreadPoolTask *task);
+static ThreadPoolTask *StealTask(ThreadPool *threadPool, ThreadPoolWorker *thief);
+static void StartWorkers(ThreadPool *threadPool);
 
 void CreatorThreadPool_Free(CreatorThreadPool *self)
 {
     if (self && *self)
     {
         ThreadPool *threadPool = *self;
-        int count = 0;
+        uint count;
+        CreatorMutex_Lock(threadPool->Lock);
         threadPool->Terminate = true;
-        if (threadPool->Lock)
-        {
-            CreatorSemaphore_Wait(threadPool->Lock, 1);
-            if (threadPool->Threads)
-                count = CreatorList_GetCount(threadPool->Threads);
-            CreatorSemaphore_Release(threadPool->Lock, 1);
-        }
-        if (threadPool->Tasks)
+        count = threadPool->ThreadCount;
+        if (count > 0)
         {
-            ThreadPoolTask *task = CreatorQueue_DequeueWaitFor(threadPool->Tasks, 1);
-            while (task != NULL)
-            {
-                Creator_MemFree((void **)&task);
-                task = CreatorQueue_DequeueWaitFor(threadPool->Tasks, 1);
-            }
-            CreatorQueue_Free(&threadPool->Tasks);
+            // Wake every worker, the last one to exit releases the pool
+            CreatorSemaphore_Release(threadPool->WorkAvailable, count);
         }
-        if (threadPool->Threads && (count == 0))
+        CreatorMutex_Unlock(threadPool->Lock);
+        if (count == 0)
         {
-            CreatorList_Free(&threadPool->Threads, false);
+            FreeThreadPool(threadPool);
         }
-        if (threadPool->Lock && (count == 0))
-            CreatorSemaphore_Free(&threadPool->Lock);
-        if (count == 0)
-            Creator_MemFree(self);
-        else
-            self = NULL;
+        *self = NULL;
     }
 }
 
@@ -100,36 +159,44 @@ CreatorThreadPool CreatorThreadPool_New(uint minThreads, uint maxThreads, uint p
     {
         memset(threadPool, 0, sizeof(ThreadPool));
         bool failed = false;
-        threadPool->Lock = CreatorSemaphore_New(1, 0);
-        if (threadPool->Lock)
+        if (minThreads < 1)
+            minThreads = 1;
+        if (maxThreads < minThreads)
+            maxThreads = minThreads;
+        threadPool->MinThreads = minThreads;
+        threadPool->MaxThreads = maxThreads;
+        threadPool->Priority = priority;
+        threadPool->StackSize = stackSize;
+        threadPool->Lock = CreatorMutex_New();
+        threadPool->WorkAvailable = CreatorSemaphore_New(MAX_PENDING_WAKEUPS, MAX_PENDING_WAKEUPS);
+        threadPool->FreeTasksLock = CreatorMutex_New();
+        threadPool->Workers = (ThreadPoolWorker*)Creator_MemAlloc(sizeof(ThreadPoolWorker) * maxThreads);
+        if (threadPool->Workers)
+            memset(threadPool->Workers, 0, sizeof(ThreadPoolWorker) * maxThreads);
+        if (threadPool->Lock && threadPool->WorkAvailable && threadPool->FreeTasksLock && threadPool->Workers)
         {
-            threadPool->Tasks = CreatorQueue_NewBlocking(10);
-            if (threadPool->Tasks)
+            // All deques exist up front (threads are started on demand) so that stealing never races with creation
+            uint index;
+            for (index = 0; index < maxThreads && !failed; index++)
             {
-                threadPool->Threads = CreatorList_New(maxThreads);
-                if (threadPool->Threads)
-                {
-                    if (minThreads < 1)
-                        minThreads = 1;
-                    if (maxThreads < minThreads)
-                        maxThreads = minThreads;
-                    threadPool->MinThreads = minThreads;
-                    threadPool->MaxThreads = maxThreads;
-                    threadPool->Priority = priority;
-                    threadPool->StackSize = stackSize;
-                    result = threadPool;
-                }
+                ThreadPoolWorker *worker = &threadPool->Workers[index];
+                worker->ThreadPool = threadPool;
+                worker->RandomState = (uint)Creator_GetRandom() | 1;
+                worker->DequeLock = CreatorMutex_New();
+                worker->Tasks = (ThreadPoolTask**)Creator_MemAlloc(sizeof(ThreadPoolTask*) * INITIAL_DEQUE_SIZE);
+                if (worker->DequeLock && worker->Tasks)
+                    worker->Size = INITIAL_DEQUE_SIZE;
                 else
                     failed = true;
             }
-            else
-                failed = true;
+            if (!failed)
+                result = threadPool;
         }
         else
             failed = true;
         if (failed)
         {
-            CreatorThreadPool_Free((CreatorThreadPool) & threadPool);
+            FreeThreadPool(threadPool);
         }
     }
     return result;
@@ -137,62 +204,531 @@ CreatorThreadPool CreatorThreadPool_New(uint minThreads, uint maxThreads, uint p
 
 bool CreatorThreadPool_AddTask(CreatorThreadPool self, CreatorThreadPool_Callback runnable, void *context)
 {
-    bool result = false;
+    return (CreatorThreadPool_AddTasks(self, &runnable, &context, 1) == 1);
+}
+
+uint CreatorThreadPool_AddTasks(CreatorThreadPool self, CreatorThreadPool_Callback *runnables, void **contexts, uint count)
+{
+    uint result = 0;
     ThreadPool *threadPool = self;
-    if (threadPool && runnable && !threadPool->Terminate)
+    if (threadPool && runnables && (count > 0) && !threadPool->Terminate)
     {
-        ThreadPoolTask *task = (ThreadPoolTask*)Creator_MemAlloc(sizeof(ThreadPoolTask));
-        if (task)
+        ThreadPoolTask *tasks = NULL;
+        uint allocated = AllocateTasks(threadPool, &tasks, count);
+        uint index;
+        for (index = 0; (index < allocated) && tasks; index++)
         {
-            task->Runnable = runnable;
-            task->RunnableContext = context;
-            if (CreatorQueue_Enqueue(threadPool->Tasks, task))
+            ThreadPoolTask *task = tasks;
+            tasks = task->Next;
+            task->Next = NULL;
+            task->Runnable = runnables[index];
+            task->RunnableContext = contexts ? contexts[index] : NULL;
+            if (!task->Runnable || !PushTask(GetAddWorker(threadPool), task))
             {
-                result = true;
-                int count = CreatorList_GetCount(threadPool->Threads);
-                if (count < threadPool->MinThreads)
-                {
-                    CreatorSemaphore_Wait(threadPool->Lock, 1);
-                    count = CreatorList_GetCount(threadPool->Threads);
-                    if (count < threadPool->MinThreads)
-                    {
-                        CreatorThread thread = CreatorThread_New("ThreadPool", threadPool->Priority, threadPool->StackSize, executeTask, threadPool);
-                        if (thread)
-                            CreatorList_Add(threadPool->Threads, thread);
-                    }
-                    CreatorSemaphore_Release(threadPool->Lock, 1);
-                }
+                task->Next = tasks;
+                tasks = task;
+                break;
             }
+            result++;
+        }
+        if (tasks)
+            FreeTasks(threadPool, tasks);
+        if (result > 0)
+        {
+            // One wakeup call for the whole batch
+            CreatorSemaphore_Release(threadPool->WorkAvailable, result);
+            StartWorkers(threadPool);
         }
     }
     return result;
 }
 
+CreatorFuture CreatorThreadPool_Submit(CreatorThreadPool self, CreatorFuture_Callback runnable, void *context)
+{
+    Future *result = NULL;
+    if (self && runnable)
+    {
+        result = (Future*)Creator_MemAlloc(sizeof(Future));
+        if (result)
+        {
+            memset(result, 0, sizeof(Future));
+            result->Lock = CreatorMutex_New();
+            result->Finished = CreatorCondition_New();
+            result->Runnable = runnable;
+            result->RunnableContext = context;
+            result->State = CreatorFutureState_Pending;
+            result->References = 2;
+            if (!result->Lock || !result->Finished || !CreatorThreadPool_AddTask(self, RunFuture, result))
+            {
+                result->References = 1;
+                CreatorFuture_Free((CreatorFuture *)&result);
+            }
+        }
+    }
+    return (CreatorFuture)result;
+}
+
+bool CreatorFuture_Cancel(CreatorFuture self)
+{
+    bool result = false;
+    if (self)
+    {
+        result = CancelFuture((Future*)self);
+    }
+    return result;
+}
+
+void CreatorFuture_Free(CreatorFuture *self)
+{
+    if (self && *self)
+    {
+        ReleaseFuture((Future*)*self);
+        *self = NULL;
+    }
+}
+
+void *CreatorFuture_GetResult(CreatorFuture self)
+{
+    void *result = NULL;
+    Future *future = self;
+    if (future)
+    {
+        CreatorMutex_Lock(future->Lock);
+        if (future->State == CreatorFutureState_Completed)
+            result = future->Result;
+        CreatorMutex_Unlock(future->Lock);
+    }
+    return result;
+}
+
+CreatorFutureState CreatorFuture_GetState(CreatorFuture self)
+{
+    CreatorFutureState result = CreatorFutureState_Cancelled;
+    Future *future = self;
+    if (future)
+    {
+        CreatorMutex_Lock(future->Lock);
+        result = future->State;
+        CreatorMutex_Unlock(future->Lock);
+    }
+    return result;
+}
+
+bool CreatorFuture_SetContinuation(CreatorFuture self, CreatorFuture_Continuation continuation, void *context)
+{
+    bool result = false;
+    Future *future = self;
+    if (future && continuation)
+    {
+        bool finished;
+        CreatorMutex_Lock(future->Lock);
+        finished = (future->State == CreatorFutureState_Completed) || (future->State == CreatorFutureState_Cancelled);
+        if (!future->Continuation)
+        {
+            if (!finished)
+            {
+                future->Continuation = continuation;
+                future->ContinuationContext = context;
+            }
+            result = true;
+        }
+        CreatorMutex_Unlock(future->Lock);
+        if (result && finished)
+        {
+            continuation(self, context);
+        }
+    }
+    return result;
+}
+
+bool CreatorFuture_Wait(CreatorFuture self)
+{
+    bool result = false;
+    Future *future = self;
+    if (future)
+    {
+        CreatorMutex_Lock(future->Lock);
+        while ((future->State == CreatorFutureState_Pending) || (future->State == CreatorFutureState_Running))
+        {
+            CreatorCondition_Wait(future->Finished, future->Lock);
+        }
+        result = (future->State == CreatorFutureState_Completed);
+        CreatorMutex_Unlock(future->Lock);
+    }
+    return result;
+}
+
+bool CreatorFuture_WaitFor(CreatorFuture self, uint milliseconds)
+{
+    bool result = false;
+    Future *future = self;
+    if (future)
+    {
+        uint ticksPerSecond = CreatorTimer_GetTicksPerSecond();
+        uint startTick = CreatorTimer_GetTickCount();
+        CreatorMutex_Lock(future->Lock);
+        while ((future->State == CreatorFutureState_Pending) || (future->State == CreatorFutureState_Running))
+        {
+            uint elapsed = (uint)(((uint64)(CreatorTimer_GetTickCount() - startTick) * 1000) / ticksPerSecond);
+            if ((elapsed >= milliseconds) || !CreatorCondition_WaitFor(future->Finished, future->Lock, milliseconds - elapsed))
+                break;
+        }
+        result = (future->State == CreatorFutureState_Completed);
+        CreatorMutex_Unlock(future->Lock);
+    }
+    return result;
+}
+
 void executeTask(CreatorThread thread, void *context)
 {
-    ThreadPool *threadPool = context;
-    if (threadPool)
+    ThreadPoolWorker *worker = context;
+    if (worker)
     {
+        ThreadPool *threadPool = worker->ThreadPool;
+        worker->ThreadID = CreatorThread_GetThreadID(NULL);
         while (!threadPool->Terminate)
         {
-            ThreadPoolTask *task = CreatorQueue_DequeueWaitFor(threadPool->Tasks, 2000);
+            ThreadPoolTask *task = PopTask(worker);
+            if (!task)
+                task = StealTask(threadPool, worker);
             if (task)
             {
+                CreatorThreadPool_Callback runnable = task->Runnable;
+                void *runnableContext = task->RunnableContext;
+                FreeTasks(threadPool, task);
                 CreatorThread_ClearLastError();
-                task->Runnable(task->RunnableContext);
-                Creator_MemFree((void **)&task);
+                runnable(runnableContext);
+            }
+            else
+            {
+                CreatorMutex_Lock(threadPool->Lock);
+                threadPool->IdleCount++;
+                CreatorMutex_Unlock(threadPool->Lock);
+                CreatorSemaphore_WaitFor(threadPool->WorkAvailable, 1, IDLE_WAIT_TIME);
+                CreatorMutex_Lock(threadPool->Lock);
+                threadPool->IdleCount--;
+                CreatorMutex_Unlock(threadPool->Lock);
             }
         }
-        CreatorSemaphore_Wait(threadPool->Lock, 1);
-        CreatorList_Remove(threadPool->Threads, thread);
-        int count = CreatorList_GetCount(threadPool->Threads);
-        CreatorSemaphore_Release(threadPool->Lock, 1);
+        CreatorMutex_Lock(threadPool->Lock);
+        worker->Thread = NULL;
+        worker->Started = false;
+        uint count = --threadPool->ThreadCount;
+        CreatorMutex_Unlock(threadPool->Lock);
         if (count == 0)
         {
-            CreatorList_Free(&threadPool->Threads, false);
-            CreatorSemaphore_Free(&threadPool->Lock);
-            Creator_MemFree((void **)&threadPool);
+            FreeThreadPool(threadPool);
         }
     }
     CreatorThread_Free(&thread);
 }
+
+static uint AllocateTasks(ThreadPool *threadPool, ThreadPoolTask **tasks, uint count)
+{
+    uint result = 0;
+    ThreadPoolTask *last = NULL;
+    CreatorMutex_Lock(threadPool->FreeTasksLock);
+    while (result < count)
+    {
+        if (!threadPool->FreeTasks)
+        {
+            ThreadPoolTaskBlock *block = (ThreadPoolTaskBlock*)Creator_MemAlloc(sizeof(ThreadPoolTaskBlock));
+            if (!block)
+                break;
+            uint index;
+            for (index = 0; index < TASK_BLOCK_SIZE; index++)
+            {
+                block->Tasks[index].Next = threadPool->FreeTasks;
+                threadPool->FreeTasks = &block->Tasks[index];
+            }
+            block->Next = threadPool->TaskBlocks;
+            threadPool->TaskBlocks = block;
+        }
+        ThreadPoolTask *task = threadPool->FreeTasks;
+        threadPool->FreeTasks = task->Next;
+        task->Next = NULL;
+        if (last)
+            last->Next = task;
+        else
+            *tasks = task;
+        last = task;
+        result++;
+    }
+    CreatorMutex_Unlock(threadPool->FreeTasksLock);
+    return result;
+}
+
+static bool CancelFuture(Future *future)
+{
+    bool result = false;
+    CreatorMutex_Lock(future->Lock);
+    if (future->State == CreatorFutureState_Pending)
+    {
+        // The queued task still holds its reference and drops it when it is dequeued
+        FinishFuture(future, CreatorFutureState_Cancelled, NULL);
+        result = true;
+    }
+    else
+    {
+        CreatorMutex_Unlock(future->Lock);
+    }
+    return result;
+}
+
+/*
+ * must be called with the future locked, returns with it unlocked
+ */
+static void FinishFuture(Future *future, CreatorFutureState state, void *result)
+{
+    CreatorFuture_Continuation continuation = future->Continuation;
+    void *continuationContext = future->ContinuationContext;
+    future->Result = result;
+    future->State = state;
+    future->Continuation = NULL;
+    CreatorCondition_Broadcast(future->Finished);
+    CreatorMutex_Unlock(future->Lock);
+    if (continuation)
+    {
+        continuation((CreatorFuture)future, continuationContext);
+    }
+}
+
+static void ReleaseFuture(Future *future)
+{
+    uint references;
+    CreatorMutex_Lock(future->Lock);
+    references = --future->References;
+    CreatorMutex_Unlock(future->Lock);
+    if (references == 0)
+    {
+        if (future->Finished)
+            CreatorCondition_Free(&future->Finished);
+        if (future->Lock)
+            CreatorMutex_Free(&future->Lock);
+        Creator_MemFree((void **)&future);
+    }
+}
+
+static void RunFuture(void *context)
+{
+    Future *future = context;
+    bool run;
+    CreatorMutex_Lock(future->Lock);
+    run = (future->State == CreatorFutureState_Pending);
+    if (run)
+        future->State = CreatorFutureState_Running;
+    CreatorMutex_Unlock(future->Lock);
+    if (run)
+    {
+        void *result = future->Runnable(future->RunnableContext);
+        CreatorMutex_Lock(future->Lock);
+        FinishFuture(future, CreatorFutureState_Completed, result);
+    }
+    ReleaseFuture(future);
+}
+
+static void FreeTasks(ThreadPool *threadPool, ThreadPoolTask *tasks)
+{
+    ThreadPoolTask *last = tasks;
+    while (last->Next)
+        last = last->Next;
+    CreatorMutex_Lock(threadPool->FreeTasksLock);
+    last->Next = threadPool->FreeTasks;
+    threadPool->FreeTasks = tasks;
+    CreatorMutex_Unlock(threadPool->FreeTasksLock);
+}
+
+static void FreeThreadPool(ThreadPool *threadPool)
+{
+    // Pending tasks are dropped, their nodes are released with the task blocks. Futures that never ran are cancelled
+    // so nobody is left waiting on them.
+    if (threadPool->Workers)
+    {
+        uint index;
+        for (index = 0; index < threadPool->MaxThreads; index++)
+        {
+            ThreadPoolWorker *worker = &threadPool->Workers[index];
+            while (worker->Used > 0)
+            {
+                ThreadPoolTask *task = PopTask(worker);
+                if (task->Runnable == RunFuture)
+                {
+                    CancelFuture(task->RunnableContext);
+                    ReleaseFuture(task->RunnableContext);
+                }
+            }
+        }
+    }
+    while (threadPool->TaskBlocks)
+    {
+        ThreadPoolTaskBlock *block = threadPool->TaskBlocks;
+        threadPool->TaskBlocks = block->Next;
+        Creator_MemFree((void **)&block);
+    }
+    if (threadPool->Workers)
+    {
+        uint index;
+        for (index = 0; index < threadPool->MaxThreads; index++)
+        {
+            ThreadPoolWorker *worker = &threadPool->Workers[index];
+            if (worker->Tasks)
+                Creator_MemFree((void **)&worker->Tasks);
+            if (worker->DequeLock)
+                CreatorMutex_Free(&worker->DequeLock);
+        }
+        Creator_MemFree((void **)&threadPool->Workers);
+    }
+    if (threadPool->FreeTasksLock)
+        CreatorMutex_Free(&threadPool->FreeTasksLock);
+    if (threadPool->WorkAvailable)
+        CreatorSemaphore_Free(&threadPool->WorkAvailable);
+    if (threadPool->Lock)
+        CreatorMutex_Free(&threadPool->Lock);
+    Creator_MemFree((void **)&threadPool);
+}
+
+static ThreadPoolWorker *GetAddWorker(ThreadPool *threadPool)
+{
+    // Tasks spawned from a pool thread stay local, others are spread round robin over the running workers
+    ThreadPoolWorker *result = GetCurrentWorker(threadPool);
+    if (!result)
+    {
+        uint count = threadPool->ThreadCount;
+        if (count == 0)
+            count = 1;
+        result = &threadPool->Workers[threadPool->NextWorker++ % count];
+    }
+    return result;
+}
+
+static ThreadPoolWorker *GetCurrentWorker(ThreadPool *threadPool)
+{
+    ThreadPoolWorker *result = NULL;
+    if (threadPool->ThreadCount > 0)
+    {
+        uint threadID = CreatorThread_GetThreadID(NULL);
+        uint index;
+        for (index = 0; index < threadPool->MaxThreads; index++)
+        {
+            ThreadPoolWorker *worker = &threadPool->Workers[index];
+            if (worker->Started && worker->ThreadID == threadID)
+            {
+                result = worker;
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+static ThreadPoolTask *PopTask(ThreadPoolWorker *worker)
+{
+    ThreadPoolTask *result = NULL;
+    if (worker->Used > 0)
+    {
+        CreatorMutex_Lock(worker->DequeLock);
+        if (worker->Used > 0)
+        {
+            worker->Tail = (worker->Tail - 1) & (worker->Size - 1);
+            result = worker->Tasks[worker->Tail];
+            worker->Used--;
+        }
+        CreatorMutex_Unlock(worker->DequeLock);
+    }
+    return result;
+}
+
+static bool PushTask(ThreadPoolWorker *worker, ThreadPoolTask *task)
+{
+    bool result = false;
+    CreatorMutex_Lock(worker->DequeLock);
+    if (worker->Used == worker->Size)
+    {
+        uint newSize = worker->Size * 2;
+        ThreadPoolTask **newTasks = (ThreadPoolTask**)Creator_MemAlloc(sizeof(ThreadPoolTask*) * newSize);
+        if (newTasks)
+        {
+            uint index;
+            for (index = 0; index < worker->Used; index++)
+            {
+                newTasks[index] = worker->Tasks[(worker->Head + index) & (worker->Size - 1)];
+            }
+            Creator_MemFree((void **)&worker->Tasks);
+            worker->Tasks = newTasks;
+            worker->Head = 0;
+            worker->Tail = worker->Used;
+            worker->Size = newSize;
+        }
+    }
+    if (worker->Used < worker->Size)
+    {
+        worker->Tasks[worker->Tail] = task;
+        worker->Tail = (worker->Tail + 1) & (worker->Size - 1);
+        worker->Used++;
+        result = true;
+    }
+    CreatorMutex_Unlock(worker->DequeLock);
+    return result;
+}
+
+static ThreadPoolTask *StealTask(ThreadPool *threadPool, ThreadPoolWorker *thief)
+{
+    ThreadPoolTask *result = NULL;
+    uint count = threadPool->MaxThreads;
+    // xorshift - cheap per worker random victim selection
+    uint random = thief->RandomState;
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    thief->RandomState = random;
+    uint attempt;
+    for (attempt = 0; attempt < count && !result; attempt++)
+    {
+        ThreadPoolWorker *victim = &threadPool->Workers[(random + attempt) % count];
+        if (victim != thief && victim->Used > 0)
+        {
+            CreatorMutex_Lock(victim->DequeLock);
+            if (victim->Used > 0)
+            {
+                result = victim->Tasks[victim->Head];
+                victim->Head = (victim->Head + 1) & (victim->Size - 1);
+                victim->Used--;
+            }
+            CreatorMutex_Unlock(victim->DequeLock);
+        }
+    }
+    return result;
+}
+
+static void StartWorkers(ThreadPool *threadPool)
+{
+    // Grow while below the minimum, or on demand up to the maximum when no worker is idle
+    if ((threadPool->ThreadCount < threadPool->MinThreads)
+            || ((threadPool->IdleCount == 0) && (threadPool->ThreadCount < threadPool->MaxThreads)))
+    {
+        CreatorMutex_Lock(threadPool->Lock);
+        if (!threadPool->Terminate && ((threadPool->ThreadCount < threadPool->MinThreads)
+                || ((threadPool->IdleCount == 0) && (threadPool->ThreadCount < threadPool->MaxThreads))))
+        {
+            uint index;
+            for (index = 0; index < threadPool->MaxThreads; index++)
+            {
+                ThreadPoolWorker *worker = &threadPool->Workers[index];
+                if (!worker->Started)
+                {
+                    worker->Started = true;
+                    worker->ThreadID = 0;
+                    threadPool->ThreadCount++;
+                    worker->Thread = CreatorThread_New("ThreadPool", threadPool->Priority, threadPool->StackSize, executeTask, worker);
+                    if (!worker->Thread)
+                    {
+                        worker->Started = false;
+                        threadPool->ThreadCount--;
+                    }
+                    break;
+                }
+            }
+        }
+        CreatorMutex_Unlock(threadPool->Lock);
+    }
+}
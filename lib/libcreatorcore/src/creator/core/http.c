@@ -36,9 +36,11 @@
 
 #include "oauth.h"
 
+#include "creator/core/creator_arena.h"
 #include "creator/core/creator_debug.h"
 #include "creator/core/creator_memalloc.h"
 #include "creator/core/creator_threading.h"
+#include "creator/core/creator_threadpool.h"
 #include "creator_threading_private.h"
 #include "creator_cache.h"
 
@@ -51,6 +53,7 @@
 #include "creator/core/creator_object_methods.h"
 #include "creator/core/creator_object_private.h"
 #include "creator/core/creator_memorymanager_methods.h"
+#include "creator/core/http_async.h"
 #include "creator/core/http_private.h"
 #include "creator/core/session_private.h"
 #include "creator/core/server_private.h"
@@ -75,24 +78,81 @@ typedef struct HTTPCallbackContextImpl
     CreatorDatetime Expires;
     CreatorHTTPStatus Status;
     CreatorErrorType Error;
+    CreatorArena Arena;         // temporaries that live for the whole call, released together
+    char *URL;                  // unescaped copy (from Arena)
+    char *Accept;               // Accept header value (from Arena)
+    CreatorHTTPMethod Method;   // method sent (PUT and DELETE are overridden to POST)
+    CreatorHTTPMethod ActualMethod;
+    struct HTTPAsyncCallImpl *AsyncCall;    // NULL for a synchronous call
 } HTTPCallbackContext;
 
+typedef enum
+{
+    HTTPAsyncCallState_Pending = 0,     // waiting for an in-flight slot
+    HTTPAsyncCallState_Starting,        // request being built (and sent) by a worker
+    HTTPAsyncCallState_InFlight,        // waiting for the response
+    HTTPAsyncCallState_Completing       // result being delivered
+} HTTPAsyncCallState;
+
+typedef struct HTTPAsyncCallImpl
+{
+    struct HTTPAsyncCallImpl *Next;
+    CreatorHTTPCallID ID;
+    HTTPAsyncCallState State;
+    bool Cancelled;
+    int AttemptCount;
+    bool UseOAuth;              // caller's thread settings, applied on the worker
+    bool UseSessionToken;
+    CreatorObject BodyData;
+    CreatorHTTP_CallCallback Callback;
+    void *CallbackContext;
+    HTTPCallbackContext Context;
+} HTTPAsyncCall;
+
+
+// The per-call arena is sized for exactly the unescaped URL and the Accept header (allocations are 8-byte aligned),
+// so it stays as small as the two separate allocations it replaces
+#define HTTP_CALL_ARENA_ALIGN(size) (((size) + 7) & ~(size_t)7)
+
+#define HTTP_ACCEPT_TYPE_COUNT (4)
+#define HTTP_ACCEPT_TERMINATOR "+xml"
+
+// Default number of asynchronous calls started at once, see CreatorHTTP_SetMaxAsyncCalls
+#ifndef HTTP_MAX_ASYNC_CALLS
+#define HTTP_MAX_ASYNC_CALLS (2)
+#endif
+
+#define HTTP_CALL_ATTEMPTS (2)
+
+static CreatorThreadPool _AsyncThreadPool = NULL;
+static CreatorMutex _AsyncLock = NULL;
+static HTTPAsyncCall *_AsyncCalls = NULL;      // pending and running calls, oldest first
+static uint _AsyncCallsRunning = 0;
+static uint _MaxAsyncCalls = HTTP_MAX_ASYNC_CALLS;
+static CreatorHTTPCallID _LastAsyncCallID = 0;
 
 /**
- * Concatenates null-terminated strings from strArray into one result buffer. Result must be freed by the caller.
+ * Concatenates null-terminated strings from strArray into one result buffer allocated from arena.
  *
+ * @param arena request arena the result is allocated from
  * @param strArray array of null-terminated mime types
  * @param arrayCount number of items in strArray
  * @param szTerminator string to be appended to each string value (e.g. +xml or +json)
  * @return a null-terminated string with mime types separated by a comma
  */
-static char *ConcatenateAcceptValues(const char **strArray, size_t arrayCount, const char *szTerminator);
+static char *ConcatenateAcceptValues(CreatorArena arena, const char **strArray, size_t arrayCount, const char *szTerminator);
+static void CompleteAsyncCall(void *context);
+static size_t GetAcceptValuesLength(const char **strArray, size_t arrayCount, const char *terminator);
+static void FreeAcceptMIMETypes(CreatorType expectedType, const char **mimes);
+static void GetAcceptMIMETypes(CreatorType expectedType, const char **mimes);
+static size_t GetUnescapedUrlLength(const char *url);
 static void DataCallback(CreatorHTTPRequest request, void *callbackContext, const char *sData, size_t dataLength);
 static void FinishCallback(CreatorHTTPRequest request, void *callbackContext, CreatorHTTPError error);
 static void HeaderCallback(CreatorHTTPRequest request, void *callbackContext, const char *headerName, size_t nameLength, const char *headerValue, size_t valueLength);
 static bool MakeOAuthSignature(const char *httpMethod, const char *url, char *dest, size_t destSize);
 static void ResultCallback(CreatorHTTPRequest request, void *callbackContext, unsigned short httpResult);
-static char *UnescapeUrl(char *url);
+static void StartAsyncCall(void *context);
+static char *UnescapeUrl(CreatorArena arena, char *url);
 
 
 static char *nstrstr(const char *haystack, const char *needle, size_t haystackLength)
@@ -168,137 +228,265 @@ void CreatorHTTP_AddAuthorizationHeader(CreatorMemoryManager memoryManager, Crea
     }
 }
 
-bool CreatorHTTP_Call(CreatorMemoryManager memoryManager, CreatorHTTPMethod httpMethod, char *url, CreatorType expectedType, CreatorObject *pResponse,
-        CreatorObject bodyData, CreatorHTTPStatus *status)
+/* Set up a call, returns false if it can't be made (no memory manager, or the URL could not be copied) */
+static bool BeginCall(HTTPCallbackContext *httpContext, CreatorMemoryManager memoryManager, CreatorHTTPMethod httpMethod, char *url,
+        CreatorType expectedType)
 {
-    bool result = false;
-    CreatorThread_ClearLastError();
-    if (pResponse)
-        *pResponse = NULL;
-    url = UnescapeUrl(url);
-    if (memoryManager && url)
+    const char *mimes[HTTP_ACCEPT_TYPE_COUNT];
+    memset(httpContext, 0, sizeof(*httpContext));
+    GetAcceptMIMETypes(expectedType, mimes);
+    httpContext->Arena = CreatorArena_New(HTTP_CALL_ARENA_ALIGN(GetUnescapedUrlLength(url)) +
+            HTTP_CALL_ARENA_ALIGN(GetAcceptValuesLength(mimes, HTTP_ACCEPT_TYPE_COUNT, HTTP_ACCEPT_TERMINATOR)), CreatorMemTag_HTTP);
+    httpContext->URL = UnescapeUrl(httpContext->Arena, url);
+    httpContext->Accept = ConcatenateAcceptValues(httpContext->Arena, mimes, HTTP_ACCEPT_TYPE_COUNT, HTTP_ACCEPT_TERMINATOR);
+    FreeAcceptMIMETypes(expectedType, mimes);
+    httpContext->MemoryManager = memoryManager;
+    httpContext->Success = true;
+    httpContext->ExpectedType = expectedType;
+    httpContext->ResponseType = CreatorType__Unknown;
+    httpContext->IsSuccessResponse = false;
+    httpContext->IsBadRequestResponse = false;
+    httpContext->HasParserError = false;
+    httpContext->Expires = 0;
+    httpContext->Status = CreatorHTTPStatus_NotSet;
+    httpContext->Error = CreatorError_NoError;
+    httpContext->ActualMethod = httpMethod;
+    httpContext->Method = httpMethod;
+    //use X-HTTP-Method-Override
+    if (httpMethod == CreatorHTTPMethod_Put || httpMethod == CreatorHTTPMethod_Delete)
     {
-        if (httpMethod == CreatorHTTPMethod_Get)
+        httpContext->Method = CreatorHTTPMethod_Post;
+    }
+    return (memoryManager && httpContext->URL);
+}
+
+static void EndCall(HTTPCallbackContext *httpContext)
+{
+    if (httpContext->Request)
+    {
+        CreatorHTTPRequest_Free(&httpContext->Request);
+    }
+    if (httpContext->Semaphore)
+    {
+        CreatorSemaphore_Free(&httpContext->Semaphore);
+    }
+    if (httpContext->Deserialiser)
+    {
+        CreatorXMLDeserialiser_Free(&httpContext->Deserialiser);
+    }
+    CreatorArena_Free(&httpContext->Arena);
+}
+
+/* Process the response (or its absence): sets the thread error, and the response object attached to the memory manager */
+static void FinishCall(HTTPCallbackContext *httpContext, CreatorObject *pResponse)
+{
+    CreatorHTTPMethod httpMethod = httpContext->Method;
+    char *url = httpContext->URL;
+    if (httpContext->IsSuccessResponse && !httpContext->HasParserError)
+    {
+        Creator_Log(CreatorLogLevel_Info, "HTTP %s %s response %u", CreatorHTTPMethod_ToString(httpMethod), url, httpContext->Status);
+    }
+
+    if (httpContext->Deserialiser)
+    {
+        CreatorObject response = CreatorXMLDeserialiser_GetObject(httpContext->Deserialiser);
+        if (response)
         {
-            CreatorObject cachedValue = CreatorCache_Get(url);
-            if (cachedValue)
+            if ((httpMethod == CreatorHTTPMethod_Get) && (httpContext->ResponseType == httpContext->ExpectedType))
             {
-                if (pResponse)
-                {
-                    *pResponse = CreatorXMLDeserialiser_NewObject(expectedType);
-                    CreatorObject_CopyFrom(*pResponse, cachedValue);
-                    if (*pResponse)
-                    {
-                        CreatorMemoryManager_AttachObject(memoryManager, *pResponse);
-                        //CreatorObject_SetJob(*pResponse,memoryManager);
-                    }
-                }
-                if (status)
-                {
-                    *status = CreatorHTTPStatus_OK; //Return HTTP status 200 if found in cache.
-                }
-                Creator_MemFree((void **)&url);
-                return true;
+                CreatorXMLDeserialiser_SetSelfLink(httpContext->Deserialiser, response, url);
             }
+            CreatorMemoryManager_AttachObject(httpContext->MemoryManager, response);
         }
-
-        CreatorHTTPMethod actualMethod = httpMethod;
-        //use X-HTTP-Method-Override
-        if (httpMethod == CreatorHTTPMethod_Put || httpMethod == CreatorHTTPMethod_Delete)
+        if (pResponse)
         {
-            httpMethod = CreatorHTTPMethod_Post;
+            *pResponse = response;
         }
+        CreatorXMLDeserialiser_Free(&httpContext->Deserialiser);
+    }
 
-        //prepare context for HTTP call
-        HTTPCallbackContext httpContext;
-        memset(&httpContext, 0, sizeof(httpContext));
-
-        httpContext.MemoryManager = memoryManager;
-        httpContext.Success = true;
-        httpContext.Semaphore = CreatorSemaphore_New(1, 1);
-        httpContext.ExpectedType = expectedType;
-        httpContext.ResponseType = CreatorType__Unknown;
-        httpContext.IsSuccessResponse = false;
-        httpContext.IsBadRequestResponse = false;
-        httpContext.HasParserError = false;
-        httpContext.Expires = 0;
-        httpContext.Status = CreatorHTTPStatus_NotSet;
-        httpContext.Error = CreatorError_NoError;
-
-        httpContext.Request = CreatorHTTPRequest_New(actualMethod, url, ResultCallback, HeaderCallback, DataCallback, FinishCallback, &httpContext);
-
-        if (httpContext.Semaphore && httpContext.Request)
+    //notify cache manager of the result
+    if (httpContext->IsSuccessResponse && !httpContext->HasParserError)
+    {
+        if ((httpMethod == CreatorHTTPMethod_Get) && CreatorThread_GetUseOAuth())
         {
-            Creator_Log(CreatorLogLevel_Debug, "HTTP %p will handle %s %s", httpContext.Request, CreatorHTTPMethod_ToString(httpMethod), url);
-
-            //add X-HTTP-Method-Override
-            if (httpMethod != actualMethod)
+            if ((httpContext->ResponseType == httpContext->ExpectedType) && (httpContext->Expires > 0))
             {
-                CreatorHTTPRequest_AddHeader(httpContext.Request, "X-HTTP-Method-Override", CreatorHTTPMethod_ToString(httpMethod));
+                if (pResponse)
+                    CreatorCache_Set(url, *pResponse, httpContext->Expires);
             }
+        }
+    }
 
-            const char *locale = CreatorClient_GetLocale();
-            if (locale && strlen(locale))
+    if (!httpContext->IsSuccessResponse)
+    {
+        if (!httpContext->HasParserError && httpContext->ResponseType == CreatorType_BadRequestResponse)
+        {
+            if (pResponse)
+            {
+                CreatorBadRequestResponse errorResponse = (CreatorBadRequestResponse) * pResponse;
+                int errorCode = CreatorBadRequestResponse_GetErrorCode(errorResponse);
+                CreatorErrorType errorType =
+                        ((errorCode - 1 + (int)CreatorError_BadRequest_Min >= CreatorError_BadRequest_Unknown) || (errorCode <= 0)) ?
+                                CreatorError_BadRequest_Unknown : (CreatorErrorType)(errorCode - 1 + (int)CreatorError_BadRequest_Min);
+                CreatorThread_SetError(errorType);
+                Creator_Log(CreatorLogLevel_Error, "HTTP %s %s response %u - failed with [%d]", CreatorHTTPMethod_ToString(httpMethod), url,
+                        httpContext->Status, errorType);
+            }
+            else
+            {
+                CreatorThread_SetError(CreatorError_BadRequest_Unknown);
+            }
+        }
+        else if (httpContext->Error == CreatorError_Server)
+        {
+            Creator_Log(CreatorLogLevel_Error, "HTTP %s %s response %u - failed (internal server error)", CreatorHTTPMethod_ToString(httpMethod), url,
+                    httpContext->Status);
+        }
+        else
+        {
+            Creator_Log(CreatorLogLevel_Error, "HTTP %s %s response %u - failed (no content returned)", CreatorHTTPMethod_ToString(httpMethod), url,
+                    httpContext->Status);
+            if (CreatorThread_GetLastError() == CreatorError_NoError)
             {
-                CreatorHTTPRequest_AddHeader(httpContext.Request, "X-Culture", locale);
+                CreatorThread_SetError((httpContext->IsBadRequestResponse) ? CreatorError_BadRequest_Unknown : CreatorError_InvalidArgument);
             }
+            httpContext->Success = false;
+        }
+    }
+}
 
-            const char *bodyContentType = CreatorClient_GetBodyContentType();
-            if (bodyContentType && strlen(bodyContentType))
+/* Answer a GET from the cache, returns false if the URL isn't cached */
+static bool GetCachedResponse(HTTPCallbackContext *httpContext, CreatorObject *pResponse)
+{
+    bool result = false;
+    if (httpContext->ActualMethod == CreatorHTTPMethod_Get)
+    {
+        CreatorObject cachedValue = CreatorCache_Get(httpContext->URL);
+        if (cachedValue)
+        {
+            if (pResponse)
             {
-                if (!strstr(bodyContentType, "xml"))
+                *pResponse = CreatorXMLDeserialiser_NewObject(httpContext->ExpectedType);
+                CreatorObject_CopyFrom(*pResponse, cachedValue);
+                if (*pResponse)
                 {
-                    CreatorHTTPRequest_AddHeader(httpContext.Request, "X-Body-Content-Type", bodyContentType);
+                    CreatorMemoryManager_AttachObject(httpContext->MemoryManager, *pResponse);
+                    //CreatorObject_SetJob(*pResponse,memoryManager);
                 }
             }
+            httpContext->Status = CreatorHTTPStatus_OK; //Return HTTP status 200 if found in cache.
+            result = true;
+        }
+    }
+    return result;
+}
 
-            char requestId[65];
-            snprintf(requestId, sizeof(requestId), "%lX", (unsigned long)httpContext.Request);
-            CreatorHTTPRequest_AddHeader(httpContext.Request, "X-Client-RequestId", requestId);
+/* Create the request with all its headers and body, returns false (and sets the thread error) if it can't be started */
+static bool PrepareRequest(HTTPCallbackContext *httpContext, CreatorObject bodyData)
+{
+    bool result = false;
+    CreatorHTTPMethod httpMethod = httpContext->Method;
+    CreatorHTTPMethod actualMethod = httpContext->ActualMethod;
+    char *url = httpContext->URL;
 
-            /* ??? TODO add Accept-Language ??? */
+    // An asynchronous call is completed by a worker thread rather than waking its caller
+    if (!httpContext->AsyncCall)
+        httpContext->Semaphore = CreatorSemaphore_New(1, 1);
+    httpContext->Request = CreatorHTTPRequest_New(actualMethod, url, ResultCallback, HeaderCallback, DataCallback, FinishCallback, httpContext);
 
-            //set up oAuth authorization
-            CreatorHTTP_AddAuthorizationHeader(memoryManager, httpContext.Request, actualMethod, url);
+    if ((httpContext->Semaphore || httpContext->AsyncCall) && httpContext->Request)
+    {
+        Creator_Log(CreatorLogLevel_Debug, "HTTP %p will handle %s %s", httpContext->Request, CreatorHTTPMethod_ToString(httpMethod), url);
 
-            //add accept header
+        //add X-HTTP-Method-Override
+        if (httpMethod != actualMethod)
+        {
+            CreatorHTTPRequest_AddHeader(httpContext->Request, "X-HTTP-Method-Override", CreatorHTTPMethod_ToString(httpMethod));
+        }
 
-            const char *mimes[4] =
-            { (httpContext.ExpectedType != CreatorType__Unknown) ? CreatorXMLDeserialiser_GetMIMEType(httpContext.ExpectedType) : "",
-                    CreatorXMLDeserialiser_GetMIMEType(CreatorType_Error), CreatorXMLDeserialiser_GetMIMEType(CreatorType_BadRequestResponse), "*/*" };
+        const char *locale = CreatorClient_GetLocale();
+        if (locale && strlen(locale))
+        {
+            CreatorHTTPRequest_AddHeader(httpContext->Request, "X-Culture", locale);
+        }
 
-            char *acceptedMimeTypes = ConcatenateAcceptValues(mimes, sizeof(mimes) / sizeof(*mimes), "+xml");
-            if (acceptedMimeTypes)
+        const char *bodyContentType = CreatorClient_GetBodyContentType();
+        if (bodyContentType && strlen(bodyContentType))
+        {
+            if (!strstr(bodyContentType, "xml"))
             {
-                CreatorHTTPRequest_AddHeader(httpContext.Request, "Accept", acceptedMimeTypes);
-                Creator_MemFree((void **)&acceptedMimeTypes);
+                CreatorHTTPRequest_AddHeader(httpContext->Request, "X-Body-Content-Type", bodyContentType);
             }
+        }
 
-            if (httpContext.ExpectedType != CreatorType__Unknown)
-                Creator_MemFree((void **)&mimes[0]);
-            Creator_MemFree((void **)&mimes[1]);
-            Creator_MemFree((void **)&mimes[2]);
+        char requestId[65];
+        snprintf(requestId, sizeof(requestId), "%lX", (unsigned long)httpContext->Request);
+        CreatorHTTPRequest_AddHeader(httpContext->Request, "X-Client-RequestId", requestId);
 
-            /* handle body */
-            if (bodyData)
+        /* ??? TODO add Accept-Language ??? */
+
+        //set up oAuth authorization
+        CreatorHTTP_AddAuthorizationHeader(httpContext->MemoryManager, httpContext->Request, actualMethod, url);
+
+        //add accept header (built by BeginCall)
+        if (httpContext->Accept)
+        {
+            CreatorHTTPRequest_AddHeader(httpContext->Request, "Accept", httpContext->Accept);
+        }
+
+        /* handle body */
+        if (bodyData)
+        {
+            Creator_Assert(actualMethod != CreatorHTTPMethod_Get, "HTTP %p: GET does not allow a request body", httpContext->Request);
+            // Note: some HTTP libs need all headers to be set before the data
+            char contentType[256];
+            char *mimeType = CreatorXMLDeserialiser_GetMIMEType(CreatorObject_GetType(bodyData));
+            strncpy(contentType, mimeType, sizeof(contentType));
+            Creator_MemFree((void **)&mimeType);
+            strcat(contentType, "+xml");
+            CreatorHTTPRequest_AddHeader(httpContext->Request, "Content-Type", contentType);
+            int bodySize = 0;
+            char *body = CreatorObject_SerialiseToXML(bodyData, &bodySize);
+            if (body)
             {
-                Creator_Assert(actualMethod != CreatorHTTPMethod_Get, "HTTP %p: GET does not allow a request body", httpContext.Request);
-                // Note: some HTTP libs need all headers to be set before the data
-                char contentType[256];
-                char *mimeType = CreatorXMLDeserialiser_GetMIMEType(CreatorObject_GetType(bodyData));
-                strncpy(contentType, mimeType, sizeof(contentType));
-                Creator_MemFree((void **)&mimeType);
-                strcat(contentType, "+xml");
-                CreatorHTTPRequest_AddHeader(httpContext.Request, "Content-Type", contentType);
-                int bodySize = 0;
-                char *body = CreatorObject_SerialiseToXML(bodyData, &bodySize);
-                if (body)
-                {
-                    CreatorHTTPRequest_SetBody(httpContext.Request, body, bodySize);
-                    Creator_MemFree((void **)&body);
-                }
+                CreatorHTTPRequest_SetBody(httpContext->Request, body, bodySize);
+                Creator_MemFree((void **)&body);
             }
+        }
+        result = true;
+    }
+    else
+    {
+        /* error */
+        //Creator_Log(CreatorLogLevel_Error, "HTTP %p (%s %s) failed to start: parser instance %p, semaphore %p", httpContext.Request, CreatorHTTPMethod_ToString(httpMethod), url, httpContext.parsingContext.parserInstance, httpContext.Semaphore);
+        Creator_Log(CreatorLogLevel_Error, "HTTP %p (%s %s) failed to start", httpContext->Request, CreatorHTTPMethod_ToString(httpMethod), url);
+        CreatorThread_SetError(CreatorError_Internal);
+        httpContext->Success = false;
+    }
+    return result;
+}
 
+bool CreatorHTTP_Call(CreatorMemoryManager memoryManager, CreatorHTTPMethod httpMethod, char *url, CreatorType expectedType, CreatorObject *pResponse,
+        CreatorObject bodyData, CreatorHTTPStatus *status)
+{
+    bool result = false;
+    HTTPCallbackContext httpContext;
+    CreatorThread_ClearLastError();
+    if (pResponse)
+        *pResponse = NULL;
+    if (BeginCall(&httpContext, memoryManager, httpMethod, url, expectedType))
+    {
+        if (GetCachedResponse(&httpContext, pResponse))
+        {
+            if (status)
+                *status = httpContext.Status;
+            EndCall(&httpContext);
+            return true;
+        }
+
+        if (PrepareRequest(&httpContext, bodyData))
+        {
             if (CreatorThread_GetLastError() == CreatorError_NoError)
             {
                 int attemptCount = 0;
@@ -310,130 +498,262 @@ bool CreatorHTTP_Call(CreatorMemoryManager memoryManager, CreatorHTTPMethod http
                     /* wait for lock availability (data received and parsed) */
                     CreatorSemaphore_Wait(httpContext.Semaphore, 1);
                     attemptCount += 1;
-                } while ((attemptCount < 2) && (httpContext.Error == CreatorError_Network));
+                } while ((attemptCount < HTTP_CALL_ATTEMPTS) && (httpContext.Error == CreatorError_Network));
                 if (httpContext.Error != CreatorError_NoError)
                     CreatorThread_SetError(httpContext.Error);
             }
+            FinishCall(&httpContext, pResponse);
+        }
+
+        if (status)
+            *status = httpContext.Status;
+        result = httpContext.Success;
+    }
+    EndCall(&httpContext);
+    return result;
+}
 
-            if (httpContext.IsSuccessResponse && !httpContext.HasParserError)
+/* Unlink a call from the list (the async lock must be held) */
+static void RemoveAsyncCall(HTTPAsyncCall *call)
+{
+    HTTPAsyncCall **link = &_AsyncCalls;
+    while (*link && *link != call)
+        link = &(*link)->Next;
+    if (*link)
+        *link = call->Next;
+    if (call->State != HTTPAsyncCallState_Pending)
+        _AsyncCallsRunning--;
+}
+
+static void StartPendingAsyncCalls(void)
+{
+    HTTPAsyncCall *call;
+    do
+    {
+        call = NULL;
+        CreatorMutex_Lock(_AsyncLock);
+        if (_AsyncCallsRunning < _MaxAsyncCalls)
+        {
+            for (call = _AsyncCalls; call && call->State != HTTPAsyncCallState_Pending; call = call->Next)
+                ;
+            if (call)
             {
-                Creator_Log(CreatorLogLevel_Info, "HTTP %s %s response %u", CreatorHTTPMethod_ToString(httpMethod), url, httpContext.Status);
+                call->State = HTTPAsyncCallState_Starting;
+                _AsyncCallsRunning++;
             }
+        }
+        CreatorMutex_Unlock(_AsyncLock);
+        // Run it here if the pool can't take it (as the scheduler does)
+        if (call && !CreatorThreadPool_AddTask(_AsyncThreadPool, StartAsyncCall, call))
+            StartAsyncCall(call);
+    } while (call);
+}
+
+static void DeliverAsyncCall(HTTPAsyncCall *call, CreatorObject response)
+{
+    HTTPCallbackContext *httpContext = &call->Context;
+    call->Callback(call->ID, call->CallbackContext, httpContext->Success, response, httpContext->Status, CreatorThread_GetLastError());
+    CreatorMutex_Lock(_AsyncLock);
+    RemoveAsyncCall(call);
+    CreatorMutex_Unlock(_AsyncLock);
+    EndCall(httpContext);
+    Creator_MemFree((void **)&call);
+    StartPendingAsyncCalls();
+}
+
+static void SendAsyncCall(HTTPAsyncCall *call)
+{
+    // The request may finish (and the call be released) before Send returns
+    call->Context.Error = CreatorError_NoError;
+    call->AttemptCount++;
+    CreatorHTTPRequest_Send(call->Context.Request);
+}
 
-            if (httpContext.Deserialiser)
+static void StartAsyncCall(void *context)
+{
+    HTTPAsyncCall *call = (HTTPAsyncCall *)context;
+    HTTPCallbackContext *httpContext = &call->Context;
+    CreatorObject response = NULL;
+    CreatorThread_ClearLastError();
+    CreatorThread_SetUseOAuth(call->UseOAuth);
+    CreatorThread_SetUseSessionToken(call->UseSessionToken);
+    if (!GetCachedResponse(httpContext, &response))
+    {
+        if (PrepareRequest(httpContext, call->BodyData))
+        {
+            if (CreatorThread_GetLastError() == CreatorError_NoError)
             {
-                CreatorObject response = CreatorXMLDeserialiser_GetObject(httpContext.Deserialiser);
-                if (response)
-                {
-                    if ((httpMethod == CreatorHTTPMethod_Get) && (httpContext.ResponseType == httpContext.ExpectedType))
-                    {
-                        CreatorXMLDeserialiser_SetSelfLink(httpContext.Deserialiser, response, url);
-                    }
-                    CreatorMemoryManager_AttachObject(memoryManager, response);
-                }
-                if (pResponse)
-                {
-                    *pResponse = response;
-                }
-                CreatorXMLDeserialiser_Free(&httpContext.Deserialiser);
+                CreatorMutex_Lock(_AsyncLock);
+                call->State = HTTPAsyncCallState_InFlight;
+                CreatorMutex_Unlock(_AsyncLock);
+                SendAsyncCall(call);
+                return;
             }
+            FinishCall(httpContext, &response);
+        }
+    }
+    CreatorMutex_Lock(_AsyncLock);
+    call->State = HTTPAsyncCallState_Completing;
+    CreatorMutex_Unlock(_AsyncLock);
+    DeliverAsyncCall(call, response);
+}
 
-            //notify cache manager of the result
-            if (httpContext.IsSuccessResponse && !httpContext.HasParserError)
+static void CompleteAsyncCall(void *context)
+{
+    HTTPAsyncCall *call = (HTTPAsyncCall *)context;
+    HTTPCallbackContext *httpContext = &call->Context;
+    CreatorObject response = NULL;
+    bool cancelled;
+    bool retry;
+    CreatorMutex_Lock(_AsyncLock);
+    cancelled = call->Cancelled;
+    retry = !cancelled && (call->AttemptCount < HTTP_CALL_ATTEMPTS) && (httpContext->Error == CreatorError_Network);
+    if (cancelled)
+        RemoveAsyncCall(call);
+    else if (!retry)
+        call->State = HTTPAsyncCallState_Completing;
+    CreatorMutex_Unlock(_AsyncLock);
+
+    if (cancelled)
+    {
+        // Nobody wants the response (the memory manager may already be gone), just drop it
+        EndCall(httpContext);
+        Creator_MemFree((void **)&call);
+        StartPendingAsyncCalls();
+    }
+    else if (retry)
+    {
+        SendAsyncCall(call);
+    }
+    else
+    {
+        CreatorThread_ClearLastError();
+        CreatorThread_SetUseOAuth(call->UseOAuth);
+        CreatorThread_SetUseSessionToken(call->UseSessionToken);
+        if (httpContext->Error != CreatorError_NoError)
+            CreatorThread_SetError(httpContext->Error);
+        FinishCall(httpContext, &response);
+        DeliverAsyncCall(call, response);
+    }
+}
+
+CreatorHTTPCallID CreatorHTTP_CallAsync(CreatorMemoryManager memoryManager, CreatorHTTPMethod httpMethod, char *url, CreatorType expectedType,
+        CreatorObject bodyData, CreatorHTTP_CallCallback callback, void *callbackContext)
+{
+    CreatorHTTPCallID result = 0;
+    CreatorThread_ClearLastError();
+    if (_AsyncThreadPool && callback)
+    {
+        HTTPAsyncCall *call = (HTTPAsyncCall *)Creator_MemAllocWithTag(sizeof(HTTPAsyncCall), CreatorMemTag_HTTP);
+        if (call)
+        {
+            // The URL is copied here, but the request is built by a worker once an in-flight slot is free
+            if (BeginCall(&call->Context, memoryManager, httpMethod, url, expectedType))
             {
-                if ((httpMethod == CreatorHTTPMethod_Get) && CreatorThread_GetUseOAuth())
-                {
-                    if ((httpContext.ResponseType == httpContext.ExpectedType) && (httpContext.Expires > 0))
-                    {
-                        if (pResponse)
-                            CreatorCache_Set(url, *pResponse, httpContext.Expires);
-                    }
-                }
-            }
+                call->Next = NULL;
+                call->State = HTTPAsyncCallState_Pending;
+                call->Cancelled = false;
+                call->AttemptCount = 0;
+                call->UseOAuth = CreatorThread_GetUseOAuth();
+                call->UseSessionToken = CreatorThread_GetUseSessionToken();
+                call->BodyData = bodyData;
+                call->Callback = callback;
+                call->CallbackContext = callbackContext;
+                call->Context.AsyncCall = call;
 
-            if (!httpContext.IsSuccessResponse)
+                HTTPAsyncCall **link;
+                CreatorMutex_Lock(_AsyncLock);
+                if (++_LastAsyncCallID == 0)
+                    _LastAsyncCallID = 1;
+                call->ID = _LastAsyncCallID;
+                result = call->ID;     // once the call is listed and unlocked it may complete and be freed
+                for (link = &_AsyncCalls; *link; link = &(*link)->Next)
+                    ;
+                *link = call;
+                CreatorMutex_Unlock(_AsyncLock);
+                StartPendingAsyncCalls();
+            }
+            else
             {
-                if (!httpContext.HasParserError && httpContext.ResponseType == CreatorType_BadRequestResponse)
-                {
-                    if (pResponse)
-                    {
-                        CreatorBadRequestResponse errorResponse = (CreatorBadRequestResponse) * pResponse;
-                        int errorCode = CreatorBadRequestResponse_GetErrorCode(errorResponse);
-                        CreatorErrorType errorType =
-                                ((errorCode - 1 + (int)CreatorError_BadRequest_Min >= CreatorError_BadRequest_Unknown) || (errorCode <= 0)) ?
-                                        CreatorError_BadRequest_Unknown : (CreatorErrorType)(errorCode - 1 + (int)CreatorError_BadRequest_Min);
-                        CreatorThread_SetError(errorType);
-                        Creator_Log(CreatorLogLevel_Error, "HTTP %s %s response %u - failed with [%d]", CreatorHTTPMethod_ToString(httpMethod), url,
-                                httpContext.Status, errorType);
-                    }
-                    else
-                    {
-                        CreatorThread_SetError(CreatorError_BadRequest_Unknown);
-                    }
-                }
-                else if (httpContext.Error == CreatorError_Server)
-                {
-                    Creator_Log(CreatorLogLevel_Error, "HTTP %s %s response %u - failed (internal server error)", CreatorHTTPMethod_ToString(httpMethod), url,
-                            httpContext.Status);
-                }
-                else
-                {
-                    Creator_Log(CreatorLogLevel_Error, "HTTP %s %s response %u - failed (no content returned)", CreatorHTTPMethod_ToString(httpMethod), url,
-                            httpContext.Status);
-                    if (CreatorThread_GetLastError() == CreatorError_NoError)
-                    {
-                        CreatorThread_SetError((httpContext.IsBadRequestResponse) ? CreatorError_BadRequest_Unknown : CreatorError_InvalidArgument);
-                    }
-                    httpContext.Success = false;
-                }
+                EndCall(&call->Context);
+                Creator_MemFree((void **)&call);
+                CreatorThread_SetError(CreatorError_InvalidArgument);
             }
         }
         else
         {
-            /* error */
-            //Creator_Log(CreatorLogLevel_Error, "HTTP %p (%s %s) failed to start: parser instance %p, semaphore %p", httpContext.Request, CreatorHTTPMethod_ToString(httpMethod), url, httpContext.parsingContext.parserInstance, httpContext.Semaphore);
-            Creator_Log(CreatorLogLevel_Error, "HTTP %p (%s %s) failed to start", httpContext.Request, CreatorHTTPMethod_ToString(httpMethod), url);
-            CreatorThread_SetError(CreatorError_Internal);
-            httpContext.Success = false;
+            CreatorThread_SetError(CreatorError_Memory);
         }
+    }
+    else
+    {
+        CreatorThread_SetError(CreatorError_InvalidArgument);
+    }
+    return result;
+}
 
-        if (httpContext.Request)
-        {
-            CreatorHTTPRequest_Free(&httpContext.Request);
-        }
-        if (httpContext.Semaphore)
+bool CreatorHTTP_CancelCall(CreatorHTTPCallID callID)
+{
+    bool result = false;
+    HTTPAsyncCall *call;
+    if (_AsyncLock && callID)
+    {
+        CreatorMutex_Lock(_AsyncLock);
+        for (call = _AsyncCalls; call && call->ID != callID; call = call->Next)
+            ;
+        if (call && !call->Cancelled)
         {
-            CreatorSemaphore_Free(&httpContext.Semaphore);
+            if (call->State == HTTPAsyncCallState_Pending)
+            {
+                RemoveAsyncCall(call);
+                EndCall(&call->Context);
+                Creator_MemFree((void **)&call);
+                result = true;
+            }
+            else if (call->State == HTTPAsyncCallState_InFlight)
+            {
+                // The request can't be withdrawn from the connection, its response is dropped when it arrives
+                call->Cancelled = true;
+                result = true;
+            }
         }
-        if (status)
-            *status = httpContext.Status;
-        result = httpContext.Success;
+        CreatorMutex_Unlock(_AsyncLock);
     }
-    if (url)
-        Creator_MemFree((void **)&url);
     return result;
 }
 
-static char *ConcatenateAcceptValues(const char **strArray, size_t arrayCount, const char *terminator)
+void CreatorHTTP_SetAsyncThreadPool(CreatorThreadPool threadPool)
+{
+    _AsyncThreadPool = threadPool;
+    if (threadPool && !_AsyncLock)
+    {
+        _AsyncLock = CreatorMutex_New();
+        CreatorMutex_SetName(_AsyncLock, "HTTPAsyncLock");
+    }
+    else if (!threadPool && _AsyncLock && !_AsyncCalls)
+    {
+        CreatorMutex_Free(&_AsyncLock);
+    }
+}
+
+void CreatorHTTP_SetMaxAsyncCalls(uint maxCalls)
+{
+    _MaxAsyncCalls = (maxCalls > 0) ? maxCalls : 1;
+    if (_AsyncLock)
+        StartPendingAsyncCalls();
+}
+
+static char *ConcatenateAcceptValues(CreatorArena arena, const char **strArray, size_t arrayCount, const char *terminator)
 {
     size_t stringLengths[arrayCount];
     size_t index;
-    size_t totalLength = 1;
+    size_t totalLength = GetAcceptValuesLength(strArray, arrayCount, terminator);
     size_t terminatorLength = strlen(terminator);
     for (index = 0; index < arrayCount; ++index)
     {
         stringLengths[index] = strlen(strArray[index]);
-        //protect against empty strings
-        if (stringLengths[index])
-        {
-            totalLength += stringLengths[index] + 2 + terminatorLength;
-        }
-    }
-    if (totalLength > 1)
-    {
-        totalLength -= 2 + terminatorLength;
     }
-    char *acceptedMimeTypes = (char*)Creator_MemAlloc(totalLength);
+    char *acceptedMimeTypes = (char*)CreatorArena_Alloc(arena, totalLength);
     if (!acceptedMimeTypes)
     {
         return NULL;
@@ -460,6 +780,60 @@ static char *ConcatenateAcceptValues(const char **strArray, size_t arrayCount, c
     return acceptedMimeTypes;
 }
 
+static size_t GetAcceptValuesLength(const char **strArray, size_t arrayCount, const char *terminator)
+{
+    size_t index;
+    size_t totalLength = 1;
+    size_t terminatorLength = strlen(terminator);
+    for (index = 0; index < arrayCount; ++index)
+    {
+        size_t stringLength = strlen(strArray[index]);
+        //protect against empty strings
+        if (stringLength)
+        {
+            totalLength += stringLength + 2 + terminatorLength;
+        }
+    }
+    if (totalLength > 1)
+    {
+        totalLength -= 2 + terminatorLength;
+    }
+    return totalLength;
+}
+
+static void FreeAcceptMIMETypes(CreatorType expectedType, const char **mimes)
+{
+    if (expectedType != CreatorType__Unknown)
+        Creator_MemFree((void **)&mimes[0]);
+    Creator_MemFree((void **)&mimes[1]);
+    Creator_MemFree((void **)&mimes[2]);
+}
+
+static void GetAcceptMIMETypes(CreatorType expectedType, const char **mimes)
+{
+    mimes[0] = (expectedType != CreatorType__Unknown) ? CreatorXMLDeserialiser_GetMIMEType(expectedType) : "";
+    mimes[1] = CreatorXMLDeserialiser_GetMIMEType(CreatorType_Error);
+    mimes[2] = CreatorXMLDeserialiser_GetMIMEType(CreatorType_BadRequestResponse);
+    mimes[3] = "*/*";
+}
+
+/* Length (with terminator) of the copy made by UnescapeUrl, each '+' in the query becomes "%20" */
+static size_t GetUnescapedUrlLength(const char *url)
+{
+    size_t result = 0;
+    if (url)
+    {
+        const char *query = strchr(url, '?');
+        result = strlen(url) + 1;
+        while (query && (query = strchr(query, '+')) != NULL)
+        {
+            result += 2;
+            query++;
+        }
+    }
+    return result;
+}
+
 static void DataCallback(CreatorHTTPRequest request, void *callbackContext, const char *sData, size_t dataLength)
 {
     HTTPCallbackContext *httpContext = (HTTPCallbackContext*)callbackContext;
@@ -493,6 +867,11 @@ static void FinishCallback(CreatorHTTPRequest request, void *callbackContext, Cr
         {
             errorKind = CreatorError_Timeout;
         }
+        else if (error == CreatorHTTPError_ContentDecoding)
+        {
+            // the response arrived, so a network retry would only fetch (or for a POST, repeat) it again
+            errorKind = CreatorError_Internal;
+        }
         httpContext->Error = errorKind;
         httpContext->Success = false;
     }
@@ -509,7 +888,16 @@ static void FinishCallback(CreatorHTTPRequest request, void *callbackContext, Cr
             }
         }
     }
-    CreatorSemaphore_Release(httpContext->Semaphore, 1);
+    if (httpContext->AsyncCall)
+    {
+        // Process the response (or retry) on a worker rather than the receive thread
+        if (!CreatorThreadPool_AddTask(_AsyncThreadPool, CompleteAsyncCall, httpContext->AsyncCall))
+            CompleteAsyncCall(httpContext->AsyncCall);
+    }
+    else
+    {
+        CreatorSemaphore_Release(httpContext->Semaphore, 1);
+    }
 }
 
 static void HeaderCallback(CreatorHTTPRequest request, void *callbackContext, const char *headerName, size_t nameLength, const char *headerValue,
@@ -732,7 +1120,7 @@ static void ResultCallback(CreatorHTTPRequest request, void *callbackContext, un
     }
 }
 
-static char *UnescapeUrl(char *url)
+static char *UnescapeUrl(CreatorArena arena, char *url)
 {
     char *result = NULL;
     if (url)
@@ -761,7 +1149,7 @@ static char *UnescapeUrl(char *url)
         }
         if (countOfSpaces > 0)
         {
-            result = (char *)Creator_MemAlloc(position - url + sizeof(char) + (countOfSpaces * 2 * sizeof(char)));
+            result = (char *)CreatorArena_Alloc(arena, position - url + sizeof(char) + (countOfSpaces * 2 * sizeof(char)));
             if (result)
             {
                 memcpy(result, url, startOfQuery - url);
@@ -788,7 +1176,7 @@ static char *UnescapeUrl(char *url)
             }
         }
         else
-            result = CreatorString_Duplicate(url);
+            result = CreatorArena_DuplicateString(arena, url);
     }
     return result;
 }
@@ -73,6 +73,7 @@ bool CreatorLog_Initialise()
     pFirstItem = NULL;
     pLastItem = NULL;
     logsSemaphore = CreatorSemaphore_New(1, 0);
+    CreatorSemaphore_SetName(logsSemaphore, "logsSemaphore");
     return logsSemaphore != NULL;
 }
 
@@ -104,7 +105,7 @@ void Creator_Logv(CreatorLogLevel level, const char *message, va_list vl)
 
 static LogItem *LogItem_New(CreatorLogLevel level, const char *szMsg)
 {
-    LogItem *pNewItem = Creator_MemAlloc(sizeof(LogItem));
+    LogItem *pNewItem = Creator_MemAllocWithTag(sizeof(LogItem), CreatorMemTag_Log);
     if (pNewItem)
     {
         pNewItem->pNextItem = NULL;
@@ -130,7 +131,7 @@ static LogItem *LogItem_New(CreatorLogLevel level, const char *szMsg)
         if (szMsg)
         {
             size_t msgSize = strlen(szMsg) + 1;
-            pNewItem->message = Creator_MemAlloc(msgSize);
+            pNewItem->message = Creator_MemAllocWithTag(msgSize, CreatorMemTag_Log);
             if (pNewItem->message)
             {
                 strcpy(pNewItem->message, szMsg);
@@ -177,6 +178,7 @@ static void appendLogItem(LogItem *item)
     if (!logPostingTaskID)
     {
         logPostingTaskID = CreatorScheduler_ScheduleTask(logsPoster, NULL, 5, false);
+        CreatorScheduler_SetTaskFlags(logPostingTaskID, CreatorSchedulerTaskFlags_Concurrent);
     }
     CreatorSemaphore_Release(logsSemaphore, 1);
 }
@@ -223,6 +225,7 @@ static void logsPoster(void *pArg)
     else
     {
         logPostingTaskID = CreatorScheduler_ScheduleTask(logsPoster, NULL, 0, false);
+        CreatorScheduler_SetTaskFlags(logPostingTaskID, CreatorSchedulerTaskFlags_Concurrent);
         fprintf(stdout, "Scheduled new batch of logs to be sent\n");
     }
     CreatorSemaphore_Release(logsSemaphore, 1);
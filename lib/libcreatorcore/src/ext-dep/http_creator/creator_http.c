@@ -25,6 +25,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -39,8 +40,13 @@
 #include "creator/core/common_messaging_main.h"
 #include "creator/core/base_types_methods.h"
 //#include "creator/core/http_private.h"
+char *CreatorHTTPMethod_ToString(CreatorHTTPMethod method);		// http.c
 #include "creator/core/creator_time.h"
 #include "creator/core/creator_task_scheduler.h"
+#include "data_buffer.h"
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
 
 #ifdef MICROCHIP_PIC32
 #ifdef CREATOR_HTTP_DEBUG
@@ -48,6 +54,78 @@
 #endif
 #endif
 
+// Connection pool: total connections, and how many of them may be talking to the same host at once
+#ifndef MAX_HTTP_CONNECTIONS
+#define MAX_HTTP_CONNECTIONS	4
+#endif
+
+#if MAX_HTTP_CONNECTIONS > CREATOR_MAX_CONNECTIONS
+#error "MAX_HTTP_CONNECTIONS needs as many common messaging connections (CREATOR_MAX_CONNECTIONS)"
+#endif
+
+#ifndef MAX_HTTP_CONNECTIONS_PER_HOST
+#define MAX_HTTP_CONNECTIONS_PER_HOST	2
+#endif
+
+// Requests that may be outstanding on one connection. Above 1, GET requests are pipelined (sent without waiting for
+// the previous response) on an open connection to the same host.
+#ifndef MAX_HTTP_PIPELINE_DEPTH
+#define MAX_HTTP_PIPELINE_DEPTH	1
+#endif
+
+#define MAX_HTTP_REQUESTS		(MAX_HTTP_CONNECTIONS * MAX_HTTP_PIPELINE_DEPTH)
+
+// Largest piece of a streamed (chunked) request body sent at once
+#ifndef HTTP_BODY_CHUNK_SIZE
+#define HTTP_BODY_CHUNK_SIZE	1024
+#endif
+
+#define HTTP_CHUNK_HEADER_SIZE	10			// hex size + CRLF
+
+#define HTTP_DEFAULT_PORT		80
+#define HTTPS_DEFAULT_PORT		443
+
+#ifdef HAVE_LIBZ
+// Asking for compressed responses is a separate opt-in: inflating one needs (1 << HTTP_INFLATE_WINDOW_BITS) bytes of
+// window plus about 7KB of zlib state, per response being read
+#ifdef HTTP_ACCEPT_COMPRESSION
+#define HTTP_INFLATE
+#endif
+
+// Request body compression (see CreatorHTTPRequest_SetCompressedBody) - deflate needs about
+// (1 << (windowBits + 2)) + (1 << (memLevel + 9)) bytes, so the zlib defaults (256KB) are too big for a device
+#ifndef HTTP_DEFLATE_WINDOW_BITS
+#define HTTP_DEFLATE_WINDOW_BITS	12
+#endif
+
+#ifndef HTTP_DEFLATE_MEMLEVEL
+#define HTTP_DEFLATE_MEMLEVEL	4
+#endif
+#endif
+
+#ifdef HTTP_INFLATE
+// Gzip/deflate response bodies are inflated in pieces of this size as they arrive (the whole body is never held)
+#ifndef HTTP_INFLATE_BUFFER_SIZE
+#define HTTP_INFLATE_BUFFER_SIZE	512
+#endif
+
+// Largest window accepted from the server (servers compress with 15 unless configured otherwise); a stream that
+// needs a bigger one fails to decode
+#ifndef HTTP_INFLATE_WINDOW_BITS
+#define HTTP_INFLATE_WINDOW_BITS	MAX_WBITS
+#endif
+
+typedef struct
+{
+    z_stream Stream;
+    bool Deflate;               // "deflate" - may be raw (as some servers send it) rather than zlib wrapped
+    bool Ended;
+    bool Failed;
+    Bytef FirstByte;            // to start "deflate" again as raw if the (2 byte) zlib header check fails
+    char Output[HTTP_INFLATE_BUFFER_SIZE];
+} HTTPInflater;
+#endif
+
 struct HTTPRequestImpl;		// forward declaration
 
 typedef struct
@@ -56,10 +134,16 @@ typedef struct
     char *HostName;		// TODO - allocate buffer for max hostname or malloc?
     uint32 HostAddress;
     CreatorCommonMessaging_ConnectionInformation ConnectionInfo;
-    struct HTTPRequestImpl *Request;
-    time_t LastUsed;
-    CreatorTaskID CloseConnectionTaskID;
-    CreatorSemaphore RequestMutex;
+    CreatorMutex SendLock;      // keeps requests in the order they are put on the wire
+    char BodyChunk[HTTP_CHUNK_HEADER_SIZE + HTTP_BODY_CHUNK_SIZE + 2];      // streamed body framing (send lock protects it)
+    struct HTTPRequestImpl *Pipeline[MAX_HTTP_PIPELINE_DEPTH];     // sent requests awaiting a response, oldest first
+    uint PipelineHead;
+    uint PipelineCount;
+    bool Pipelining;            // cleared if the server drops a pipeline or closes the connection (requests are then sent one at a time)
+    time_t LastUsed;            // for the inactivity timeout
+    uint UseOrder;              // for LRU (seconds are too coarse to order requests)
+    uint Owners;                // requests using the connection (pool lock protects these, HostName and the pipeline)
+    uint SerialOwners;          // owners that must not share the connection
 } HTTPClient;
 
 typedef struct HTTPRequestImpl
@@ -68,11 +152,17 @@ typedef struct HTTPRequestImpl
     HTTPClient *HTTPClient;
     // TODO - add error to be sent in finished c/b
     CreatorHTTPMethod Method;
-    char *Buffer;
+    DataBuffer *Message;        // request line, headers and body, sent chunk by chunk
     size_t BodyLength;
-    size_t BufferLength;
-    size_t BufferSize;
+    CreatorHTTPRequest_BodyProducer BodyProducer;   // streamed body (instead of Message holding it)
+    void *BodyProducerContext;
     int HTTPResult;
+    bool HeadersTerminated;
+    bool Pipelinable;           // idempotent, so can be sent behind other requests (and re-sent if they are dropped)
+    bool Queued;                // in the client's pipeline (its response has not been read yet)
+#ifdef HTTP_INFLATE
+    HTTPInflater *Inflater;     // decodes the response Content-Encoding (allocated when the header arrives)
+#endif
 
     CreatorHTTPRequest_ResultCallback ResultCallback;
     CreatorHTTPRequest_HeaderCallback HeaderCallback;
@@ -81,29 +171,49 @@ typedef struct HTTPRequestImpl
     void *CallbackContext;
 } HTTPRequest;
 
-#ifndef MAX_HTTP_CONNECTIONS
-#define MAX_HTTP_CONNECTIONS	2
-#endif
-
 #define MAX_HEADER_SIZE			1024
 #define MAX_HTTP_MESSAGE_SIZE	(40*1024)	// 40KB : TODO - define project/platform specific limits?
-#define DEFAULT_MESSAGE_SIZE	(2*1024)	// 2KB
-#define INCREASE_MESSAGE_SIZE	(DEFAULT_MESSAGE_SIZE)
 
 #define HTTP_RESPONSE_TIME		60			// Response timeout (seconds)
 
-#define INACTIVITY_TIMEOUT		10
+#ifndef INACTIVITY_TIMEOUT
+#define INACTIVITY_TIMEOUT		10			// Idle connections are closed after this (seconds)
+#endif
+
+#define REAP_INTERVAL			((INACTIVITY_TIMEOUT + 1) / 2)
 
 static HTTPClient _HTTPClient[MAX_HTTP_CONNECTIONS];
-static HTTPRequest _HTTPRequest[MAX_HTTP_CONNECTIONS];
+static HTTPRequest _HTTPRequest[MAX_HTTP_REQUESTS];
+static CreatorMutex _PoolLock = NULL;
+static CreatorCondition _PoolReleased = NULL;
+static CreatorTaskID _ReapTaskID = 0;
+static uint _UseCount = 0;
+static CreatorHTTPConnectionPoolStatistics _PoolStatistics;
 bool _HTTPInitialised = false;
 
-static void CheckRequestBuffer(HTTPRequest *request, size_t size);
-static void CloseConnection(HTTPClient *client);
-static void CloseConnectionTask(CreatorTaskID taskID, void *context);
+static bool AbortPipeline(HTTPClient *client, HTTPRequest *except, CreatorHTTPError error, bool sendLocked);
+static void AddHostHeader(HTTPRequest *request, HTTPClient *client);
+static bool CheckRequestMessage(HTTPRequest *request, size_t size);
+static void CloseConnection(HTTPClient *client, bool sendLocked);
+static void DeleteConnection(HTTPClient *client, void *connection, bool sendLocked);
+static void CompletePipelineHead(HTTPClient *client);
 static bool CreatorHTTPCallback(CreatorCommonMessaging_CallbackEventType event, char *headerName, char *value, int len, void *context);
 static void CreatorHTTPResponseFinishedCallback(HTTPClient *client, HTTPRequest *request, CreatorHTTPError error);
-static HTTPClient *GetClient(const char *url, const char **requestUri);
+static HTTPRequest *GetClient(const char *url, bool pipelinable, const char **requestUri);
+static HTTPRequest *GetPipelineHead(HTTPClient *client);
+static bool QueueRequest(HTTPClient *client, HTTPRequest *request, void **connection);
+static void ReapIdleConnectionsTask(CreatorTaskID taskID, void *context);
+static void ReleaseClient(HTTPClient *client, HTTPRequest *request);
+static bool SendBodyChunks(HTTPClient *client, void *connection, HTTPRequest *request);
+#ifdef HTTP_INFLATE
+static void FreeInflater(HTTPRequest *request);
+static void InflateResponseData(char *data, size_t dataLength, HTTPRequest *request);
+static bool StartInflater(HTTPRequest *request, const char *encoding);
+#endif
+#ifdef HAVE_LIBZ
+static void *ZlibAlloc(void *opaque, uInt items, uInt size);
+static void ZlibFree(void *opaque, void *address);
+#endif
 
 
 void CreatorHTTP_Initialise(void)
@@ -112,31 +222,69 @@ void CreatorHTTP_Initialise(void)
 
     memset(_HTTPClient, 0, sizeof(_HTTPClient));
     memset(_HTTPRequest, 0, sizeof(_HTTPRequest));
+    memset(&_PoolStatistics, 0, sizeof(_PoolStatistics));
     for (index = 0; index < MAX_HTTP_CONNECTIONS; index++)
     {
-        HTTPClient *client = &_HTTPClient[index];
-        client->RequestMutex = CreatorSemaphore_New(1, 0);
-        // Limit requests to 1 per client connection (for now)
-        client->Request = &_HTTPRequest[index];
-        client->CloseConnectionTaskID = CreatorScheduler_ScheduleTask(CloseConnectionTask, (void *)client, INACTIVITY_TIMEOUT, true);
+        _HTTPClient[index].SendLock = CreatorMutex_New();
+        CreatorMutex_SetName(_HTTPClient[index].SendLock, "HTTPSendLock");
+        _HTTPClient[index].Pipelining = (MAX_HTTP_PIPELINE_DEPTH > 1);
     }
+    _PoolLock = CreatorMutex_New();
+    CreatorMutex_SetName(_PoolLock, "HTTPPoolLock");
+    _PoolReleased = CreatorCondition_New();
+    _UseCount = 0;
+    _ReapTaskID = CreatorScheduler_ScheduleTask(ReapIdleConnectionsTask, NULL, REAP_INTERVAL, true);
     _HTTPInitialised = true;
 }
 
 void CreatorHTTP_Shutdown(void)
 {
     int index;
+    if (_ReapTaskID)
+    {
+        CreatorScheduler_UnscheduleTask(_ReapTaskID);
+        _ReapTaskID = 0;
+    }
     for (index = 0; index < MAX_HTTP_CONNECTIONS; index++)
     {
         HTTPClient *client = &_HTTPClient[index];
+        CloseConnection(client, false);
         if (client->HostName)
             Creator_MemFree((void **)&client->HostName);
-        if (client->RequestMutex)
-            CreatorSemaphore_Free(&client->RequestMutex);
+        if (client->SendLock)
+            CreatorMutex_Free(&client->SendLock);
     }
+    if (_PoolReleased)
+        CreatorCondition_Free(&_PoolReleased);
+    if (_PoolLock)
+        CreatorMutex_Free(&_PoolLock);
     _HTTPInitialised = false;
 }
 
+bool CreatorHTTP_GetConnectionPoolStatistics(CreatorHTTPConnectionPoolStatistics *statistics)
+{
+    bool result = false;
+    if (statistics && _PoolLock)
+    {
+        int index;
+        CreatorMutex_Lock(_PoolLock);
+        *statistics = _PoolStatistics;
+        statistics->Connections = MAX_HTTP_CONNECTIONS;
+        statistics->Open = 0;
+        statistics->Busy = 0;
+        for (index = 0; index < MAX_HTTP_CONNECTIONS; index++)
+        {
+            if (_HTTPClient[index].Connection)
+                statistics->Open++;
+            if (_HTTPClient[index].Owners > 0)
+                statistics->Busy++;
+        }
+        CreatorMutex_Unlock(_PoolLock);
+        result = true;
+    }
+    return result;
+}
+
 CreatorHTTPRequest CreatorHTTPRequest_New(CreatorHTTPMethod method, const char *url, CreatorHTTPRequest_ResultCallback resultCallback,
         CreatorHTTPRequest_HeaderCallback headerCallback, CreatorHTTPRequest_DataCallback dataCallback, CreatorHTTPRequest_FinishCallback finishCallback,
         void *callbackContext)
@@ -156,36 +304,44 @@ CreatorHTTPRequest CreatorHTTPRequest_New(CreatorHTTPMethod method, const char *
 #ifdef CREATOR_HTTP_DEBUG
     SYS_CONSOLE_PRINT("HTTP: %s %s\r\n", CreatorHTTPMethod_ToString(method), url);
 #endif
-    client = GetClient(url, &requestUri);
-    if (client)
+    request = GetClient(url, method == CreatorHTTPMethod_Get, &requestUri);
+    if (request)
     {
-        // Note: only single request per client support for now (requests block on client mutex)
-        request = client->Request;
-        request->HTTPClient = client;
+        client = request->HTTPClient;
         request->HTTPResult = 0;
+        request->HeadersTerminated = false;
+        request->Queued = false;
+#ifdef HTTP_INFLATE
+        request->Inflater = NULL;
+#endif
         request->Method = method;
-        request->Buffer = Creator_MemAlloc(DEFAULT_MESSAGE_SIZE);
-        if (request->Buffer)
+        request->Message = DataBuffer_New();
+        if (request->Message)
         {
-            request->BufferSize = DEFAULT_MESSAGE_SIZE;
-            request->BufferLength = 0;
             request->BodyLength = 0;
+            request->BodyProducer = NULL;
+            request->BodyProducerContext = NULL;
             request->CallbackContext = callbackContext;
             request->ResultCallback = resultCallback;
             request->HeaderCallback = headerCallback;
             request->DataCallback = dataCallback;
             request->FinishCallback = finishCallback;
-            request->InUse = true;
 
             // Write request line with default header
-            request->BufferLength = sprintf(request->Buffer, "%s %s HTTP/1.1\r\n", CreatorHTTPMethod_ToString(method), requestUri);
+            DataBuffer_WriteCString(request->Message, CreatorHTTPMethod_ToString(method));
+            DataBuffer_Write(request->Message, " ", 1);
+            DataBuffer_WriteCString(request->Message, requestUri);
+            DataBuffer_WriteCString(request->Message, " HTTP/1.1\r\n");
 
             // TODO - define agent name
             CreatorHTTPRequest_AddHeader((CreatorHTTPRequest)request, "User-Agent", "c http client");
-            CreatorHTTPRequest_AddHeader((CreatorHTTPRequest)request, "Host", client->HostName);
+            AddHostHeader(request, client);
 
-            // TODO - define accept-encoding? (Note: tcp stays alive for by itself - for awhile)
-            //CreatorHTTPRequestAddHeader((CreatorHTTPRequest)request, "Accept-Encoding", "gzip, deflate");
+#ifdef HTTP_INFLATE
+            // Responses are inflated as they arrive (XML typically compresses 5-10x)
+            CreatorHTTPRequest_AddHeader((CreatorHTTPRequest)request, "Accept-Encoding", "gzip, deflate");
+#endif
+            // Note: tcp stays alive for by itself - for awhile
             //CreatorHTTPRequestAddHeader((CreatorHTTPRequest)request, "Connection", "keep-alive");
             result = request;
         }
@@ -193,12 +349,9 @@ CreatorHTTPRequest CreatorHTTPRequest_New(CreatorHTTPMethod method, const char *
     if (result == NULL)
     {
         Creator_Log(CreatorLogLevel_Error, "HTTP request failed...");	// TODO - Add reason...
-        if (client)
+        if (request)
         {
-#ifdef CREATOR_HTTP_DEBUG_SEM
-            SYS_CONSOLE_MESSAGE("\r\nCreatorSemaphore_ReleaseError2");
-#endif
-            CreatorSemaphore_Release(client->RequestMutex, 1);
+            ReleaseClient(client, request);
         }
     }
     return result;
@@ -212,11 +365,12 @@ void CreatorHTTPRequest_AddHeader(CreatorHTTPRequest self, const char *headerNam
     int length = nameLength + valueLength + 4;
     if (length <= MAX_HEADER_SIZE)
     {
-        CheckRequestBuffer(request, length);
-        if (request->Buffer)
+        if (CheckRequestMessage(request, length))
         {
-            char *buffer = request->Buffer + request->BufferLength;
-            request->BufferLength += sprintf(buffer, "%s: %s\r\n", headerName, headerValue);
+            DataBuffer_Write(request->Message, headerName, nameLength);
+            DataBuffer_Write(request->Message, ": ", 2);
+            DataBuffer_Write(request->Message, headerValue, valueLength);
+            DataBuffer_Write(request->Message, "\r\n", 2);
         }
     }
 }
@@ -224,22 +378,74 @@ void CreatorHTTPRequest_AddHeader(CreatorHTTPRequest self, const char *headerNam
 void CreatorHTTPRequest_SetBody(CreatorHTTPRequest self, const void *pBody, size_t bodySize)
 {
     HTTPRequest *request = (HTTPRequest*)self;
-    if (request->Method != CreatorHTTPMethod_Get && request->BodyLength == 0)
+    if (request->Method != CreatorHTTPMethod_Get && request->BodyLength == 0 && !request->HeadersTerminated)
     {
-        // TODO - fix check for length header room
-        CheckRequestBuffer(request, bodySize + 24);
-        if (request->Buffer)
+        char contentLength[32];
+        int headerLength = snprintf(contentLength, sizeof(contentLength), "Content-Length: %lu\r\n\r\n", (unsigned long)bodySize);
+        if (CheckRequestMessage(request, bodySize + headerLength))
         {
-            char *buffer = request->Buffer + request->BufferLength;
-#if i386
-            request->BufferLength += sprintf(buffer, "Content-Length: %d\r\n\r\n", bodySize);
-#else
-            request->BufferLength += sprintf(buffer, "Content-Length: %ld\r\n\r\n", bodySize);
-#endif
-            buffer = &request->Buffer[request->BufferLength];
-            memcpy(buffer, pBody, bodySize);
-            request->BufferLength += bodySize;
+            DataBuffer_Write(request->Message, contentLength, headerLength);
+            DataBuffer_Write(request->Message, pBody, bodySize);
             request->BodyLength = bodySize;
+            request->HeadersTerminated = true;
+        }
+    }
+}
+
+void CreatorHTTPRequest_SetCompressedBody(CreatorHTTPRequest self, const void *body, size_t bodySize)
+{
+    bool compressed = false;
+#ifdef HAVE_LIBZ
+    HTTPRequest *request = (HTTPRequest*)self;
+    if (request->Method != CreatorHTTPMethod_Get && request->BodyLength == 0 && !request->HeadersTerminated && bodySize > 0)
+    {
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        stream.zalloc = ZlibAlloc;
+        stream.zfree = ZlibFree;
+        // windowBits + 16 for a gzip wrapper (the encoding servers most commonly accept)
+        if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, HTTP_DEFLATE_WINDOW_BITS + 16, HTTP_DEFLATE_MEMLEVEL, Z_DEFAULT_STRATEGY) == Z_OK)
+        {
+            // Not worth sending compressed unless it saves something
+            size_t outputSize = deflateBound(&stream, bodySize);
+            if (outputSize >= bodySize)
+                outputSize = bodySize - 1;
+            Bytef *output = (outputSize > 0) ? (Bytef *)Creator_MemAllocWithTag(outputSize, CreatorMemTag_HTTP) : NULL;
+            if (output)
+            {
+                stream.next_in = (Bytef *)body;
+                stream.avail_in = bodySize;
+                stream.next_out = output;
+                stream.avail_out = outputSize;
+                if (deflate(&stream, Z_FINISH) == Z_STREAM_END)
+                {
+                    CreatorHTTPRequest_AddHeader(self, "Content-Encoding", "gzip");
+                    CreatorHTTPRequest_SetBody(self, output, stream.total_out);
+                    compressed = true;
+                }
+                Creator_MemFree((void **)&output);
+            }
+            deflateEnd(&stream);
+        }
+    }
+#endif
+    if (!compressed)
+        CreatorHTTPRequest_SetBody(self, body, bodySize);
+}
+
+void CreatorHTTPRequest_SetBodyProducer(CreatorHTTPRequest self, CreatorHTTPRequest_BodyProducer producer, void *context)
+{
+    HTTPRequest *request = (HTTPRequest*)self;
+    if (request->Method != CreatorHTTPMethod_Get && request->BodyLength == 0 && !request->HeadersTerminated && producer)
+    {
+        const char *header = "Transfer-Encoding: chunked\r\n\r\n";
+        if (CheckRequestMessage(request, strlen(header)))
+        {
+            // Only the headers are buffered, the body is produced while sending
+            DataBuffer_WriteCString(request->Message, header);
+            request->BodyProducer = producer;
+            request->BodyProducerContext = context;
+            request->HeadersTerminated = true;
         }
     }
 }
@@ -249,31 +455,31 @@ void CreatorHTTPRequest_Send(CreatorHTTPRequest self)
     HTTPRequest *request = (HTTPRequest*)self;
     HTTPClient *client = request->HTTPClient;
     CreatorHTTPError error = CreatorHTTPError_Unspecified;
+    bool reported = false;
     if (client)
     {
-        CreatorScheduler_SetTaskInterval(client->CloseConnectionTaskID, HTTP_RESPONSE_TIME + INACTIVITY_TIMEOUT);
-        if (request->BodyLength == 0)
+        if (!request->HeadersTerminated)
         {
-            // Terminate headers
-            // TODO - fix check for length header room
-            CheckRequestBuffer(request, 24);
-            if (request->Buffer)
+            // Terminate headers (once - the request is sent again if a retry is needed)
+            const char *terminator = (request->Method == CreatorHTTPMethod_Get) ? "\r\n" : "Content-Length: 0\r\n\r\n";
+            if (CheckRequestMessage(request, strlen(terminator)))
             {
-                char *buffer = request->Buffer + request->BufferLength;
-                if (request->Method == CreatorHTTPMethod_Get)
-                {
-                    memcpy(buffer, "\r\n", 2);
-                    request->BufferLength += 2;
-                }
-                else
-                {
-                    request->BufferLength += sprintf(buffer, "Content-Length: 0\r\n\r\n");
-                }
+                DataBuffer_WriteCString(request->Message, terminator);
+                request->HeadersTerminated = true;
             }
         }
 
-        if (request->Buffer)
+        if (request->Message && DataBuffer_GetDataSize(request->Message) == 0)
+        {
+            // a chunk allocation failed while the message was being built
+            Creator_Log(CreatorLogLevel_Error, "HTTP request failed - insufficient memory");
+            DataBuffer_Free(&request->Message);
+        }
+
+        if (request->Message)
         {
+            // Requests sharing the connection go out (and so get their responses) in the order they are queued
+            CreatorMutex_Lock(client->SendLock);
             if (!client->Connection)
             {
                 if (client->ConnectionInfo.ConnectionDestinationAddress == 0)
@@ -298,29 +504,42 @@ void CreatorHTTPRequest_Send(CreatorHTTPRequest self)
                 if (client->ConnectionInfo.ConnectionDestinationAddress != 0)
                 {
                     // Open host connection
-                    client->Connection = CreatorCommonMessaging_CreateConnection(&client->ConnectionInfo, CreatorHTTPCallback, client);
-                    if (!client->Connection)
+                    void *connection = CreatorCommonMessaging_CreateConnection(&client->ConnectionInfo, CreatorHTTPCallback, client);
+                    if (!connection)
                         client->ConnectionInfo.ConnectionDestinationAddress = 0;
+                    CreatorMutex_Lock(_PoolLock);
+                    client->Connection = connection;
+                    CreatorMutex_Unlock(_PoolLock);
                 }
             }
 
-            if (client->Connection)
+            // The connection can be detached from the client at any time (see AbortPipeline), but is only deleted by
+            // a holder of the send lock, so the handle returned here stays valid until it is released
+            void *connection = NULL;
+            // Not sent for want of a connection, or on one that was lost - either way worth sending again
+            error = CreatorHTTPError_NetworkFailure;
+            if (QueueRequest(client, request, &connection))
             {
-                int result = CreatorCommonMessaging_SendRequest(client->Connection, request->Buffer, request->BufferLength, HTTP_RESPONSE_TIME);
+                int result = CreatorCommonMessaging_SendDataBuffer(connection, request->Message, HTTP_RESPONSE_TIME);
+                if (result && request->BodyProducer)
+                    result = SendBodyChunks(client, connection, request);
                 if (result == 0)
                 {
-                    CloseConnection(client);
                     Creator_Log(CreatorLogLevel_Error, "HTTP send failed: %s, total length=%d, content-length=%d", CreatorHTTPMethod_ToString(request->Method),
-                            request->BufferLength, request->BodyLength);
+                            DataBuffer_GetDataSize(request->Message), request->BodyLength);
+                    // Closes the connection - requests already sent on it won't get their responses either. If the
+                    // connection loss has already been handled, this request is reported with the rest of its pipeline.
+                    reported = !AbortPipeline(client, request, CreatorHTTPError_NetworkFailure, true);
                 }
                 else
                 {
                     error = CreatorHTTPError_None;
                 }
             }
+            CreatorMutex_Unlock(client->SendLock);
         }
     }
-    if (error != CreatorHTTPError_None)
+    if (error != CreatorHTTPError_None && !reported)
     {
         // Failed
 #ifdef CREATOR_HTTP_DEBUG
@@ -335,22 +554,20 @@ void CreatorHTTPRequest_Free(CreatorHTTPRequest *self)
     if (self && *self)
     {
         HTTPRequest *request = (HTTPRequest*)*self;
-        if (request->Buffer)
+        if (request->Message)
         {
-            Creator_MemFree((void **)&request->Buffer);
-            request->BufferSize = 0;
+            DataBuffer_Free(&request->Message);
         }
-        if (request->InUse)
-        {
-#ifdef CREATOR_HTTP_DEBUG_SEM
-            SYS_CONSOLE_MESSAGE("\r\nCreatorSemaphore_Release Finish");
+#ifdef HTTP_INFLATE
+        FreeInflater(request);
 #endif
 #ifdef CREATOR_HTTP_DEBUG
-            SYS_CONSOLE_MESSAGE("  HTTP: done\r\n");
+        SYS_CONSOLE_MESSAGE("  HTTP: done\r\n");
 #endif
-            request->InUse = false;
-        }
-        CreatorSemaphore_Release(request->HTTPClient->RequestMutex, 1);
+        // Don't hand a connection with unread response data to the next request
+        if (request->Queued)
+            AbortPipeline(request->HTTPClient, request, CreatorHTTPError_NetworkFailure, false);
+        ReleaseClient(request->HTTPClient, request);
         self = NULL;
     }
 }
@@ -368,6 +585,10 @@ static bool CreatorHTTPResponseResultCallback(char *ptr, size_t headerLength, HT
             if (statusCode > 0 && statusCode != 100)
             {
                 result = true;
+#ifdef HTTP_INFLATE
+                // A re-sent request gets a fresh response
+                FreeInflater(request);
+#endif
                 request->HTTPResult = statusCode;
                 request->ResultCallback(request, request->CallbackContext, (unsigned short)statusCode);
                 // FIXME not robust... ?
@@ -394,6 +615,11 @@ static void CreatorHTTPResponseDataCallback(char *responseData, size_t dataLengt
 {
     if (request->HTTPResult && request->DataCallback)
     {
+#ifdef HTTP_INFLATE
+        if (request->Inflater)
+            InflateResponseData(responseData, dataLength, request);
+        else
+#endif
         request->DataCallback(request, request->CallbackContext, responseData, dataLength);
     }
 }
@@ -413,7 +639,7 @@ bool CreatorHTTPCallback(CreatorCommonMessaging_CallbackEventType callbackEvent,
     HTTPRequest *request = NULL;
     if (client)
     {
-        request = client->Request;
+        request = GetPipelineHead(client);
     }
     if (request && request->InUse)
     {
@@ -425,6 +651,14 @@ bool CreatorHTTPCallback(CreatorCommonMessaging_CallbackEventType callbackEvent,
             }
             case CreatorCommonMessaging_CallbackEventType_Header:
             {
+                // The server will close the connection after this response, so anything sent behind it would be lost
+                if (headerName && value && strcasecmp(headerName, "Connection") == 0 && strncasecmp(value, "close", 5) == 0)
+                    client->Pipelining = false;
+#ifdef HTTP_INFLATE
+                // The body is passed on decoded, so its encoding is of no interest to the caller
+                if (headerName && value && strcasecmp(headerName, "Content-Encoding") == 0 && StartInflater(request, value))
+                    break;
+#endif
                 CreatorHTTPResponseHeaderCallback(headerName, value, length, request);
                 break;
             }
@@ -438,8 +672,19 @@ bool CreatorHTTPCallback(CreatorCommonMessaging_CallbackEventType callbackEvent,
             }
             case CreatorCommonMessaging_CallbackEventType_Finished:
             {
-                CreatorScheduler_SetTaskInterval(client->CloseConnectionTaskID, INACTIVITY_TIMEOUT);
-                CreatorHTTPResponseFinishedCallback(client, request, CreatorHTTPError_None);
+                CreatorHTTPError error = CreatorHTTPError_None;
+#ifdef HTTP_INFLATE
+                if (request->Inflater)
+                {
+                    // Corrupt or truncated compressed body (a response without one, e.g. 204, is fine). Re-sending
+                    // wouldn't help, so this is not reported as a network error.
+                    if (request->Inflater->Failed || (!request->Inflater->Ended && request->Inflater->Stream.total_in > 0))
+                        error = CreatorHTTPError_ContentDecoding;
+                    FreeInflater(request);
+                }
+#endif
+                CompletePipelineHead(client);
+                CreatorHTTPResponseFinishedCallback(client, request, error);
                 break;
             }
             case CreatorCommonMessaging_CallbackEventType_NetworkFailure:
@@ -447,8 +692,7 @@ bool CreatorHTTPCallback(CreatorCommonMessaging_CallbackEventType callbackEvent,
 #ifdef CREATOR_HTTP_DEBUG
                 SYS_CONSOLE_PRINT("\r\nHTTP Error - response timeout or connection lost: dport=%d\r\n", client->ConnectionInfo.ConnectionDestinationPort);
 #endif
-                CloseConnection(client);
-                CreatorHTTPResponseFinishedCallback(client, request, CreatorHTTPError_NetworkFailure);
+                AbortPipeline(client, NULL, CreatorHTTPError_NetworkFailure, false);
                 break;
             }
             case CreatorCommonMessaging_CallbackEventType_HeaderEnd:
@@ -461,7 +705,8 @@ bool CreatorHTTPCallback(CreatorCommonMessaging_CallbackEventType callbackEvent,
     {
         if (client && callbackEvent == CreatorCommonMessaging_CallbackEventType_NetworkFailure)
         {
-            CloseConnection(client);
+            // Not just closed: a request may have been queued on the connection since the pipeline was found empty
+            AbortPipeline(client, NULL, CreatorHTTPError_NetworkFailure, false);
 #ifdef CREATOR_HTTP_DEBUG
             SYS_CONSOLE_PRINT("\r\nHTTP - connection lost: dport=%d (no Rx pending)\r\n", client->ConnectionInfo.ConnectionDestinationPort);
 #endif
@@ -470,43 +715,159 @@ bool CreatorHTTPCallback(CreatorCommonMessaging_CallbackEventType callbackEvent,
     return result;
 }
 
-static void CloseConnection(HTTPClient *client)
+/*
+ * Fails the requests queued on the client's connection and closes it. The caller reports \a except itself, but only
+ * if true is returned - otherwise it was not queued (anymore), and whoever aborted its pipeline reports it.
+ */
+static bool AbortPipeline(HTTPClient *client, HTTPRequest *except, CreatorHTTPError error, bool sendLocked)
 {
-    if (client->Connection)
+    HTTPRequest *aborted[MAX_HTTP_PIPELINE_DEPTH];
+    uint abortedCount;
+    uint index;
+    void *connection;
+    bool exceptQueued = false;
+    CreatorMutex_Lock(_PoolLock);
+    abortedCount = client->PipelineCount;
+    for (index = 0; index < abortedCount; index++)
     {
-        CreatorCommonMessaging_DeleteConnection(client->Connection);
-        client->Connection = NULL;
+        aborted[index] = client->Pipeline[(client->PipelineHead + index) % MAX_HTTP_PIPELINE_DEPTH];
+        aborted[index]->Queued = false;
+        if (aborted[index] == except)
+            exceptQueued = true;
     }
+    client->PipelineCount = 0;
+    if (abortedCount > 1)
+    {
+        // Connection dropped mid-pipeline: the unanswered requests are failed (callers retry them), and from now on
+        // they are sent to this host one at a time
+        client->Pipelining = false;
+        _PoolStatistics.PipelineFallbacks++;
+    }
+    // Detach before waking senders, so none of them queues on the connection being deleted
+    connection = client->Connection;
+    client->Connection = NULL;
+    CreatorCondition_Broadcast(_PoolReleased);
+    CreatorMutex_Unlock(_PoolLock);
+
+    DeleteConnection(client, connection, sendLocked);
+    for (index = 0; index < abortedCount; index++)
+    {
+        if (aborted[index] != except)
+            CreatorHTTPResponseFinishedCallback(client, aborted[index], error);
+    }
+    return exceptQueued;
 }
 
-static void CloseConnectionTask(CreatorTaskID taskID, void *context)
+static void AddHostHeader(HTTPRequest *request, HTTPClient *client)
 {
-    HTTPClient *client = (HTTPClient *)context;
-    if (client)
+    char port[8] = "";
+    int defaultPort = (client->ConnectionInfo.ConnectionTransportType == CREATOR_TLS) ? HTTPS_DEFAULT_PORT : HTTP_DEFAULT_PORT;
+    if (client->ConnectionInfo.ConnectionDestinationPort != defaultPort)
+        sprintf(port, ":%u", client->ConnectionInfo.ConnectionDestinationPort);
+    int nameLength = strlen(client->HostName);
+    int portLength = strlen(port);
+    if (CheckRequestMessage(request, nameLength + portLength + 8))
     {
-        CloseConnection(client);
+        DataBuffer_Write(request->Message, "Host: ", 6);
+        DataBuffer_Write(request->Message, client->HostName, nameLength);
+        DataBuffer_Write(request->Message, port, portLength);
+        DataBuffer_Write(request->Message, "\r\n", 2);
     }
 }
 
-static HTTPClient *GetClient(const char *url, const char **requestUri)
+static void CloseConnection(HTTPClient *client, bool sendLocked)
+{
+    void *connection;
+    CreatorMutex_Lock(_PoolLock);
+    connection = client->Connection;
+    client->Connection = NULL;
+    CreatorCondition_Broadcast(_PoolReleased);
+    CreatorMutex_Unlock(_PoolLock);
+    DeleteConnection(client, connection, sendLocked);
+}
+
+static void CompletePipelineHead(HTTPClient *client)
+{
+    CreatorMutex_Lock(_PoolLock);
+    if (client->PipelineCount > 0)
+    {
+        client->Pipeline[client->PipelineHead]->Queued = false;
+        client->PipelineHead = (client->PipelineHead + 1) % MAX_HTTP_PIPELINE_DEPTH;
+        client->PipelineCount--;
+        // The parser stops the response timeout at the end of each response
+        if (client->PipelineCount > 0)
+            CreatorCommonMessaging_ExpectResponse(client->Connection, HTTP_RESPONSE_TIME);
+        CreatorCondition_Broadcast(_PoolReleased);
+    }
+    CreatorMutex_Unlock(_PoolLock);
+}
+
+#ifdef HTTP_INFLATE
+static void FreeInflater(HTTPRequest *request)
+{
+    if (request->Inflater)
+    {
+        inflateEnd(&request->Inflater->Stream);
+        Creator_MemFree((void **)&request->Inflater);
+    }
+}
+#endif
+
+static void DeleteConnection(HTTPClient *client, void *connection, bool sendLocked)
+{
+    // A detached connection may still be in use by the sender holding the send lock, so wait for it to finish
+    if (connection)
+    {
+        if (!sendLocked)
+            CreatorMutex_Lock(client->SendLock);
+        CreatorCommonMessaging_DeleteConnection(connection);
+        if (!sendLocked)
+            CreatorMutex_Unlock(client->SendLock);
+    }
+}
+
+static HTTPRequest *GetPipelineHead(HTTPClient *client)
+{
+    HTTPRequest *result = NULL;
+    CreatorMutex_Lock(_PoolLock);
+    if (client->PipelineCount > 0)
+        result = client->Pipeline[client->PipelineHead];
+    CreatorMutex_Unlock(_PoolLock);
+    return result;
+}
+
+static bool IsClientForHost(HTTPClient *client, const char *hostName, int hostNameLength, int port)
+{
+    bool result = false;
+    if (client->HostName && client->ConnectionInfo.ConnectionDestinationPort == port)
+    {
+        int length = strlen(client->HostName);
+        result = (length == hostNameLength && memcmp(client->HostName, hostName, hostNameLength) == 0);
+    }
+    return result;
+}
+
+static HTTPRequest *GetClient(const char *url, bool pipelinable, const char **requestUri)
 {
     int index;
     HTTPClient *client = NULL;
+    HTTPRequest *request = NULL;
     const char *hostName = NULL;
     bool isSSL = false;
     int port;
     int connectionTransportType;
     int hostNameLength = 0;
+    void *evictedConnection = NULL;
     // Use protocol to get the connection
     if (strncmp(url, "http://", 7) == 0)
     {
-        port = 80;
+        port = HTTP_DEFAULT_PORT;
         connectionTransportType = CREATOR_TCP;
         hostName = url + 7;
     }
     else //if (strncmp(url, "https://", 8) == 0)
     {
-        port = 443;
+        port = HTTPS_DEFAULT_PORT;
         connectionTransportType = CREATOR_TLS;
         hostName = url + 8;
         isSSL = true;
@@ -526,108 +887,338 @@ static HTTPClient *GetClient(const char *url, const char **requestUri)
             hostNameLength = strlen(hostName);
             *requestUri = "/";
         }
+        // An explicit port ("host:port") is part of what the connection is for
+        const char *portStart = memchr(hostName, ':', hostNameLength);
+        if (portStart)
+        {
+            long explicitPort = strtol(portStart + 1, NULL, 10);
+            if (explicitPort > 0 && explicitPort <= 0xFFFF)
+                port = (int)explicitPort;
+            hostNameLength = portStart - hostName;
+        }
     }
 
-    time_t oldest;
-    Creator_GetTime(&oldest);
-    int bestIndex = -1;
-    for (index = 0; index < MAX_HTTP_CONNECTIONS; index++)
+    CreatorMutex_Lock(_PoolLock);
+    while (!client)
     {
-        if (_HTTPClient[index].HostName)
+        // Prefer an idle open connection to the same host, then queueing behind other requests on an open one (if
+        // pipelining). Otherwise take an idle (closed) one, an unused slot or evict the least recently used idle one -
+        // unless the host already has its share
+        HTTPClient *idleMatch = NULL;
+        HTTPClient *pipelineMatch = NULL;
+        HTTPClient *unused = NULL;
+        HTTPClient *leastRecentlyUsed = NULL;
+        int hostBusyCount = 0;
+        for (index = 0; index < MAX_HTTP_CONNECTIONS; index++)
         {
-            if (_HTTPClient[index].ConnectionInfo.ConnectionDestinationPort == port)
+            HTTPClient *candidate = &_HTTPClient[index];
+            if (IsClientForHost(candidate, hostName, hostNameLength, port))
             {
-                int length = strlen(_HTTPClient[index].HostName);
-                if (length == hostNameLength && memcmp(_HTTPClient[index].HostName, hostName, hostNameLength) == 0)
+                if (candidate->Owners > 0)
                 {
-                    client = &_HTTPClient[index];
-                    break;
+                    hostBusyCount++;
+                    if (pipelinable && candidate->Pipelining && candidate->Connection && candidate->SerialOwners == 0
+                            && candidate->Owners < MAX_HTTP_PIPELINE_DEPTH && (!pipelineMatch || candidate->Owners < pipelineMatch->Owners))
+                        pipelineMatch = candidate;
                 }
+                else if (!idleMatch || (candidate->Connection && !idleMatch->Connection)
+                        || ((!candidate->Connection == !idleMatch->Connection) && candidate->UseOrder > idleMatch->UseOrder))
+                    idleMatch = candidate;
             }
-            else
+            else if (candidate->Owners == 0)
             {
-                if (_HTTPClient[index].LastUsed < oldest)
+                if (!candidate->HostName)
                 {
-                    oldest = _HTTPClient[index].LastUsed;
-                    bestIndex = index;
+                    if (!unused)
+                        unused = candidate;
                 }
+                else if (!leastRecentlyUsed || candidate->UseOrder < leastRecentlyUsed->UseOrder)
+                {
+                    leastRecentlyUsed = candidate;
+                }
+            }
+        }
+
+        if (idleMatch && idleMatch->Connection)
+        {
+            client = idleMatch;
+            _PoolStatistics.Hits++;
+        }
+        else if (pipelineMatch)
+        {
+            client = pipelineMatch;
+            _PoolStatistics.Hits++;
+        }
+        else if (idleMatch)
+        {
+            client = idleMatch;
+            _PoolStatistics.Misses++;
+        }
+        else if (hostBusyCount < MAX_HTTP_CONNECTIONS_PER_HOST && (unused || leastRecentlyUsed))
+        {
+            client = unused ? unused : leastRecentlyUsed;
+            _PoolStatistics.Misses++;
+            if (client->HostName)
+            {
+                _PoolStatistics.Evictions++;
+                CreatorString_Free(&client->HostName);
             }
+            // Closed once the pool lock has been released
+            evictedConnection = client->Connection;
+            client->Connection = NULL;
+            client->ConnectionInfo.ConnectionDestinationPort = port;
+            client->ConnectionInfo.ConnectionTransportType = connectionTransportType;
+            client->ConnectionInfo.ConnectionDestinationAddress = 0;
+            client->ConnectionInfo.TLSCertificateData = NULL;
+            client->HostName = CreatorString_DuplicateWithLength(hostName, hostNameLength);
+            client->HostAddress = 0;
+            client->Pipelining = (MAX_HTTP_PIPELINE_DEPTH > 1);
         }
         else
         {
-            bestIndex = index;
-            oldest = 0;
+            // Wait for a request to release its connection
+            _PoolStatistics.Waits++;
+            CreatorCondition_Wait(_PoolReleased, _PoolLock);
         }
     }
-
-    if (client)
+    // There are enough requests for every connection to be fully owned
+    for (index = 0; index < MAX_HTTP_REQUESTS; index++)
     {
-        CreatorSemaphore_Wait(client->RequestMutex, 1);
-        Creator_GetTime(&client->LastUsed);
+        if (!_HTTPRequest[index].InUse)
+        {
+            request = &_HTTPRequest[index];
+            break;
+        }
     }
-    else
+    request->InUse = true;
+    request->HTTPClient = client;
+    request->Pipelinable = pipelinable;
+    client->Owners++;
+    if (!pipelinable)
+        client->SerialOwners++;
+    client->UseOrder = ++_UseCount;
+    Creator_GetTime(&client->LastUsed);
+    CreatorMutex_Unlock(_PoolLock);
+
+    if (evictedConnection)
+        CreatorCommonMessaging_DeleteConnection(evictedConnection);
+    if (isSSL && !client->ConnectionInfo.TLSCertificateData && client->HostName)
+        client->ConnectionInfo.TLSCertificateData = CreatorCert_GetCertificate(client->HostName);
+    return request;
+}
+
+#ifdef HTTP_INFLATE
+static void InflateResponseData(char *data, size_t dataLength, HTTPRequest *request)
+{
+    HTTPInflater *inflater = request->Inflater;
+    z_stream *stream = &inflater->Stream;
+    if (stream->total_in == 0 && dataLength > 0)
+        inflater->FirstByte = (Bytef)data[0];
+    stream->next_in = (Bytef *)data;
+    stream->avail_in = dataLength;
+    do
     {
-        client = &_HTTPClient[bestIndex];
-#ifdef CREATOR_HTTP_DEBUG_SEM
-        SYS_CONSOLE_MESSAGE("\r\nCreatorSemaphore_Wait");
+        int result;
+        size_t outputLength;
+        stream->next_out = (Bytef *)inflater->Output;
+        stream->avail_out = sizeof(inflater->Output);
+        result = inflate(stream, Z_NO_FLUSH);
+        if (result == Z_DATA_ERROR && inflater->Deflate && stream->total_out == 0)
+        {
+            // Not zlib wrapped - start again as raw deflate (only once). The header check fails by the second byte,
+            // so at most the first byte came in an earlier piece of data.
+            uLong earlierLength = stream->total_in - (dataLength - stream->avail_in);
+            inflater->Deflate = false;
+            if (earlierLength <= 1 && inflateReset2(stream, -HTTP_INFLATE_WINDOW_BITS) == Z_OK)
+            {
+                if (earlierLength == 1)
+                {
+                    // too short to produce any output
+                    stream->next_in = &inflater->FirstByte;
+                    stream->avail_in = 1;
+                    inflate(stream, Z_NO_FLUSH);
+                }
+                stream->next_in = (Bytef *)data;
+                stream->avail_in = dataLength;
+                continue;
+            }
+        }
+        if (result == Z_STREAM_END)
+            inflater->Ended = true;
+        else if (result != Z_OK && result != Z_BUF_ERROR)       // Z_BUF_ERROR - no more output for now
+            inflater->Failed = true;
+
+        outputLength = sizeof(inflater->Output) - stream->avail_out;
+        if (outputLength > 0)
+            request->DataCallback(request, request->CallbackContext, inflater->Output, outputLength);
+        // A full output buffer may leave more output pending in zlib, even once all the input is used
+    } while ((stream->avail_in > 0 || stream->avail_out == 0) && !inflater->Ended && !inflater->Failed);
+}
 #endif
-        CreatorSemaphore_Wait(client->RequestMutex, 1);
-        CloseConnection(client);
-        client->ConnectionInfo.ConnectionDestinationPort = port;
-        client->ConnectionInfo.ConnectionTransportType = connectionTransportType;
-        client->ConnectionInfo.ConnectionDestinationAddress = 0;
-        if (client->HostName)
-            CreatorString_Free(&client->HostName);
-        client->HostName = CreatorString_DuplicateWithLength(hostName, hostNameLength);
-        client->HostAddress = 0;
-        if (isSSL)
-            client->ConnectionInfo.TLSCertificateData = CreatorCert_GetCertificate(client->HostName);
-#ifdef CREATOR_HTTP_DEBUG_SEM
-        SYS_CONSOLE_MESSAGE("\r\nGOT CreatorSemaphore_Wait");
+
+#ifdef HAVE_LIBZ
+static void *ZlibAlloc(void *opaque, uInt items, uInt size)
+{
+    (void)opaque;
+    return Creator_MemAllocWithTag(items * size, CreatorMemTag_HTTP);
+}
+
+static void ZlibFree(void *opaque, void *address)
+{
+    (void)opaque;
+    Creator_MemFree(&address);
+}
 #endif
-        Creator_GetTime(&client->LastUsed);
+
+static bool QueueRequest(HTTPClient *client, HTTPRequest *request, void **connection)
+{
+    // Called with the client's send lock held. A request that can't be pipelined waits for the responses to those
+    // already sent (as do all requests once the server has dropped a pipeline).
+    bool result = false;
+    CreatorMutex_Lock(_PoolLock);
+    while (client->Connection && client->PipelineCount > 0
+            && !(request->Pipelinable && client->Pipelining && client->PipelineCount < MAX_HTTP_PIPELINE_DEPTH))
+    {
+        CreatorCondition_Wait(_PoolReleased, _PoolLock);
+    }
+    // The connection may have been dropped while waiting (the request is then retried by the caller)
+    if (client->Connection)
+    {
+        *connection = client->Connection;
+        if (client->PipelineCount > 0)
+            _PoolStatistics.Pipelined++;
+        client->Pipeline[(client->PipelineHead + client->PipelineCount) % MAX_HTTP_PIPELINE_DEPTH] = request;
+        client->PipelineCount++;
+        request->Queued = true;
+        result = true;
+    }
+    CreatorMutex_Unlock(_PoolLock);
+    return result;
+}
+
+static void ReapIdleConnectionsTask(CreatorTaskID taskID, void *context)
+{
+    void *idleConnections[MAX_HTTP_CONNECTIONS];
+    int idleCount = 0;
+    int index;
+    time_t now;
+    Creator_GetTime(&now);
+    CreatorMutex_Lock(_PoolLock);
+    for (index = 0; index < MAX_HTTP_CONNECTIONS; index++)
+    {
+        HTTPClient *client = &_HTTPClient[index];
+        if (client->Owners == 0 && client->Connection && (now - client->LastUsed) >= INACTIVITY_TIMEOUT)
+        {
+            idleConnections[idleCount++] = client->Connection;
+            client->Connection = NULL;
+        }
     }
+    _PoolStatistics.Reaped += idleCount;
+    CreatorMutex_Unlock(_PoolLock);
+
+    for (index = 0; index < idleCount; index++)
+        CreatorCommonMessaging_DeleteConnection(idleConnections[index]);
+}
 
-    return client;
+static void ReleaseClient(HTTPClient *client, HTTPRequest *request)
+{
+    CreatorMutex_Lock(_PoolLock);
+    request->InUse = false;
+    client->Owners--;
+    if (!request->Pipelinable)
+        client->SerialOwners--;
+    Creator_GetTime(&client->LastUsed);
+    // Waiters may be after different hosts, so wake them all
+    CreatorCondition_Broadcast(_PoolReleased);
+    CreatorMutex_Unlock(_PoolLock);
 }
 
-static void CheckRequestBuffer(HTTPRequest *request, size_t size)
+#ifdef HTTP_INFLATE
+static bool StartInflater(HTTPRequest *request, const char *encoding)
 {
-    // Reallocate if smaller buffer already allocated
-    // Note - don't allocate buffer if previous reallocate already failed
-    size_t newSize = request->BufferLength + size;
-    if (request->Buffer && newSize > request->BufferSize)
+    bool result = false;
+    bool gzip = (strcasecmp(encoding, "gzip") == 0) || (strcasecmp(encoding, "x-gzip") == 0);
+    if (gzip || strcasecmp(encoding, "deflate") == 0)
     {
-        bool success = false;
-        if (newSize < MAX_HTTP_MESSAGE_SIZE)
+        FreeInflater(request);
+        request->Inflater = (HTTPInflater *)Creator_MemAllocWithTag(sizeof(HTTPInflater), CreatorMemTag_HTTP);
+        if (request->Inflater)
         {
-            // Round up new size to nearest re-allocation size
-            newSize = ((newSize / INCREASE_MESSAGE_SIZE) + 1) * INCREASE_MESSAGE_SIZE;
-            char *newBuffer = Creator_MemRealloc(request->Buffer, newSize);
-            if (newBuffer)
+            memset(request->Inflater, 0, sizeof(HTTPInflater));
+            request->Inflater->Stream.zalloc = ZlibAlloc;
+            request->Inflater->Stream.zfree = ZlibFree;
+            request->Inflater->Deflate = !gzip;
+            // windowBits + 32 detects a gzip or zlib wrapper (the window is only as big as the stream needs)
+            if (inflateInit2(&request->Inflater->Stream, HTTP_INFLATE_WINDOW_BITS + 32) == Z_OK)
             {
-                request->Buffer = newBuffer;
-                request->BufferSize = newSize;
-                success = true;
+                result = true;
             }
             else
             {
-                Creator_Log(CreatorLogLevel_Error, "HTTP request failed - insufficient memory (buffer size = %d)", newSize);
+                Creator_MemFree((void **)&request->Inflater);
             }
         }
+        if (!result)
+            Creator_Log(CreatorLogLevel_Error, "HTTP response can't be decoded (%s) - insufficient memory", encoding);
+    }
+    return result;
+}
+#endif
+
+static bool SendBodyChunks(HTTPClient *client, void *connection, HTTPRequest *request)
+{
+    // Called with the client's send lock held. Each piece is framed in place in the client's chunk buffer, so an upload
+    // needs no more memory however long the body is. Each send restarts the response timeout.
+    bool result = true;
+    size_t offset = 0;
+    int length;
+    do
+    {
+        char *data = client->BodyChunk + HTTP_CHUNK_HEADER_SIZE;
+        length = request->BodyProducer((CreatorHTTPRequest)request, request->BodyProducerContext, offset, data, HTTP_BODY_CHUNK_SIZE);
+        if (length < 0 || length > HTTP_BODY_CHUNK_SIZE)
+        {
+            // The server is still waiting for the rest of the body, so the connection can't be used again
+            Creator_Log(CreatorLogLevel_Error, "HTTP request body aborted at %lu bytes", (unsigned long)offset);
+            result = false;
+        }
         else
         {
-            Creator_Log(CreatorLogLevel_Error, "HTTP request failed - message too big (buffer size = %d)", newSize);
+            char header[HTTP_CHUNK_HEADER_SIZE + 1];
+            int headerLength = snprintf(header, sizeof(header), "%X\r\n", length);
+            char *chunk = data - headerLength;
+            int chunkLength = headerLength + length + 2;
+            memcpy(chunk, header, headerLength);
+            data[length] = '\r';
+            data[length + 1] = '\n';           // for the last chunk this ends the (empty) trailer: "0\r\n\r\n"
+            result = CreatorCommonMessaging_SendRequest(connection, chunk, chunkLength, HTTP_RESPONSE_TIME);
+            offset += length;
         }
+    } while (result && length > 0);
+    return result;
+}
 
-        if (!success)
+static bool CheckRequestMessage(HTTPRequest *request, size_t size)
+{
+    // Message is built in pool-sized chunks, so only the overall limit needs checking here
+    // Note - the message is dropped (and not re-created) once a limit has been exceeded
+    bool result = false;
+    if (request->Message)
+    {
+        size_t newSize = DataBuffer_GetDataSize(request->Message) + size;
+        if (newSize < MAX_HTTP_MESSAGE_SIZE)
+        {
+            result = true;
+        }
+        else
         {
             // Message too big (DON'T send, just wait for release)
             // TODO - Set failed status or do error result callback on send request?
-            Creator_MemFree((void **)&request->Buffer);
-            request->BufferSize = 0;
+            Creator_Log(CreatorLogLevel_Error, "HTTP request failed - message too big (buffer size = %d)", (int)newSize);
+            DataBuffer_Free(&request->Message);
         }
     }
+    return result;
 }
 
 #endif
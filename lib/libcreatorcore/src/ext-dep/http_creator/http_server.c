@@ -205,6 +205,7 @@ void CreatorHTTPServerRequest_SendResponse(CreatorHTTPServerRequest self, int st
 void CreatorHTTPServer_Initialise(void)
 {
     _ServersLock = CreatorSemaphore_New(1, 0);
+    CreatorSemaphore_SetName(_ServersLock, "ServersLock");
     _Servers = CreatorList_New(5);
     _ListenThread = CreatorThread_New("Http", 1, 4096, ListenForClient, NULL);
 }
@@ -213,7 +214,7 @@ CreatorHTTPServer CreatorHTTPServer_New(int port, bool secure, CreatorHTTPServer
 {
     CreatorHTTPServer result;
     size_t size = sizeof(struct CreatorHTTPServerImpl);
-    result = Creator_MemAlloc(size);
+    result = Creator_MemAllocWithTag(size, CreatorMemTag_HTTP);
     if (result)
     {
         memset(result, 0, size);
@@ -263,7 +264,7 @@ bool CreatorHTTPServer_Start(CreatorHTTPServer self)
             if (serverSocket != SOCKET_ERROR)
             {
                 addressLength = sizeof(struct sockaddr_in);
-                struct sockaddr_in *ipAddress = Creator_MemAlloc(addressLength);
+                struct sockaddr_in *ipAddress = Creator_MemAllocWithTag(addressLength, CreatorMemTag_HTTP);
                 if (ipAddress)
                 {
                     memset(ipAddress, 0, addressLength);
@@ -284,7 +285,7 @@ bool CreatorHTTPServer_Start(CreatorHTTPServer self)
             if (serverSocket != SOCKET_ERROR)
             {
                 addressLength = sizeof(struct sockaddr_in6);
-                struct sockaddr_in6 *ipAddress = Creator_MemAlloc(addressLength);
+                struct sockaddr_in6 *ipAddress = Creator_MemAllocWithTag(addressLength, CreatorMemTag_HTTP);
                 if (ipAddress)
                 {
                     memset(ipAddress, 0, addressLength);
@@ -364,7 +365,7 @@ static bool HttpProtocolCallBack(CreatorCommonMessaging_CallbackEventType callba
                 if (request->ContentLength != 0)
                 {
                     request->CurrentContentPosition = 0;
-                    request->Content = Creator_MemAlloc(request->ContentLength);
+                    request->Content = Creator_MemAllocWithTag(request->ContentLength, CreatorMemTag_HTTP);
                 }
             }
             else if (strcasecmp(headerName, "Content-Type") == 0)
@@ -424,12 +425,12 @@ static void ListenForClient(CreatorThread thread, void *context)
                     }
 #endif
                     size_t size = sizeof(CreatorCommonMessaging_ControlBlock);
-                    CreatorCommonMessaging_ControlBlock *clientControl = Creator_MemAlloc(size);
+                    CreatorCommonMessaging_ControlBlock *clientControl = Creator_MemAllocWithTag(size, CreatorMemTag_HTTP);
                     if (clientControl)
                     {
                         memset(clientControl, 0, size);
                         size = sizeof(HTTPServerRequest);
-                        HTTPServerRequest *request = Creator_MemAlloc(size);
+                        HTTPServerRequest *request = Creator_MemAllocWithTag(size, CreatorMemTag_HTTP);
                         if (request)
                         {
                             memset(request, 0, size);
@@ -439,9 +440,6 @@ static void ListenForClient(CreatorThread thread, void *context)
                             clientControl->Enabled = true;
                             clientControl->ProtocolCallBack = HttpProtocolCallBack;
                             clientControl->CallbackContext = request;
-                            clientControl->ReceivedBuffer = Creator_MemAlloc(CREATOR_MAX_PACKET_LEN);
-                            if (clientControl->ReceivedBuffer)
-                                memset(clientControl->ReceivedBuffer, 0, CREATOR_MAX_PACKET_LEN);
 
                             clientControl->IsPacketBegining = true;
                             if (server->Secure)
@@ -451,8 +449,7 @@ static void ListenForClient(CreatorThread thread, void *context)
                                 clientControl->TLSCertificateSize = server->CertLength;
                                 if (!CreatorTLS_StartSSLSession(clientControl, false))
                                 {
-                                    if (clientControl->ReceivedBuffer)
-                                        Creator_MemFree((void **)&clientControl->ReceivedBuffer);
+                                    CreatorCommonMessaging_FreeReceiveBuffer(&clientControl->ReceivedBuffer);
                                     Creator_MemFree((void **)&clientControl);
                                     CreatorHTTPServerRequest_Free(&request);
                                     closesocket(client);
@@ -484,8 +481,7 @@ static void ListenForClient(CreatorThread thread, void *context)
                 if (!clientControl->Enabled || clientControl->ConnectionHandle == SOCKET_ERROR)
                 {
                     CreatorHTTPServerRequest_Free((CreatorHTTPServerRequest *)&clientControl->CallbackContext);
-                    if (clientControl->ReceivedBuffer)
-                        Creator_MemFree((void **)&clientControl->ReceivedBuffer);
+                    CreatorCommonMessaging_FreeReceiveBuffer(&clientControl->ReceivedBuffer);
                     if (clientControl->SSLSession)
                         CreatorTLS_EndSSLSession(clientControl);
                     if (clientControl->ConnectionHandle != SOCKET_ERROR)
@@ -508,8 +504,7 @@ static void ListenForClient(CreatorThread thread, void *context)
         if (clientControl)
         {
             CreatorHTTPServerRequest_Free((CreatorHTTPServerRequest *)&clientControl->CallbackContext);
-            if (clientControl->ReceivedBuffer)
-                Creator_MemFree((void **)&clientControl->ReceivedBuffer);
+            CreatorCommonMessaging_FreeReceiveBuffer(&clientControl->ReceivedBuffer);
             if (clientControl->SSLSession)
                 CreatorTLS_EndSSLSession(clientControl);
             if (clientControl->ConnectionHandle != SOCKET_ERROR)
@@ -48,6 +48,8 @@ typedef struct
     size_t BodySize;
     size_t BodyWritten;
     bool BodyHandled;
+    CreatorHTTPRequest_BodyProducer BodyProducer;
+    void *BodyProducerContext;
 
     int HTTPResult;
 
@@ -60,6 +62,7 @@ typedef struct
 
 static size_t curlResponseDataReadFunction(char *ptr, size_t size, size_t nmemb, void *userdata);
 static size_t curlRequestDataWriteFunction(void *ptr, size_t size, size_t nmemb, void *userdata);
+static size_t curlRequestBodyProducerFunction(void *ptr, size_t size, size_t nmemb, void *userdata);
 static size_t curlResponseHeaderFunction(void *ptr, size_t size, size_t nmemb, void *userdata);
 
 void CreatorHTTP_Initialise(void)
@@ -70,6 +73,12 @@ void CreatorHTTP_Shutdown(void)
 {
 }
 
+bool CreatorHTTP_GetConnectionPoolStatistics(CreatorHTTPConnectionPoolStatistics *statistics)
+{
+    // Each request uses its own curl handle
+    return false;
+}
+
 CreatorHTTPRequest CreatorHTTPRequest_New(CreatorHTTPMethod method, const char *url, CreatorHTTPRequest_ResultCallback resultCallback, CreatorHTTPRequest_HeaderCallback headerCallback, CreatorHTTPRequest_DataCallback dataCallback, CreatorHTTPRequest_FinishCallback finishCallback, void *callbackContext)
 {
     RequestContext *result = Creator_MemAlloc(sizeof(RequestContext));
@@ -87,6 +96,8 @@ CreatorHTTPRequest CreatorHTTPRequest_New(CreatorHTTPMethod method, const char *
             result->BodySize = 0;
             result->BodyWritten = 0;
             result->BodyHandled = false;
+            result->BodyProducer = NULL;
+            result->BodyProducerContext = NULL;
 
             result->CallbackContext = callbackContext;
             result->ResultCallback = resultCallback;
@@ -137,10 +148,11 @@ CreatorHTTPRequest CreatorHTTPRequest_New(CreatorHTTPMethod method, const char *
 
             CreatorHTTPRequest_AddHeader((CreatorHTTPRequest)result, "User-Agent", "libcurl; Creator REST Client");
 
+            // "" - every encoding libcurl can decode (gzip and deflate)
 #if LIBCURL_VERSION_NUM >= 0x071506
-            curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "gzip");
+            curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
 #else
-            curl_easy_setopt(curl, CURLOPT_ENCODING, "gzip");
+            curl_easy_setopt(curl, CURLOPT_ENCODING, "");
 #endif
         }
         else
@@ -195,6 +207,27 @@ void CreatorHTTPRequest_SetBody(CreatorHTTPRequest self, const void *body, size_
     }
 }
 
+void CreatorHTTPRequest_SetCompressedBody(CreatorHTTPRequest self, const void *body, size_t bodySize)
+{
+    // libcurl doesn't compress request bodies
+    CreatorHTTPRequest_SetBody(self, body, bodySize);
+}
+
+void CreatorHTTPRequest_SetBodyProducer(CreatorHTTPRequest self, CreatorHTTPRequest_BodyProducer producer, void *context)
+{
+    RequestContext *requestContext = (RequestContext*)self;
+    if (requestContext && producer && (requestContext->Method == CreatorHTTPMethod_Post || requestContext->Method == CreatorHTTPMethod_Put))
+    {
+        /* curl sends a body of unknown size chunked, reading it as it goes */
+        requestContext->BodyHandled = true;
+        requestContext->BodyProducer = producer;
+        requestContext->BodyProducerContext = context;
+        CreatorHTTPRequest_AddHeader(self, "Transfer-Encoding", "chunked");
+        curl_easy_setopt(requestContext->Curl, CURLOPT_READFUNCTION, curlRequestBodyProducerFunction);
+        curl_easy_setopt(requestContext->Curl, CURLOPT_READDATA, requestContext);
+    }
+}
+
 void CreatorHTTPRequest_Send(CreatorHTTPRequest self)
 {
     RequestContext *context = (RequestContext*)self;
@@ -211,13 +244,17 @@ void CreatorHTTPRequest_Send(CreatorHTTPRequest self)
         curl_easy_setopt(context->Curl, CURLOPT_COPYPOSTFIELDS , "");
     }
 
+    /* a re-sent request reads its body from the start again */
+    context->BodyWritten = 0;
     success = curl_easy_perform(context->Curl);
     if(success != CURLE_OK)
     {
         Creator_Log(CreatorLogLevel_Error, "HTTP %p failed: curl error %d", self, success);
     }
     CreatorHTTPError error = CreatorHTTPError_None;
-    if (success != CURLE_OK)
+    if (success == CURLE_BAD_CONTENT_ENCODING)
+        error = CreatorHTTPError_ContentDecoding;
+    else if (success != CURLE_OK)
     error = CreatorHTTPError_Unspecified;
     context->FinishCallback(self, context->CallbackContext, error);
 }
@@ -263,6 +300,16 @@ static size_t curlRequestDataWriteFunction(void *ptr, size_t size, size_t nmemb,
     return chunkSize;
 }
 
+static size_t curlRequestBodyProducerFunction(void *ptr, size_t size, size_t nmemb, void *userdata)
+{
+    RequestContext *context = (RequestContext*)userdata;
+    int length = context->BodyProducer(context, context->BodyProducerContext, context->BodyWritten, (char*)ptr, size * nmemb);
+    if (length < 0)
+        return CURL_READFUNC_ABORT;
+    context->BodyWritten += length;
+    return length;
+}
+
 static size_t curlResponseHeaderFunction(void *ptr, size_t size, size_t nmemb, void *userdata)
 {
     RequestContext *context = (RequestContext*)userdata;
@@ -22,53 +22,73 @@
 
 #ifdef FREERTOS
 
-#include <stdlib.h>
-#include <string.h>
-#include "FreeRTOS.h"
-#include "task.h"
-
 #include "creator/core/creator_memalloc.h"
 #include "creator/core/creator_debug.h"
+#include "creator/core/memalloc_accounting.h"
+#include "creator/core/memalloc_trace.h"
+#include "mem_pool.h"
 
-static inline void Creator_MemLock(void)
-{
-    vTaskSuspendAll();
-}
+/*
+ * Small blocks come from the size-class pool, which only enters a short critical section. Only large blocks and pool
+ * slab refills suspend the scheduler to use the heap.
+ */
 
-static inline void Creator_MemUnLock(void)
+void *Creator_MemAlloc(size_t size)
 {
-    xTaskResumeAll();
+    return Creator_MemAllocWithTag(size, CreatorMemTag_Other);
 }
 
-void *Creator_MemAlloc(size_t size)
+void *Creator_MemAllocWithTag(size_t size, CreatorMemTag tag)
 {
-    void *result;
-    Creator_MemLock();
-    result = malloc(size);
-    Creator_MemUnLock();
-
+    void *result = MemPool_Alloc(size);
+#ifdef CREATOR_MEMALLOC_ACCOUNTING
+    // The pool block header has room for the tag, accounting costs no extra memory
+    if (result)
+    {
+        MemPool_SetTag(result, (unsigned char)tag);
+        MemAccounting_Allocated(tag, size);
+    }
+    else
+    {
+        MemAccounting_Failed(tag);
+    }
+#endif
+    MEMTRACE_ALLOC(result, size, tag);
     Creator_Assert(result != NULL, "Allocation of %ld bytes failed", size);
     return result;
 }
 
 void *Creator_MemCalloc(size_t blockCount, size_t blockSize)
 {
-    void *result;
-    Creator_MemLock();
-    result = calloc(blockCount, blockSize);
-    Creator_MemUnLock();
-
+    void *result = MemPool_Calloc(blockCount, blockSize);
+#ifdef CREATOR_MEMALLOC_ACCOUNTING
+    if (result)
+        MemAccounting_Allocated(CreatorMemTag_Other, blockCount * blockSize);
+    else
+        MemAccounting_Failed(CreatorMemTag_Other);
+#endif
+    MEMTRACE_ALLOC(result, blockCount * blockSize, CreatorMemTag_Other);
     Creator_Assert(result != NULL, "Allocation of %ld bytes failed", blockCount * blockSize);
     return result;
 }
 
 void *Creator_MemRealloc(void *buffer, size_t size)
 {
+#ifdef CREATOR_MEMALLOC_ACCOUNTING
     void *result;
-    Creator_MemLock();
-    result = realloc(buffer, size);
-    Creator_MemUnLock();
-
+    if (!buffer)
+        return Creator_MemAlloc(size);
+    CreatorMemTag tag = (CreatorMemTag)MemPool_GetTag(buffer);
+    size_t oldSize = MemPool_GetSize(buffer);
+    result = MemPool_Realloc(buffer, size);
+    if (result)
+        MemAccounting_Resized(tag, oldSize, size);
+    else
+        MemAccounting_Failed(tag);
+#else
+    void *result = MemPool_Realloc(buffer, size);
+#endif
+    MEMTRACE_REALLOC(buffer, result, size);
     Creator_Assert(result != NULL, "(Re)Allocation of %ld bytes failed", size);
     return result;
 }
@@ -77,9 +97,7 @@ void Creator_MemFree(void **buffer)
 {
     if (*buffer)
     {
-        Creator_MemLock();
-        free(*buffer);
-        Creator_MemUnLock();
+        Creator_MemSafeFree(*buffer);
         *buffer = NULL;
     }
 }
@@ -88,9 +106,11 @@ void Creator_MemSafeFree(void *buffer)
 {
     if (buffer)
     {
-        Creator_MemLock();
-        free(buffer);
-        Creator_MemUnLock();
+        MEMTRACE_FREE(buffer);
+#ifdef CREATOR_MEMALLOC_ACCOUNTING
+        MemAccounting_Freed((CreatorMemTag)MemPool_GetTag(buffer), MemPool_GetSize(buffer));
+#endif
+        MemPool_Free(buffer);
     }
 }
 
@@ -27,10 +27,51 @@
 
 #include "creator/core/creator_debug.h"
 #include "creator/core/creator_memalloc.h"
+#include "creator/core/memalloc_accounting.h"
+#include "creator/core/memalloc_trace.h"
+
+#ifdef CREATOR_MEMALLOC_ACCOUNTING
+/*
+ * Accounting builds put the size and tag in front of each block, padded so the buffer keeps malloc's alignment
+ */
+typedef union
+{
+    struct
+    {
+        size_t Size;
+        CreatorMemTag Tag;
+    } Info;
+    long double AlignDouble;
+    long long AlignLong;
+    void *AlignPointer;
+} AllocationHeader;
+#endif
 
 void *Creator_MemAlloc(size_t size)
 {
+    return Creator_MemAllocWithTag(size, CreatorMemTag_Other);
+}
+
+void *Creator_MemAllocWithTag(size_t size, CreatorMemTag tag)
+{
+#ifdef CREATOR_MEMALLOC_ACCOUNTING
+    void *result = NULL;
+    AllocationHeader *header = malloc(sizeof(AllocationHeader) + size);
+    if (header)
+    {
+        header->Info.Size = size;
+        header->Info.Tag = tag;
+        MemAccounting_Allocated(tag, size);
+        result = header + 1;
+    }
+    else
+    {
+        MemAccounting_Failed(tag);
+    }
+#else
     void *result = malloc(size);
+#endif
+    MEMTRACE_ALLOC(result, size, tag);
     //Creator_Log(CreatorLogLevel_Debug, "Allocating %ld bytes to %p", size, result);
     Creator_Assert(result != NULL, "Allocation of %ld bytes failed", size);
     return result;
@@ -38,14 +79,53 @@ void *Creator_MemAlloc(size_t size)
 
 void *Creator_MemCalloc(size_t blockCount, size_t blockSize)
 {
+#ifdef CREATOR_MEMALLOC_ACCOUNTING
+    void *result = NULL;
+    size_t size = blockCount * blockSize;
+    if ((blockSize == 0) || ((size / blockSize) == blockCount))
+    {
+        result = Creator_MemAlloc(size);
+        if (result)
+            memset(result, 0, size);
+    }
+#else
     void *result = calloc(blockCount, blockSize);
+    MEMTRACE_ALLOC(result, blockCount * blockSize, CreatorMemTag_Other);
+#endif
     Creator_Assert(result != NULL, "Allocation of %ld bytes failed", blockCount * blockSize);
     return result;
 }
 
 void *Creator_MemRealloc(void *buffer, size_t size)
 {
+#ifdef CREATOR_MEMALLOC_ACCOUNTING
+    void *result = NULL;
+    if (!buffer)
+    {
+        result = Creator_MemAlloc(size);
+    }
+    else
+    {
+        AllocationHeader *header = ((AllocationHeader *)buffer) - 1;
+        size_t oldSize = header->Info.Size;
+        CreatorMemTag tag = header->Info.Tag;
+        header = realloc(header, sizeof(AllocationHeader) + size);
+        if (header)
+        {
+            header->Info.Size = size;
+            MemAccounting_Resized(tag, oldSize, size);
+            result = header + 1;
+        }
+        else
+        {
+            MemAccounting_Failed(tag);
+        }
+        MEMTRACE_REALLOC(buffer, result, size);
+    }
+#else
     void *result = realloc(buffer, size);
+    MEMTRACE_REALLOC(buffer, result, size);
+#endif
     //Creator_Log(CreatorLogLevel_Debug, "Reallocating %p with %ld bytes as %p", pBuf, size, result);
     Creator_Assert(result != NULL, "(Re)Allocation of %ld bytes failed", size);
     return result;
@@ -56,7 +136,7 @@ void Creator_MemFree(void **buffer)
     //Creator_Log(CreatorLogLevel_Debug, "Freeing %p", pBuf);
     if (*buffer)
     {
-        free(*buffer);
+        Creator_MemSafeFree(*buffer);
         *buffer = NULL;
     }
 }
@@ -65,7 +145,14 @@ void Creator_MemSafeFree(void *buffer)
 {
     if (buffer)
     {
+        MEMTRACE_FREE(buffer);
+#ifdef CREATOR_MEMALLOC_ACCOUNTING
+        AllocationHeader *header = ((AllocationHeader *)buffer) - 1;
+        MemAccounting_Freed(header->Info.Tag, header->Info.Size);
+        free(header);
+#else
         free(buffer);
+#endif
     }
 }
 
@@ -29,6 +29,7 @@
 #include <string.h>
 #include <unistd.h>
 
+#include "creator/core/creator_hashmap.h"
 #include "creator/core/creator_list.h"
 
 #include "creator_nvs_file.h"
@@ -46,13 +47,14 @@ typedef struct
 }NVSElement;
 
 static char _NVSFilename[512];
-static CreatorList _NVSData = NULL;
+static CreatorList _NVSData = NULL;          // elements in file order
+static CreatorHashMap _NVSIndex = NULL;      // element->Key -> element
 static CreatorSemaphore _DataMutex;
 
 static bool ReadDataFromFile(void);
 static bool WriteDataToFile(void);
 
-static int FindIndexOfKey(const char *key);
+static void AddElement(NVSElement *element);
 
 bool CreatorNVSFile_Initialise(const char *filename)
 {
@@ -72,14 +74,16 @@ bool CreatorNVSFile_Initialise(const char *filename)
 
     //initialize in-memory data copy
     _NVSData = CreatorList_New(10);
-    if (_NVSData)
+    _NVSIndex = CreatorHashMap_New(CreatorHashMapKeyType_String, 10);
+    if (_NVSData && _NVSIndex)
     {
         ReadDataFromFile();
     }
 
     _DataMutex = CreatorSemaphore_New(1, 0);
+    CreatorSemaphore_SetName(_DataMutex, "NVSDataMutex");
 
-    return _NVSData && _DataMutex;
+    return _NVSData && _NVSIndex && _DataMutex;
 }
 
 void CreatorNVSFile_Set(const char *key, const void *value, size_t size)
@@ -92,14 +96,9 @@ void CreatorNVSFile_Set(const char *key, const void *value, size_t size)
 
     CreatorSemaphore_Wait(_DataMutex, 1);
 
-    int targetIndex = FindIndexOfKey(key);
-    NVSElement *element = NULL;
-    if (targetIndex != -1)
-    {
-        //find item with the same key and replace the value
-        element = CreatorList_GetItem(_NVSData, (uint)targetIndex);
-    }
-    else
+    //find item with the same key and replace the value
+    NVSElement *element = CreatorHashMap_Get(_NVSIndex, key);
+    if (!element)
     {
         //no existing item with the same key, add it
         size_t keySize = strlen(key) + 1;
@@ -111,8 +110,8 @@ void CreatorNVSFile_Set(const char *key, const void *value, size_t size)
         {
             memset(element,0,sizeof(NVSElement));
             //create item then get ref to it
-            CreatorList_Add(_NVSData, element);
             element->Key = keyCopy;
+            AddElement(element);
         }
     }
 
@@ -154,13 +153,10 @@ void *CreatorNVSFile_Get(const char *key, size_t *size)
 
     CreatorSemaphore_Wait(_DataMutex, 1);
 
-    int targetIndex = FindIndexOfKey(key);
+    NVSElement *element = CreatorHashMap_Get(_NVSIndex, key);
 
-    //find item with the same key and replace the value
-    if (targetIndex != -1)
+    if (element)
     {
-        NVSElement *element = CreatorList_GetItem(_NVSData, (uint)targetIndex);
-
         if (size)
         {
             *size = element->ValueSize;
@@ -196,6 +192,7 @@ void CreatorNVSFile_Shutdown(void)
         }
     }
 
+    CreatorHashMap_Free(&_NVSIndex);
     CreatorList_Free(&_NVSData, true);
     if (_DataMutex)
     {
@@ -279,7 +276,7 @@ static bool ReadDataFromFile(void)
         if (!fileIsCorrupt && !bItemIsCorrupt)
         {
             //add element to local copy
-            CreatorList_Add(_NVSData, newElement);
+            AddElement(newElement);
         }
         else
         {
@@ -346,24 +343,10 @@ static bool WriteDataToFile(void)
     return true;
 }
 
-static int FindIndexOfKey(const char *key)
+static void AddElement(NVSElement *element)
 {
-    uint itemCount = CreatorList_GetCount(_NVSData);
-    uint index;
-    int targetIndex = -1;
-
-    //find item with the same key and replace the value
-    for (index = 0; index < itemCount; index++)
-    {
-        NVSElement *pElem = CreatorList_GetItem(_NVSData, index);
-        if (strcmp(pElem->Key, key) == 0)
-        {
-            targetIndex = index;
-            break;
-        }
-    }
-
-    return targetIndex;
+    CreatorList_Add(_NVSData, element);
+    CreatorHashMap_Put(_NVSIndex, element->Key, element);
 }
 
 #endif
@@ -34,7 +34,7 @@
 //#define NVS_BASE_ADDRESS			0xBD1F0000   //Does work anymore base address is now number of blocks in
 #define NVS_BASE_ADDRESS			0
 
-static CreatorSemaphore _NVSLock = NULL;
+static CreatorMutex _NVSLock = NULL;
 
 static DRV_HANDLE _NVMHandle;
 static DRV_NVM_COMMAND_HANDLE _NVMBufferHandle;
@@ -66,10 +66,12 @@ bool CreatorNVS_Initialise(void)
     result = true;
     else
     {
-        /* Attempt to create a semaphore. */
-        _NVSLock = CreatorSemaphore_New(1,1);
+        /* Attempt to create a mutex, held until the cache is loaded. */
+        _NVSLock = CreatorMutex_New();
         if (_NVSLock)
         {
+            CreatorMutex_SetName(_NVSLock, "NVSLock");
+            CreatorMutex_Lock(_NVSLock);
             _NVMHandle = DRV_NVM_Open(DRV_NVM_INDEX_0, DRV_IO_INTENT_READWRITE);
             if (DRV_HANDLE_INVALID == _NVMHandle)
             {
@@ -98,7 +100,7 @@ bool CreatorNVS_Initialise(void)
                 }
                 _CreatorKeyValue = (ConfigCreatorKeyValue *)(_NVSCache + 8);
 
-                CreatorSemaphore_Release(_NVSLock,1);
+                CreatorMutex_Unlock(_NVSLock);
                 result = true;
             }
         }
@@ -109,11 +111,11 @@ bool CreatorNVS_Initialise(void)
 bool NVS_Read(size_t offset, void *value, size_t size)
 {
     bool result = false;
-    if (CreatorSemaphore_WaitFor(_NVSLock, 1, MAX_SEMAPHORE_WAIT_TIME_MS))
+    if (CreatorMutex_LockFor(_NVSLock, MAX_SEMAPHORE_WAIT_TIME_MS))
     {
         memcpy(value, _NVSCache + offset, size);
         result = true;
-        CreatorSemaphore_Release(_NVSLock,1);
+        CreatorMutex_Unlock(_NVSLock);
     }
     return result;
 }
@@ -126,7 +128,7 @@ bool CreatorNVS_Read(size_t offset, void *value, size_t size)
 bool NVS_Write(size_t offset, const void *value, size_t size)
 {
     bool result = false;
-    if (CreatorSemaphore_WaitFor(_NVSLock, 1, MAX_SEMAPHORE_WAIT_TIME_MS))
+    if (CreatorMutex_LockFor(_NVSLock, MAX_SEMAPHORE_WAIT_TIME_MS))
     {
         memcpy((void*)_NVSCache + offset, value, size);
         DRV_NVM_Erase(_NVMHandle, &_NVMBufferHandle, NVS_BASE_ADDRESS, 1); //DRV_NVM_PAGE_SIZE
@@ -152,7 +154,7 @@ bool NVS_Write(size_t offset, const void *value, size_t size)
                 result = true;
             }
         }
-        CreatorSemaphore_Release(_NVSLock,1);
+        CreatorMutex_Unlock(_NVSLock);
     }
     return result;
 }
@@ -19,66 +19,114 @@
  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***********************************************************************************************************************/
-
 #include <stdbool.h>
 #include <time.h>
 #include <limits.h>
 #include <string.h>
+#include <stdint.h>
 
 #include "creator/core/creator_task_scheduler.h"
 
+#include "creator/core/creator_threadpool.h"
+
 #include "creator/core/creator_threading.h"
 #include "creator/core/creator_memalloc.h"
+#include "creator/core/creator_static_alloc.h"
+#include "creator/core/creator_timer.h"
 #include "creator/core/creator_debug.h"
 //#include "creator/core/servertime.h"
 
+#define INITIAL_TASK_SLOTS      (20)
+#define TASK_SLOT_BITS          (16)
+#define TASK_SLOT_MASK          ((1 << TASK_SLOT_BITS) - 1)
+#define MAX_TASK_SLOTS          (TASK_SLOT_MASK)
+#define INVALID_INDEX           (UINT_MAX)
+#define MAX_RUNNER_WAIT_MS      (10000)
+
+/*
+ * Tasks live in a slot table and are ordered by a binary min-heap of slot indices keyed on NextExecutionTime.
+ * A task ID encodes the slot (low bits) and the slot generation (high bits) so lookups are O(1) and stale IDs
+ * of reused slots are rejected. Times are milliseconds on a 64-bit monotonic clock.
+ */
 typedef struct
 {
-    CreatorTaskID TaskID;
     CreatorScheduler_TaskCallback TaskCallback;
     void *TaskContext;
-    ulong RecurrenceInterval;
-    time_t NextExecutionTime;
+    uint64 RecurrenceInterval;
+    uint64 NextExecutionTime;
+    uint Generation;
+    uint HeapIndex;
+    uint NextFree;
+    uint Flags;
+    bool Running;
+    bool Unscheduled;
+    uint64 DueTime;
+    CreatorSchedulerTaskStatistics Statistics;
 } CreatorSchedulerTask;
 
 static uint _TasksCount = 0;
 static uint _TasksListSize = 0;
 static CreatorSchedulerTask *_TasksList = NULL;
+static uint *_TaskHeap = NULL;
+#ifdef CREATOR_STATIC_ALLOC
+// Fixed table, it cannot grow in a static build
+static CreatorSchedulerTask _StaticTasksList[CREATOR_STATIC_SCHEDULER_TASKS];
+static uint _StaticTaskHeap[CREATOR_STATIC_SCHEDULER_TASKS];
+#endif
+static uint _FreeTask = INVALID_INDEX;
 static CreatorThread _TaskRunnerThread = NULL;
-static CreatorSemaphore _TaskListLock = NULL;
-static CreatorSemaphore _TaskWait = NULL;
+static CreatorMutex _TaskListLock = NULL;
+static CreatorCondition _TaskWait = NULL;
 //flag indicating when to stop to the task executor thread
 static bool _TerminateTaskThread = false;
+//optional pool that concurrent tasks are handed to
+static CreatorThreadPool _ThreadPool = NULL;
+static uint _ConcurrentTasksRunning = 0;
 
-static CreatorTaskID _LastGeneratedID = 1;
+static uint64 _ElapsedTicks = 0;
+static uint _LastTickCount = 0;
 
 static void TaskRunnerMethod(CreatorThread thread, void *context);
 /*
  * must be mutex-protected before entering
  */
-static void ReorderTaskList();
+static CreatorTaskID AddTask(CreatorScheduler_TaskCallback executor, void *context, uint64 delay, bool continuous);
+static void CompleteTask(uint slot, uint64 startTime);
+static void ExecuteConcurrentTask(void *context);
+static void ExecuteTask(uint slot, CreatorTaskID taskID);
+static CreatorSchedulerTask *FindTask(CreatorTaskID taskID);
+static void FreeTaskSlot(uint slot);
+static uint64 GetSchedulerTime(void);
+static bool GrowTaskList(void);
+static void HeapInsert(uint slot);
+static void HeapRemove(uint heapIndex);
+static void HeapSiftDown(uint heapIndex);
+static void HeapSiftUp(uint heapIndex);
+static void HeapSwap(uint first, uint second);
+static void SetTaskInterval(CreatorTaskID taskID, uint64 interval);
 
 bool CreatorScheduler_Initialise(void)
 {
     bool result = false;
     //clear up existing variables
     CreatorScheduler_Shutdown();
-    _TaskListLock = CreatorSemaphore_New(1, 0);
+    _TaskListLock = CreatorMutex_New();
     if (_TaskListLock)
     {
-        _TaskWait = CreatorSemaphore_New(1, 1);
-        //create empty list of tasks
-        _TasksListSize = 20;
-        size_t taskListMemSize = sizeof(CreatorSchedulerTask[_TasksListSize]);
-        _TasksList = (CreatorSchedulerTask*)Creator_MemAlloc(taskListMemSize);
-        if (_TasksList)
+        CreatorMutex_SetName(_TaskListLock, "TaskListLock");
+        _TaskWait = CreatorCondition_New();
+        _TasksListSize = 0;
+        _TasksCount = 0;
+        _FreeTask = INVALID_INDEX;
+        _ElapsedTicks = 0;
+        _LastTickCount = CreatorTimer_GetTickCount();
+        if (_TaskWait && GrowTaskList())
         {
-            memset(_TasksList, 0, taskListMemSize);
             _TerminateTaskThread = false;
             //create thread
-            CreatorSemaphore_Wait(_TaskListLock, 1);
+            CreatorMutex_Lock(_TaskListLock);
             _TaskRunnerThread = CreatorThread_New("CreatorScheduler", 0, 0, TaskRunnerMethod, NULL);
-            CreatorSemaphore_Release(_TaskListLock, 1);
+            CreatorMutex_Unlock(_TaskListLock);
             if (_TaskRunnerThread)
             {
                 result = true;
@@ -94,40 +142,164 @@ bool CreatorScheduler_Initialise(void)
 
 CreatorTaskID CreatorScheduler_ScheduleTask(CreatorScheduler_TaskCallback executor, void *context, ulong delayBeforeExecution, bool continuous)
 {
-    CreatorTaskID result = 0;
+    return AddTask(executor, context, (uint64)delayBeforeExecution * 1000, continuous);
+}
+
+CreatorTaskID CreatorScheduler_ScheduleTaskMs(CreatorScheduler_TaskCallback executor, void *context, ulong delayInMilliseconds, bool continuous)
+{
+    return AddTask(executor, context, delayInMilliseconds, continuous);
+}
+
+void CreatorScheduler_SetTaskInterval(CreatorTaskID taskID, ulong delayBeforeExecution)
+{
+    SetTaskInterval(taskID, (uint64)delayBeforeExecution * 1000);
+}
+
+void CreatorScheduler_SetTaskIntervalMs(CreatorTaskID taskID, ulong intervalInMilliseconds)
+{
+    SetTaskInterval(taskID, intervalInMilliseconds);
+}
+
+void CreatorScheduler_UnscheduleTask(CreatorTaskID taskID)
+{
+    if (_TaskListLock)
+    {
+        CreatorMutex_Lock(_TaskListLock);
+        CreatorSchedulerTask *task = FindTask(taskID);
+        if (task)
+        {
+            if (task->HeapIndex != INVALID_INDEX)
+                HeapRemove(task->HeapIndex);
+            //a running task releases its slot when it completes
+            if (task->Running)
+                task->Unscheduled = true;
+            else
+                FreeTaskSlot((taskID & TASK_SLOT_MASK) - 1);
+        }
+        CreatorMutex_Unlock(_TaskListLock);
+    }
+}
+
+bool CreatorScheduler_GetTaskStatistics(CreatorTaskID taskID, CreatorSchedulerTaskStatistics *statistics)
+{
+    bool result = false;
+    if (_TaskListLock && statistics)
+    {
+        CreatorMutex_Lock(_TaskListLock);
+        CreatorSchedulerTask *task = FindTask(taskID);
+        if (task)
+        {
+            *statistics = task->Statistics;
+            result = true;
+        }
+        CreatorMutex_Unlock(_TaskListLock);
+    }
+    return result;
+}
+
+void CreatorScheduler_SetTaskFlags(CreatorTaskID taskID, uint flags)
+{
+    if (_TaskListLock)
+    {
+        CreatorMutex_Lock(_TaskListLock);
+        CreatorSchedulerTask *task = FindTask(taskID);
+        if (task)
+            task->Flags = flags;
+        CreatorMutex_Unlock(_TaskListLock);
+    }
+}
+
+void CreatorScheduler_SetThreadPool(CreatorThreadPool threadPool)
+{
+    _ThreadPool = threadPool;
+}
+
+void CreatorScheduler_Shutdown(void)
+{
+    //stop thread
+    if (_TaskRunnerThread)
+    {
+        CreatorMutex_Lock(_TaskListLock);
+        _TerminateTaskThread = true;
+        CreatorCondition_Signal(_TaskWait);
+        CreatorMutex_Unlock(_TaskListLock);
+        CreatorThread_Wakeup(_TaskRunnerThread);
+        CreatorThread_Join(_TaskRunnerThread);
+        CreatorThread_Free(&_TaskRunnerThread);
+    }
+    //wait for tasks handed to the thread pool to complete
+    while (_TaskListLock)
+    {
+        CreatorMutex_Lock(_TaskListLock);
+        uint running = _ConcurrentTasksRunning;
+        CreatorMutex_Unlock(_TaskListLock);
+        if (running == 0)
+            break;
+        CreatorThread_SleepMilliseconds(NULL, 10);
+    }
+
+    if (_TaskListLock)
+        CreatorMutex_Lock(_TaskListLock);
+#ifdef CREATOR_STATIC_ALLOC
+    _TasksList = NULL;
+    _TaskHeap = NULL;
+#else
+    if (_TasksList)
+    {
+        Creator_MemFree((void **)&_TasksList);
+    }
+    if (_TaskHeap)
+    {
+        Creator_MemFree((void **)&_TaskHeap);
+    }
+#endif
+    _TasksListSize = 0;
+    _TasksCount = 0;
+    _FreeTask = INVALID_INDEX;
+    if (_TaskListLock)
+    {
+        CreatorMutex_Unlock(_TaskListLock);
+        CreatorMutex_Free(&_TaskListLock);
+    }
+    CreatorCondition_Free(&_TaskWait);
+}
+
+static CreatorTaskID AddTask(CreatorScheduler_TaskCallback executor, void *context, uint64 delay, bool continuous)
+{
+    CreatorTaskID result = CREATOR_TASKID_INVALID;
     if (executor)
     {
         if (_TaskListLock)
         {
-            CreatorSemaphore_Wait(_TaskListLock, 1);
+            CreatorMutex_Lock(_TaskListLock);
             if (_TasksList && _TaskRunnerThread)
             {
-                if (_TasksCount == _TasksListSize)
+                if (_FreeTask == INVALID_INDEX)
                 {
-                    //resize task list
-                    size_t newSize = sizeof(CreatorSchedulerTask[_TasksListSize * 2]);
-                    size_t growth = newSize - sizeof(CreatorSchedulerTask[_TasksListSize]);
-                    CreatorSchedulerTask *newTaskList = Creator_MemRealloc(_TasksList, newSize);
-                    if (newTaskList)
-                    {
-                        memset(&newTaskList[_TasksListSize], 0, growth);
-                        _TasksList = newTaskList;
-                        _TasksListSize *= 2;
-                    }
+                    GrowTaskList();
                 }
-                if (_TasksCount < _TasksListSize)
+                if (_FreeTask != INVALID_INDEX)
                 {
-                    result = _LastGeneratedID++;
-                    _TasksList[_TasksCount].TaskID = result;
-                    _TasksList[_TasksCount].TaskCallback = executor;
-                    _TasksList[_TasksCount].TaskContext = context;
-                    _TasksList[_TasksCount].RecurrenceInterval = (continuous) ? delayBeforeExecution : 0;
-                    _TasksList[_TasksCount].NextExecutionTime = Creator_GetTime(NULL) + delayBeforeExecution;
-                    _TasksCount++;
-                    ReorderTaskList();
+                    uint slot = _FreeTask;
+                    CreatorSchedulerTask *task = &_TasksList[slot];
+                    _FreeTask = task->NextFree;
+                    task->TaskCallback = executor;
+                    task->TaskContext = context;
+                    task->RecurrenceInterval = (continuous) ? delay : 0;
+                    task->NextExecutionTime = GetSchedulerTime() + delay;
+                    task->NextFree = INVALID_INDEX;
+                    task->Flags = CreatorSchedulerTaskFlags_Serial;
+                    task->Running = false;
+                    task->Unscheduled = false;
+                    memset(&task->Statistics, 0, sizeof(CreatorSchedulerTaskStatistics));
+                    HeapInsert(slot);
+                    //only wake the runner if its next deadline has moved
+                    if (task->HeapIndex == 0)
+                        CreatorCondition_Signal(_TaskWait);
+                    result = (task->Generation << TASK_SLOT_BITS) | (slot + 1);
                 }
             }
-            CreatorSemaphore_Release(_TaskListLock, 1);
+            CreatorMutex_Unlock(_TaskListLock);
         }
     }
     else
@@ -136,9 +308,7 @@ CreatorTaskID CreatorScheduler_ScheduleTask(CreatorScheduler_TaskCallback execut
     }
     if (result)
     {
-        CreatorSemaphore_Release(_TaskWait, 1);
-        //CreatorThread_Wakeup(_TaskRunnerThread);
-        //Creator_Log(CreatorLogLevel_Debug, "Scheduling task %u: [%p] in [%lu] seconds", result, executor, delayBeforeExecution);
+        //Creator_Log(CreatorLogLevel_Debug, "Scheduling task %u: [%p] in [%lu] ms", result, executor, (ulong)delay);
     }
     else
     {
@@ -147,86 +317,233 @@ CreatorTaskID CreatorScheduler_ScheduleTask(CreatorScheduler_TaskCallback execut
     return result;
 }
 
-void CreatorScheduler_SetTaskInterval(CreatorTaskID taskID, ulong delayBeforeExecution)
+static void CompleteTask(uint slot, uint64 startTime)
 {
-    if (_TaskListLock)
+    CreatorSchedulerTask *task = &_TasksList[slot];
+    uint64 now = GetSchedulerTime();
+    uint executionTime = (uint)(now - startTime);
+    task->Statistics.ExecutionCount++;
+    task->Statistics.LastExecutionTime = executionTime;
+    task->Statistics.TotalExecutionTime += executionTime;
+    if (executionTime > task->Statistics.MaxExecutionTime)
+        task->Statistics.MaxExecutionTime = executionTime;
+    task->Running = false;
+    //one-shot tasks (not re-armed by their callback) and unscheduled tasks are released now
+    if (task->Unscheduled || (task->HeapIndex == INVALID_INDEX))
+        FreeTaskSlot(slot);
+}
+
+static void ExecuteConcurrentTask(void *context)
+{
+    CreatorTaskID taskID = (CreatorTaskID)(uintptr_t)context;
+    ExecuteTask((taskID & TASK_SLOT_MASK) - 1, taskID);
+    CreatorMutex_Lock(_TaskListLock);
+    _ConcurrentTasksRunning--;
+    CreatorMutex_Unlock(_TaskListLock);
+}
+
+static void ExecuteTask(uint slot, CreatorTaskID taskID)
+{
+    CreatorMutex_Lock(_TaskListLock);
+    CreatorSchedulerTask *task = &_TasksList[slot];
+    CreatorScheduler_TaskCallback taskCallback = task->TaskCallback;
+    void *taskContext = task->TaskContext;
+    //unscheduled while waiting for a pool thread: don't run it, but still complete it to release the slot
+    bool unscheduled = task->Unscheduled;
+    uint64 startTime = GetSchedulerTime();
+    uint dispatchLag = (startTime > task->DueTime) ? (uint)(startTime - task->DueTime) : 0;
+    task->Statistics.LastDispatchLag = dispatchLag;
+    if (dispatchLag > task->Statistics.MaxDispatchLag)
+        task->Statistics.MaxDispatchLag = dispatchLag;
+    CreatorMutex_Unlock(_TaskListLock);
+
+    if (!unscheduled)
     {
-        CreatorSemaphore_Wait(_TaskListLock, 1);
-        if (_TasksList)
-        {
-            uint i;
-            for (i = 0; i < _TasksCount; i++)
-            {
-                if (_TasksList[i].TaskID == taskID)
-                {
-                    time_t now = Creator_GetTime(NULL);
-                    _TasksList[i].RecurrenceInterval = delayBeforeExecution;
-                    _TasksList[i].NextExecutionTime = now + delayBeforeExecution;
-                    break;
-                }
-            }
-            ReorderTaskList();
-        }
-        CreatorSemaphore_Release(_TaskListLock, 1);
+        //Creator_Log(CreatorLogLevel_Debug, "Executing task %u", taskID);
+        CreatorThread_ClearLastError();
+        taskCallback(taskID, taskContext);
     }
+
+    CreatorMutex_Lock(_TaskListLock);
+    CompleteTask(slot, startTime);
+    CreatorMutex_Unlock(_TaskListLock);
 }
 
-void CreatorScheduler_UnscheduleTask(CreatorTaskID taskID)
+static CreatorSchedulerTask *FindTask(CreatorTaskID taskID)
 {
-    if (_TaskListLock)
+    CreatorSchedulerTask *result = NULL;
+    uint slot = (taskID & TASK_SLOT_MASK);
+    if (_TasksList && (slot > 0) && (slot <= _TasksListSize))
     {
-        CreatorSemaphore_Wait(_TaskListLock, 1);
-        if (_TasksList)
+        CreatorSchedulerTask *task = &_TasksList[slot - 1];
+        if (task->TaskCallback && !task->Unscheduled && (task->Generation == (taskID >> TASK_SLOT_BITS)))
+            result = task;
+    }
+    return result;
+}
+
+static void FreeTaskSlot(uint slot)
+{
+    CreatorSchedulerTask *task = &_TasksList[slot];
+    task->TaskCallback = NULL;
+    task->TaskContext = NULL;
+    task->HeapIndex = INVALID_INDEX;
+    task->Running = false;
+    task->Unscheduled = false;
+    task->Generation = (task->Generation + 1) & TASK_SLOT_MASK;
+    task->NextFree = _FreeTask;
+    _FreeTask = slot;
+}
+
+static uint64 GetSchedulerTime(void)
+{
+    // Extend the wrapping tick counter to 64 bits; called at least every MAX_RUNNER_WAIT_MS by the runner
+    uint tickCount = CreatorTimer_GetTickCount();
+    _ElapsedTicks += (uint)(tickCount - _LastTickCount);
+    _LastTickCount = tickCount;
+    uint ticksPerSecond = CreatorTimer_GetTicksPerSecond();
+    if (ticksPerSecond == 0)
+        ticksPerSecond = 1000;
+    return (_ElapsedTicks * 1000) / ticksPerSecond;
+}
+
+static bool GrowTaskList(void)
+{
+    bool result = false;
+#ifdef CREATOR_STATIC_ALLOC
+    uint newSize = CREATOR_STATIC_SCHEDULER_TASKS;
+    if (_TasksListSize == 0)
+    {
+        _TasksList = _StaticTasksList;
+        _TaskHeap = _StaticTaskHeap;
+        result = true;
+    }
+    else
+    {
+        Creator_Log(CreatorLogLevel_Error, "Scheduler task table full, raise CREATOR_STATIC_SCHEDULER_TASKS");
+    }
+#else
+    uint newSize = (_TasksListSize == 0) ? INITIAL_TASK_SLOTS : _TasksListSize * 2;
+    if (newSize > MAX_TASK_SLOTS)
+        newSize = MAX_TASK_SLOTS;
+    if (newSize > _TasksListSize)
+    {
+        CreatorSchedulerTask *newTaskList = Creator_MemRealloc(_TasksList, sizeof(CreatorSchedulerTask) * newSize);
+        if (newTaskList)
         {
-            uint i;
-            for (i = 0; i < _TasksCount; i++)
+            _TasksList = newTaskList;
+            uint *newHeap = Creator_MemRealloc(_TaskHeap, sizeof(uint) * newSize);
+            if (newHeap)
             {
-                if (_TasksList[i].TaskID == taskID)
-                {
-                    _TasksList[i].TaskCallback = NULL;
-                    break;
-                }
+                _TaskHeap = newHeap;
+                result = true;
             }
-            ReorderTaskList();
         }
-        CreatorSemaphore_Release(_TaskListLock, 1);
     }
+#endif
+    if (result)
+    {
+        uint index;
+        //chain new slots onto the free list, lowest index first
+        for (index = newSize; index > _TasksListSize; index--)
+        {
+            CreatorSchedulerTask *task = &_TasksList[index - 1];
+            memset(task, 0, sizeof(CreatorSchedulerTask));
+            task->HeapIndex = INVALID_INDEX;
+            task->NextFree = _FreeTask;
+            _FreeTask = index - 1;
+        }
+        _TasksListSize = newSize;
+    }
+    return result;
 }
 
-void CreatorScheduler_Shutdown(void)
+static void HeapInsert(uint slot)
 {
-    //stop thread
-    if (_TaskRunnerThread)
+    uint heapIndex = _TasksCount++;
+    _TaskHeap[heapIndex] = slot;
+    _TasksList[slot].HeapIndex = heapIndex;
+    HeapSiftUp(heapIndex);
+}
+
+static void HeapRemove(uint heapIndex)
+{
+    uint slot = _TaskHeap[heapIndex];
+    _TasksCount--;
+    if (heapIndex != _TasksCount)
     {
-        _TerminateTaskThread = true;
-        CreatorSemaphore_Release(_TaskWait, 1);
-        CreatorThread_Wakeup(_TaskRunnerThread);
-        CreatorThread_Join(_TaskRunnerThread);
-        CreatorThread_Free(&_TaskRunnerThread);
+        HeapSwap(heapIndex, _TasksCount);
+        HeapSiftDown(heapIndex);
+        HeapSiftUp(heapIndex);
     }
+    _TasksList[slot].HeapIndex = INVALID_INDEX;
+}
 
-    if (_TaskListLock)
+static void HeapSiftDown(uint heapIndex)
+{
+    for (;;)
     {
-        CreatorSemaphore_Wait(_TaskListLock, 1);
-        if (_TasksList)
-        {
-            Creator_MemFree((void **)&_TasksList);
-        }
-        _TasksListSize = 0;
-        _TasksCount = 0;
-        CreatorSemaphore_Release(_TaskListLock, 1);
-        CreatorSemaphore_Free(&_TaskListLock);
+        uint smallest = heapIndex;
+        uint left = (heapIndex * 2) + 1;
+        uint right = left + 1;
+        if ((left < _TasksCount)
+                && (_TasksList[_TaskHeap[left]].NextExecutionTime < _TasksList[_TaskHeap[smallest]].NextExecutionTime))
+            smallest = left;
+        if ((right < _TasksCount)
+                && (_TasksList[_TaskHeap[right]].NextExecutionTime < _TasksList[_TaskHeap[smallest]].NextExecutionTime))
+            smallest = right;
+        if (smallest == heapIndex)
+            break;
+        HeapSwap(heapIndex, smallest);
+        heapIndex = smallest;
     }
-    else
+}
+
+static void HeapSiftUp(uint heapIndex)
+{
+    while (heapIndex > 0)
+    {
+        uint parent = (heapIndex - 1) / 2;
+        if (_TasksList[_TaskHeap[parent]].NextExecutionTime <= _TasksList[_TaskHeap[heapIndex]].NextExecutionTime)
+            break;
+        HeapSwap(heapIndex, parent);
+        heapIndex = parent;
+    }
+}
+
+static void HeapSwap(uint first, uint second)
+{
+    uint slot = _TaskHeap[first];
+    _TaskHeap[first] = _TaskHeap[second];
+    _TaskHeap[second] = slot;
+    _TasksList[_TaskHeap[first]].HeapIndex = first;
+    _TasksList[_TaskHeap[second]].HeapIndex = second;
+}
+
+static void SetTaskInterval(CreatorTaskID taskID, uint64 interval)
+{
+    if (_TaskListLock)
     {
-        if (_TasksList)
+        CreatorMutex_Lock(_TaskListLock);
+        CreatorSchedulerTask *task = FindTask(taskID);
+        if (task)
         {
-            Creator_MemFree((void **)&_TasksList);
+            task->RecurrenceInterval = interval;
+            task->NextExecutionTime = GetSchedulerTime() + interval;
+            if (task->HeapIndex == INVALID_INDEX)
+            {
+                HeapInsert((taskID & TASK_SLOT_MASK) - 1);
+            }
+            else
+            {
+                HeapSiftDown(task->HeapIndex);
+                HeapSiftUp(task->HeapIndex);
+            }
+            if (task->HeapIndex == 0)
+                CreatorCondition_Signal(_TaskWait);
         }
-        _TasksListSize = 0;
-        _TasksCount = 0;
+        CreatorMutex_Unlock(_TaskListLock);
     }
-    CreatorSemaphore_Free(&_TaskWait);
 }
 
 static void TaskRunnerMethod(CreatorThread thread, void *context)
@@ -235,123 +552,66 @@ static void TaskRunnerMethod(CreatorThread thread, void *context)
     (void)context;
     while (!_TerminateTaskThread)
     {
-        if (_TerminateTaskThread)
-        {
-            break;
-        }
+        CreatorTaskID taskID = CREATOR_TASKID_INVALID;
+        uint taskSlot = INVALID_INDEX;
+        bool concurrent = false;
+        uint64 nextTaskIn = MAX_RUNNER_WAIT_MS;
 
-        //by default, make it sleep for a *long* while
-        //ulong nextTaskIn = 3600*24; // hour
-        //ulong nextTaskIn = 60; // minute
-        ulong nextTaskIn = 10;
-        //this will hold the that are due for execution
-        uint taskToExecuteCount = 0;
-        //find tasks to execute from sorted list
-        CreatorSemaphore_Wait(_TaskListLock, 1);
-        CreatorSchedulerTask pTasksToExecute[_TasksCount];
+        //take the earliest task from the heap if it is due
+        CreatorMutex_Lock(_TaskListLock);
+        uint64 now = GetSchedulerTime();
         if (_TasksCount > 0)
         {
-            uint i;
-            time_t now = Creator_GetTime(NULL);
-            for (i = 0; i < _TasksCount; i++)
+            uint slot = _TaskHeap[0];
+            CreatorSchedulerTask *task = &_TasksList[slot];
+            if (now >= task->NextExecutionTime)
             {
-                if (!_TasksList[i].TaskCallback)
+                nextTaskIn = 0;
+                if (!task->Running)
                 {
-                    //no more executors in the list
-                    break;
+                    task->Running = true;
+                    task->DueTime = task->NextExecutionTime;
+                    taskSlot = slot;
+                    taskID = (task->Generation << TASK_SLOT_BITS) | (slot + 1);
+                    concurrent = (_ThreadPool && (task->Flags & CreatorSchedulerTaskFlags_Concurrent));
+                    if (concurrent)
+                        _ConcurrentTasksRunning++;
                 }
-                if (now >= _TasksList[i].NextExecutionTime)
+                if (task->RecurrenceInterval)
                 {
-                    //should execute that on this run
-                    pTasksToExecute[taskToExecuteCount++] = _TasksList[i];
-                    if (_TasksList[i].RecurrenceInterval)
-                    {
-                        _TasksList[i].NextExecutionTime = now + _TasksList[i].RecurrenceInterval;
-                        if (nextTaskIn > _TasksList[i].RecurrenceInterval)
-                        {
-                            nextTaskIn = _TasksList[i].RecurrenceInterval;
-                        }
-                    }
-                    else
-                    {
-                        //this ensures that the task will get deleted during reordering
-                        _TasksList[i].TaskCallback = NULL;
-                    }
+                    //a recurrence that is still running from last time is skipped rather than overlapped
+                    task->NextExecutionTime = now + task->RecurrenceInterval;
+                    HeapSiftDown(0);
                 }
                 else
                 {
-                    //next task is not for right now
-                    ulong timeToNextTask = _TasksList[i].NextExecutionTime - now;
-                    if (nextTaskIn > timeToNextTask)
-                    {
-                        nextTaskIn = timeToNextTask;
-                    }
-                    break;
+                    //slot is released when the task completes
+                    HeapRemove(0);
                 }
             }
-            if (taskToExecuteCount > 0)
-                ReorderTaskList();
-        }
-        CreatorSemaphore_Release(_TaskListLock, 1);
-
-        //execute selected tasks
-        uint i;
-        for (i = 0; i < taskToExecuteCount && !_TerminateTaskThread; i++)
-        {
-            //Creator_Log(CreatorLogLevel_Debug, "Executing task %u", pTasksToExecute[i].TaskID);
-            CreatorThread_ClearLastError();
-            pTasksToExecute[i].TaskCallback(pTasksToExecute[i].TaskID, pTasksToExecute[i].TaskContext);
-            //Creator_Log(CreatorLogLevel_Debug, "Done executing task %u", pTasksToExecute[i].TaskID);
-        }
-
-        if (!_TerminateTaskThread)
-        {
-            //sleep thread until next task start
-            CreatorSemaphore_WaitFor(_TaskWait, 1, nextTaskIn * 1000);
-            //CreatorThread_Sleep(_TaskRunnerThread, nextTaskIn);
-        }
-    }
-}
-
-static void ReorderTaskList()
-{
-    uint index;
-    uint newTaskCount = 0;
-    for (index = 0; index < _TasksCount; index++)
-    {
-        //position of the task to be executed soonest, -1 for unknown
-        int minPos = (_TasksList[index].TaskCallback) ? (int)index : -1;
-        uint j;
-        for (j = index + 1; j < _TasksCount; j++)
-        {
-            if (!_TasksList[j].TaskCallback)
-            {
-                continue;
-            }
-            if (minPos == -1)
+            else if (task->NextExecutionTime - now < nextTaskIn)
             {
-                minPos = (int)j;
-            }
-            else if (_TasksList[j].NextExecutionTime < _TasksList[minPos].NextExecutionTime)
-            {
-                minPos = (int)j;
+                nextTaskIn = task->NextExecutionTime - now;
             }
         }
-
-        if (minPos != -1)
+        if ((taskSlot == INVALID_INDEX) && !_TerminateTaskThread && (nextTaskIn > 0))
         {
-            //either the current element is valid, or there is an element that will take its place
-            newTaskCount++;
+            //sleep thread until next task start, or until an earlier task is scheduled
+            CreatorCondition_WaitFor(_TaskWait, _TaskListLock, (uint)nextTaskIn);
         }
+        CreatorMutex_Unlock(_TaskListLock);
 
-        if (minPos > (int)index)
+        if (taskSlot != INVALID_INDEX)
         {
-            //swap elements
-            CreatorSchedulerTask tmpTask = _TasksList[minPos];
-            _TasksList[minPos] = _TasksList[index];
-            _TasksList[index] = tmpTask;
+            if (concurrent && !CreatorThreadPool_AddTask(_ThreadPool, ExecuteConcurrentTask, (void *)(uintptr_t)taskID))
+            {
+                CreatorMutex_Lock(_TaskListLock);
+                _ConcurrentTasksRunning--;
+                CreatorMutex_Unlock(_TaskListLock);
+                concurrent = false;
+            }
+            if (!concurrent)
+                ExecuteTask(taskSlot, taskID);
         }
     }
-    _TasksCount = newTaskCount;
 }
-
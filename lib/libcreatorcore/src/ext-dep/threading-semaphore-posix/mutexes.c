@@ -0,0 +1,257 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+
+#ifdef POSIX
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* for pthread_mutex_clocklock */
+#endif
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+
+// pthread_mutex_clocklock (glibc 2.30+) waits against a monotonic deadline. Elsewhere pthread_mutex_timedlock is used,
+// whose CLOCK_REALTIME deadline is lengthened or cut short if the wall clock is stepped during the wait.
+#if !defined(HAVE_PTHREAD_MUTEX_CLOCKLOCK) && defined(__GLIBC__) && ((__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 30)))
+#define HAVE_PTHREAD_MUTEX_CLOCKLOCK
+#endif
+
+#include "creator/core/creator_threading.h"
+#include "creator/core/creator_memalloc.h"
+#include "creator/core/creator_debug.h"
+#include "creator/core/lock_profiling.h"
+
+// Mutex must stay the first member, conditions wait on the handle directly
+typedef struct
+{
+    pthread_mutex_t Mutex;
+#ifdef CREATOR_LOCK_PROFILING
+    LockProfile Profile;
+#endif
+} Mutex;
+
+static void GetDeadline(clockid_t clock, uint milliseconds, struct timespec *deadline);
+
+CreatorMutex CreatorMutex_New(void)
+{
+    Mutex *result = Creator_MemAlloc(sizeof(Mutex));
+    if (result)
+    {
+        pthread_mutexattr_t attributes;
+        pthread_mutexattr_init(&attributes);
+#if defined(_POSIX_THREAD_PRIO_INHERIT) && (_POSIX_THREAD_PRIO_INHERIT > 0)
+        pthread_mutexattr_setprotocol(&attributes, PTHREAD_PRIO_INHERIT);
+#endif
+        if (pthread_mutex_init(&result->Mutex, &attributes) != 0)
+        {
+            Creator_MemFree((void **)&result);
+        }
+#ifdef CREATOR_LOCK_PROFILING
+        else
+        {
+            LockProfile_Register(&result->Profile);
+        }
+#endif
+        pthread_mutexattr_destroy(&attributes);
+    }
+    return result;
+}
+
+void CreatorMutex_Lock(CreatorMutex self)
+{
+    if (self)
+    {
+#ifdef CREATOR_LOCK_PROFILING
+        Mutex *mutex = (Mutex *)self;
+        if (pthread_mutex_trylock(&mutex->Mutex) == 0)
+        {
+            LockProfile_Acquired(&mutex->Profile, false, 0, 1);
+        }
+        else
+        {
+            uint waitStart = LockProfile_GetTime();
+            pthread_mutex_lock(&mutex->Mutex);
+            LockProfile_Acquired(&mutex->Profile, true, waitStart, 1);
+        }
+#else
+        pthread_mutex_lock((pthread_mutex_t *)self);
+#endif
+    }
+}
+
+bool CreatorMutex_LockFor(CreatorMutex self, uint milliseconds)
+{
+    bool result = false;
+    if (self)
+    {
+        Mutex *mutex = (Mutex *)self;
+        result = (pthread_mutex_trylock(&mutex->Mutex) == 0);
+#ifdef CREATOR_LOCK_PROFILING
+        if (result)
+            LockProfile_Acquired(&mutex->Profile, false, 0, 1);
+#endif
+        if (!result && (milliseconds > 0))
+        {
+            struct timespec deadline;
+#ifdef CREATOR_LOCK_PROFILING
+            uint waitStart = LockProfile_GetTime();
+#endif
+#ifdef HAVE_PTHREAD_MUTEX_CLOCKLOCK
+            GetDeadline(CLOCK_MONOTONIC, milliseconds, &deadline);
+            result = (pthread_mutex_clocklock(&mutex->Mutex, CLOCK_MONOTONIC, &deadline) == 0);
+#else
+            // Fallback: pthread_mutex_timedlock only takes a CLOCK_REALTIME deadline (wall clock steps affect it)
+            GetDeadline(CLOCK_REALTIME, milliseconds, &deadline);
+            result = (pthread_mutex_timedlock(&mutex->Mutex, &deadline) == 0);
+#endif
+#ifdef CREATOR_LOCK_PROFILING
+            if (result)
+                LockProfile_Acquired(&mutex->Profile, true, waitStart, 1);
+#endif
+        }
+    }
+    return result;
+}
+
+void CreatorMutex_Unlock(CreatorMutex self)
+{
+    if (self)
+    {
+        Mutex *mutex = (Mutex *)self;
+#ifdef CREATOR_LOCK_PROFILING
+        LockProfile_Released(&mutex->Profile, 1);
+#endif
+        pthread_mutex_unlock(&mutex->Mutex);
+    }
+}
+
+void CreatorMutex_SetName(CreatorMutex self, const char *name)
+{
+#ifdef CREATOR_LOCK_PROFILING
+    if (self)
+    {
+        LockProfile_SetName(&((Mutex *)self)->Profile, name);
+    }
+#endif
+}
+
+void CreatorMutex_Free(CreatorMutex *self)
+{
+    if (self && *self)
+    {
+        Mutex *mutex = (Mutex *)*self;
+#ifdef CREATOR_LOCK_PROFILING
+        LockProfile_Unregister(&mutex->Profile);
+#endif
+        pthread_mutex_destroy(&mutex->Mutex);
+        Creator_MemFree(self);
+    }
+}
+
+CreatorCondition CreatorCondition_New(void)
+{
+    pthread_cond_t *result = Creator_MemAlloc(sizeof(pthread_cond_t));
+    if (result)
+    {
+        pthread_condattr_t attributes;
+        pthread_condattr_init(&attributes);
+        pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+        if (pthread_cond_init(result, &attributes) != 0)
+        {
+            Creator_MemFree((void **)&result);
+        }
+        pthread_condattr_destroy(&attributes);
+    }
+    return result;
+}
+
+void CreatorCondition_Wait(CreatorCondition self, CreatorMutex mutex)
+{
+    if (self && mutex)
+    {
+#ifdef CREATOR_LOCK_PROFILING
+        // The mutex is not held while waiting, do not count the wait as hold time
+        LockProfile_Released(&((Mutex *)mutex)->Profile, 1);
+#endif
+        pthread_cond_wait((pthread_cond_t *)self, &((Mutex *)mutex)->Mutex);
+#ifdef CREATOR_LOCK_PROFILING
+        LockProfile_Acquired(&((Mutex *)mutex)->Profile, false, 0, 1);
+#endif
+    }
+}
+
+bool CreatorCondition_WaitFor(CreatorCondition self, CreatorMutex mutex, uint milliseconds)
+{
+    bool result = false;
+    if (self && mutex)
+    {
+        struct timespec deadline;
+        GetDeadline(CLOCK_MONOTONIC, milliseconds, &deadline);
+#ifdef CREATOR_LOCK_PROFILING
+        LockProfile_Released(&((Mutex *)mutex)->Profile, 1);
+#endif
+        result = (pthread_cond_timedwait((pthread_cond_t *)self, &((Mutex *)mutex)->Mutex, &deadline) != ETIMEDOUT);
+#ifdef CREATOR_LOCK_PROFILING
+        LockProfile_Acquired(&((Mutex *)mutex)->Profile, false, 0, 1);
+#endif
+    }
+    return result;
+}
+
+void CreatorCondition_Signal(CreatorCondition self)
+{
+    if (self)
+    {
+        pthread_cond_signal((pthread_cond_t *)self);
+    }
+}
+
+void CreatorCondition_Broadcast(CreatorCondition self)
+{
+    if (self)
+    {
+        pthread_cond_broadcast((pthread_cond_t *)self);
+    }
+}
+
+void CreatorCondition_Free(CreatorCondition *self)
+{
+    if (self && *self)
+    {
+        pthread_cond_destroy((pthread_cond_t *)*self);
+        Creator_MemFree(self);
+    }
+}
+
+static void GetDeadline(clockid_t clock, uint milliseconds, struct timespec *deadline)
+{
+    clock_gettime(clock, deadline);
+    deadline->tv_sec += milliseconds / 1000;
+    deadline->tv_nsec += (milliseconds % 1000) * 1000000;
+    if (deadline->tv_nsec >= 1000000000)
+    {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000;
+    }
+}
+
+#endif
@@ -22,30 +22,65 @@
 
 #ifdef POSIX
 
-#include <semaphore.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
 
-#include "creator/core/creator_time.h"
 #include "creator/core/creator_threading.h"
 #include "creator/core/creator_memalloc.h"
 #include "creator/core/creator_debug.h"
+#include "creator/core/lock_profiling.h"
+
+/*
+ * Counting semaphore on a mutex and a CLOCK_MONOTONIC condition variable. Multi-token waits take all their tokens
+ * at once and timeouts do not move when the wall clock is set.
+ */
+typedef struct
+{
+    pthread_mutex_t Mutex;
+    pthread_cond_t Condition;
+    uint Tokens;
+    uint Waiters;
+    uint MultiTokenWaiters;
+#ifdef CREATOR_LOCK_PROFILING
+    LockProfile Profile;
+#endif
+} Semaphore;
 
 CreatorSemaphore CreatorSemaphore_New(uint tokensTotal, uint tokensTaken)
 {
-    sem_t *result;
+    Semaphore *result;
     Creator_Assert(tokensTaken <= tokensTotal, "Bad initial number of tokens");
     if (tokensTaken > tokensTotal)
     {
         tokensTaken = tokensTotal;
     }
 
-    result = Creator_MemAlloc(sizeof(sem_t));
+    result = Creator_MemAlloc(sizeof(Semaphore));
     if (result)
     {
-        int response = sem_init(result, 0, tokensTotal - tokensTaken);
-        if (response != 0)
+        pthread_condattr_t attributes;
+        pthread_condattr_init(&attributes);
+        pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+        result->Tokens = tokensTotal - tokensTaken;
+        result->Waiters = 0;
+        result->MultiTokenWaiters = 0;
+        if (pthread_mutex_init(&result->Mutex, NULL) != 0)
+        {
+            Creator_MemFree((void **)&result);
+        }
+        else if (pthread_cond_init(&result->Condition, &attributes) != 0)
         {
+            pthread_mutex_destroy(&result->Mutex);
             Creator_MemFree((void **)&result);
         }
+#ifdef CREATOR_LOCK_PROFILING
+        else
+        {
+            LockProfile_Register(&result->Profile);
+        }
+#endif
+        pthread_condattr_destroy(&attributes);
     }
     return result;
 }
@@ -54,12 +89,30 @@ void CreatorSemaphore_Wait(CreatorSemaphore self, uint tokens)
 {
     if (self)
     {
-        sem_t *semaphore = (sem_t*)self;
-        uint index;
-        for (index = 0; index < tokens; ++index)
+        Semaphore *semaphore = (Semaphore*)self;
+        pthread_mutex_lock(&semaphore->Mutex);
+#ifdef CREATOR_LOCK_PROFILING
+        bool contended = (semaphore->Tokens < tokens);
+        uint waitStart = contended ? LockProfile_GetTime() : 0;
+#endif
+        if (semaphore->Tokens < tokens)
         {
-            sem_wait(semaphore);
+            semaphore->Waiters++;
+            if (tokens > 1)
+                semaphore->MultiTokenWaiters++;
+            while (semaphore->Tokens < tokens)
+            {
+                pthread_cond_wait(&semaphore->Condition, &semaphore->Mutex);
+            }
+            semaphore->Waiters--;
+            if (tokens > 1)
+                semaphore->MultiTokenWaiters--;
         }
+        semaphore->Tokens -= tokens;
+#ifdef CREATOR_LOCK_PROFILING
+        LockProfile_Acquired(&semaphore->Profile, contended, waitStart, tokens);
+#endif
+        pthread_mutex_unlock(&semaphore->Mutex);
     }
 }
 
@@ -68,46 +121,90 @@ bool CreatorSemaphore_WaitFor(CreatorSemaphore self, uint tokens, uint milliseco
     bool result = true;
     if (self)
     {
-        sem_t *semaphore = (sem_t*)self;
-        uint index;
-        uint seconds = milliseconds / 1000;
-        milliseconds = milliseconds % 1000;
-        struct timespec sleepDuration;
-        sleepDuration.tv_sec = Creator_GetTime(NULL) + seconds;
-        sleepDuration.tv_nsec =  milliseconds * 1000000;
-        for (index = 0; index < tokens; ++index)
+        Semaphore *semaphore = (Semaphore*)self;
+        pthread_mutex_lock(&semaphore->Mutex);
+#ifdef CREATOR_LOCK_PROFILING
+        bool contended = (semaphore->Tokens < tokens);
+        uint waitStart = contended ? LockProfile_GetTime() : 0;
+#endif
+        if (semaphore->Tokens < tokens)
         {
-            if (sem_timedwait(semaphore, &sleepDuration) != 0)
+            struct timespec deadline;
+            clock_gettime(CLOCK_MONOTONIC, &deadline);
+            deadline.tv_sec += milliseconds / 1000;
+            deadline.tv_nsec += (milliseconds % 1000) * 1000000;
+            if (deadline.tv_nsec >= 1000000000)
             {
-                if (index > 0)
-                    CreatorSemaphore_Release(semaphore, index-1);
-                result =  false;
-                break;
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
             }
+            semaphore->Waiters++;
+            if (tokens > 1)
+                semaphore->MultiTokenWaiters++;
+            while (semaphore->Tokens < tokens)
+            {
+                if (pthread_cond_timedwait(&semaphore->Condition, &semaphore->Mutex, &deadline) == ETIMEDOUT)
+                    break;
+            }
+            semaphore->Waiters--;
+            if (tokens > 1)
+                semaphore->MultiTokenWaiters--;
+        }
+        result = (semaphore->Tokens >= tokens);
+        if (result)
+        {
+            semaphore->Tokens -= tokens;
+#ifdef CREATOR_LOCK_PROFILING
+            LockProfile_Acquired(&semaphore->Profile, contended, waitStart, tokens);
+#endif
         }
+        pthread_mutex_unlock(&semaphore->Mutex);
     }
     return result;
 }
 
 void CreatorSemaphore_Release(CreatorSemaphore self, uint tokens)
 {
-    if (self)
+    if (self && (tokens > 0))
     {
-        sem_t *semaphore = (sem_t*)self;
-        uint index;
-        for (index = 0; index < tokens; ++index)
+        Semaphore *semaphore = (Semaphore*)self;
+        pthread_mutex_lock(&semaphore->Mutex);
+#ifdef CREATOR_LOCK_PROFILING
+        LockProfile_Released(&semaphore->Profile, tokens);
+#endif
+        semaphore->Tokens += tokens;
+        if (semaphore->Waiters > 0)
         {
-            sem_post(semaphore);
+            // A single token can only satisfy one single token waiter
+            if ((tokens == 1) && (semaphore->MultiTokenWaiters == 0))
+                pthread_cond_signal(&semaphore->Condition);
+            else
+                pthread_cond_broadcast(&semaphore->Condition);
         }
+        pthread_mutex_unlock(&semaphore->Mutex);
+    }
+}
+
+void CreatorSemaphore_SetName(CreatorSemaphore self, const char *name)
+{
+#ifdef CREATOR_LOCK_PROFILING
+    if (self)
+    {
+        LockProfile_SetName(&((Semaphore*)self)->Profile, name);
     }
+#endif
 }
 
 void CreatorSemaphore_Free(CreatorSemaphore *self)
 {
     if (self && *self)
     {
-        sem_t *semaphore = (sem_t*)*self;
-        sem_destroy(semaphore);
+        Semaphore *semaphore = (Semaphore*)*self;
+#ifdef CREATOR_LOCK_PROFILING
+        LockProfile_Unregister(&semaphore->Profile);
+#endif
+        pthread_cond_destroy(&semaphore->Condition);
+        pthread_mutex_destroy(&semaphore->Mutex);
         Creator_MemFree((void **)self);
     }
 }
@@ -0,0 +1,232 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+
+#ifdef FREERTOS
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+#include "creator/core/creator_timer.h"
+#include "creator/core/creator_threading.h"
+#include "creator/core/creator_memalloc.h"
+#include "creator/core/creator_debug.h"
+#include "creator/core/lock_profiling.h"
+
+#define MAX_CONDITION_WAITERS	(0xFFFF)
+
+/*
+ * FreeRTOS has no condition variable, emulate one with a counting semaphore. Waiters counts threads waiting that
+ * have not been signalled yet and is only changed with the associated mutex held.
+ */
+typedef struct
+{
+    xSemaphoreHandle Semaphore;
+    uint Waiters;
+} Condition;
+
+CreatorMutex CreatorMutex_New(void)
+{
+    // FreeRTOS mutexes have priority inheritance
+    xSemaphoreHandle result = xSemaphoreCreateMutex();
+#ifdef CREATOR_LOCK_PROFILING
+    if (result)
+    {
+        ProfiledLock *lock = Creator_MemAlloc(sizeof(ProfiledLock));
+        if (lock)
+        {
+            lock->Handle = result;
+            LockProfile_Register(&lock->Profile);
+        }
+        else
+        {
+            vSemaphoreDelete(result);
+        }
+        return lock;
+    }
+#endif
+    return result;
+}
+
+void CreatorMutex_Lock(CreatorMutex self)
+{
+    if (self)
+    {
+        BaseType_t result;
+#ifdef CREATOR_LOCK_PROFILING
+        if (xSemaphoreTake(LOCK_HANDLE(self), 0) == pdTRUE)
+        {
+            LockProfile_Acquired(LOCK_PROFILE(self), false, 0, 1);
+            return;
+        }
+        uint waitStart = LockProfile_GetTime();
+#endif
+        do
+        {
+            result = xSemaphoreTake(LOCK_HANDLE(self), portMAX_DELAY);
+        } while (result != pdTRUE);
+#ifdef CREATOR_LOCK_PROFILING
+        LockProfile_Acquired(LOCK_PROFILE(self), true, waitStart, 1);
+#endif
+    }
+}
+
+bool CreatorMutex_LockFor(CreatorMutex self, uint milliseconds)
+{
+    bool result = false;
+    if (self)
+    {
+#ifdef CREATOR_LOCK_PROFILING
+        bool contended = (xSemaphoreTake(LOCK_HANDLE(self), 0) != pdTRUE);
+        uint waitStart = LockProfile_GetTime();
+        result = !contended || (xSemaphoreTake(LOCK_HANDLE(self), (milliseconds * CreatorTimer_GetTicksPerSecond())/1000) == pdTRUE);
+        if (result)
+            LockProfile_Acquired(LOCK_PROFILE(self), contended, waitStart, 1);
+#else
+        result = (xSemaphoreTake(LOCK_HANDLE(self), (milliseconds * CreatorTimer_GetTicksPerSecond())/1000) == pdTRUE);
+#endif
+    }
+    return result;
+}
+
+void CreatorMutex_Unlock(CreatorMutex self)
+{
+    if (self)
+    {
+#ifdef CREATOR_LOCK_PROFILING
+        LockProfile_Released(LOCK_PROFILE(self), 1);
+#endif
+        xSemaphoreGive(LOCK_HANDLE(self));
+    }
+}
+
+void CreatorMutex_SetName(CreatorMutex self, const char *name)
+{
+#ifdef CREATOR_LOCK_PROFILING
+    if (self)
+    {
+        LockProfile_SetName(LOCK_PROFILE(self), name);
+    }
+#endif
+}
+
+void CreatorMutex_Free(CreatorMutex *self)
+{
+    if (self && *self)
+    {
+        vSemaphoreDelete(LOCK_HANDLE(*self));
+#ifdef CREATOR_LOCK_PROFILING
+        LockProfile_Unregister(LOCK_PROFILE(*self));
+        Creator_MemFree(self);
+#endif
+        *self = NULL;
+    }
+}
+
+CreatorCondition CreatorCondition_New(void)
+{
+    Condition *result = Creator_MemAlloc(sizeof(Condition));
+    if (result)
+    {
+        result->Waiters = 0;
+        result->Semaphore = xSemaphoreCreateCounting(MAX_CONDITION_WAITERS, 0);
+        if (!result->Semaphore)
+        {
+            Creator_MemFree((void **)&result);
+        }
+    }
+    return result;
+}
+
+void CreatorCondition_Wait(CreatorCondition self, CreatorMutex mutex)
+{
+    if (self && mutex)
+    {
+        Condition *condition = (Condition*)self;
+        condition->Waiters++;
+        CreatorMutex_Unlock(mutex);
+        BaseType_t result;
+        do
+        {
+            result = xSemaphoreTake(condition->Semaphore, portMAX_DELAY);
+        } while (result != pdTRUE);
+        CreatorMutex_Lock(mutex);
+    }
+}
+
+bool CreatorCondition_WaitFor(CreatorCondition self, CreatorMutex mutex, uint milliseconds)
+{
+    bool result = false;
+    if (self && mutex)
+    {
+        Condition *condition = (Condition*)self;
+        condition->Waiters++;
+        CreatorMutex_Unlock(mutex);
+        result = (xSemaphoreTake(condition->Semaphore, (milliseconds * CreatorTimer_GetTicksPerSecond())/1000) == pdTRUE);
+        CreatorMutex_Lock(mutex);
+        if (!result)
+        {
+            // A signal may have been given between the timeout and re-locking the mutex
+            result = (xSemaphoreTake(condition->Semaphore, 0) == pdTRUE);
+            if (!result)
+                condition->Waiters--;
+        }
+    }
+    return result;
+}
+
+void CreatorCondition_Signal(CreatorCondition self)
+{
+    if (self)
+    {
+        Condition *condition = (Condition*)self;
+        if (condition->Waiters > 0)
+        {
+            condition->Waiters--;
+            xSemaphoreGive(condition->Semaphore);
+        }
+    }
+}
+
+void CreatorCondition_Broadcast(CreatorCondition self)
+{
+    if (self)
+    {
+        Condition *condition = (Condition*)self;
+        while (condition->Waiters > 0)
+        {
+            condition->Waiters--;
+            xSemaphoreGive(condition->Semaphore);
+        }
+    }
+}
+
+void CreatorCondition_Free(CreatorCondition *self)
+{
+    if (self && *self)
+    {
+        Condition *condition = (Condition*)*self;
+        vSemaphoreDelete(condition->Semaphore);
+        Creator_MemFree(self);
+    }
+}
+
+#endif
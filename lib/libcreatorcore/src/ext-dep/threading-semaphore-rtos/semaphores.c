@@ -29,6 +29,7 @@
 #include "creator/core/creator_threading.h"
 #include "creator/core/creator_memalloc.h"
 #include "creator/core/creator_debug.h"
+#include "creator/core/lock_profiling.h"
 
 CreatorSemaphore CreatorSemaphore_New(uint tokensTotal, uint tokensTaken)
 {
@@ -39,57 +40,119 @@ CreatorSemaphore CreatorSemaphore_New(uint tokensTotal, uint tokensTaken)
         tokensTaken = tokensTotal;
     }
     result = xSemaphoreCreateCounting(tokensTotal, (tokensTotal - tokensTaken));
+#ifdef CREATOR_LOCK_PROFILING
+    if (result)
+    {
+        ProfiledLock *lock = Creator_MemAlloc(sizeof(ProfiledLock));
+        if (lock)
+        {
+            lock->Handle = result;
+            LockProfile_Register(&lock->Profile);
+        }
+        else
+        {
+            vSemaphoreDelete(result);
+        }
+        return lock;
+    }
+#endif
     return result;
 }
 
 void CreatorSemaphore_Wait(CreatorSemaphore self, uint tokens)
 {
-    xSemaphoreHandle semaphore = (xSemaphoreHandle)self;
+    xSemaphoreHandle semaphore = LOCK_HANDLE(self);
     uint index;
+#ifdef CREATOR_LOCK_PROFILING
+    bool contended = false;
+    uint waitStart = LockProfile_GetTime();
+#endif
     for (index = 0; index < tokens; ++index)
     {
         BaseType_t result;
+#ifdef CREATOR_LOCK_PROFILING
+        if (xSemaphoreTake(semaphore, 0) == pdTRUE)
+            continue;
+        contended = true;
+#endif
         do
         {
             result = xSemaphoreTake(semaphore, portMAX_DELAY);
         }while (result != pdTRUE);
     }
+#ifdef CREATOR_LOCK_PROFILING
+    LockProfile_Acquired(LOCK_PROFILE(self), contended, waitStart, tokens);
+#endif
 }
 
 
 bool CreatorSemaphore_WaitFor(CreatorSemaphore self, uint tokens, uint milliseconds)
 {
     bool result = true;
-    xSemaphoreHandle semaphore = (xSemaphoreHandle)self;
+    xSemaphoreHandle semaphore = LOCK_HANDLE(self);
     uint index;
+#ifdef CREATOR_LOCK_PROFILING
+    bool contended = false;
+    uint waitStart = LockProfile_GetTime();
+#endif
     for (index = 0; index < tokens; ++index)
     {
+#ifdef CREATOR_LOCK_PROFILING
+        if (xSemaphoreTake(semaphore, 0) == pdTRUE)
+            continue;
+        contended = true;
+#endif
         if (xSemaphoreTake(semaphore,(milliseconds * CreatorTimer_GetTicksPerSecond())/1000) != pdTRUE)
         {
-            if (index > 0)
-                CreatorSemaphore_Release(semaphore, index-1);
+            // Give back the tokens already taken
+            while (index > 0)
+            {
+                xSemaphoreGive(semaphore);
+                index--;
+            }
             result =  false;
             break;
         }
     }
+#ifdef CREATOR_LOCK_PROFILING
+    if (result)
+        LockProfile_Acquired(LOCK_PROFILE(self), contended, waitStart, tokens);
+#endif
     return result;
 }
 
 void CreatorSemaphore_Release(CreatorSemaphore self, uint tokens) {
-    xSemaphoreHandle semaphore = (xSemaphoreHandle)self;
+    xSemaphoreHandle semaphore = LOCK_HANDLE(self);
     uint index;
+#ifdef CREATOR_LOCK_PROFILING
+    LockProfile_Released(LOCK_PROFILE(self), tokens);
+#endif
     for (index = 0; index < tokens; ++index)
     {
         xSemaphoreGive(semaphore);
     }
 }
 
+void CreatorSemaphore_SetName(CreatorSemaphore self, const char *name)
+{
+#ifdef CREATOR_LOCK_PROFILING
+    if (self)
+    {
+        LockProfile_SetName(LOCK_PROFILE(self), name);
+    }
+#endif
+}
+
 void CreatorSemaphore_Free(CreatorSemaphore *self)
 {
     if (self && *self)
     {
-        xSemaphoreHandle semaphore = (xSemaphoreHandle)*self;
+        xSemaphoreHandle semaphore = LOCK_HANDLE(*self);
         vSemaphoreDelete(semaphore);
+#ifdef CREATOR_LOCK_PROFILING
+        LockProfile_Unregister(LOCK_PROFILE(*self));
+        Creator_MemFree(self);
+#endif
         *self = NULL;
     }
 }
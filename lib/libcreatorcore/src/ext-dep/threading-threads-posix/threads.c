@@ -28,6 +28,7 @@
 #endif
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <pthread.h>
 #include <signal.h>
 #include <time.h>
@@ -37,8 +38,8 @@
 #include "creator/core/creator_time.h"
 #include "creator/core/creator_threading.h"
 #include "creator/core/creator_memalloc.h"
+#include "creator/core/creator_hashmap.h"
 #include "creator/core/creator_list.h"
-#include "creator/core/client.h"
 
 typedef struct
 {
@@ -49,17 +50,16 @@ typedef struct
     pthread_mutex_t SleepMutex;
     CreatorSemaphore Lock;
     bool Exited;
+    bool FreeOnExit;        // thread freed itself - ThreadCallbackWrapper releases the ThreadInfo once runnable returns
 }ThreadInfo;
 
-static CreatorList _Threads = NULL;
+// Thread ID -> ThreadInfo
+static CreatorHashMap _Threads = NULL;
 
-typedef struct
-{
-    pthread_t ThreadID;
-    CreatorErrorType Error;
-}ThreadError;
+#define THREAD_KEY(threadID) ((const void *)(uintptr_t)(threadID))
 
-static CreatorList _ThreadErrors = NULL;
+// Last error of the calling thread
+static __thread CreatorErrorType _LastError = CreatorError_NoError;
 
 typedef struct
 {
@@ -73,29 +73,14 @@ static CreatorList _ThreadRequestSecurityList = NULL;
 
 static CreatorSemaphore _ThreadLock = NULL;
 
+static void FreeThreadInfo(ThreadInfo *threadInfo);
 static pthread_t GetThreadID(CreatorThread self);
 static ThreadInfo *GetThreadInfo(CreatorThread self);
 static void *ThreadCallbackWrapper(void *context);
 
 void CreatorThread_ClearLastError(void)
 {
-    if (_ThreadErrors)
-    {
-        pthread_t threadID = GetThreadID(NULL);
-        CreatorSemaphore_Wait(_ThreadLock,1);
-        uint index;
-        for(index = 0; index < CreatorList_GetCount(_ThreadErrors); index++)
-        {
-            ThreadError *threadError = CreatorList_GetItem(_ThreadErrors, index);
-            if (threadError && (threadError->ThreadID == threadID))
-            {
-                CreatorList_RemoveAt(_ThreadErrors, index);
-                Creator_MemFree((void **)&threadError);
-                break;
-            }
-        }
-        CreatorSemaphore_Release(_ThreadLock,1);
-    }
+    _LastError = CreatorError_NoError;
 }
 
 void CreatorThread_Free(CreatorThread *self)
@@ -106,24 +91,27 @@ void CreatorThread_Free(CreatorThread *self)
         ThreadInfo *threadInfo = (ThreadInfo*)*self;
         if (_ThreadLock)
             CreatorSemaphore_Wait(_ThreadLock,1);
-        if (_Threads)
-            CreatorList_Remove(_Threads, threadInfo);
+        if (_Threads && (CreatorHashMap_Get(_Threads, THREAD_KEY(threadInfo->ThreadID)) == threadInfo))
+            CreatorHashMap_Remove(_Threads, THREAD_KEY(threadInfo->ThreadID));
         if (_ThreadLock)
             CreatorSemaphore_Release(_ThreadLock,1);
         if (threadInfo->Lock)
         {
             CreatorSemaphore_Wait(threadInfo->Lock,1);
         }
+        bool freeOnExit = false;
+        bool join = false;
         if (!threadInfo->Exited)
         {
             if (threadInfo->ThreadID == threadID)
             {
+                // still running on this thread's stack: ThreadCallbackWrapper frees it after the runnable returns
                 pthread_detach(threadInfo->ThreadID);
+                freeOnExit = true;
             }
             else
             {
-                pthread_cancel(threadInfo->ThreadID);
-                pthread_join(threadInfo->ThreadID, NULL);
+                join = true;
             }
             threadInfo->Exited = true;
         }
@@ -131,13 +119,17 @@ void CreatorThread_Free(CreatorThread *self)
         {
             CreatorSemaphore_Release(threadInfo->Lock,1);
         }
-        pthread_cond_destroy(&threadInfo->SleepCondition);
-        pthread_mutex_destroy(&threadInfo->SleepMutex);
-        if (threadInfo->Lock)
+        if (join)
         {
-            CreatorSemaphore_Free(&threadInfo->Lock);
+            // Not under the lock: a thread cancelled while waiting for it would exit holding the semaphore's mutex
+            pthread_cancel(threadInfo->ThreadID);
+            pthread_join(threadInfo->ThreadID, NULL);
         }
-        Creator_MemFree((void **)self);
+        if (freeOnExit)
+            threadInfo->FreeOnExit = true;
+        else
+            FreeThreadInfo(threadInfo);
+        *self = NULL;
     }
 }
 
@@ -165,24 +157,7 @@ void CreatorThread_Free(CreatorThread *self)
 
 CreatorErrorType CreatorThread_GetLastError(void)
 {
-    CreatorErrorType result = CreatorError_NoError;
-    if (_ThreadErrors)
-    {
-        pthread_t threadID = GetThreadID(NULL);
-        CreatorSemaphore_Wait(_ThreadLock,1);
-        uint index;
-        for(index = 0; index < CreatorList_GetCount(_ThreadErrors); index++)
-        {
-            ThreadError *threadError = CreatorList_GetItem(_ThreadErrors, index);
-            if (threadError && (threadError->ThreadID == threadID))
-            {
-                result = threadError->Error;
-                break;
-            }
-        }
-        CreatorSemaphore_Release(_ThreadLock,1);
-    }
-    return result;
+    return _LastError;
 }
 
 uint CreatorThread_GetThreadID(CreatorThread self)
@@ -237,9 +212,12 @@ uint CreatorThread_GetThreadID(CreatorThread self)
 void CreatorThread_Initialise(void)
 {
     if (!_Threads)
-        _Threads = CreatorList_New(5);
+        _Threads = CreatorHashMap_New(CreatorHashMapKeyType_Pointer, 5);
     if (!_ThreadLock)
+    {
         _ThreadLock = CreatorSemaphore_New(1,0);
+        CreatorSemaphore_SetName(_ThreadLock, "ThreadLock");
+    }
 }
 
 void CreatorThread_Join(CreatorThread self)
@@ -249,6 +227,7 @@ void CreatorThread_Join(CreatorThread self)
     {
         if (!threadInfo->Exited)
         {
+            bool join = false;
             if (threadInfo->Lock)
             {
                 CreatorSemaphore_Wait(threadInfo->Lock,1);
@@ -256,12 +235,15 @@ void CreatorThread_Join(CreatorThread self)
             if (!threadInfo->Exited)
             {
                 threadInfo->Exited = true;
-                pthread_join(threadInfo->ThreadID, NULL);
+                join = true;
             }
             if (threadInfo->Lock)
             {
                 CreatorSemaphore_Release(threadInfo->Lock,1);
             }
+            // Not under the lock, which the thread takes as it finishes (see ThreadCallbackWrapper)
+            if (join)
+                pthread_join(threadInfo->ThreadID, NULL);
         }
     }
 }
@@ -295,7 +277,7 @@ void CreatorThread_Join(CreatorThread self)
 CreatorThread CreatorThread_New(const char *name, uint priority, uint stackSize, CreatorThread_Callback runnable, void *context)
 {
     if (!_Threads)
-        _Threads = CreatorList_New(5);
+        _Threads = CreatorHashMap_New(CreatorHashMapKeyType_Pointer, 5);
     (void)name;
     (void)priority;
     (void)stackSize;
@@ -307,6 +289,7 @@ CreatorThread CreatorThread_New(const char *name, uint priority, uint stackSize,
     threadInfo->RunnableContext = context;
     threadInfo->Lock = CreatorSemaphore_New(1,0);
     threadInfo->Exited = false;
+    threadInfo->FreeOnExit = false;
     pthread_cond_init(&threadInfo->SleepCondition, NULL);
     pthread_mutex_init(&threadInfo->SleepMutex, NULL);
 
@@ -320,47 +303,14 @@ CreatorThread CreatorThread_New(const char *name, uint priority, uint stackSize,
         return NULL;
     }
     CreatorSemaphore_Wait(_ThreadLock,1);
-    CreatorList_Add(_Threads, threadInfo);
+    CreatorHashMap_Put(_Threads, THREAD_KEY(threadInfo->ThreadID), threadInfo);
     CreatorSemaphore_Release(_ThreadLock,1);
     return (CreatorThread)threadInfo;
 }
 
 void CreatorThread_SetError(CreatorErrorType error)
 {
-    if (error == CreatorError_NoError)
-        CreatorThread_ClearLastError();
-    else
-    {
-        pthread_t threadID = GetThreadID(NULL);
-        if (!_ThreadLock)
-            _ThreadLock = CreatorSemaphore_New(1,0);
-        CreatorSemaphore_Wait(_ThreadLock,1);
-        if (!_ThreadErrors)
-            _ThreadErrors = CreatorList_New(10);
-        uint index;
-        bool found = false;
-        for(index = 0; index < CreatorList_GetCount(_ThreadErrors); index++)
-        {
-            ThreadError *threadError = CreatorList_GetItem(_ThreadErrors, index);
-            if (threadError && (threadError->ThreadID == threadID))
-            {
-                threadError->Error = error;
-                found = true;
-                break;
-            }
-        }
-        if (!found)
-        {
-            ThreadError *threadError = Creator_MemAlloc(sizeof(ThreadError));
-            if (threadError)
-            {
-                threadError->ThreadID = threadID;
-                threadError->Error = error;
-                CreatorList_Add(_ThreadErrors, threadError);
-            }
-        }
-        CreatorSemaphore_Release(_ThreadLock,1);
-    }
+    _LastError = error;
 }
 
 //void CreatorThread_SetClient(CreatorClient client)
@@ -599,12 +549,10 @@ bool CreatorThread_SleepTicks(CreatorThread self, uint ticks)
 
 void CreatorThread_Shutdown(void)
 {
-    if (_ThreadErrors)
-         CreatorList_Free(&_ThreadErrors, true);
     if (_ThreadRequestSecurityList)
          CreatorList_Free(&_ThreadRequestSecurityList, true);
     if (_Threads)
-         CreatorList_Free(&_Threads, false);
+         CreatorHashMap_Free(&_Threads);
     if (_ThreadLock)
          CreatorSemaphore_Free(&_ThreadLock);
 }
@@ -617,6 +565,17 @@ void CreatorThread_Wakeup(CreatorThread self)
     pthread_mutex_unlock(&threadInfo->SleepMutex);
 }
 
+static void FreeThreadInfo(ThreadInfo *threadInfo)
+{
+    pthread_cond_destroy(&threadInfo->SleepCondition);
+    pthread_mutex_destroy(&threadInfo->SleepMutex);
+    if (threadInfo->Lock)
+    {
+        CreatorSemaphore_Free(&threadInfo->Lock);
+    }
+    Creator_MemFree((void **)&threadInfo);
+}
+
 pthread_t GetThreadID(CreatorThread self)
 {
     pthread_t result;
@@ -645,17 +604,8 @@ static ThreadInfo *GetThreadInfo(CreatorThread self)
         if (_Threads)
         {
             pthread_t threadID = GetThreadID(NULL);
-            uint index;
             CreatorSemaphore_Wait(_ThreadLock,1);
-            for(index = 0; index < CreatorList_GetCount(_Threads); index++)
-            {
-                ThreadInfo *threadInfo = CreatorList_GetItem(_Threads, index);
-                if (threadInfo && (threadInfo->ThreadID == threadID))
-                {
-                    result = threadInfo;
-                    break;
-                }
-            }
+            result = CreatorHashMap_Get(_Threads, THREAD_KEY(threadID));
             CreatorSemaphore_Release(_ThreadLock,1);
         }
     }
@@ -666,7 +616,14 @@ static void *ThreadCallbackWrapper(void *context)
 {
     ThreadInfo *threadInfo = (ThreadInfo*)context;
     threadInfo->Runnable(threadInfo, threadInfo->RunnableContext);
-    if (threadInfo)
+    // CreatorThread_Free may be cancelling this thread - finish without being cancelled while holding a lock
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+    if (threadInfo->FreeOnExit)
+    {
+        // runnable called CreatorThread_Free on its own thread (already detached)
+        FreeThreadInfo(threadInfo);
+    }
+    else
     {
         if (!threadInfo->Exited)
         {
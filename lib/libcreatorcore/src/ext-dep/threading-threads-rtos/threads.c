@@ -25,6 +25,7 @@
 //enable nanosleep
 #define _POSIX_C_SOURCE 199506L
 #include <stddef.h>
+#include <stdint.h>
 #include <time.h>
 #include <errno.h>
 #include "FreeRTOS.h"
@@ -45,13 +46,11 @@ typedef struct
     xTaskHandle ThreadID;
 }ThreadInfo;
 
-typedef struct
-{
-    uint ThreadID;
-    CreatorErrorType Error;
-}ThreadError;
-
-static CreatorList _ThreadErrors = NULL;
+// Last error of each task is kept in a FreeRTOS thread local storage pointer
+#if !defined(configNUM_THREAD_LOCAL_STORAGE_POINTERS) || (configNUM_THREAD_LOCAL_STORAGE_POINTERS < 1)
+#error "configNUM_THREAD_LOCAL_STORAGE_POINTERS must be at least 1"
+#endif
+#define CREATOR_TLS_INDEX_LAST_ERROR	(0)
 
 typedef struct
 {
@@ -71,23 +70,7 @@ static void ThreadCallbackWrapper(void *context);
 
 void CreatorThread_ClearLastError(void)
 {
-    if (_ThreadErrors)
-    {
-        uint threadID = CreatorThread_GetThreadID(NULL);
-        CreatorSemaphore_Wait(_ThreadLock,1);
-        uint index;
-        for(index = 0; index < CreatorList_GetCount(_ThreadErrors); index++)
-        {
-            ThreadError *threadError = CreatorList_GetItem(_ThreadErrors, index);
-            if (threadError && (threadError->ThreadID == threadID))
-            {
-                CreatorList_RemoveAt(_ThreadErrors, index);
-                Creator_MemFree((void **)&threadError);
-                break;
-            }
-        }
-        CreatorSemaphore_Release(_ThreadLock,1);
-    }
+    vTaskSetThreadLocalStoragePointer(NULL, CREATOR_TLS_INDEX_LAST_ERROR, (void *)(intptr_t)CreatorError_NoError);
 }
 
 void CreatorThread_Free(CreatorThread *self)
@@ -125,24 +108,7 @@ void CreatorThread_Free(CreatorThread *self)
 
 CreatorErrorType CreatorThread_GetLastError(void)
 {
-    CreatorErrorType result = CreatorError_NoError;
-    if (_ThreadErrors)
-    {
-        uint threadID = CreatorThread_GetThreadID(NULL);
-        CreatorSemaphore_Wait(_ThreadLock,1);
-        uint index;
-        for(index = 0; index < CreatorList_GetCount(_ThreadErrors); index++)
-        {
-            ThreadError *threadError = CreatorList_GetItem(_ThreadErrors, index);
-            if (threadError && (threadError->ThreadID == threadID))
-            {
-                result = threadError->Error;
-                break;
-            }
-        }
-        CreatorSemaphore_Release(_ThreadLock,1);
-    }
-    return result;
+    return (CreatorErrorType)(intptr_t)pvTaskGetThreadLocalStoragePointer(NULL, CREATOR_TLS_INDEX_LAST_ERROR);
 }
 
 uint CreatorThread_GetThreadID(CreatorThread self)
@@ -209,7 +175,10 @@ uint CreatorThread_GetThreadID(CreatorThread self)
 void CreatorThread_Initialise(void)
 {
     if (!_ThreadLock)
-    _ThreadLock = CreatorSemaphore_New(1,0);
+    {
+        _ThreadLock = CreatorSemaphore_New(1,0);
+        CreatorSemaphore_SetName(_ThreadLock, "ThreadLock");
+    }
 }
 
 void CreatorThread_Join(CreatorThread self)
@@ -383,46 +352,11 @@ CreatorThread CreatorThread_New(const char *name, uint priority, uint stackSize,
 
 void CreatorThread_SetError(CreatorErrorType error)
 {
-    if (error == CreatorError_NoError)
-    CreatorThread_ClearLastError();
-    else
-    {
-        uint threadID = CreatorThread_GetThreadID(NULL);
-        if (!_ThreadLock)
-        _ThreadLock = CreatorSemaphore_New(1,0);
-        CreatorSemaphore_Wait(_ThreadLock,1);
-        if (!_ThreadErrors)
-        _ThreadErrors = CreatorList_New(10);
-        uint index;
-        bool found = false;
-        for(index = 0; index < CreatorList_GetCount(_ThreadErrors); index++)
-        {
-            ThreadError *threadError = CreatorList_GetItem(_ThreadErrors, index);
-            if (threadError && (threadError->ThreadID == threadID))
-            {
-                threadError->Error = error;
-                found = true;
-                break;
-            }
-        }
-        if (!found)
-        {
-            ThreadError *threadError = Creator_MemAlloc(sizeof(ThreadError));
-            if (threadError)
-            {
-                threadError->ThreadID = threadID;
-                threadError->Error = error;
-                CreatorList_Add(_ThreadErrors, threadError);
-            }
-        }
-        CreatorSemaphore_Release(_ThreadLock,1);
-    }
+    vTaskSetThreadLocalStoragePointer(NULL, CREATOR_TLS_INDEX_LAST_ERROR, (void *)(intptr_t)error);
 }
 
 void CreatorThread_Shutdown(void)
 {
-    if (_ThreadErrors)
-    CreatorList_Free(&_ThreadErrors, true);
     if (_ThreadRequestSecurityList)
     CreatorList_Free(&_ThreadRequestSecurityList, true);
     if (_ThreadLock)
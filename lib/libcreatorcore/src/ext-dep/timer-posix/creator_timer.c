@@ -19,67 +19,108 @@
  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***********************************************************************************************************************/
-
 #ifdef POSIX
 
 #include "creator/core/creator_timer.h"
 #include "creator/core/creator_memalloc.h"
 
-#include <signal.h>
+#include <pthread.h>
 #include <sys/time.h>
 #include <time.h>
 #include <string.h>
+#include <limits.h>
 
+#define INITIAL_HEAP_SIZE		(16)
+#define INVALID_HEAP_INDEX		(UINT_MAX)
+#define NANOSECONDS_PER_SECOND	(1000000000ULL)
+#define NANOSECONDS_PER_MS		(1000000ULL)
 
+/*
+ * All timers are multiplexed onto one dispatch thread. Armed timers sit in a binary min-heap keyed on their
+ * CLOCK_MONOTONIC deadline and the thread sleeps on a condition variable until the earliest one is due, so
+ * callbacks run in normal thread context (not in a signal handler) one at a time.
+ */
 typedef struct TimerInfoImpl
 {
     CreatorTimer_Callback Runnable;
     void *Context;
-    timer_t Timer;
     uint PeriodInMilliseconds;
     bool Continuous;
+    uint64 Deadline;
+    uint HeapIndex;
 }*TimerInfo;
 
-struct sigaction *_Action = NULL;
+static pthread_mutex_t _TimerLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _TimerCondition;
+static pthread_cond_t _CallbackCompleted;
+static pthread_t _TimerThread;
+static bool _Initialised = false;
+static bool _TerminateTimerThread = false;
+static TimerInfo _RunningTimer = NULL;
 
-static void TimerCallBack(int sig, siginfo_t *si, void *uc)
-{
-    if (si)
-    {
-        TimerInfo timerInfo = (TimerInfo)si->si_value.sival_ptr;
-        if (timerInfo)
-        {
-            if(timerInfo->Runnable)
-            {
-                timerInfo->Runnable((CreatorTimer)timerInfo, timerInfo->Context);
-            }
-        }
-    }
+static TimerInfo *_TimerHeap = NULL;
+static uint _TimerCount = 0;
+static uint _TimerHeapSize = 0;
 
-}
+static void ArmTimer(TimerInfo timerInfo);
+static void DisarmTimer(TimerInfo timerInfo);
+static uint64 GetTime(void);
+static void HeapRemove(uint heapIndex);
+static void HeapSiftDown(uint heapIndex);
+static void HeapSiftUp(uint heapIndex);
+static void HeapSwap(uint first, uint second);
+static void *TimerThreadMethod(void *context);
 
 void CreatorTimer_Initialise(void)
 {
-    if (!_Action)
+    pthread_mutex_lock(&_TimerLock);
+    if (!_Initialised)
     {
-        _Action = (struct sigaction*)Creator_MemAlloc(sizeof(struct sigaction));
-        memset(_Action,0, sizeof(struct sigaction));
-        _Action->sa_flags = SA_SIGINFO;
-        _Action->sa_sigaction = TimerCallBack;
-        sigemptyset(&_Action->sa_mask);
-        if (sigaction(SIGRTMIN, _Action, NULL) == -1)
+        pthread_condattr_t attributes;
+        pthread_condattr_init(&attributes);
+        pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+        pthread_cond_init(&_TimerCondition, &attributes);
+        pthread_cond_init(&_CallbackCompleted, &attributes);
+        pthread_condattr_destroy(&attributes);
+        _TerminateTimerThread = false;
+        if (pthread_create(&_TimerThread, NULL, TimerThreadMethod, NULL) == 0)
+        {
+            _Initialised = true;
+        }
+        else
         {
-            Creator_MemFree((void **)&_Action);
+            pthread_cond_destroy(&_TimerCondition);
+            pthread_cond_destroy(&_CallbackCompleted);
         }
     }
+    pthread_mutex_unlock(&_TimerLock);
 }
 
 void CreatorTimer_Shutdown(void)
 {
-    if (_Action)
+    pthread_mutex_lock(&_TimerLock);
+    if (_Initialised)
     {
-        Creator_MemFree((void **)&_Action);
+        _TerminateTimerThread = true;
+        pthread_cond_signal(&_TimerCondition);
+        pthread_mutex_unlock(&_TimerLock);
+        pthread_join(_TimerThread, NULL);
+        pthread_mutex_lock(&_TimerLock);
+        // Timers still armed are left disarmed, they remain owned by their creators
+        uint index;
+        for (index = 0; index < _TimerCount; index++)
+        {
+            _TimerHeap[index]->HeapIndex = INVALID_HEAP_INDEX;
+        }
+        _TimerCount = 0;
+        _TimerHeapSize = 0;
+        if (_TimerHeap)
+            Creator_MemFree((void **)&_TimerHeap);
+        pthread_cond_destroy(&_TimerCondition);
+        pthread_cond_destroy(&_CallbackCompleted);
+        _Initialised = false;
     }
+    pthread_mutex_unlock(&_TimerLock);
 }
 
 CreatorTimer CreatorTimer_New(const char *name, uint periodInMilliseconds, bool continuous, CreatorTimer_Callback runnable, void *context)
@@ -87,7 +128,7 @@ CreatorTimer CreatorTimer_New(const char *name, uint periodInMilliseconds, bool
     TimerInfo result = (TimerInfo)Creator_MemAlloc(sizeof(struct TimerInfoImpl));
     if (result)
     {
-        if (!_Action)
+        if (!_Initialised)
         {
             CreatorTimer_Initialise();
         }
@@ -96,48 +137,22 @@ CreatorTimer CreatorTimer_New(const char *name, uint periodInMilliseconds, bool
         result->Context = context;
         result->PeriodInMilliseconds = periodInMilliseconds;
         result->Continuous = continuous;
-
-        struct sigevent sev;
-        memset(&sev,0, sizeof(struct sigevent));
-        sev.sigev_notify = SIGEV_SIGNAL;
-        sev.sigev_signo = SIGRTMIN;
-        sev.sigev_value.sival_ptr = result;
-        if (timer_create(CLOCK_REALTIME, &sev, &result->Timer) == -1)
-        {
-
-        }
+        result->Deadline = 0;
+        result->HeapIndex = INVALID_HEAP_INDEX;
     }
     return (CreatorTimer)result;
 }
 
-void SetTimerPeriod(TimerInfo timerInfo, struct itimerspec *timePeriod)
-{
-    if (timerInfo->Continuous)
-    {
-        timePeriod->it_interval.tv_sec = timerInfo->PeriodInMilliseconds / 1000;
-        timePeriod->it_interval.tv_nsec = ((timerInfo->PeriodInMilliseconds % 1000) * 1000000);
-    }
-    else
-    {
-        timePeriod->it_interval.tv_sec = 0;
-        timePeriod->it_interval.tv_nsec = 0;
-    }
-    timePeriod->it_value.tv_sec = timerInfo->PeriodInMilliseconds / 1000;
-    timePeriod->it_value.tv_nsec = ((timerInfo->PeriodInMilliseconds % 1000) * 1000000);
-}
-
 bool CreatorTimer_Reset(CreatorTimer self)
 {
     bool result = false;
-    if (self)
+    if (self && _Initialised)
     {
         TimerInfo timerInfo = (TimerInfo)self;
-        struct itimerspec timePeriod;
-        SetTimerPeriod(timerInfo, &timePeriod);
-        if (timer_settime(timerInfo->Timer, 0, &timePeriod, NULL) == 0)
-        {
-            result = true;
-        }
+        pthread_mutex_lock(&_TimerLock);
+        ArmTimer(timerInfo);
+        result = (timerInfo->HeapIndex != INVALID_HEAP_INDEX);
+        pthread_mutex_unlock(&_TimerLock);
     }
     return result;
 }
@@ -145,50 +160,33 @@ bool CreatorTimer_Reset(CreatorTimer self)
 bool CreatorTimer_SetPeriod(CreatorTimer self, uint periodInMilliseconds)
 {
     bool result = false;
-    if (self)
+    if (self && _Initialised)
     {
         TimerInfo timerInfo = (TimerInfo)self;
+        pthread_mutex_lock(&_TimerLock);
         timerInfo->PeriodInMilliseconds = periodInMilliseconds;
-        struct itimerspec timePeriod;
-        SetTimerPeriod(timerInfo, &timePeriod);
-        if (timer_settime(timerInfo->Timer, 0, &timePeriod, NULL) == 0)
-        {
-            result = true;
-        }
+        ArmTimer(timerInfo);
+        result = (timerInfo->HeapIndex != INVALID_HEAP_INDEX);
+        pthread_mutex_unlock(&_TimerLock);
     }
     return result;
 }
 
 bool CreatorTimer_Start(CreatorTimer self)
 {
-    bool result = false;
-    if (self)
-    {
-        TimerInfo timerInfo = (TimerInfo)self;
-        struct itimerspec timePeriod;
-        SetTimerPeriod(timerInfo, &timePeriod);
-        if (timer_settime(timerInfo->Timer, 0, &timePeriod, NULL) == 0)
-        {
-            result = true;
-        }
-    }
-    return result;
+    return CreatorTimer_Reset(self);
 }
 
 bool CreatorTimer_Stop(CreatorTimer self)
 {
     bool result = false;
-    if (self)
+    if (self && _Initialised)
     {
         TimerInfo timerInfo = (TimerInfo)self;
-        struct itimerspec timePeriod;
-        SetTimerPeriod(timerInfo, &timePeriod);
-        timePeriod.it_value.tv_sec = 0;
-        timePeriod.it_value.tv_nsec = 0;
-        if (timer_settime(timerInfo->Timer, 0, &timePeriod, NULL) == 0)
-        {
-            result = true;
-        }
+        pthread_mutex_lock(&_TimerLock);
+        DisarmTimer(timerInfo);
+        pthread_mutex_unlock(&_TimerLock);
+        result = true;
     }
     return result;
 }
@@ -197,10 +195,18 @@ void CreatorTimer_Free(CreatorTimer *self)
 {
     if (self && *self)
     {
-        CreatorTimer timer = *self;
-        CreatorTimer_Stop(timer);
-        TimerInfo timerInfo = (TimerInfo)timer;
-        timer_delete(timerInfo->Timer);
+        TimerInfo timerInfo = (TimerInfo)*self;
+        if (_Initialised)
+        {
+            pthread_mutex_lock(&_TimerLock);
+            DisarmTimer(timerInfo);
+            // Wait for a callback in progress on another thread, a callback may free its own timer
+            while ((_RunningTimer == timerInfo) && !pthread_equal(pthread_self(), _TimerThread))
+            {
+                pthread_cond_wait(&_CallbackCompleted, &_TimerLock);
+            }
+            pthread_mutex_unlock(&_TimerLock);
+        }
         Creator_MemFree((void **)self);
     }
 }
@@ -226,4 +232,158 @@ void CreatorTimer_SetTicksPerSecond(uint ticks)
 
 }
 
+/*
+ * must be mutex-protected before entering
+ */
+static void ArmTimer(TimerInfo timerInfo)
+{
+    timerInfo->Deadline = GetTime() + (timerInfo->PeriodInMilliseconds * NANOSECONDS_PER_MS);
+    if (timerInfo->HeapIndex == INVALID_HEAP_INDEX)
+    {
+        if (_TimerCount == _TimerHeapSize)
+        {
+            uint newSize = (_TimerHeapSize == 0) ? INITIAL_HEAP_SIZE : _TimerHeapSize * 2;
+            TimerInfo *newHeap = Creator_MemRealloc(_TimerHeap, sizeof(TimerInfo) * newSize);
+            if (newHeap)
+            {
+                _TimerHeap = newHeap;
+                _TimerHeapSize = newSize;
+            }
+        }
+        if (_TimerCount < _TimerHeapSize)
+        {
+            timerInfo->HeapIndex = _TimerCount++;
+            _TimerHeap[timerInfo->HeapIndex] = timerInfo;
+            HeapSiftUp(timerInfo->HeapIndex);
+        }
+    }
+    else
+    {
+        HeapSiftDown(timerInfo->HeapIndex);
+        HeapSiftUp(timerInfo->HeapIndex);
+    }
+    if (timerInfo->HeapIndex == 0)
+    {
+        // Earliest deadline changed
+        pthread_cond_signal(&_TimerCondition);
+    }
+}
+
+static void DisarmTimer(TimerInfo timerInfo)
+{
+    if (timerInfo->HeapIndex != INVALID_HEAP_INDEX)
+    {
+        HeapRemove(timerInfo->HeapIndex);
+    }
+}
+
+static uint64 GetTime(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64)now.tv_sec * NANOSECONDS_PER_SECOND) + (uint64)now.tv_nsec;
+}
+
+static void HeapRemove(uint heapIndex)
+{
+    TimerInfo timerInfo = _TimerHeap[heapIndex];
+    _TimerCount--;
+    if (heapIndex != _TimerCount)
+    {
+        HeapSwap(heapIndex, _TimerCount);
+        HeapSiftDown(heapIndex);
+        HeapSiftUp(heapIndex);
+    }
+    timerInfo->HeapIndex = INVALID_HEAP_INDEX;
+}
+
+static void HeapSiftDown(uint heapIndex)
+{
+    for (;;)
+    {
+        uint smallest = heapIndex;
+        uint left = (heapIndex * 2) + 1;
+        uint right = left + 1;
+        if ((left < _TimerCount) && (_TimerHeap[left]->Deadline < _TimerHeap[smallest]->Deadline))
+            smallest = left;
+        if ((right < _TimerCount) && (_TimerHeap[right]->Deadline < _TimerHeap[smallest]->Deadline))
+            smallest = right;
+        if (smallest == heapIndex)
+            break;
+        HeapSwap(heapIndex, smallest);
+        heapIndex = smallest;
+    }
+}
+
+static void HeapSiftUp(uint heapIndex)
+{
+    while (heapIndex > 0)
+    {
+        uint parent = (heapIndex - 1) / 2;
+        if (_TimerHeap[parent]->Deadline <= _TimerHeap[heapIndex]->Deadline)
+            break;
+        HeapSwap(heapIndex, parent);
+        heapIndex = parent;
+    }
+}
+
+static void HeapSwap(uint first, uint second)
+{
+    TimerInfo timerInfo = _TimerHeap[first];
+    _TimerHeap[first] = _TimerHeap[second];
+    _TimerHeap[second] = timerInfo;
+    _TimerHeap[first]->HeapIndex = first;
+    _TimerHeap[second]->HeapIndex = second;
+}
+
+static void *TimerThreadMethod(void *context)
+{
+    (void)context;
+    pthread_mutex_lock(&_TimerLock);
+    while (!_TerminateTimerThread)
+    {
+        if (_TimerCount == 0)
+        {
+            pthread_cond_wait(&_TimerCondition, &_TimerLock);
+            continue;
+        }
+        TimerInfo timerInfo = _TimerHeap[0];
+        uint64 now = GetTime();
+        if (timerInfo->Deadline > now)
+        {
+            struct timespec deadline;
+            deadline.tv_sec = (time_t)(timerInfo->Deadline / NANOSECONDS_PER_SECOND);
+            deadline.tv_nsec = (long)(timerInfo->Deadline % NANOSECONDS_PER_SECOND);
+            pthread_cond_timedwait(&_TimerCondition, &_TimerLock, &deadline);
+            continue;
+        }
+        if (timerInfo->Continuous && (timerInfo->PeriodInMilliseconds > 0))
+        {
+            // Re-arm from the previous deadline so periodic timers do not drift, skipping missed periods
+            uint64 period = timerInfo->PeriodInMilliseconds * NANOSECONDS_PER_MS;
+            timerInfo->Deadline += period;
+            if (timerInfo->Deadline <= now)
+                timerInfo->Deadline = now + period - ((now - timerInfo->Deadline) % period);
+            HeapSiftDown(0);
+        }
+        else
+        {
+            HeapRemove(0);
+        }
+        _RunningTimer = timerInfo;
+        CreatorTimer_Callback runnable = timerInfo->Runnable;
+        void *runnableContext = timerInfo->Context;
+        pthread_mutex_unlock(&_TimerLock);
+        if (runnable)
+        {
+            runnable((CreatorTimer)timerInfo, runnableContext);
+        }
+        pthread_mutex_lock(&_TimerLock);
+        _RunningTimer = NULL;
+        pthread_cond_broadcast(&_CallbackCompleted);
+    }
+    pthread_mutex_unlock(&_TimerLock);
+    return NULL;
+}
+
 #endif
@@ -80,12 +80,17 @@ static int SSLSendCallBack(CYASSL *sslSessioon, char *sendBuffer, int sendBuffer
 
 #define WAIT_TIMEOUT_SECS 60    // wait timeout in seconds
 
+static void *TLSMemAlloc(size_t size)
+{
+    return Creator_MemAllocWithTag(size, CreatorMemTag_TLS);
+}
+
 #if 1
 void *XMALLOC(size_t n, void* heap, int type)
 {
     (void)heap;
     (void)type;
-    return Creator_MemAlloc(n);
+    return TLSMemAlloc(n);
 }
 
 void *XREALLOC(void *p, size_t n, void* heap, int type)
@@ -106,7 +111,7 @@ void XFREE(void *p, void* heap, int type)
 void CreatorTLS_Initialise(void)
 {
     CyaSSL_Init();
-    CyaSSL_SetAllocators(Creator_MemAlloc, Creator_MemSafeFree, Creator_MemRealloc);
+    CyaSSL_SetAllocators(TLSMemAlloc, Creator_MemSafeFree, Creator_MemRealloc);
 }
 
 void CreatorTLS_Shutdown(void)
@@ -0,0 +1,156 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+
+/*! \file common_messaging_buffers.c
+ *  \brief Shared pool of receive buffers, lent to a connection only while it has data to parse.
+ */
+
+#include <stddef.h>
+
+#include "creator/core/common_messaging_defines.h"
+#include "creator/core/common_messaging_main.h"
+#include "creator/core/creator_memalloc.h"
+#include "creator/core/creator_static_alloc.h"
+#include "common_messaging_parser.h"
+
+// Idle heap buffers kept for the next loan (the static build keeps its whole pool instead)
+#ifndef CREATOR_RECEIVE_BUFFER_CACHE
+#define CREATOR_RECEIVE_BUFFER_CACHE    (2)
+#endif
+
+// One spare byte so the received data can be null-terminated for the header parser
+#define RECEIVE_BUFFER_SIZE             (CREATOR_MAX_PACKET_LEN + 1)
+
+#ifdef FREERTOS
+#include "FreeRTOS.h"
+#include "task.h"
+#define LOCK_BUFFERS()      taskENTER_CRITICAL()
+#define UNLOCK_BUFFERS()    taskEXIT_CRITICAL()
+#else
+#include <pthread.h>
+static pthread_mutex_t _BufferLock = PTHREAD_MUTEX_INITIALIZER;
+#define LOCK_BUFFERS()      pthread_mutex_lock(&_BufferLock)
+#define UNLOCK_BUFFERS()    pthread_mutex_unlock(&_BufferLock)
+#endif
+
+#ifdef CREATOR_STATIC_ALLOC
+CREATOR_STATIC_POOL(_ReceiveBuffers, RECEIVE_BUFFER_SIZE, CREATOR_STATIC_RECEIVE_BUFFERS);
+#else
+typedef struct IdleBuffer
+{
+    struct IdleBuffer *Next;
+} IdleBuffer;
+
+static IdleBuffer *_IdleBuffers = NULL;
+static uint _IdleCount = 0;
+#endif
+
+static CreatorCommonMessaging_ReceiveBufferStatistics _Statistics;
+
+char *CreatorCommonMessaging_NewReceiveBuffer(void)
+{
+    char *result = NULL;
+#ifdef CREATOR_STATIC_ALLOC
+    result = (char *)CreatorStaticPool_Alloc(&_ReceiveBuffers);
+#else
+    LOCK_BUFFERS();
+    if (_IdleBuffers)
+    {
+        result = (char *)_IdleBuffers;
+        _IdleBuffers = _IdleBuffers->Next;
+        _IdleCount--;
+    }
+    UNLOCK_BUFFERS();
+#endif
+    bool fromHeap = false;
+    if (!result)
+    {
+        result = (char *)Creator_MemAlloc(RECEIVE_BUFFER_SIZE);
+        fromHeap = true;
+    }
+
+    LOCK_BUFFERS();
+    if (result)
+    {
+        _Statistics.Borrowed++;
+        if (fromHeap)
+            _Statistics.HeapAllocations++;
+        _Statistics.InUse++;
+        if (_Statistics.InUse > _Statistics.PeakInUse)
+            _Statistics.PeakInUse = _Statistics.InUse;
+    }
+    else
+    {
+        _Statistics.Failed++;
+    }
+    UNLOCK_BUFFERS();
+    return result;
+}
+
+void CreatorCommonMessaging_FreeReceiveBuffer(char **buffer)
+{
+    if (buffer && *buffer)
+    {
+        bool released = false;
+        LOCK_BUFFERS();
+        _Statistics.InUse--;
+#ifndef CREATOR_STATIC_ALLOC
+        if (_IdleCount < CREATOR_RECEIVE_BUFFER_CACHE)
+        {
+            IdleBuffer *idle = (IdleBuffer *)*buffer;
+            idle->Next = _IdleBuffers;
+            _IdleBuffers = idle;
+            _IdleCount++;
+            released = true;
+        }
+#endif
+        UNLOCK_BUFFERS();
+#ifdef CREATOR_STATIC_ALLOC
+        released = CreatorStaticPool_Free(&_ReceiveBuffers, *buffer);
+#endif
+        if (released)
+            *buffer = NULL;
+        else
+            Creator_MemFree((void **)buffer);
+    }
+}
+
+void CreatorCommonMessaging_GetReceiveBufferStatistics(CreatorCommonMessaging_ReceiveBufferStatistics *statistics)
+{
+    if (statistics)
+    {
+#ifdef CREATOR_STATIC_ALLOC
+        CreatorStaticPoolStatistics poolStatistics;
+        CreatorStaticPool_GetStatistics(&_ReceiveBuffers, &poolStatistics);
+#endif
+        LOCK_BUFFERS();
+        *statistics = _Statistics;
+#ifdef CREATOR_STATIC_ALLOC
+        statistics->Capacity = poolStatistics.BlockCount;
+        statistics->Idle = poolStatistics.BlockCount - poolStatistics.UsedCount;
+#else
+        statistics->Capacity = 0;
+        statistics->Idle = _IdleCount;
+#endif
+        UNLOCK_BUFFERS();
+    }
+}
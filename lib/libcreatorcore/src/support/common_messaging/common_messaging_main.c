@@ -29,6 +29,7 @@
 #include "creator/core/common_messaging_main.h"
 #include "common_messaging_parser.h"
 #include "creator_tls.h"
+#include "data_buffer.h"
 #include "creator/core/creator_threading.h"
 #include "creator/core/creator_memalloc.h"
 #include "creator/core/creator_timer.h"
@@ -60,7 +61,7 @@
 #define CMP_THREAD_SAFE		// Use single thread for tcp + common messaging task
 #ifdef CMP_THREAD_SAFE
 
-static CreatorSemaphore _TCPStackLock = NULL;
+static CreatorMutex _TCPStackLock = NULL;
 
 #endif
 
@@ -76,7 +77,11 @@ static bool _Shutdown;
 #define WAIT_TIMEOUT_SECS					60	// wait timeout in seconds
 
 
+static void BeginSend(CreatorCommonMessaging_ControlBlock *controlBlock, size_t length, ushort responseTimeout);
 static void CreatorCommonMessaging_Task(CreatorThread thread, void *taskParameters);
+static bool EndSend(CreatorCommonMessaging_ControlBlock *controlBlock, bool sendError, ushort responseTimeout);
+static void ReturnReceiveBuffers(CreatorCommonMessaging_ControlBlock *controlBlock);
+static bool SendData(CreatorCommonMessaging_ControlBlock *controlBlock, const char *sendBuffer, size_t sendBufferLength);
 
 #ifndef MICROCHIP_PIC32
 #define CREATOR_TCP_KEEPALIVE_PROBES	3
@@ -89,6 +94,13 @@ static void CreatorCommonMessaging_Task(CreatorThread thread, void *taskParamete
 
 #define  TCP_ENABLE_CLIENT_KEEP_ALIVE   1
 
+// A send to a connection the peer has closed fails (EPIPE) rather than raising SIGPIPE
+#ifdef MSG_NOSIGNAL
+#define CREATOR_SEND_FLAGS	MSG_NOSIGNAL
+#else
+#define CREATOR_SEND_FLAGS	0
+#endif
+
 void CreatorCommonMessaging_SetKeepAliveParameters(SOCKET socketDescriptor)
 {
 #ifndef MICROCHIP_PIC32
@@ -167,6 +179,11 @@ void *CreatorCommonMessaging_CreateConnection(CreatorCommonMessaging_ConnectionI
                 controlBlock->Enabled = false;
                 controlBlock->ResponsePending = false;
                 controlBlock->IsKeepAliveRequired = connectionInformation->IsKeepAliveRequired;
+                controlBlock->IsPacketBegining = true;
+                controlBlock->PacketOffsetLength = 0;       // no partial header left over from the last connection
+                controlBlock->IsContentReadingInProgress = false;
+                controlBlock->LengthOfRemainingContent = 0;
+                controlBlock->IsChunked = false;
 
                 controlBlock->TLSCertificateData = (uchar *)connectionInformation->TLSCertificateData;
                 if (connectionInformation->TLSCertificateData)
@@ -388,19 +405,28 @@ void CreatorCommonMessaging_Initialise(void)
     CreatorCommonMessaging_ControlBlock *controlBlock;
 #ifdef CMP_THREAD_SAFE
     if (!_TCPStackLock)
-        _TCPStackLock = CreatorSemaphore_New(1, 0);
+    {
+        _TCPStackLock = CreatorMutex_New();
+        CreatorMutex_SetName(_TCPStackLock, "TCPStackLock");
+    }
 #endif
     if (!_DNSRequestLock)
+    {
         _DNSRequestLock = CreatorSemaphore_New(1, 0);
+        CreatorSemaphore_SetName(_DNSRequestLock, "DNSRequestLock");
+    }
     if (!_ConnectionLock)
+    {
         _ConnectionLock = CreatorSemaphore_New(1, 0);
+        CreatorSemaphore_SetName(_ConnectionLock, "ConnectionLock");
+    }
 
     for (controlBlockCount = 0; controlBlockCount < CREATOR_MAX_CONNECTIONS; controlBlockCount++)
     {
         controlBlock = &_CommonMessagingControlBlock[controlBlockCount];
         controlBlock->Enabled = false;
         controlBlock->ConnectionHandle = SOCKET_ERROR;
-        controlBlock->ReceivedBuffer = Creator_MemAlloc(CREATOR_MAX_PACKET_LEN);
+        controlBlock->ReceivedBuffer = NULL;        // borrowed from the shared pool while data is being parsed
         controlBlock->IsPacketBegining = true;
         controlBlock->PacketOffsetLength = 0;
         controlBlock->TemporaryDataBuffer = NULL;
@@ -435,124 +461,175 @@ void CreatorCommonMessaging_LockTCP(void)
 {
 #ifdef CMP_THREAD_SAFE
     if (!_TCPStackLock)
-        _TCPStackLock = CreatorSemaphore_New(1, 0);
-    CreatorSemaphore_Wait(_TCPStackLock, 1);
+        _TCPStackLock = CreatorMutex_New();
+    CreatorMutex_Lock(_TCPStackLock);
 #endif
 }
 
-bool CreatorCommonMessaging_SendRequest(void *connectionInformation, char *sendBuffer, uint16 sendBufferLength, ushort responseTimeout)
+static void BeginSend(CreatorCommonMessaging_ControlBlock *controlBlock, size_t length, ushort responseTimeout)
+{
+    COMMON_MESSAGING_LOG(CreatorLogLevel_Debug, "< SEND(%d) len=%d", controlBlock->ConnectionHandle, (int)length);
+    controlBlock->ResponsePending = false;
+    controlBlock->ResponseTimeout = 0;										// Don't set timeout until message has been sent.
+    if (responseTimeout > 0)
+    {
+        controlBlock->ResponsePending = true;
+    }
+}
+
+static bool EndSend(CreatorCommonMessaging_ControlBlock *controlBlock, bool sendError, ushort responseTimeout)
 {
     bool result = false;
-    CreatorCommonMessaging_ControlBlock *controlBlock = (CreatorCommonMessaging_ControlBlock *)connectionInformation;
-    if (controlBlock && controlBlock->Enabled)
+    if (sendError)
     {
-        int sentBytes = 0;
-        bool sendError = false;
-        char *currentBufferLocation = sendBuffer;
-        COMMON_MESSAGING_LOG(CreatorLogLevel_Debug, "< SEND(%d) len=%d", controlBlock->ConnectionHandle, sendBufferLength);
         controlBlock->ResponsePending = false;
-        controlBlock->ResponseTimeout = 0;										// Don't set timeout until message has been sent.
-        if (responseTimeout > 0)
+        Creator_Log(CreatorLogLevel_Error, "TCP send failed - dest port=%d", controlBlock->ConnectionDestinationPort);
+    }
+    else
+    {
+        if (controlBlock->ResponsePending)
         {
-            controlBlock->ResponsePending = true;
+            controlBlock->SendStartTime = CreatorTimer_GetTickCount();
+            controlBlock->ResponseTimeout = responseTimeout * CreatorTimer_GetTicksPerSecond();
         }
-        if (controlBlock->TransportType == CREATOR_TLS)
+        COMMON_MESSAGING_LOG(CreatorLogLevel_Debug, "\tTCP send done - dest port=%d", controlBlock->ConnectionDestinationPort);
+        result = true;
+    }
+    return result;
+}
+
+/* Write all of sendBuffer to the connection (TLS or plain TCP). Returns false on error or timeout. */
+static bool SendData(CreatorCommonMessaging_ControlBlock *controlBlock, const char *sendBuffer, size_t sendBufferLength)
+{
+    int sentBytes = 0;
+    bool sendError = false;
+    const char *currentBufferLocation = sendBuffer;
+    if (controlBlock->TransportType == CREATOR_TLS)
+    {
+        while (sendBufferLength > 0)
         {
-            while (sendBufferLength > 0)
+            CreatorTLSError error;
+            int timeOutPeriod = CreatorTimer_GetTicksPerSecond() * WAIT_TIMEOUT_SECS;
+            uint startTick = CreatorTimer_GetTickCount();
+            while (1)
             {
-                CreatorTLSError error;
-                int timeOutPeriod = CreatorTimer_GetTicksPerSecond() * WAIT_TIMEOUT_SECS;
-                uint startTick = CreatorTimer_GetTickCount();
-                while (1)
+                CreatorCommonMessaging_LockTCP();
+                sentBytes = CreatorTLS_Write(controlBlock, (void *)currentBufferLocation, sendBufferLength);
+                CreatorCommonMessaging_UnLockTCP();
+                if (sentBytes < 0)
                 {
-                    CreatorCommonMessaging_LockTCP();
-                    sentBytes = CreatorTLS_Write(controlBlock, currentBufferLocation, sendBufferLength);
-                    CreatorCommonMessaging_UnLockTCP();
-                    if (sentBytes < 0)
+                    error = CreatorTLS_GetError(controlBlock);
+                    if (error == CreatorTLSError_RecieveBufferEmpty || error == CreatorTLSError_TransmitBufferFull)
                     {
-                        error = CreatorTLS_GetError(controlBlock);
-                        if (error == CreatorTLSError_RecieveBufferEmpty || error == CreatorTLSError_TransmitBufferFull)
+                        if ((CreatorTimer_GetTickCount() - startTick) >= timeOutPeriod)
                         {
-                            if ((CreatorTimer_GetTickCount() - startTick) >= timeOutPeriod)
-                            {
-                                sendError = true;
-                                break;
-                            }
-                            CreatorThread_SleepMilliseconds(NULL, 5);
-                            continue;
+                            sendError = true;
+                            break;
                         }
-                        sendError = true;
-                        break;
-                    }
-                    else if (sentBytes == 0)
-                    {
-                        sendError = true;
+                        CreatorThread_SleepMilliseconds(NULL, 5);
+                        continue;
                     }
+                    sendError = true;
                     break;
                 }
-                if (sendError)
-                    break;
-                currentBufferLocation += sentBytes;
-                sendBufferLength -= sentBytes;
+                else if (sentBytes == 0)
+                {
+                    sendError = true;
+                }
+                break;
             }
+            if (sendError)
+                break;
+            currentBufferLocation += sentBytes;
+            sendBufferLength -= sentBytes;
         }
-        else
+    }
+    else
+    {
+        SOCKET socket = controlBlock->ConnectionHandle;
+        int timeOutPeriod = CreatorTimer_GetTicksPerSecond() * WAIT_TIMEOUT_SECS;
+        uint startTick = CreatorTimer_GetTickCount();
+        while (sendBufferLength > 0)
         {
-            SOCKET socket = controlBlock->ConnectionHandle;
-            int timeOutPeriod = CreatorTimer_GetTicksPerSecond() * WAIT_TIMEOUT_SECS;
-            uint startTick = CreatorTimer_GetTickCount();
-            while (sendBufferLength > 0)
+            CreatorCommonMessaging_LockTCP();
+            errno = 0;
+            sentBytes = send(socket, currentBufferLocation, sendBufferLength, CREATOR_SEND_FLAGS);
+            CreatorCommonMessaging_UnLockTCP();
+            int lastError = errno;
+            if (sentBytes == SOCKET_ERROR)
             {
-                CreatorCommonMessaging_LockTCP();
-                errno = 0;
-                sentBytes = send(socket, currentBufferLocation, sendBufferLength, 0);
-                CreatorCommonMessaging_UnLockTCP();
-                int lastError = errno;
-                if (sentBytes == SOCKET_ERROR)
+                sentBytes = 0;
+                if (lastError == EWOULDBLOCK)
                 {
-                    if (lastError == EWOULDBLOCK)
+                    if ((CreatorTimer_GetTickCount() - startTick) >= timeOutPeriod)
                     {
-                        if ((CreatorTimer_GetTickCount() - startTick) >= timeOutPeriod)
-                        {
-                            sendError = true;
-                        }
-                        else
-                        {
-                            CreatorThread_SleepMilliseconds(NULL, 5);
-                            sentBytes = 0;
-                        }
-                    }
-                    else if (lastError == ENOTCONN)
-                        sendError = true;
-                    else if (lastError == ECONNRESET)
-                        sendError = true;
-                    else if (lastError == EBADF)
                         sendError = true;
+                    }
+                    else
+                    {
+                        CreatorThread_SleepMilliseconds(NULL, 5);
+                    }
+                }
+                else if (lastError != EINTR)
+                {
+                    // ENOTCONN, ECONNRESET, EPIPE (closed by the peer), EBADF... - nothing more will go out
+                    sendError = true;
                 }
-                else
-                    startTick = CreatorTimer_GetTickCount();
-
-                if (sendError)
-                    break;
-                currentBufferLocation += sentBytes;
-                sendBufferLength -= sentBytes;
             }
+            else
+                startTick = CreatorTimer_GetTickCount();
+
+            if (sendError)
+                break;
+            currentBufferLocation += sentBytes;
+            sendBufferLength -= sentBytes;
         }
-        if (sendError)
-        {
-            controlBlock->ResponsePending = false;
-            Creator_Log(CreatorLogLevel_Error, "TCP send failed - dest port=%d", controlBlock->ConnectionDestinationPort);
-        }
-        else
+    }
+    return !sendError;
+}
+
+bool CreatorCommonMessaging_SendDataBuffer(void *connectionInformation, DataBuffer *sendBuffer, ushort responseTimeout)
+{
+    bool result = false;
+    CreatorCommonMessaging_ControlBlock *controlBlock = (CreatorCommonMessaging_ControlBlock *)connectionInformation;
+    if (controlBlock && controlBlock->Enabled && DataBuffer_GetDataSize(sendBuffer) > 0)
+    {
+        bool sendError = false;
+        DataBufferIterator iterator;
+        const void *segment;
+        size_t segmentLength;
+        BeginSend(controlBlock, DataBuffer_GetDataSize(sendBuffer), responseTimeout);
+        // Send each chunk in place - the buffer is never flattened into one contiguous block
+        DataBuffer_GetIterator(sendBuffer, &iterator);
+        while (!sendError && DataBufferIterator_Next(&iterator, &segment, &segmentLength))
         {
-            if (controlBlock->ResponsePending)
-            {
-                controlBlock->SendStartTime = CreatorTimer_GetTickCount();
-                controlBlock->ResponseTimeout = responseTimeout * CreatorTimer_GetTicksPerSecond();
-            }
-            COMMON_MESSAGING_LOG(CreatorLogLevel_Debug, "\tTCP send done - dest port=%d", controlBlock->ConnectionDestinationPort);
-            result = true;
+            sendError = !SendData(controlBlock, (const char *)segment, segmentLength);
         }
+        result = EndSend(controlBlock, sendError, responseTimeout);
+    }
+    return result;
+}
+
+void CreatorCommonMessaging_ExpectResponse(void *connectionInformation, ushort responseTimeout)
+{
+    CreatorCommonMessaging_ControlBlock *controlBlock = (CreatorCommonMessaging_ControlBlock *)connectionInformation;
+    if (controlBlock && controlBlock->Enabled && responseTimeout > 0)
+    {
+        controlBlock->SendStartTime = CreatorTimer_GetTickCount();
+        controlBlock->ResponseTimeout = responseTimeout * CreatorTimer_GetTicksPerSecond();
+        controlBlock->ResponsePending = true;
+    }
+}
+
+bool CreatorCommonMessaging_SendRequest(void *connectionInformation, char *sendBuffer, uint16 sendBufferLength, ushort responseTimeout)
+{
+    bool result = false;
+    CreatorCommonMessaging_ControlBlock *controlBlock = (CreatorCommonMessaging_ControlBlock *)connectionInformation;
+    if (controlBlock && controlBlock->Enabled)
+    {
+        BeginSend(controlBlock, sendBufferLength, responseTimeout);
+        bool sendError = !SendData(controlBlock, sendBuffer, sendBufferLength);
+        result = EndSend(controlBlock, sendError, responseTimeout);
     }
     return result;
 }
@@ -562,7 +639,13 @@ void CreatorCommonMessaging_Shutdown(void)
     if (!_IsCommonMessagingTaskCreated)
         return;
 
+    // Let the processing thread finish its pass (it may be using a control block's buffers) before tearing them down
     _Shutdown = true;
+    if (_ProcessingThread)
+    {
+        CreatorThread_Join(_ProcessingThread);
+        CreatorThread_Free(&_ProcessingThread);
+    }
 
     int controlBlockCount;
     CreatorCommonMessaging_ControlBlock *controlBlock;
@@ -572,16 +655,13 @@ void CreatorCommonMessaging_Shutdown(void)
         controlBlock->Enabled = false;
         if (controlBlock->ConnectionHandle != SOCKET_ERROR)
             CreatorCommonMessaging_DeleteConnection(controlBlock);
-        if (controlBlock->ReceivedBuffer)
-            Creator_MemFree((void **)&controlBlock->ReceivedBuffer);
+        CreatorCommonMessaging_FreeReceiveBuffer(&controlBlock->ReceivedBuffer);
         controlBlock->IsPacketBegining = true;
         controlBlock->PacketOffsetLength = 0;
         if (controlBlock->TemporaryDataBuffer)
             Creator_MemFree((void **)&controlBlock->TemporaryDataBuffer);
         controlBlock->TemporaryDataBufferLength = 0;
     }
-    if (_ProcessingThread)
-        CreatorThread_Free(&_ProcessingThread);
     if (_DNSRequestLock)
         CreatorSemaphore_Free(&_DNSRequestLock);
     if (_ConnectionLock)
@@ -589,7 +669,7 @@ void CreatorCommonMessaging_Shutdown(void)
 
 #ifdef CMP_THREAD_SAFE
     if (_TCPStackLock)
-        CreatorSemaphore_Free(&_TCPStackLock);
+        CreatorMutex_Free(&_TCPStackLock);
 #endif
 
     CreatorTLS_Shutdown();
@@ -604,11 +684,13 @@ void CreatorCommonMessaging_Receive(CreatorCommonMessaging_ControlBlock *control
     ushort maximumLengthToRead;
     char *receivedBuffer;
     bool connectionLost = false;
+    bool messageError = false;
 
     CreatorCommonMessaging_LockTCP();
     if (!controlBlock->Enabled || controlBlock->ConnectionHandle == SOCKET_ERROR)
     {
         CreatorCommonMessaging_UnLockTCP();
+        ReturnReceiveBuffers(controlBlock);
         return;
     }
     if (controlBlock->SSLSession == NULL && controlBlock->TransportType == CREATOR_TLS)
@@ -623,6 +705,14 @@ void CreatorCommonMessaging_Receive(CreatorCommonMessaging_ControlBlock *control
     }
     else
     {
+        if (!controlBlock->ReceivedBuffer)
+            controlBlock->ReceivedBuffer = CreatorCommonMessaging_NewReceiveBuffer();
+        if (!controlBlock->ReceivedBuffer)
+        {
+            // Leave the data in the socket until a buffer is free
+            CreatorCommonMessaging_UnLockTCP();
+            return;
+        }
         maximumLengthToRead = CREATOR_MAX_PACKET_LEN - controlBlock->PacketOffsetLength;
         receivedBuffer = controlBlock->ReceivedBuffer;
     }
@@ -660,12 +750,10 @@ void CreatorCommonMessaging_Receive(CreatorCommonMessaging_ControlBlock *control
         }
         else if (receivedDataLength == SOCKET_ERROR)
         {
-            if (lastError == EWOULDBLOCK)
+            if ((lastError == EWOULDBLOCK) || (lastError == EINTR))
                 receivedDataLength = 0;
-            else if (lastError == ENOTCONN)
-                connectionLost = true;
-            else if (lastError == EBADF)
-                connectionLost = true;
+            else
+                connectionLost = true;      // ENOTCONN, ECONNRESET, EBADF...
         }
 
     }
@@ -676,26 +764,36 @@ void CreatorCommonMessaging_Receive(CreatorCommonMessaging_ControlBlock *control
         // BEWARE: Must unlock TCP mutex to avoid deadlock caused by SIP response messages sent within callback!
         // TODO: protect against concurrent connection recovery if an asynchronous send fails...
         receivedDataLength += controlBlock->PacketOffsetLength;
-        if (controlBlock->LengthOfRemainingContent > 0 && controlBlock->IsContentReadingInProgress)
+        receivedBuffer[receivedDataLength] = '\0';         // buffers have a spare byte, the header parser uses string functions
+        if (controlBlock->IsChunked && controlBlock->IsContentReadingInProgress)
+        {
+            COMMON_MESSAGING_LOG(CreatorLogLevel_Debug, "> RECV(%d) CHUNK len=%d", controlBlock->ConnectionHandle, receivedDataLength);
+            int32 consumed = CreatorCommonMessaging_HandleChunkedContent(controlBlock, receivedBuffer, &receivedDataLength);
+            if (consumed < 0)
+                messageError = true;
+            else if (receivedDataLength > 0)
+                messageError = (CreatorCommonMessaging_ParseMessage(controlBlock, receivedBuffer + consumed, receivedDataLength) < 0);
+        }
+        else if (controlBlock->LengthOfRemainingContent > 0 && controlBlock->IsContentReadingInProgress)
         {
             COMMON_MESSAGING_LOG(CreatorLogLevel_Debug, "> RECV(%d) CONT len=%d", controlBlock->ConnectionHandle,
                     receivedDataLength - controlBlock->PacketOffsetLength);
             maximumLengthToRead = CreatorCommonMessaging_HandleContent(controlBlock, receivedBuffer, &receivedDataLength);
             if (receivedDataLength > 0)
             {
-                CreatorCommonMessaging_ParseMessage(controlBlock, receivedBuffer + maximumLengthToRead, receivedDataLength);
+                messageError = (CreatorCommonMessaging_ParseMessage(controlBlock, receivedBuffer + maximumLengthToRead, receivedDataLength) < 0);
             }
         }
         else
         {
             COMMON_MESSAGING_LOG(CreatorLogLevel_Debug, "> RECV(%d) len=%d", controlBlock->ConnectionHandle, receivedDataLength);
-            CreatorCommonMessaging_ParseMessage(controlBlock, receivedBuffer, receivedDataLength);
+            messageError = (CreatorCommonMessaging_ParseMessage(controlBlock, receivedBuffer, receivedDataLength) < 0);
         }
-        if (controlBlock->PacketOffsetLength == 0)
+        if (messageError)
         {
-            if (controlBlock->TemporaryDataBuffer != NULL)
-                Creator_MemFree((void **)&controlBlock->TemporaryDataBuffer);
-            controlBlock->TemporaryDataBufferLength = 0;
+            // The rest of the stream can't be framed, so treat it like a lost connection
+            Creator_Log(CreatorLogLevel_Error, "TCP failed - malformed message dest port=%d", controlBlock->ConnectionDestinationPort);
+            connectionLost = true;
         }
     }
 
@@ -713,6 +811,8 @@ void CreatorCommonMessaging_Receive(CreatorCommonMessaging_ControlBlock *control
     {
         COMMON_MESSAGING_LOG(CreatorLogLevel_Info, "TCP(%d) - connection lost dest port=%d", controlBlock->ConnectionHandle,
                 controlBlock->ConnectionDestinationPort);
+        // A partial header of a lost connection is of no use (reset before the callback can reconnect)
+        controlBlock->PacketOffsetLength = 0;
         // Disable receive handling for the connection (use mutex to prevent recovery collision)
         if (controlBlock->Enabled)
         {
@@ -727,6 +827,21 @@ void CreatorCommonMessaging_Receive(CreatorCommonMessaging_ControlBlock *control
                 controlBlock->ProtocolCallBack(CreatorCommonMessaging_CallbackEventType_NetworkFailure, NULL, NULL, 0, controlBlock->CallbackContext);
         }
     }
+    ReturnReceiveBuffers(controlBlock);
+}
+
+static void ReturnReceiveBuffers(CreatorCommonMessaging_ControlBlock *controlBlock)
+{
+    if (!controlBlock->Enabled || controlBlock->ConnectionHandle == SOCKET_ERROR)
+        controlBlock->PacketOffsetLength = 0;
+    if ((controlBlock->PacketOffsetLength == 0) && controlBlock->TemporaryDataBuffer)
+    {
+        Creator_MemFree((void **)&controlBlock->TemporaryDataBuffer);
+        controlBlock->TemporaryDataBufferLength = 0;
+    }
+    // Keep the receive buffer only while it holds the start of an incomplete header
+    if ((controlBlock->PacketOffsetLength == 0) || controlBlock->TemporaryDataBuffer)
+        CreatorCommonMessaging_FreeReceiveBuffer(&controlBlock->ReceivedBuffer);
 }
 
 static void CreatorCommonMessaging_Task(CreatorThread thread, void * taskParameters)
@@ -756,7 +871,7 @@ void CreatorCommonMessaging_UnLockTCP(void)
 {
 #ifdef CMP_THREAD_SAFE
     if (!_TCPStackLock)
-        _TCPStackLock = CreatorSemaphore_New(1, 0);
-    CreatorSemaphore_Release(_TCPStackLock, 1);
+        _TCPStackLock = CreatorMutex_New();
+    CreatorMutex_Unlock(_TCPStackLock);
 #endif
 }
@@ -28,6 +28,21 @@
 #include "creator/core/common_messaging_main.h"
 #include "common_messaging_parser.h"
 
+typedef enum
+{
+    ChunkState_SizeStart = 0,       // expecting the first hex digit of a chunk size
+    ChunkState_Size,
+    ChunkState_Extension,           // skipping chunk extensions up to the end of the size line
+    ChunkState_SizeLF,
+    ChunkState_Data,
+    ChunkState_DataCR,
+    ChunkState_DataLF,
+    ChunkState_Trailer              // last chunk read, the trailer (if any) is parsed as headers
+} ChunkState;
+
+static int HexDigitValue(char c);
+static void KeepIncompleteData(CreatorCommonMessaging_ControlBlock *controlBlock, char *data, int length);
+
 int32 CreatorCommonMessaging_HandleContent(CreatorCommonMessaging_ControlBlock *controlBlock, char *contentBuffer, int *length)
 {
     ushort *remaingContentLength = &(controlBlock->LengthOfRemainingContent);
@@ -49,6 +64,106 @@ int32 CreatorCommonMessaging_HandleContent(CreatorCommonMessaging_ControlBlock *
     return contentLength;
 }
 
+int32 CreatorCommonMessaging_HandleChunkedContent(CreatorCommonMessaging_ControlBlock *controlBlock, char *contentBuffer, int *length)
+{
+    // Decoded a byte at a time so a chunk boundary can fall anywhere in a read, without keeping partial size lines.
+    // Chunk data is passed on as it arrives, in as few callbacks as the reads allow.
+    char *position = contentBuffer;
+    char *end = contentBuffer + *length;
+    while (position < end && controlBlock->ChunkState != ChunkState_Trailer)
+    {
+        bool sizeComplete = false;
+        char c = *position;
+        switch (controlBlock->ChunkState)
+        {
+            case ChunkState_Data:
+            {
+                int dataLength = end - position;
+                if ((uint32)dataLength > controlBlock->LengthOfRemainingChunk)
+                    dataLength = (int)controlBlock->LengthOfRemainingChunk;
+                if (controlBlock->ProtocolCallBack)
+                    controlBlock->ProtocolCallBack(CreatorCommonMessaging_CallbackEventType_Data, NULL, position, dataLength, controlBlock->CallbackContext);
+                position += dataLength;
+                controlBlock->LengthOfRemainingChunk -= dataLength;
+                if (controlBlock->LengthOfRemainingChunk == 0)
+                    controlBlock->ChunkState = ChunkState_DataCR;
+                continue;
+            }
+            case ChunkState_SizeStart:
+            case ChunkState_Size:
+            {
+                int digit = HexDigitValue(c);
+                if (digit >= 0)
+                {
+                    if (controlBlock->LengthOfRemainingChunk > (0xFFFFFFFFU >> 4))
+                        return -1;
+                    controlBlock->LengthOfRemainingChunk = (controlBlock->LengthOfRemainingChunk << 4) | digit;
+                    controlBlock->ChunkState = ChunkState_Size;
+                }
+                else if (controlBlock->ChunkState == ChunkState_SizeStart)
+                    return -1;
+                else if (c == '\r')
+                    controlBlock->ChunkState = ChunkState_SizeLF;
+                else if (c == '\n')
+                    sizeComplete = true;
+                else if (c == ';' || c == ' ' || c == '\t')
+                    controlBlock->ChunkState = ChunkState_Extension;
+                else
+                    return -1;
+                break;
+            }
+            case ChunkState_Extension:
+            {
+                if (c == '\n')
+                    sizeComplete = true;
+                break;
+            }
+            case ChunkState_SizeLF:
+            {
+                if (c != '\n')
+                    return -1;
+                sizeComplete = true;
+                break;
+            }
+            case ChunkState_DataCR:
+            {
+                if (c == '\r')
+                    controlBlock->ChunkState = ChunkState_DataLF;
+                else if (c == '\n')
+                    controlBlock->ChunkState = ChunkState_SizeStart;
+                else
+                    return -1;
+                break;
+            }
+            case ChunkState_DataLF:
+            {
+                if (c != '\n')
+                    return -1;
+                controlBlock->ChunkState = ChunkState_SizeStart;
+                break;
+            }
+            default:
+                return -1;
+        }
+        position++;
+        if (sizeComplete)
+        {
+            if (controlBlock->LengthOfRemainingChunk > 0)
+            {
+                controlBlock->ChunkState = ChunkState_Data;
+            }
+            else
+            {
+                // Last chunk - hand back to the header parser for the trailer, whose blank line finishes the response
+                controlBlock->ChunkState = ChunkState_Trailer;
+                controlBlock->IsContentReadingInProgress = false;
+            }
+        }
+    }
+    *length -= (position - contentBuffer);
+    return (position - contentBuffer);
+}
+
 int CreatorCommonMessaging_ParseMessage(CreatorCommonMessaging_ControlBlock * controlBlock, char *dataBuffer, int bufferLength)
 {
     int headerValueLength;
@@ -57,6 +172,7 @@ int CreatorCommonMessaging_ParseMessage(CreatorCommonMessaging_ControlBlock * co
     char *valueEnd;
     char *keyEnd;
     CreatorCommonMessaging_ProtocolCallBack callBack;
+    bool inTrailer;
 
     callBack = controlBlock->ProtocolCallBack;
     lineBuffer = dataBuffer;
@@ -76,11 +192,17 @@ int CreatorCommonMessaging_ParseMessage(CreatorCommonMessaging_ControlBlock * co
                 if (searchLength == 0)
                     controlBlock->PacketOffsetLength = 0;
                 else
-                    controlBlock->PacketOffsetLength = bufferLength;
+                    KeepIncompleteData(controlBlock, dataBuffer, bufferLength);
                 return 0;
             }
             lineLength = lineBuffer - lineStart - 1;
-            if ((lineLength == 0) && *lineStart == '\r')
+            if (lineLength < 0)
+            {
+                // Bare LF - skip it, there is no CR to terminate the line on
+                searchLength -= 1;
+                lineStart += 1;
+            }
+            else if ((lineLength == 0) && *lineStart == '\r')
             {
                 searchLength -= 2;
                 lineStart += 2;
@@ -109,23 +231,36 @@ int CreatorCommonMessaging_ParseMessage(CreatorCommonMessaging_ControlBlock * co
     }
 
     controlBlock->PacketOffsetLength = 0;
+    inTrailer = controlBlock->IsChunked && (controlBlock->ChunkState == ChunkState_Trailer);
 
     while (lineBuffer && bufferLength > 0)
     {
         if (*lineBuffer == '\r' && *(lineBuffer + 1) == '\n')
         {
             // TODO - skip header event if isContentReadingInProgress == true?
-            if (callBack)
+            if (callBack && !inTrailer)
                 callBack(CreatorCommonMessaging_CallbackEventType_HeaderEnd, NULL, NULL, 0, controlBlock->CallbackContext);
             bufferLength -= 2;
             lineBuffer += 2;
-            if (controlBlock->LengthOfRemainingContent > 0)
+            if (controlBlock->IsChunked && !inTrailer)
+            {
+                // Transfer-Encoding overrides any Content-Length
+                controlBlock->LengthOfRemainingContent = 0;
+                controlBlock->IsContentReadingInProgress = true;
+                int32 consumed = CreatorCommonMessaging_HandleChunkedContent(controlBlock, lineBuffer, &bufferLength);
+                if (consumed < 0)
+                    return -1;
+                lineBuffer += consumed;
+                inTrailer = (controlBlock->ChunkState == ChunkState_Trailer);
+            }
+            else if (controlBlock->LengthOfRemainingContent > 0)
             {
                 controlBlock->IsContentReadingInProgress = true;
                 lineBuffer += CreatorCommonMessaging_HandleContent(controlBlock, lineBuffer, &bufferLength);
             }
             else
             {
+                controlBlock->IsChunked = false;
                 controlBlock->ResponsePending = false;
                 controlBlock->IsPacketBegining = true;
                 if (callBack)
@@ -159,28 +294,67 @@ int CreatorCommonMessaging_ParseMessage(CreatorCommonMessaging_ControlBlock * co
         headerValueLength = valueEnd - keyEnd;
         if (callBack)
             callBack(CreatorCommonMessaging_CallbackEventType_Header, lineBuffer, keyEnd, headerValueLength, controlBlock->CallbackContext);
-        if (((*lineBuffer == 'C' || *lineBuffer == 'c') && strcasecmp(lineBuffer, "Content-Length") == 0))
+        if (inTrailer)
+        {
+            // framing headers are not allowed in a trailer
+        }
+        else if (((*lineBuffer == 'C' || *lineBuffer == 'c') && strcasecmp(lineBuffer, "Content-Length") == 0))
         {
             controlBlock->LengthOfRemainingContent = (int)strtol(keyEnd, NULL, 10);
         }
+        else if (((*lineBuffer == 'T' || *lineBuffer == 't') && strcasecmp(lineBuffer, "Transfer-Encoding") == 0))
+        {
+            // When present, chunked is always the last coding applied
+            controlBlock->IsChunked = (headerValueLength >= 7) && (strcasecmp(keyEnd + headerValueLength - 7, "chunked") == 0);
+            controlBlock->ChunkState = ChunkState_SizeStart;
+            controlBlock->LengthOfRemainingChunk = 0;
+        }
         bufferLength -= lineLength;
         lineBuffer += lineLength;
     }
     return 0;
     incomplete_header:
     //Incomplete header
-    controlBlock->PacketOffsetLength = bufferLength;
-    char *incompleteDataBuffer = (char *)Creator_MemAlloc(controlBlock->TemporaryDataBufferLength + CREATOR_MAX_PACKET_LEN);
-    if (incompleteDataBuffer)
-    {
-        memcpy(incompleteDataBuffer, lineBuffer, controlBlock->PacketOffsetLength);
-        //Free previously allocated temporary buffer
-        if (controlBlock->TemporaryDataBuffer)
-            Creator_MemFree((void **)&controlBlock->TemporaryDataBuffer);
-        controlBlock->TemporaryDataBufferLength += CREATOR_MAX_PACKET_LEN;
-        controlBlock->TemporaryDataBuffer = incompleteDataBuffer;
-    }
-
+    KeepIncompleteData(controlBlock, lineBuffer, bufferLength);
     return 0;
 
 }
+
+static int HexDigitValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+static void KeepIncompleteData(CreatorCommonMessaging_ControlBlock *controlBlock, char *data, int length)
+{
+    // Move the partial line to the front of the buffer being read into, so the next read completes it. Only a header that
+    // fills the whole buffer needs a larger temporary one.
+    char *buffer = controlBlock->TemporaryDataBuffer ? controlBlock->TemporaryDataBuffer : controlBlock->ReceivedBuffer;
+    int capacity = controlBlock->TemporaryDataBuffer ? controlBlock->TemporaryDataBufferLength : CREATOR_MAX_PACKET_LEN;
+    controlBlock->PacketOffsetLength = length;
+    if (length < capacity)
+    {
+        if (data != buffer)
+            memmove(buffer, data, length);
+    }
+    else
+    {
+        // If this fails the next read has no room, which ends the connection
+        char *incompleteDataBuffer = (char *)Creator_MemAlloc(capacity + CREATOR_MAX_PACKET_LEN + 1);
+        if (incompleteDataBuffer)
+        {
+            memcpy(incompleteDataBuffer, data, length);
+            //Free previously allocated temporary buffer
+            if (controlBlock->TemporaryDataBuffer)
+                Creator_MemFree((void **)&controlBlock->TemporaryDataBuffer);
+            controlBlock->TemporaryDataBufferLength = capacity + CREATOR_MAX_PACKET_LEN;
+            controlBlock->TemporaryDataBuffer = incompleteDataBuffer;
+        }
+    }
+}
@@ -20,6 +20,7 @@
  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***********************************************************************************************************************/
 
+
 #include <stddef.h>
 #include <string.h>
 
@@ -27,25 +28,50 @@
 
 #include "creator/core/creator_memalloc.h"
 #include "creator/core/creator_debug.h"
+#include "creator/core/creator_static_alloc.h"
+
+struct DataBufferChunkImpl
+{
+    struct DataBufferChunkImpl *pNext;
+    size_t dataSize;
+    char data[];
+};
+
+#define CHUNK_DATA_SIZE (DATABUFFER_CHUNK_SIZE - offsetof(DataBufferChunk, data))
 
 struct DataBufferImpl
 {
-    char *pBuffer;
+    DataBufferChunk *pHead;
+    DataBufferChunk *pTail;
     size_t dataSize;
-    size_t bufferSize;
     bool bCorrupt;
 };
 
-static void DataBuffer_Resize(DataBuffer *pBuffer, size_t newMinSize);
+#ifdef CREATOR_STATIC_ALLOC
+// Messages larger than the pools allow spill over onto the heap
+CREATOR_STATIC_POOL(_Buffers, sizeof(DataBuffer), CREATOR_STATIC_DATABUFFERS);
+CREATOR_STATIC_POOL(_Chunks, DATABUFFER_CHUNK_SIZE, CREATOR_STATIC_DATABUFFER_CHUNKS);
+#define ALLOC_BLOCK(pool, size)     DataBuffer_AllocBlock(&pool, size)
+#define FREE_BLOCK(pool, block)     DataBuffer_FreeBlock(&pool, (void **)block)
+#else
+#define ALLOC_BLOCK(pool, size)     Creator_MemAlloc(size)
+#define FREE_BLOCK(pool, block)     Creator_MemFree((void **)block)
+#endif
+
+static void DataBuffer_FreeChunks(DataBuffer *pBuffer);
+#ifdef CREATOR_STATIC_ALLOC
+static void *DataBuffer_AllocBlock(CreatorStaticPool *pPool, size_t size);
+static void DataBuffer_FreeBlock(CreatorStaticPool *pPool, void **ppBlock);
+#endif
 
 DataBuffer *DataBuffer_New()
 {
-    DataBuffer *pResult = Creator_MemAlloc(sizeof(DataBuffer));
+    DataBuffer *pResult = ALLOC_BLOCK(_Buffers, sizeof(DataBuffer));
     if (pResult)
     {
-        pResult->pBuffer = NULL;
+        pResult->pHead = NULL;
+        pResult->pTail = NULL;
         pResult->dataSize = 0;
-        pResult->bufferSize = 0;
         pResult->bCorrupt = false;
     }
     return pResult;
@@ -53,21 +79,40 @@ DataBuffer *DataBuffer_New()
 
 bool DataBuffer_Write(DataBuffer *pBuffer, const void *pData, size_t dataSize)
 {
-    if (!pBuffer)
+    if (!pBuffer || pBuffer->bCorrupt)
     {
         return false;
     }
-    if (pBuffer->dataSize + dataSize > pBuffer->bufferSize)
-    {
-        DataBuffer_Resize(pBuffer, pBuffer->dataSize + dataSize);
-    }
-    if (!pBuffer->bCorrupt)
+    const char *pSource = (const char *)pData;
+    while (dataSize > 0)
     {
-        memcpy(pBuffer->pBuffer + pBuffer->dataSize, pData, dataSize);
-        pBuffer->dataSize += dataSize;
-        return true;
+        DataBufferChunk *pChunk = pBuffer->pTail;
+        if (!pChunk || pChunk->dataSize == CHUNK_DATA_SIZE)
+        {
+            pChunk = ALLOC_BLOCK(_Chunks, DATABUFFER_CHUNK_SIZE);
+            if (!pChunk)
+            {
+                pBuffer->bCorrupt = true;
+                return false;
+            }
+            pChunk->pNext = NULL;
+            pChunk->dataSize = 0;
+            if (pBuffer->pTail)
+                pBuffer->pTail->pNext = pChunk;
+            else
+                pBuffer->pHead = pChunk;
+            pBuffer->pTail = pChunk;
+        }
+        size_t copySize = CHUNK_DATA_SIZE - pChunk->dataSize;
+        if (copySize > dataSize)
+            copySize = dataSize;
+        memcpy(pChunk->data + pChunk->dataSize, pSource, copySize);
+        pChunk->dataSize += copySize;
+        pBuffer->dataSize += copySize;
+        pSource += copySize;
+        dataSize -= copySize;
     }
-    return false;
+    return true;
 }
 
 bool DataBuffer_WriteCString(DataBuffer *pBuffer, const char *szData)
@@ -77,34 +122,32 @@ bool DataBuffer_WriteCString(DataBuffer *pBuffer, const char *szData)
         return false;
     }
     size_t dataSize = (szData) ? strlen(szData) : 0;
-    //FIXME optimize this impl
     return DataBuffer_Write(pBuffer, szData, dataSize);
 }
 
 void *DataBuffer_GetBufferData(DataBuffer *pBuffer, bool bTakeOwnership)
 {
-    if (!pBuffer || pBuffer->bCorrupt)
+    if (!pBuffer || pBuffer->bCorrupt || pBuffer->dataSize == 0)
     {
         return NULL;
     }
-    if (bTakeOwnership)
-    {
-        void *pResult = pBuffer->pBuffer;
-        pBuffer->pBuffer = NULL;
-        pBuffer->bufferSize = 0;
-        pBuffer->dataSize = 0;
-        return pResult;
-    }
-    else if (pBuffer->dataSize > 0)
+    char *pResult = Creator_MemAlloc(pBuffer->dataSize);
+    if (pResult)
     {
-        void *pResult = Creator_MemAlloc(pBuffer->dataSize);
-        if (pResult)
+        size_t offset = 0;
+        DataBufferChunk *pChunk;
+        for (pChunk = pBuffer->pHead; pChunk; pChunk = pChunk->pNext)
+        {
+            memcpy(pResult + offset, pChunk->data, pChunk->dataSize);
+            offset += pChunk->dataSize;
+        }
+        Creator_Assert(offset == pBuffer->dataSize, "DataBuffer size does not match its chunks");
+        if (bTakeOwnership)
         {
-            memcpy(pResult, pBuffer->pBuffer, pBuffer->dataSize);
+            DataBuffer_FreeChunks(pBuffer);
         }
-        return pResult;
     }
-    return NULL;
+    return pResult;
 }
 
 size_t DataBuffer_GetDataSize(DataBuffer *pBuffer)
@@ -116,46 +159,69 @@ size_t DataBuffer_GetDataSize(DataBuffer *pBuffer)
     return pBuffer->dataSize;
 }
 
-void DataBuffer_Free(DataBuffer **self)
+void DataBuffer_GetIterator(DataBuffer *pBuffer, DataBufferIterator *pIterator)
 {
-    if (self && *self)
+    if (pIterator)
     {
-        DataBuffer *buffer = *self;
-        if (buffer->pBuffer)
-        {
-            Creator_MemFree((void **)&buffer->pBuffer);
-        }
-        Creator_MemFree((void **)self);
+        pIterator->pChunk = (pBuffer && !pBuffer->bCorrupt) ? pBuffer->pHead : NULL;
     }
 }
 
-#define BUFFER_MINIMUM_SIZE (2048)
-#define MAX(a,b) ((a < b)?b:a)
+bool DataBufferIterator_Next(DataBufferIterator *pIterator, const void **ppData, size_t *pDataSize)
+{
+    if (!pIterator || !pIterator->pChunk)
+    {
+        return false;
+    }
+    *ppData = pIterator->pChunk->data;
+    *pDataSize = pIterator->pChunk->dataSize;
+    pIterator->pChunk = pIterator->pChunk->pNext;
+    return true;
+}
 
-static void DataBuffer_Resize(DataBuffer *pBuffer, size_t newMinSize)
+void DataBuffer_Free(DataBuffer **self)
 {
-    if (pBuffer->bCorrupt)
+    if (self && *self)
     {
-        return;
+        DataBuffer_FreeChunks(*self);
+        FREE_BLOCK(_Buffers, self);
     }
-    Creator_Assert(pBuffer->bufferSize < newMinSize, "Calling DataBuffer_Resize unnecessarily");
-    size_t newSize = MAX(BUFFER_MINIMUM_SIZE, MAX(newMinSize, pBuffer->bufferSize * 2));
-    char *pNewBuffer;
-    if (pBuffer->bufferSize)
+}
+
+static void DataBuffer_FreeChunks(DataBuffer *pBuffer)
+{
+    DataBufferChunk *pChunk = pBuffer->pHead;
+    while (pChunk)
     {
-        pNewBuffer = Creator_MemRealloc(pBuffer->pBuffer, newSize);
+        DataBufferChunk *pNext = pChunk->pNext;
+        FREE_BLOCK(_Chunks, &pChunk);
+        pChunk = pNext;
     }
-    else
+    pBuffer->pHead = NULL;
+    pBuffer->pTail = NULL;
+    pBuffer->dataSize = 0;
+}
+
+#ifdef CREATOR_STATIC_ALLOC
+static void *DataBuffer_AllocBlock(CreatorStaticPool *pPool, size_t size)
+{
+    void *pResult = CreatorStaticPool_Alloc(pPool);
+    if (!pResult)
     {
-        pNewBuffer = Creator_MemAlloc(newSize);
+        pResult = Creator_MemAlloc(size);
     }
-    if (pNewBuffer)
+    return pResult;
+}
+
+static void DataBuffer_FreeBlock(CreatorStaticPool *pPool, void **ppBlock)
+{
+    if (CreatorStaticPool_Free(pPool, *ppBlock))
     {
-        pBuffer->pBuffer = pNewBuffer;
-        pBuffer->bufferSize = newSize;
+        *ppBlock = NULL;
     }
     else
     {
-        pBuffer->bCorrupt = true;
+        Creator_MemFree(ppBlock);
     }
 }
+#endif
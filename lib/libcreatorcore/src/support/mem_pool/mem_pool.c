@@ -0,0 +1,296 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem_pool.h"
+
+#ifdef FREERTOS
+#include "FreeRTOS.h"
+#include "task.h"
+#else
+#include <pthread.h>
+#endif
+
+#define SLAB_SIZE               (1024)
+#define LARGE_BLOCK_CLASS       (0xFF)
+#define BLOCK_MAGIC             (0xB10C)
+
+static const uint16_t _ClassSizes[] = { 16, 32, 48, 64, 96, 128, 192, 256 };
+
+#define CLASS_COUNT             (sizeof(_ClassSizes) / sizeof(_ClassSizes[0]))
+
+// Class for each 16 byte step of the requested size
+static const uint8_t _SizeToClass[(MEMPOOL_MAX_BLOCK_SIZE / 16) + 1] = { 0, 0, 1, 2, 3, 4, 4, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7 };
+
+/*
+ * Header in front of every block, 8 bytes so payloads keep 8 byte alignment
+ */
+typedef struct
+{
+    uint16_t Magic;
+    uint8_t Class;
+    uint8_t Tag;
+    uint32_t Size;
+} BlockHeader;
+
+typedef struct FreeBlock
+{
+    struct FreeBlock *Next;
+} FreeBlock;
+
+static FreeBlock *_FreeBlocks[CLASS_COUNT];
+
+#ifdef FREERTOS
+
+// Free list updates are a handful of instructions, a critical section is much cheaper than suspending the scheduler
+#define LOCK_CLASS(sizeClass)       taskENTER_CRITICAL()
+#define UNLOCK_CLASS(sizeClass)     taskEXIT_CRITICAL()
+
+static void *HeapAlloc(size_t size)
+{
+    void *result;
+    vTaskSuspendAll();
+    result = malloc(size);
+    xTaskResumeAll();
+    return result;
+}
+
+static void HeapFree(void *block)
+{
+    vTaskSuspendAll();
+    free(block);
+    xTaskResumeAll();
+}
+
+static void *HeapRealloc(void *block, size_t size)
+{
+    void *result;
+    vTaskSuspendAll();
+    result = realloc(block, size);
+    xTaskResumeAll();
+    return result;
+}
+
+#else
+
+static pthread_mutex_t _ClassLocks[CLASS_COUNT] = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+        PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+        PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER };
+
+#define LOCK_CLASS(sizeClass)       pthread_mutex_lock(&_ClassLocks[sizeClass])
+#define UNLOCK_CLASS(sizeClass)     pthread_mutex_unlock(&_ClassLocks[sizeClass])
+#define HeapAlloc(size)             malloc(size)
+#define HeapFree(block)             free(block)
+#define HeapRealloc(block, size)    realloc(block, size)
+
+#endif
+
+static BlockHeader *AllocateFromClass(uint8_t sizeClass);
+static BlockHeader *GetHeader(void *block);
+
+void *MemPool_Alloc(size_t size)
+{
+    BlockHeader *header;
+    if (size <= MEMPOOL_MAX_BLOCK_SIZE)
+    {
+        header = AllocateFromClass(_SizeToClass[(size + 15) / 16]);
+    }
+    else
+    {
+        header = (BlockHeader *)HeapAlloc(sizeof(BlockHeader) + size);
+        if (header)
+            header->Class = LARGE_BLOCK_CLASS;
+    }
+    if (header)
+    {
+        header->Magic = BLOCK_MAGIC;
+        header->Tag = 0;
+        header->Size = (uint32_t)size;
+        return header + 1;
+    }
+    return NULL;
+}
+
+void *MemPool_Calloc(size_t blockCount, size_t blockSize)
+{
+    void *result = NULL;
+    size_t size = blockCount * blockSize;
+    if ((blockSize == 0) || ((size / blockSize) == blockCount))
+    {
+        result = MemPool_Alloc(size);
+        if (result)
+            memset(result, 0, size);
+    }
+    return result;
+}
+
+void MemPool_Free(void *block)
+{
+    BlockHeader *header = GetHeader(block);
+    if (header)
+    {
+        header->Magic = 0;
+        if (header->Class == LARGE_BLOCK_CLASS)
+        {
+            HeapFree(header);
+        }
+        else
+        {
+            uint8_t sizeClass = header->Class;
+            FreeBlock *freeBlock = (FreeBlock *)(header + 1);
+            LOCK_CLASS(sizeClass);
+            freeBlock->Next = _FreeBlocks[sizeClass];
+            _FreeBlocks[sizeClass] = freeBlock;
+            UNLOCK_CLASS(sizeClass);
+        }
+    }
+}
+
+size_t MemPool_GetBlockSize(void *block)
+{
+    size_t result = 0;
+    BlockHeader *header = GetHeader(block);
+    if (header)
+    {
+        result = (header->Class == LARGE_BLOCK_CLASS) ? header->Size : _ClassSizes[header->Class];
+    }
+    return result;
+}
+
+size_t MemPool_GetSize(void *block)
+{
+    BlockHeader *header = GetHeader(block);
+    return header ? header->Size : 0;
+}
+
+unsigned char MemPool_GetTag(void *block)
+{
+    BlockHeader *header = GetHeader(block);
+    return header ? header->Tag : 0;
+}
+
+void *MemPool_Realloc(void *block, size_t size)
+{
+    void *result = NULL;
+    BlockHeader *header = GetHeader(block);
+    if (!header)
+    {
+        result = MemPool_Alloc(size);
+    }
+    else if ((header->Class != LARGE_BLOCK_CLASS) && (size <= _ClassSizes[header->Class]))
+    {
+        // Still fits in the same block
+        header->Size = (uint32_t)size;
+        result = block;
+    }
+    else if ((header->Class == LARGE_BLOCK_CLASS) && (size > MEMPOOL_MAX_BLOCK_SIZE))
+    {
+        BlockHeader *newHeader = (BlockHeader *)HeapRealloc(header, sizeof(BlockHeader) + size);
+        if (newHeader)
+        {
+            newHeader->Size = (uint32_t)size;
+            result = newHeader + 1;
+        }
+    }
+    else
+    {
+        result = MemPool_Alloc(size);
+        if (result)
+        {
+            memcpy(result, block, (header->Size < size) ? header->Size : size);
+            MemPool_SetTag(result, header->Tag);
+            MemPool_Free(block);
+        }
+    }
+    return result;
+}
+
+void MemPool_SetTag(void *block, unsigned char tag)
+{
+    BlockHeader *header = GetHeader(block);
+    if (header)
+        header->Tag = tag;
+}
+
+static BlockHeader *AllocateFromClass(uint8_t sizeClass)
+{
+    FreeBlock *freeBlock;
+    LOCK_CLASS(sizeClass);
+    freeBlock = _FreeBlocks[sizeClass];
+    if (freeBlock)
+        _FreeBlocks[sizeClass] = freeBlock->Next;
+    UNLOCK_CLASS(sizeClass);
+
+    if (!freeBlock)
+    {
+        // Carve a new slab outside the lock, keep the first block and put the rest on the free list
+        size_t blockSize = sizeof(BlockHeader) + _ClassSizes[sizeClass];
+        size_t blockCount = SLAB_SIZE / blockSize;
+        uint8_t *slab = (uint8_t *)HeapAlloc(blockSize * blockCount);
+        if (slab)
+        {
+            FreeBlock *first = NULL;
+            FreeBlock *last = NULL;
+            size_t index;
+            for (index = 1; index < blockCount; index++)
+            {
+                BlockHeader *header = (BlockHeader *)(slab + (index * blockSize));
+                FreeBlock *block = (FreeBlock *)(header + 1);
+                header->Magic = 0;
+                header->Class = sizeClass;
+                block->Next = first;
+                first = block;
+                if (!last)
+                    last = block;
+            }
+            if (first)
+            {
+                LOCK_CLASS(sizeClass);
+                last->Next = _FreeBlocks[sizeClass];
+                _FreeBlocks[sizeClass] = first;
+                UNLOCK_CLASS(sizeClass);
+            }
+            ((BlockHeader *)slab)->Class = sizeClass;
+            return (BlockHeader *)slab;
+        }
+        return NULL;
+    }
+    return ((BlockHeader *)freeBlock) - 1;
+}
+
+static BlockHeader *GetHeader(void *block)
+{
+    BlockHeader *result = NULL;
+    if (block)
+    {
+        result = ((BlockHeader *)block) - 1;
+        if (result->Magic != BLOCK_MAGIC)
+        {
+            // Not from the pool or already freed, leaking is safer than corrupting the free lists
+            result = NULL;
+        }
+    }
+    return result;
+}
@@ -310,7 +310,7 @@ char *oauth_url_unescape(const char *string, size_t *olen) {
  * @return signature string
  */
 char *oauth_sign_plaintext (G_GNUC_UNUSED const char *m, const char *k) {
-  return(strdup(k));
+  return(xstrdup(k));
 }
 
 /**
@@ -152,7 +152,7 @@ bool dynamicString_add(XMLParser_Context xmlParser, char newChar)
 			{
 				/* Resize the buffer and copy contents (if there is room to grow) */
 				oldBuf = xmlParser->DynamicString;
-				xmlParser->DynamicString = Creator_MemAlloc(sizeof(char) * (newBuffSize + 1));
+				xmlParser->DynamicString = Creator_MemAllocWithTag(sizeof(char) * (newBuffSize + 1), CreatorMemTag_XML);
 				if(xmlParser->DynamicString)
 				{
 					memcpy(xmlParser->DynamicString, oldBuf, xmlParser->DynamicStringUsed * sizeof(char));
@@ -239,7 +239,7 @@ XMLParser_Context XMLParser_Create (void)
 {
 	XMLParser_Context newParser = NULL;
 	size_t parserSize = sizeof(XMLParser_ContextStruct);
-	newParser = (XMLParser_Context) Creator_MemAlloc(parserSize);
+	newParser = (XMLParser_Context) Creator_MemAllocWithTag(parserSize, CreatorMemTag_XML);
 
 	if(newParser)
 	{
@@ -259,7 +259,7 @@ XMLParser_Context XMLParser_Create (void)
 		/* Initialise dynamic string storage */
 		newParser->DynamicStringSize = DEFAULT_DYNAMIC_STRING_BUFFER_SIZE;
 		newParser->DynamicStringUsed = 0;
-		newParser->DynamicString = (char*) Creator_MemAlloc(sizeof(char) * (newParser->DynamicStringSize + 1));
+		newParser->DynamicString = (char*) Creator_MemAllocWithTag(sizeof(char) * (newParser->DynamicStringSize + 1), CreatorMemTag_XML);
 		if(!newParser->DynamicString)
 			initError = true;
 		// Initialise current element storage
@@ -331,7 +331,7 @@ bool XMLParser_IsFinished(XMLParser_Context xmlParser)
 const char** XMLParser_getAttributesArray(XMLParser_Context xmlParser)
 {
 	unsigned int arraySize = sizeof(char*) * (xmlParser->CurrentElement.AttributeCount*2 + 1);
-	char** newArray = Creator_MemAlloc(arraySize);
+	char** newArray = Creator_MemAllocWithTag(arraySize, CreatorMemTag_XML);
 
 	// The format of an attributes array is as follows:
 	//  -- The attributes are stored in an array of char* where:
@@ -347,9 +347,9 @@ const char** XMLParser_getAttributesArray(XMLParser_Context xmlParser)
 		char** ptr = newArray;
 		for(attrIndex = 0; attrIndex < xmlParser->CurrentElement.AttributeCount; attrIndex++)
 		{
-			*ptr = strdup(attribute->Name);
+			*ptr = CreatorString_Duplicate(attribute->Name);
 			ptr++;
-			*ptr = strdup(attribute->Value);
+			*ptr = CreatorString_Duplicate(attribute->Value);
 			ptr++;
 			attribute = attribute->Next;
 		}
@@ -625,7 +625,7 @@ bool XMLParser_Parse(XMLParser_Context xmlParser, const char *doc, unsigned int
 									Creator_MemFree((void **) &xmlParser->CurrentElement._Attribute);
 								}
 
-								xmlParser->CurrentElement._Attribute = Creator_MemAlloc(sizeof(XMLParser_attribute));
+								xmlParser->CurrentElement._Attribute = Creator_MemAllocWithTag(sizeof(XMLParser_attribute), CreatorMemTag_XML);
 								memset(xmlParser->CurrentElement._Attribute, '\0', sizeof(XMLParser_attribute));
 								xmlParser->CurrentElement._Attribute->AttributeDelimiter = '\0';
 
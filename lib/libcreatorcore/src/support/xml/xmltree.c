@@ -77,7 +77,7 @@ bool TreeNode_AddChild(TreeNode node, TreeNode child)
 
             // Double list capacity
             uint32_t newChildrenListSize = sizeof(TreeNode) * (_node->ChildSlots * 2);
-            _node->Children = (struct TreeNodeImpl**)Creator_MemAlloc(newChildrenListSize);
+            _node->Children = (struct TreeNodeImpl**)Creator_MemAllocWithTag(newChildrenListSize, CreatorMemTag_XML);
             if (_node->Children)
             {
                 _node->ChildSlots = (_node->ChildSlots * 2);
@@ -167,13 +167,13 @@ bool TreeNode_AppendValue(const TreeNode node, const uint8_t* value, const uint3
 
 TreeNode TreeNode_Create(void)
 {
-    _treeNode node = (_treeNode)Creator_MemAlloc(sizeof(TreeNodeImpl));
+    _treeNode node = (_treeNode)Creator_MemAllocWithTag(sizeof(TreeNodeImpl), CreatorMemTag_XML);
     if (node)
     {
         memset(node, 0, sizeof(TreeNodeImpl));
 
         node->ChildSlots = INITIAL_TREENODE_CHILD_SLOTS;
-        node->Children = (struct TreeNodeImpl**)Creator_MemAlloc(sizeof(struct TreeNodeImpl*) * node->ChildSlots);
+        node->Children = (struct TreeNodeImpl**)Creator_MemAllocWithTag(sizeof(struct TreeNodeImpl*) * node->ChildSlots, CreatorMemTag_XML);
         if (node->Children)
         {
             memset(node->Children, 0, sizeof(TreeNodeImpl*) * node->ChildSlots);
@@ -197,9 +197,9 @@ TreeNode TreeNode_CopyTreeNode(TreeNode node)
         if (newNode != NULL)
         {
             if (((_treeNode)node)->Name)
-                newNode->Name = strdup(((_treeNode)node)->Name);
+                newNode->Name = CreatorString_Duplicate(((_treeNode)node)->Name);
             if (((_treeNode)node)->Value)
-                newNode->Value = (uint8 *)strdup((char *)((_treeNode)node)->Value);
+                newNode->Value = (uint8 *)CreatorString_Duplicate((char *)((_treeNode)node)->Value);
         }
     }
 
@@ -310,7 +310,7 @@ TreeNode TreeNode_Navigate(const TreeNode rootNode, const char* path)
     // Assuming path is null-terminated
     if (rootNode && path)
     {
-        char* _path = (char*)Creator_MemAlloc(sizeof(char) * (strlen((const char*)path) + 1));
+        char* _path = (char*)Creator_MemAllocWithTag(sizeof(char) * (strlen((const char*)path) + 1), CreatorMemTag_XML);
         if (_path)
         {
             // Design note: Need to make a copy of path ('_path') as Microchip's implementation
@@ -385,7 +385,7 @@ bool TreeNode_SetName(const TreeNode node, const char* name, const uint32_t leng
         if (_node->Name)
             Creator_MemFree((void **)&_node->Name);
 
-        _node->Name = Creator_MemAlloc(sizeof(char) * (length + 1));
+        _node->Name = Creator_MemAllocWithTag(sizeof(char) * (length + 1), CreatorMemTag_XML);
         if (_node->Name)
         {
             if (length > 0)
@@ -419,7 +419,7 @@ bool TreeNode_SetValue(const TreeNode node, const uint8* value, const uint32_t l
         if (_node->Value)
             Creator_MemFree((void **)&_node->Value);
 
-        _node->Value = Creator_MemAlloc(sizeof(uint8) * (length + 1));
+        _node->Value = Creator_MemAllocWithTag(sizeof(uint8) * (length + 1), CreatorMemTag_XML);
         if (_node->Value)
         {
             if (length > 0)
@@ -0,0 +1,350 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+
+/*! \file chunked_fuzz.c
+ *  \brief Fuzzes the common-messaging chunked transfer decoder and measures its throughput.
+ *
+ * Usage: chunked_fuzz [options]
+ *   -s <seed>        random seed (default 1)
+ *   -i <messages>    well-formed pipelines to check (default 20000)
+ *   -m <messages>    mutated pipelines to feed (default 50000)
+ *   -b               throughput only, skip the fuzzing
+ *
+ * Input is fed to the parser the way CreatorCommonMessaging_Receive does it, in reads of random size into a
+ * CREATOR_MAX_PACKET_LEN receive buffer (or the parser's own buffer while it holds a partial line). Well-formed
+ * pipelines hold 1-3 chunked responses with random chunk sizes, optional chunk extensions and trailers, and each must
+ * produce exactly its body, one HeaderEnd and one Finished. Mutated pipelines have a few bytes corrupted: they may be
+ * rejected but must not crash or overrun (build with -fsanitize=address to check the latter).
+ *
+ * The throughput runs decode a 2 MB body sent as 1 byte, 1 KB and 1 MB chunks, in full-buffer reads.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "creator/core/creator_memalloc.h"
+#include "creator/core/common_messaging_defines.h"
+#include "creator/core/common_messaging_main.h"
+#include "common_messaging_parser.h"
+
+#define DEFAULT_MESSAGES            (20000)
+#define DEFAULT_MUTATED_MESSAGES    (50000)
+#define BODY_BUFFER_SIZE            (1 << 21)
+#define MESSAGE_BUFFER_SIZE         (1 << 25)
+#define MAX_FUZZ_BODY               (5000)
+#define MAX_FUZZ_CHUNK              (700)
+#define MAX_RESPONSES               (3)
+#define MUTATIONS                   (3)
+#define THROUGHPUT_REPEATS          (20)
+
+typedef struct
+{
+    char *Output;
+    int OutputLength;
+    int Finished;
+    int HeaderEnds;
+    int Trailers;
+} Received;
+
+static CreatorCommonMessaging_ControlBlock _ControlBlock;
+static char _ReceiveBuffer[CREATOR_MAX_PACKET_LEN + 1];
+static Received _Received;
+static char *_Body;
+static char *_Message;
+
+static int BuildPipeline(int bodyLength, int minChunk, int maxChunk, int responses, bool extensions, bool trailer);
+static bool Feed(const char *data, int length, bool randomReads);
+static bool Fuzz(uint messages, uint mutatedMessages);
+static double GetSeconds(void);
+static bool ProtocolCallback(CreatorCommonMessaging_CallbackEventType eventType, char *header, char *value, int length, void *context);
+static void Reset(void);
+static void Throughput(void);
+
+int main(int argc, char **argv)
+{
+    uint seed = 1;
+    uint messages = DEFAULT_MESSAGES;
+    uint mutatedMessages = DEFAULT_MUTATED_MESSAGES;
+    bool throughputOnly = false;
+    int option;
+    while ((option = getopt(argc, argv, "s:i:m:b")) != -1)
+    {
+        switch (option)
+        {
+            case 's':
+                seed = (uint)strtoul(optarg, NULL, 0);
+                break;
+            case 'i':
+                messages = (uint)strtoul(optarg, NULL, 0);
+                break;
+            case 'm':
+                mutatedMessages = (uint)strtoul(optarg, NULL, 0);
+                break;
+            case 'b':
+                throughputOnly = true;
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-s seed] [-i messages] [-m mutated messages] [-b]\n", argv[0]);
+                return 1;
+        }
+    }
+    _Body = (char*)malloc(BODY_BUFFER_SIZE);
+    _Message = (char*)malloc(MESSAGE_BUFFER_SIZE);
+    // The decoded output of a pipeline is at most MAX_RESPONSES bodies, or one throughput body
+    _Received.Output = (char*)malloc(BODY_BUFFER_SIZE * MAX_RESPONSES);
+    if (!_Body || !_Message || !_Received.Output)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    srand(seed);
+    uint index;
+    for (index = 0; index < BODY_BUFFER_SIZE; index++)
+        _Body[index] = (char)rand();
+
+    bool result = throughputOnly || Fuzz(messages, mutatedMessages);
+    if (result)
+        Throughput();
+    Reset();
+    free(_Received.Output);
+    free(_Message);
+    free(_Body);
+    return result ? 0 : 1;
+}
+
+/*
+ * Chunk sizes are random in minChunk..maxChunk, with extensions a random half of the size lines carry one
+ */
+static int BuildPipeline(int bodyLength, int minChunk, int maxChunk, int responses, bool extensions, bool trailer)
+{
+    int length = 0;
+    int response;
+    for (response = 0; response < responses; response++)
+    {
+        length += sprintf(_Message + length, "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\n"
+                "Transfer-Encoding: chunked\r\n\r\n");
+        int offset = 0;
+        while (offset < bodyLength)
+        {
+            int chunk = minChunk + rand() % (maxChunk - minChunk + 1);
+            if (chunk > bodyLength - offset)
+                chunk = bodyLength - offset;
+            length += sprintf(_Message + length, (extensions && (rand() % 2)) ? "%X;name=value\r\n" : "%x\r\n", chunk);
+            memcpy(_Message + length, _Body + offset, chunk);
+            length += chunk;
+            offset += chunk;
+            length += sprintf(_Message + length, "\r\n");
+        }
+        length += sprintf(_Message + length, "0\r\n");
+        if (trailer)
+            length += sprintf(_Message + length, "X-Trailer: yes\r\n");
+        length += sprintf(_Message + length, "\r\n");
+    }
+    return length;
+}
+
+/*
+ * Same buffer handling as CreatorCommonMessaging_Receive, returns false if the parser rejects the input
+ */
+static bool Feed(const char *data, int length, bool randomReads)
+{
+    CreatorCommonMessaging_ControlBlock *controlBlock = &_ControlBlock;
+    bool result = true;
+    while ((length > 0) && result)
+    {
+        char *receivedBuffer;
+        int maximumLengthToRead;
+        if (controlBlock->TemporaryDataBuffer)
+        {
+            receivedBuffer = controlBlock->TemporaryDataBuffer;
+            maximumLengthToRead = controlBlock->TemporaryDataBufferLength - controlBlock->PacketOffsetLength;
+        }
+        else
+        {
+            receivedBuffer = controlBlock->ReceivedBuffer;
+            maximumLengthToRead = CREATOR_MAX_PACKET_LEN - controlBlock->PacketOffsetLength;
+        }
+        int receivedDataLength = randomReads ? (rand() % maximumLengthToRead + 1) : maximumLengthToRead;
+        if (receivedDataLength > length)
+            receivedDataLength = length;
+        memcpy(receivedBuffer + controlBlock->PacketOffsetLength, data, receivedDataLength);
+        data += receivedDataLength;
+        length -= receivedDataLength;
+
+        receivedDataLength += controlBlock->PacketOffsetLength;
+        receivedBuffer[receivedDataLength] = '\0';
+        if (controlBlock->IsChunked && controlBlock->IsContentReadingInProgress)
+        {
+            int32 consumed = CreatorCommonMessaging_HandleChunkedContent(controlBlock, receivedBuffer, &receivedDataLength);
+            if (consumed < 0)
+                result = false;
+            else if (receivedDataLength > 0)
+                result = (CreatorCommonMessaging_ParseMessage(controlBlock, receivedBuffer + consumed, receivedDataLength) >= 0);
+        }
+        else if (controlBlock->LengthOfRemainingContent > 0 && controlBlock->IsContentReadingInProgress)
+        {
+            int consumed = CreatorCommonMessaging_HandleContent(controlBlock, receivedBuffer, &receivedDataLength);
+            if (receivedDataLength > 0)
+                result = (CreatorCommonMessaging_ParseMessage(controlBlock, receivedBuffer + consumed, receivedDataLength) >= 0);
+        }
+        else
+        {
+            result = (CreatorCommonMessaging_ParseMessage(controlBlock, receivedBuffer, receivedDataLength) >= 0);
+        }
+        if ((controlBlock->PacketOffsetLength == 0) && controlBlock->TemporaryDataBuffer)
+            Creator_MemFree((void **)&controlBlock->TemporaryDataBuffer);
+    }
+    return result;
+}
+
+static bool Fuzz(uint messages, uint mutatedMessages)
+{
+    uint index;
+    for (index = 0; index < messages; index++)
+    {
+        Reset();
+        int bodyLength = rand() % MAX_FUZZ_BODY;
+        int responses = rand() % MAX_RESPONSES + 1;
+        bool trailer = (rand() % 2) != 0;
+        int length = BuildPipeline(bodyLength, 1, rand() % MAX_FUZZ_CHUNK + 1, responses, true, trailer);
+        if (!Feed(_Message, length, true))
+        {
+            fprintf(stderr, "message %u: rejected\n", index);
+            return false;
+        }
+        if ((_Received.Finished != responses) || (_Received.HeaderEnds != responses)
+                || (_Received.OutputLength != bodyLength * responses) || (_Received.Trailers != (trailer ? responses : 0)))
+        {
+            fprintf(stderr, "message %u: %d finished, %d header ends, %d of %d bytes, %d trailers for %d responses\n", index,
+                    _Received.Finished, _Received.HeaderEnds, _Received.OutputLength, bodyLength * responses,
+                    _Received.Trailers, responses);
+            return false;
+        }
+        int response;
+        for (response = 0; response < responses; response++)
+        {
+            if (memcmp(_Received.Output + response * bodyLength, _Body, bodyLength) != 0)
+            {
+                fprintf(stderr, "message %u: body %d differs\n", index, response);
+                return false;
+            }
+        }
+    }
+    printf("%u well-formed pipelines decoded\n", messages);
+
+    uint rejected = 0;
+    for (index = 0; index < mutatedMessages; index++)
+    {
+        Reset();
+        int length = BuildPipeline(rand() % (MAX_FUZZ_BODY / 2), 1, rand() % (MAX_FUZZ_CHUNK / 2) + 1, 1, true,
+                (rand() % 2) != 0);
+        int mutation;
+        for (mutation = 0; mutation < MUTATIONS; mutation++)
+            _Message[rand() % length] = (char)rand();
+        if (!Feed(_Message, length, true))
+            rejected++;
+        if (_Received.OutputLength > MAX_FUZZ_BODY)
+        {
+            fprintf(stderr, "mutated message %u: %d bytes of body delivered\n", index, _Received.OutputLength);
+            return false;
+        }
+    }
+    printf("%u mutated pipelines fed, %u rejected as malformed\n", mutatedMessages, rejected);
+    return true;
+}
+
+static double GetSeconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static bool ProtocolCallback(CreatorCommonMessaging_CallbackEventType eventType, char *header, char *value, int length, void *context)
+{
+    (void)context;
+    switch (eventType)
+    {
+        case CreatorCommonMessaging_CallbackEventType_Data:
+            // A corrupted chunk size can announce more than was sent, but never more than the pipeline holds
+            if (_Received.OutputLength + length <= BODY_BUFFER_SIZE * MAX_RESPONSES)
+                memcpy(_Received.Output + _Received.OutputLength, value, length);
+            _Received.OutputLength += length;
+            break;
+        case CreatorCommonMessaging_CallbackEventType_Header:
+            if (header && (strcmp(header, "X-Trailer") == 0))
+                _Received.Trailers++;
+            break;
+        case CreatorCommonMessaging_CallbackEventType_HeaderEnd:
+            _Received.HeaderEnds++;
+            break;
+        case CreatorCommonMessaging_CallbackEventType_Finished:
+            _Received.Finished++;
+            break;
+        default:
+            break;
+    }
+    return true;
+}
+
+static void Reset(void)
+{
+    if (_ControlBlock.TemporaryDataBuffer)
+        Creator_MemFree((void **)&_ControlBlock.TemporaryDataBuffer);
+    memset(&_ControlBlock, 0, sizeof(_ControlBlock));
+    _ControlBlock.ReceivedBuffer = _ReceiveBuffer;
+    _ControlBlock.IsPacketBegining = true;
+    _ControlBlock.ProtocolCallBack = ProtocolCallback;
+    _Received.OutputLength = 0;
+    _Received.Finished = 0;
+    _Received.HeaderEnds = 0;
+    _Received.Trailers = 0;
+}
+
+static void Throughput(void)
+{
+    static const int chunkSizes[] = { 1, 1024, 1024 * 1024 };
+    uint index;
+    for (index = 0; index < sizeof(chunkSizes) / sizeof(chunkSizes[0]); index++)
+    {
+        int length = BuildPipeline(BODY_BUFFER_SIZE, chunkSizes[index], chunkSizes[index], 1, false, false);
+        double start = GetSeconds();
+        uint repeat;
+        bool decoded = true;
+        for (repeat = 0; (repeat < THROUGHPUT_REPEATS) && decoded; repeat++)
+        {
+            Reset();
+            decoded = Feed(_Message, length, false) && (_Received.OutputLength == BODY_BUFFER_SIZE);
+        }
+        double seconds = GetSeconds() - start;
+        if (decoded)
+            printf("%7d byte chunks: %.1f MB/s of message, %.1f MB/s of body\n", chunkSizes[index],
+                    THROUGHPUT_REPEATS * (double)length / seconds / 1e6, THROUGHPUT_REPEATS * (double)BODY_BUFFER_SIZE / seconds / 1e6);
+        else
+            printf("%7d byte chunks: decode failed\n", chunkSizes[index]);
+    }
+}
@@ -0,0 +1,233 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+
+/*! \file collections_bench.c
+ *  \brief Measures CreatorList and CreatorHashMap operations from 10 to 10000 entries.
+ *
+ * Usage: collections_bench [options]
+ *   -m <entries>     largest collection; 10, 100, 1000, ... up to this are run (default 10000)
+ *   -o <operations>  minimum operations timed per line, repeated over the collection (default 1000000)
+ *
+ * Operations (nanoseconds per operation):
+ *   list_add          CreatorList_Add into a list created with capacity 1, so growth is included
+ *   list_find         strcmp scan of a CreatorList, the lookup the hash map replaces for named entries
+ *   list_remove       CreatorList_RemoveAtUnordered from the front until empty
+ *   map_put           CreatorHashMap_Put with string keys into a map created with capacity 1
+ *   map_get           CreatorHashMap_Get of a present key
+ *   map_miss          CreatorHashMap_Get of an absent key
+ *   map_remove        CreatorHashMap_Remove of every key
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "creator/core/creator_hashmap.h"
+#include "creator/core/creator_list.h"
+#include "creator/core/creator_memalloc.h"
+
+#define DEFAULT_MAX_ENTRIES     (10000)
+#define DEFAULT_OPERATIONS      (1000000)
+#define KEY_LENGTH              (24)
+
+typedef struct
+{
+    char Name[KEY_LENGTH];
+} Entry;
+
+static volatile uintptr_t _Sink;
+
+static Entry *FindInList(CreatorList list, const char *name);
+static double GetNanoseconds(void);
+static void Report(const char *operation, uint entries, double nanoseconds, uint operations);
+static bool RunSize(uint entries, uint operations);
+
+int main(int argc, char **argv)
+{
+    uint maxEntries = DEFAULT_MAX_ENTRIES;
+    uint operations = DEFAULT_OPERATIONS;
+    int option;
+    while ((option = getopt(argc, argv, "m:o:")) != -1)
+    {
+        switch (option)
+        {
+            case 'm':
+                maxEntries = (uint)strtoul(optarg, NULL, 0);
+                break;
+            case 'o':
+                operations = (uint)strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-m entries] [-o operations]\n", argv[0]);
+                return 1;
+        }
+    }
+    if ((maxEntries == 0) || (operations == 0))
+    {
+        fprintf(stderr, "entries and operations must be non-zero\n");
+        return 1;
+    }
+    printf("operation,entries,ns_per_operation\n");
+    uint entries = (maxEntries < 10) ? maxEntries : 10;
+    while (true)
+    {
+        if (!RunSize(entries, operations))
+            return 1;
+        if (entries == maxEntries)
+            break;
+        entries = (entries * 10 < maxEntries) ? entries * 10 : maxEntries;
+    }
+    return 0;
+}
+
+static Entry *FindInList(CreatorList list, const char *name)
+{
+    Entry *result = NULL;
+    uint index;
+    for (index = 0; index < CreatorList_GetCount(list); index++)
+    {
+        Entry *entry = (Entry*)CreatorList_GetItem(list, index);
+        if (strcmp(entry->Name, name) == 0)
+        {
+            result = entry;
+            break;
+        }
+    }
+    return result;
+}
+
+static double GetNanoseconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+static void Report(const char *operation, uint entries, double nanoseconds, uint operations)
+{
+    printf("%s,%u,%.1f\n", operation, entries, nanoseconds / operations);
+}
+
+static bool RunSize(uint entries, uint operations)
+{
+    bool result = false;
+    Entry *entryArray = (Entry*)Creator_MemAlloc(sizeof(Entry) * entries);
+    if (entryArray)
+    {
+        uint index;
+        for (index = 0; index < entries; index++)
+            snprintf(entryArray[index].Name, KEY_LENGTH, "certificate-%08x", index * 2654435761u);
+        // Repeat build/tear-down so that small collections are timed over enough operations
+        uint rounds = (operations + entries - 1) / entries;
+        // Scans are O(n): cap their operation count so large lists finish
+        uint findOperations = (entries > 100) ? (operations / (entries / 100)) : operations;
+        if (findOperations < entries)
+            findOperations = entries;
+        double listAdd = 0, listFind = 0, listRemove = 0;
+        double mapPut = 0, mapGet = 0, mapMiss = 0, mapRemove = 0;
+        uint round;
+        result = true;
+        for (round = 0; (round < rounds) && result; round++)
+        {
+            CreatorList list = CreatorList_New(1);
+            CreatorHashMap map = CreatorHashMap_New(CreatorHashMapKeyType_String, 1);
+            if (!list || !map)
+            {
+                result = false;
+                break;
+            }
+            double start = GetNanoseconds();
+            for (index = 0; index < entries; index++)
+                CreatorList_Add(list, &entryArray[index]);
+            listAdd += GetNanoseconds() - start;
+
+            if (round == 0)
+            {
+                start = GetNanoseconds();
+                for (index = 0; index < findOperations; index++)
+                    _Sink += (uintptr_t)FindInList(list, entryArray[(index * 7919u) % entries].Name);
+                listFind = GetNanoseconds() - start;
+            }
+
+            start = GetNanoseconds();
+            for (index = 0; index < entries; index++)
+                CreatorHashMap_Put(map, entryArray[index].Name, &entryArray[index]);
+            mapPut += GetNanoseconds() - start;
+
+            start = GetNanoseconds();
+            for (index = 0; index < entries; index++)
+            {
+                Entry *entry = (Entry*)CreatorHashMap_Get(map, entryArray[(index * 7919u) % entries].Name);
+                if (!entry)
+                    result = false;
+                _Sink += (uintptr_t)entry;
+            }
+            mapGet += GetNanoseconds() - start;
+
+            start = GetNanoseconds();
+            for (index = 0; index < entries; index++)
+            {
+                char name[KEY_LENGTH];
+                memcpy(name, entryArray[index].Name, KEY_LENGTH);
+                name[0] = 'C';
+                if (CreatorHashMap_Get(map, name))
+                    result = false;
+            }
+            mapMiss += GetNanoseconds() - start;
+
+            start = GetNanoseconds();
+            for (index = 0; index < entries; index++)
+                _Sink += (uintptr_t)CreatorHashMap_Remove(map, entryArray[index].Name);
+            mapRemove += GetNanoseconds() - start;
+
+            start = GetNanoseconds();
+            while (CreatorList_GetCount(list) > 0)
+                CreatorList_RemoveAtUnordered(list, 0);
+            listRemove += GetNanoseconds() - start;
+
+            if (CreatorHashMap_GetCount(map) != 0)
+                result = false;
+            CreatorHashMap_Free(&map);
+            CreatorList_Free(&list, false);
+        }
+        if (result)
+        {
+            uint total = rounds * entries;
+            Report("list_add", entries, listAdd, total);
+            Report("list_find", entries, listFind, findOperations);
+            Report("list_remove", entries, listRemove, total);
+            Report("map_put", entries, mapPut, total);
+            Report("map_get", entries, mapGet, total);
+            Report("map_miss", entries, mapMiss, total);
+            Report("map_remove", entries, mapRemove, total);
+            fflush(stdout);
+        }
+        else
+            fprintf(stderr, "%u entries: map lookup returned the wrong result\n", entries);
+    }
+    Creator_MemFree((void **)&entryArray);
+    return result;
+}
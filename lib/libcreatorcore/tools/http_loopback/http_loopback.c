@@ -0,0 +1,496 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+
+/*! \file http_loopback.c
+ *  \brief Drives the pooled HTTP client (http_creator) against stand-in servers on the loopback interface.
+ *
+ * Usage: http_loopback [options]
+ *   -t <threads>     client threads issuing requests (default 4)
+ *   -n <requests>    requests per thread (default 200)
+ *   -H <hosts>       stand-in servers, each on its own port, so each is a separate host to the pool (default 3)
+ *   -b <bytes>       response body size (default 512)
+ *   -k <responses>   servers drop each connection after this many responses, without warning (default 0, never)
+ *
+ * Every thread loops over CreatorHTTPRequest_New / _Send / wait for the finish callback / _Free, with GETs spread
+ * round-robin over the hosts, and checks the status and body length of each response. A request that fails with a
+ * network error is sent again once, as CreatorHTTP_Call does. The report gives the request rate and the pool's hits,
+ * misses, evictions and waits from CreatorHTTP_GetConnectionPoolStatistics.
+ *
+ * The makefile builds it twice: http_loopback with the client's default (serial) connections, and
+ * http_loopback_pipelined with MAX_HTTP_PIPELINE_DEPTH 4, where requests from different threads to the same host
+ * share a connection. Comparing the two at the same options gives serial vs pipelined throughput.
+ *
+ * -k exercises the close/send race: a server closes the connection just after a response, while the client may be
+ * sending the next request on it (or, pipelined, already have several outstanding). Failed requests are then expected
+ * (and counted), but every request must still finish exactly once - a missing finish callback stops the driver, and
+ * a second one is counted in duplicate_finishes and fails the run.
+ *
+ * CreatorHTTP_Call itself needs the generated core object model, which is not part of this tree, so the driver
+ * works at the CreatorHTTPRequest level it is built on. Only plain http:// is served; the TLS entry points are
+ * stubbed out.
+ */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "creator/core/creator_httpmethod.h"
+#include "creator/core/creator_memalloc.h"
+#include "creator/core/creator_task_scheduler.h"
+#include "creator/core/creator_threading.h"
+#include "creator/core/creator_timer.h"
+#include "creator/core/common_messaging_main.h"
+#include "creator_http.h"
+#include "creator_tls.h"
+#include "ext-dep/creator_threading_private.h"
+
+#ifndef MAX_HTTP_PIPELINE_DEPTH
+#define MAX_HTTP_PIPELINE_DEPTH     1
+#endif
+
+#define DEFAULT_THREADS             (4)
+#define DEFAULT_REQUESTS            (200)
+#define DEFAULT_HOSTS               (3)
+#define DEFAULT_BODY_SIZE           (512)
+#define MAX_HOSTS                   (16)
+#define MAX_BODY_SIZE               (64 * 1024)
+#define SERVER_BUFFER_SIZE          (16 * 1024)
+#define RESPONSE_HEADER_SIZE        (128)
+#define RESPONSE_WAIT_TIME          (90000)     // longer than the client's own response timeout
+#define CALL_ATTEMPTS               (2)
+
+typedef struct
+{
+    int ListenSocket;
+    int Port;
+    pthread_t AcceptThread;
+} StandInServer;
+
+typedef struct
+{
+    StandInServer Servers[MAX_HOSTS];
+    uint Hosts;
+    char *Response;             // header and body, sent with one write (two small writes would meet Nagle + delayed ACK)
+    uint ResponseSize;
+    uint BodySize;
+    uint DropAfter;             // responses per connection, 0 for no limit
+    volatile uint Served;
+    volatile uint Accepted;
+    volatile bool Stopping;
+} ServerState;
+
+typedef struct
+{
+    uint Number;
+    uint Requests;
+    CreatorSemaphore Done;
+    // Response to the request in progress
+    unsigned short Status;
+    size_t BodyLength;
+    CreatorHTTPError Error;
+    // Totals
+    uint Succeeded;
+    uint Retried;
+    uint Failed;
+    uint DuplicateFinishes;
+} Worker;
+
+static ServerState _Server;
+
+static void *AcceptMethod(void *context);
+static bool Call(Worker *worker, const char *url);
+static void *ConnectionMethod(void *context);
+static void DataCallback(CreatorHTTPRequest request, void *context, const char *data, size_t dataLength);
+static void FinishCallback(CreatorHTTPRequest request, void *context, CreatorHTTPError error);
+static double GetSeconds(void);
+static void ResultCallback(CreatorHTTPRequest request, void *context, unsigned short httpResult);
+static bool StartServers(uint hosts, uint bodySize, uint dropAfter);
+static void StopServers(void);
+static void WorkerMethod(CreatorThread thread, void *context);
+
+int main(int argc, char **argv)
+{
+    uint threads = DEFAULT_THREADS;
+    uint requests = DEFAULT_REQUESTS;
+    uint hosts = DEFAULT_HOSTS;
+    uint bodySize = DEFAULT_BODY_SIZE;
+    uint dropAfter = 0;
+    int option;
+    while ((option = getopt(argc, argv, "t:n:H:b:k:")) != -1)
+    {
+        switch (option)
+        {
+            case 't':
+                threads = (uint)strtoul(optarg, NULL, 0);
+                break;
+            case 'n':
+                requests = (uint)strtoul(optarg, NULL, 0);
+                break;
+            case 'H':
+                hosts = (uint)strtoul(optarg, NULL, 0);
+                break;
+            case 'b':
+                bodySize = (uint)strtoul(optarg, NULL, 0);
+                break;
+            case 'k':
+                dropAfter = (uint)strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-t threads] [-n requests] [-H hosts] [-b body size] [-k responses per connection]\n",
+                        argv[0]);
+                return 1;
+        }
+    }
+    if ((threads == 0) || (requests == 0) || (hosts == 0) || (hosts > MAX_HOSTS) || (bodySize > MAX_BODY_SIZE))
+    {
+        fprintf(stderr, "threads and requests must be non-zero, hosts 1..%d and the body at most %d bytes\n", MAX_HOSTS, MAX_BODY_SIZE);
+        return 1;
+    }
+    if (!StartServers(hosts, bodySize, dropAfter))
+        return 1;
+
+    CreatorThread_Initialise();
+    CreatorTimer_Initialise();
+    CreatorScheduler_Initialise();
+    CreatorCommonMessaging_Initialise();
+    CreatorHTTP_Initialise();
+
+    Worker *workers = (Worker*)Creator_MemAlloc(sizeof(Worker) * threads);
+    CreatorThread *workerThreads = (CreatorThread*)Creator_MemAlloc(sizeof(CreatorThread) * threads);
+    bool result = false;
+    if (workers && workerThreads)
+    {
+        memset(workers, 0, sizeof(Worker) * threads);
+        double start = GetSeconds();
+        uint index;
+        for (index = 0; index < threads; index++)
+        {
+            workers[index].Number = index;
+            workers[index].Requests = requests;
+            workers[index].Done = CreatorSemaphore_New(1, 1);
+            workerThreads[index] = CreatorThread_New("HTTPWorker", 0, 0, WorkerMethod, &workers[index]);
+        }
+        uint succeeded = 0, retried = 0, failed = 0, duplicateFinishes = 0;
+        for (index = 0; index < threads; index++)
+        {
+            if (workerThreads[index])
+            {
+                CreatorThread_Join(workerThreads[index]);
+                CreatorThread_Free(&workerThreads[index]);
+            }
+            else
+                failed += requests;
+            succeeded += workers[index].Succeeded;
+            retried += workers[index].Retried;
+            failed += workers[index].Failed;
+            duplicateFinishes += workers[index].DuplicateFinishes;
+            CreatorSemaphore_Free(&workers[index].Done);
+        }
+        double seconds = GetSeconds() - start;
+
+        CreatorHTTPConnectionPoolStatistics statistics;
+        memset(&statistics, 0, sizeof(statistics));
+        CreatorHTTP_GetConnectionPoolStatistics(&statistics);
+        printf("pipeline_depth,threads,hosts,drop_after,requests,succeeded,retried,failed,duplicate_finishes,seconds,"
+                "requests_per_second,hits,misses,evictions,waits,pipelined,pipeline_fallbacks,served,accepted\n");
+        printf("%d,%u,%u,%u,%u,%u,%u,%u,%u,%.3f,%.0f,%u,%u,%u,%u,%u,%u,%u,%u\n", MAX_HTTP_PIPELINE_DEPTH, threads, hosts,
+                dropAfter, threads * requests, succeeded, retried, failed, duplicateFinishes, seconds, succeeded / seconds,
+                statistics.Hits, statistics.Misses, statistics.Evictions, statistics.Waits, statistics.Pipelined,
+                statistics.PipelineFallbacks, _Server.Served, _Server.Accepted);
+        // Dropped connections are allowed to fail requests, never to finish one twice
+        result = (duplicateFinishes == 0) && ((failed == 0) || (dropAfter > 0));
+    }
+    Creator_MemFree((void **)&workerThreads);
+    Creator_MemFree((void **)&workers);
+
+    CreatorHTTP_Shutdown();
+    CreatorCommonMessaging_Shutdown();
+    CreatorScheduler_Shutdown();
+    CreatorTimer_Shutdown();
+    StopServers();
+    return result ? 0 : 1;
+}
+
+static void *AcceptMethod(void *context)
+{
+    StandInServer *server = (StandInServer*)context;
+    while (!_Server.Stopping)
+    {
+        int connection = accept(server->ListenSocket, NULL, NULL);
+        if (connection < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            break;
+        }
+        __atomic_add_fetch(&_Server.Accepted, 1, __ATOMIC_RELAXED);
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, ConnectionMethod, (void*)(intptr_t)connection) == 0)
+            pthread_detach(thread);
+        else
+            close(connection);
+    }
+    return NULL;
+}
+
+static bool Call(Worker *worker, const char *url)
+{
+    bool result = false;
+    int attempt;
+    for (attempt = 0; (attempt < CALL_ATTEMPTS) && !result; attempt++)
+    {
+        worker->Status = 0;
+        worker->BodyLength = 0;
+        worker->Error = CreatorHTTPError_NotSet;
+        CreatorHTTPRequest request = CreatorHTTPRequest_New(CreatorHTTPMethod_Get, url, ResultCallback, NULL, DataCallback,
+                FinishCallback, worker);
+        if (!request)
+            break;
+        CreatorHTTPRequest_Send(request);
+        if (!CreatorSemaphore_WaitFor(worker->Done, 1, RESPONSE_WAIT_TIME))
+        {
+            fprintf(stderr, "%s: no finish callback after %d ms\n", url, RESPONSE_WAIT_TIME);
+            exit(1);
+        }
+        CreatorHTTPRequest_Free(&request);
+        // No callbacks after _Free, and only one before it
+        if (CreatorSemaphore_WaitFor(worker->Done, 1, 0))
+        {
+            worker->DuplicateFinishes++;
+            while (CreatorSemaphore_WaitFor(worker->Done, 1, 0))
+                worker->DuplicateFinishes++;
+        }
+        result = (worker->Error == CreatorHTTPError_None) && (worker->Status == 200) && (worker->BodyLength == _Server.BodySize);
+        if (!result && (worker->Error != CreatorHTTPError_NetworkFailure))
+            break;
+        if (!result)
+            worker->Retried++;
+    }
+    return result;
+}
+
+/*
+ * Stand-in server connection: answers each request (pipelined or not) in order with a fixed body, until the
+ * response limit (if any) is reached
+ */
+static void *ConnectionMethod(void *context)
+{
+    int connection = (int)(intptr_t)context;
+    char *buffer = (char*)malloc(SERVER_BUFFER_SIZE + 1);
+    int used = 0;
+    uint responses = 0;
+    bool open = (buffer != NULL);
+    while (open)
+    {
+        ssize_t received = recv(connection, buffer + used, SERVER_BUFFER_SIZE - used, 0);
+        if (received <= 0)
+            break;
+        used += received;
+        buffer[used] = '\0';
+        char *requestEnd;
+        while (open && ((requestEnd = strstr(buffer, "\r\n\r\n")) != NULL))
+        {
+            int requestLength = (requestEnd + 4) - buffer;
+            // Requests from the driver are GETs (no body), anything else is not understood
+            if (strncmp(buffer, "GET ", 4) != 0)
+            {
+                open = false;
+                break;
+            }
+            if (send(connection, _Server.Response, _Server.ResponseSize, MSG_NOSIGNAL) != (ssize_t)_Server.ResponseSize)
+                open = false;
+            else
+                __atomic_add_fetch(&_Server.Served, 1, __ATOMIC_RELAXED);
+            // Any requests already received behind it are dropped with the connection
+            if (_Server.DropAfter && (++responses == _Server.DropAfter))
+                open = false;
+            used -= requestLength;
+            memmove(buffer, buffer + requestLength, used + 1);
+        }
+        if (used == SERVER_BUFFER_SIZE)
+            break;
+    }
+    close(connection);
+    free(buffer);
+    return NULL;
+}
+
+static void DataCallback(CreatorHTTPRequest request, void *context, const char *data, size_t dataLength)
+{
+    (void)request;
+    (void)data;
+    Worker *worker = (Worker*)context;
+    worker->BodyLength += dataLength;
+}
+
+static void FinishCallback(CreatorHTTPRequest request, void *context, CreatorHTTPError error)
+{
+    (void)request;
+    Worker *worker = (Worker*)context;
+    worker->Error = error;
+    CreatorSemaphore_Release(worker->Done, 1);
+}
+
+static double GetSeconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void ResultCallback(CreatorHTTPRequest request, void *context, unsigned short httpResult)
+{
+    (void)request;
+    Worker *worker = (Worker*)context;
+    worker->Status = httpResult;
+}
+
+static bool StartServers(uint hosts, uint bodySize, uint dropAfter)
+{
+    memset(&_Server, 0, sizeof(_Server));
+    _Server.BodySize = bodySize;
+    _Server.DropAfter = dropAfter;
+    _Server.Response = (char*)malloc(RESPONSE_HEADER_SIZE + bodySize);
+    if (!_Server.Response)
+        return false;
+    _Server.ResponseSize = sprintf(_Server.Response, "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: %u\r\n\r\n",
+            bodySize);
+    uint index;
+    for (index = 0; index < bodySize; index++)
+        _Server.Response[_Server.ResponseSize++] = 'a' + (index % 26);
+    for (index = 0; index < hosts; index++)
+    {
+        StandInServer *server = &_Server.Servers[index];
+        struct sockaddr_in address;
+        socklen_t addressLength = sizeof(address);
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+        server->ListenSocket = socket(AF_INET, SOCK_STREAM, 0);
+        if ((server->ListenSocket < 0) || (bind(server->ListenSocket, (struct sockaddr*)&address, sizeof(address)) != 0)
+                || (listen(server->ListenSocket, 16) != 0)
+                || (getsockname(server->ListenSocket, (struct sockaddr*)&address, &addressLength) != 0))
+        {
+            perror("stand-in server");
+            return false;
+        }
+        server->Port = ntohs(address.sin_port);
+        if (pthread_create(&server->AcceptThread, NULL, AcceptMethod, server) != 0)
+            return false;
+        _Server.Hosts++;
+    }
+    return true;
+}
+
+static void StopServers(void)
+{
+    _Server.Stopping = true;
+    uint index;
+    for (index = 0; index < _Server.Hosts; index++)
+    {
+        StandInServer *server = &_Server.Servers[index];
+        shutdown(server->ListenSocket, SHUT_RDWR);
+        close(server->ListenSocket);
+        pthread_join(server->AcceptThread, NULL);
+    }
+    free(_Server.Response);
+}
+
+static void WorkerMethod(CreatorThread thread, void *context)
+{
+    (void)thread;
+    Worker *worker = (Worker*)context;
+    char url[64];
+    uint index;
+    for (index = 0; index < worker->Requests; index++)
+    {
+        StandInServer *server = &_Server.Servers[(worker->Number + index) % _Server.Hosts];
+        sprintf(url, "http://127.0.0.1:%d/item/%u", server->Port, index);
+        if (Call(worker, url))
+            worker->Succeeded++;
+        else
+            worker->Failed++;
+    }
+}
+
+/*
+ * Plain http:// only - TLS is never started
+ */
+void CreatorTLS_Initialise(void)
+{
+}
+
+void CreatorTLS_Shutdown(void)
+{
+}
+
+bool CreatorTLS_StartSSLSession(CreatorCommonMessaging_ControlBlock *controlBlock, bool client)
+{
+    (void)controlBlock;
+    (void)client;
+    return false;
+}
+
+void CreatorTLS_EndSSLSession(CreatorCommonMessaging_ControlBlock *controlBlock)
+{
+    (void)controlBlock;
+}
+
+int CreatorTLS_Read(CreatorCommonMessaging_ControlBlock *controlBlock, void *buffer, size_t bufferSize)
+{
+    (void)controlBlock;
+    (void)buffer;
+    (void)bufferSize;
+    return -1;
+}
+
+int CreatorTLS_Write(CreatorCommonMessaging_ControlBlock *controlBlock, void *buffer, size_t length)
+{
+    (void)controlBlock;
+    (void)buffer;
+    (void)length;
+    return -1;
+}
+
+CreatorTLSError CreatorTLS_GetError(CreatorCommonMessaging_ControlBlock *controlBlock)
+{
+    (void)controlBlock;
+    return CreatorTLSError_ConnectionClosed;
+}
+
+/*
+ * Normally in core http.c
+ */
+char *CreatorHTTPMethod_ToString(CreatorHTTPMethod method)
+{
+    return (method == CreatorHTTPMethod_Get) ? "GET" : "";
+}
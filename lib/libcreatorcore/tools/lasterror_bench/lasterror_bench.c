@@ -0,0 +1,283 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+
+/*! \file lasterror_bench.c
+ *  \brief Measures CreatorThread last-error calls from many threads at once.
+ *
+ * Usage: lasterror_bench [options]
+ *   -n <rounds>      clear/set/get rounds per thread (default 200000)
+ *   -t <threads>     largest number of threads; 1, 2, 4, ... up to this are run (default 16)
+ *
+ * Each round does what an HTTP call or pool task does: ClearLastError, SetError with a value unique to the thread,
+ * then GetLastError, which must return that value. Two implementations are run:
+ *   tls      the library's CreatorThread_* calls (thread-local storage)
+ *   list     a copy of the previous implementation, a list of per-thread entries searched under one lock, kept here
+ *            as the baseline
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "creator/core/creator_list.h"
+#include "creator/core/creator_memalloc.h"
+#include "creator/core/creator_threading.h"
+#include "creator/core/errortype.h"
+#include "ext-dep/creator_threading_private.h"
+
+#define DEFAULT_ROUNDS          (200000)
+#define DEFAULT_MAX_THREADS     (16)
+#define ERROR_VALUE_COUNT       (10)
+
+typedef enum
+{
+    Variant_TLS,
+    Variant_List,
+    Variant_Max
+} Variant;
+
+static const char *_VariantNames[Variant_Max] = { "tls", "list" };
+
+typedef struct
+{
+    Variant Variant;
+    uint Rounds;
+    volatile uint NextThread;
+    volatile uint Mismatches;
+} Run;
+
+typedef struct
+{
+    pthread_t ThreadID;
+    CreatorErrorType Error;
+} ThreadError;
+
+static CreatorList _ThreadErrors = NULL;
+static CreatorSemaphore _ThreadErrorsLock = NULL;
+
+static double GetSeconds(void);
+static void ListClearLastError(void);
+static CreatorErrorType ListGetLastError(void);
+static void ListSetError(CreatorErrorType error);
+static double RunVariant(Variant variant, uint threads, uint rounds, uint *mismatches);
+static void Worker(CreatorThread thread, void *context);
+
+int main(int argc, char **argv)
+{
+    uint rounds = DEFAULT_ROUNDS;
+    uint maxThreads = DEFAULT_MAX_THREADS;
+    int option;
+    while ((option = getopt(argc, argv, "n:t:")) != -1)
+    {
+        switch (option)
+        {
+            case 'n':
+                rounds = (uint)strtoul(optarg, NULL, 0);
+                break;
+            case 't':
+                maxThreads = (uint)strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-n rounds] [-t threads]\n", argv[0]);
+                return 1;
+        }
+    }
+    if ((rounds == 0) || (maxThreads == 0))
+    {
+        fprintf(stderr, "rounds and threads must be non-zero\n");
+        return 1;
+    }
+    CreatorThread_Initialise();
+    _ThreadErrorsLock = CreatorSemaphore_New(1, 0);
+    _ThreadErrors = CreatorList_New(10);
+    if (!_ThreadErrorsLock || !_ThreadErrors)
+        return 1;
+    fprintf(stderr, "%ld CPUs online\n", sysconf(_SC_NPROCESSORS_ONLN));
+    printf("implementation,threads,rounds_per_thread,seconds,calls_per_second,mismatches\n");
+    bool failed = false;
+    uint threads = 1;
+    while (true)
+    {
+        Variant variant;
+        for (variant = Variant_TLS; variant < Variant_Max; variant++)
+        {
+            uint mismatches = 0;
+            double seconds = RunVariant(variant, threads, rounds, &mismatches);
+            if (seconds < 0)
+                return 1;
+            // Three calls per round
+            printf("%s,%u,%u,%.4f,%.0f,%u\n", _VariantNames[variant], threads, rounds, seconds,
+                    3.0 * rounds * threads / seconds, mismatches);
+            fflush(stdout);
+            failed |= (mismatches > 0);
+        }
+        if (threads == maxThreads)
+            break;
+        threads = (threads * 2 < maxThreads) ? threads * 2 : maxThreads;
+    }
+    CreatorList_Free(&_ThreadErrors, true);
+    CreatorSemaphore_Free(&_ThreadErrorsLock);
+    CreatorThread_Shutdown();
+    return failed ? 1 : 0;
+}
+
+static double GetSeconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void ListClearLastError(void)
+{
+    pthread_t threadID = pthread_self();
+    CreatorSemaphore_Wait(_ThreadErrorsLock, 1);
+    uint index;
+    for (index = 0; index < CreatorList_GetCount(_ThreadErrors); index++)
+    {
+        ThreadError *threadError = CreatorList_GetItem(_ThreadErrors, index);
+        if (threadError && (threadError->ThreadID == threadID))
+        {
+            CreatorList_RemoveAt(_ThreadErrors, index);
+            Creator_MemFree((void **)&threadError);
+            break;
+        }
+    }
+    CreatorSemaphore_Release(_ThreadErrorsLock, 1);
+}
+
+static CreatorErrorType ListGetLastError(void)
+{
+    CreatorErrorType result = CreatorError_NoError;
+    pthread_t threadID = pthread_self();
+    CreatorSemaphore_Wait(_ThreadErrorsLock, 1);
+    uint index;
+    for (index = 0; index < CreatorList_GetCount(_ThreadErrors); index++)
+    {
+        ThreadError *threadError = CreatorList_GetItem(_ThreadErrors, index);
+        if (threadError && (threadError->ThreadID == threadID))
+        {
+            result = threadError->Error;
+            break;
+        }
+    }
+    CreatorSemaphore_Release(_ThreadErrorsLock, 1);
+    return result;
+}
+
+static void ListSetError(CreatorErrorType error)
+{
+    if (error == CreatorError_NoError)
+        ListClearLastError();
+    else
+    {
+        pthread_t threadID = pthread_self();
+        CreatorSemaphore_Wait(_ThreadErrorsLock, 1);
+        bool found = false;
+        uint index;
+        for (index = 0; index < CreatorList_GetCount(_ThreadErrors); index++)
+        {
+            ThreadError *threadError = CreatorList_GetItem(_ThreadErrors, index);
+            if (threadError && (threadError->ThreadID == threadID))
+            {
+                threadError->Error = error;
+                found = true;
+                break;
+            }
+        }
+        if (!found)
+        {
+            ThreadError *threadError = Creator_MemAlloc(sizeof(ThreadError));
+            if (threadError)
+            {
+                threadError->ThreadID = threadID;
+                threadError->Error = error;
+                CreatorList_Add(_ThreadErrors, threadError);
+            }
+        }
+        CreatorSemaphore_Release(_ThreadErrorsLock, 1);
+    }
+}
+
+static double RunVariant(Variant variant, uint threads, uint rounds, uint *mismatches)
+{
+    double result = -1;
+    Run run = { 0 };
+    run.Variant = variant;
+    run.Rounds = rounds;
+    CreatorThread *workers = (CreatorThread*)Creator_MemAlloc(sizeof(CreatorThread) * threads);
+    if (workers)
+    {
+        double start = GetSeconds();
+        uint index;
+        for (index = 0; index < threads; index++)
+            workers[index] = CreatorThread_New("bench", 0, 0, Worker, &run);
+        for (index = 0; index < threads; index++)
+        {
+            if (workers[index])
+                CreatorThread_Join(workers[index]);
+            else
+                fprintf(stderr, "%s: could not start thread %u\n", _VariantNames[variant], index);
+        }
+        result = GetSeconds() - start;
+        for (index = 0; index < threads; index++)
+            CreatorThread_Free(&workers[index]);
+        *mismatches = run.Mismatches;
+    }
+    Creator_MemFree((void **)&workers);
+    return result;
+}
+
+static void Worker(CreatorThread thread, void *context)
+{
+    (void)thread;
+    Run *run = (Run*)context;
+    uint number = __atomic_fetch_add(&run->NextThread, 1, __ATOMIC_RELAXED);
+    CreatorErrorType error = (CreatorErrorType)(1 + (number % ERROR_VALUE_COUNT));
+    uint mismatches = 0;
+    uint round;
+    for (round = 0; round < run->Rounds; round++)
+    {
+        CreatorErrorType lastError;
+        if (run->Variant == Variant_TLS)
+        {
+            CreatorThread_ClearLastError();
+            CreatorThread_SetError(error);
+            lastError = CreatorThread_GetLastError();
+        }
+        else
+        {
+            ListClearLastError();
+            ListSetError(error);
+            lastError = ListGetLastError();
+        }
+        if (lastError != error)
+            mismatches++;
+    }
+    if (run->Variant == Variant_List)
+        ListClearLastError();
+    __atomic_add_fetch(&run->Mismatches, mismatches, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,498 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+
+/*! \file mem_pool_bench.c
+ *  \brief Checks the size-class pool allocator and measures it against malloc from many threads at once.
+ *
+ * Usage: mem_pool_bench [options]
+ *   -n <operations>  operations per thread per run (default 1000000)
+ *   -t <threads>     largest number of threads; 1, 2, 4, ... up to this are run (default 8)
+ *   -s <size>        largest block requested, above MEMPOOL_MAX_BLOCK_SIZE mixes in heap blocks (default 256)
+ *   -w <blocks>      blocks each thread keeps live (default 64)
+ *
+ * The pool is checked first, failures are reported on stderr and make the exit code 1:
+ *   sizes        every size up to MEMPOOL_MAX_BLOCK_SIZE + 64: block size, alignment, tag, calloc
+ *   realloc      growing and shrinking within a class, between classes, to and from the heap, contents and tag kept
+ *   double free  one thread per size class frees a block twice; the second free must be ignored, so the next two
+ *                allocations of the class are distinct. Each thread owns its class, as a double free can only be
+ *                caught before the block is handed out again.
+ *
+ * Then the same workload is run on mem_pool and malloc. Each operation picks one block of the thread's window and
+ * frees it and allocates a new one of random size (6 in 8), reallocs it to a random size (1 in 8) or swaps it with a
+ * block left by another thread (1 in 8), so blocks are freed by other threads too. Every block carries its size and
+ * a check byte, verified on each touch; bad blocks are counted as mismatches.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mem_pool.h"
+
+#define DEFAULT_OPERATIONS      (1000000)
+#define DEFAULT_MAX_THREADS     (8)
+#define DEFAULT_WINDOW          (64)
+#define DOUBLE_FREE_ROUNDS      (100000)
+#define MAX_CLASSES             (MEMPOOL_MAX_BLOCK_SIZE / 8)
+#define MIN_BLOCK_SIZE          (sizeof(uint32_t) + 1)
+#define SHARED_SLOTS            (64)
+
+typedef struct
+{
+    const char *Name;
+    void *(*Alloc)(size_t size);
+    void (*Free)(void *block);
+    void *(*Realloc)(void *block, size_t size);
+} Allocator;
+
+typedef struct
+{
+    pthread_t Thread;
+    const Allocator *Allocator;
+    size_t Size;                // largest block (stress), class size (double free)
+    unsigned Operations;
+    unsigned Window;
+    unsigned Seed;
+    unsigned Mismatches;
+} Worker;
+
+static const Allocator _Allocators[] =
+{
+    { "mem_pool", MemPool_Alloc, MemPool_Free, MemPool_Realloc },
+    { "malloc", malloc, free, realloc },
+};
+
+#define ALLOCATOR_COUNT         (sizeof(_Allocators) / sizeof(_Allocators[0]))
+
+static void *_Shared[SHARED_SLOTS];
+
+static size_t CheckBlock(void *block, size_t maxSize);
+static unsigned CheckPool(void);
+static unsigned CheckRealloc(size_t fromSize, size_t toSize);
+static void *DoubleFreeWorker(void *context);
+static void FillBlock(void *block, size_t size);
+static unsigned GetClassSizes(size_t *classSizes);
+static double GetSeconds(void);
+static unsigned NextRandom(unsigned *seed);
+static double RunAllocator(const Allocator *allocator, unsigned threads, unsigned operations, unsigned window,
+        size_t maxSize, unsigned *mismatches);
+static unsigned RunDoubleFree(const size_t *classSizes, unsigned classCount);
+static void *StressWorker(void *context);
+
+int main(int argc, char **argv)
+{
+    unsigned operations = DEFAULT_OPERATIONS;
+    unsigned maxThreads = DEFAULT_MAX_THREADS;
+    unsigned window = DEFAULT_WINDOW;
+    size_t maxSize = MEMPOOL_MAX_BLOCK_SIZE;
+    int option;
+    while ((option = getopt(argc, argv, "n:t:s:w:")) != -1)
+    {
+        switch (option)
+        {
+            case 'n':
+                operations = (unsigned)strtoul(optarg, NULL, 0);
+                break;
+            case 't':
+                maxThreads = (unsigned)strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                maxSize = (size_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'w':
+                window = (unsigned)strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-n operations] [-t threads] [-s size] [-w blocks]\n", argv[0]);
+                return 1;
+        }
+    }
+    if ((operations == 0) || (maxThreads == 0) || (window == 0) || (maxSize < MIN_BLOCK_SIZE))
+    {
+        fprintf(stderr, "operations, threads and blocks must be non-zero, size at least %u\n", (unsigned)MIN_BLOCK_SIZE);
+        return 1;
+    }
+    fprintf(stderr, "%ld CPUs online\n", sysconf(_SC_NPROCESSORS_ONLN));
+
+    size_t classSizes[MAX_CLASSES];
+    unsigned classCount = GetClassSizes(classSizes);
+    unsigned failures = CheckPool();
+    fprintf(stderr, "size and realloc checks: %u failures\n", failures);
+    unsigned doubleFreeFailures = RunDoubleFree(classSizes, classCount);
+    fprintf(stderr, "double free: %u classes x %u rounds, %u failures\n", classCount, DOUBLE_FREE_ROUNDS,
+            doubleFreeFailures);
+    bool failed = (failures > 0) || (doubleFreeFailures > 0);
+
+    printf("allocator,threads,operations_per_thread,max_size,seconds,operations_per_second,mismatches\n");
+    unsigned threads = 1;
+    while (true)
+    {
+        unsigned index;
+        for (index = 0; index < ALLOCATOR_COUNT; index++)
+        {
+            unsigned mismatches = 0;
+            double seconds = RunAllocator(&_Allocators[index], threads, operations, window, maxSize, &mismatches);
+            if (seconds < 0)
+                return 1;
+            printf("%s,%u,%u,%u,%.4f,%.0f,%u\n", _Allocators[index].Name, threads, operations, (unsigned)maxSize,
+                    seconds, (double)operations * threads / seconds, mismatches);
+            fflush(stdout);
+            failed |= (mismatches > 0);
+        }
+        if (threads == maxThreads)
+            break;
+        threads = (threads * 2 < maxThreads) ? threads * 2 : maxThreads;
+    }
+    return failed ? 1 : 0;
+}
+
+static size_t CheckBlock(void *block, size_t maxSize)
+{
+    // Returns the block's size, or 0 if it has been overwritten
+    uint32_t size;
+    memcpy(&size, block, sizeof(size));
+    if ((size < MIN_BLOCK_SIZE) || (size > maxSize) || (((uint8_t *)block)[size - 1] != (uint8_t)(size * 31 + 7)))
+        return 0;
+    return size;
+}
+
+static unsigned CheckPool(void)
+{
+    unsigned failures = 0;
+    size_t size;
+    for (size = 0; size <= MEMPOOL_MAX_BLOCK_SIZE + 64; size++)
+    {
+        uint8_t *block = (uint8_t *)MemPool_Alloc(size);
+        if (!block)
+        {
+            fprintf(stderr, "alloc %u: failed\n", (unsigned)size);
+            failures++;
+            continue;
+        }
+        size_t blockSize = MemPool_GetBlockSize(block);
+        if ((((uintptr_t)block & 7) != 0) || (MemPool_GetSize(block) != size) || (blockSize < size) ||
+                ((size > MEMPOOL_MAX_BLOCK_SIZE) && (blockSize != size)))
+        {
+            fprintf(stderr, "alloc %u: block %p, size %u, block size %u\n", (unsigned)size, block,
+                    (unsigned)MemPool_GetSize(block), (unsigned)blockSize);
+            failures++;
+        }
+        memset(block, 0xA5, blockSize);
+        MemPool_SetTag(block, (unsigned char)size);
+        if (MemPool_GetTag(block) != (unsigned char)size)
+        {
+            fprintf(stderr, "alloc %u: tag not kept\n", (unsigned)size);
+            failures++;
+        }
+        MemPool_Free(block);
+        // Pool blocks are never given back to the heap, so the freed header can still be read
+        if ((size <= MEMPOOL_MAX_BLOCK_SIZE) && (MemPool_GetSize(block) != 0))
+        {
+            fprintf(stderr, "alloc %u: freed block still valid\n", (unsigned)size);
+            failures++;
+        }
+
+        block = (uint8_t *)MemPool_Calloc(1, size);
+        size_t index;
+        for (index = 0; block && (index < size); index++)
+        {
+            if (block[index] != 0)
+            {
+                fprintf(stderr, "calloc %u: byte %u not zero\n", (unsigned)size, (unsigned)index);
+                failures++;
+                break;
+            }
+        }
+        MemPool_Free(block);
+    }
+    if (MemPool_Calloc(SIZE_MAX / 2, 4))
+    {
+        fprintf(stderr, "calloc: overflow not rejected\n");
+        failures++;
+    }
+    MemPool_Free(NULL);
+    if ((MemPool_GetSize(NULL) != 0) || (MemPool_GetBlockSize(NULL) != 0))
+    {
+        fprintf(stderr, "NULL block has a size\n");
+        failures++;
+    }
+
+    // Within a class, class to class, to and within the heap, and back
+    static const size_t transitions[][2] = { { 0, 10 }, { 10, 16 }, { 16, 12 }, { 12, 100 }, { 100, 20 }, { 20, 300 },
+            { 300, 600 }, { 600, 400 }, { 400, 40 }, { 256, 257 }, { 257, 256 }, { 40, 0 } };
+    unsigned index;
+    for (index = 0; index < sizeof(transitions) / sizeof(transitions[0]); index++)
+        failures += CheckRealloc(transitions[index][0], transitions[index][1]);
+    return failures;
+}
+
+static unsigned CheckRealloc(size_t fromSize, size_t toSize)
+{
+    // fromSize 0 starts from NULL
+    unsigned failures = 0;
+    uint8_t *block = NULL;
+    size_t index;
+    if (fromSize > 0)
+    {
+        block = (uint8_t *)MemPool_Alloc(fromSize);
+        if (!block)
+            return 1;
+        for (index = 0; index < fromSize; index++)
+            block[index] = (uint8_t)(index * 7 + 1);
+        MemPool_SetTag(block, 0x5A);
+    }
+    bool sameClass = block && (fromSize <= MEMPOOL_MAX_BLOCK_SIZE) && (toSize <= MemPool_GetBlockSize(block));
+    uint8_t *result = (uint8_t *)MemPool_Realloc(block, toSize);
+    if (!result)
+    {
+        fprintf(stderr, "realloc %u to %u: failed\n", (unsigned)fromSize, (unsigned)toSize);
+        MemPool_Free(block);
+        return 1;
+    }
+    if ((MemPool_GetSize(result) != toSize) || (sameClass && (result != block)) ||
+            (block && (MemPool_GetTag(result) != 0x5A)))
+    {
+        fprintf(stderr, "realloc %u to %u: size %u, %s block, tag %02x\n", (unsigned)fromSize, (unsigned)toSize,
+                (unsigned)MemPool_GetSize(result), (result == block) ? "same" : "new", MemPool_GetTag(result));
+        failures++;
+    }
+    for (index = 0; (index < fromSize) && (index < toSize); index++)
+    {
+        if (result[index] != (uint8_t)(index * 7 + 1))
+        {
+            fprintf(stderr, "realloc %u to %u: byte %u not kept\n", (unsigned)fromSize, (unsigned)toSize, (unsigned)index);
+            failures++;
+            break;
+        }
+    }
+    MemPool_Free(result);
+    return failures;
+}
+
+static void *DoubleFreeWorker(void *context)
+{
+    Worker *worker = (Worker *)context;
+    unsigned round;
+    for (round = 0; round < worker->Operations; round++)
+    {
+        void *first = MemPool_Alloc(worker->Size);
+        void *second = MemPool_Alloc(worker->Size);
+        MemPool_Free(first);
+        MemPool_Free(first);
+        // Had the second free pushed the block again, it would be handed out twice
+        void *third = MemPool_Alloc(worker->Size);
+        void *fourth = MemPool_Alloc(worker->Size);
+        if (!first || !second || !third || !fourth || (third == fourth) || (third == second) || (fourth == second))
+            worker->Mismatches++;
+        MemPool_Free(second);
+        MemPool_Free(third);
+        MemPool_Free(fourth);
+    }
+    return NULL;
+}
+
+static void FillBlock(void *block, size_t size)
+{
+    uint32_t storedSize = (uint32_t)size;
+    memcpy(block, &storedSize, sizeof(storedSize));
+    ((uint8_t *)block)[size - 1] = (uint8_t)(size * 31 + 7);
+}
+
+static unsigned GetClassSizes(size_t *classSizes)
+{
+    unsigned result = 0;
+    size_t size;
+    for (size = 1; size <= MEMPOOL_MAX_BLOCK_SIZE; size++)
+    {
+        void *block = MemPool_Alloc(size);
+        size_t blockSize = MemPool_GetBlockSize(block);
+        if ((blockSize > 0) && ((result == 0) || (classSizes[result - 1] != blockSize)) && (result < MAX_CLASSES))
+            classSizes[result++] = blockSize;
+        MemPool_Free(block);
+    }
+    return result;
+}
+
+static double GetSeconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static unsigned NextRandom(unsigned *seed)
+{
+    // xorshift32, cheap enough not to hide the allocator
+    unsigned value = *seed;
+    value ^= value << 13;
+    value ^= value >> 17;
+    value ^= value << 5;
+    *seed = value;
+    return value;
+}
+
+static double RunAllocator(const Allocator *allocator, unsigned threads, unsigned operations, unsigned window,
+        size_t maxSize, unsigned *mismatches)
+{
+    Worker *workers = (Worker *)calloc(threads, sizeof(Worker));
+    if (!workers)
+        return -1;
+    unsigned index;
+    unsigned started = 0;
+    double start = GetSeconds();
+    for (index = 0; index < threads; index++)
+    {
+        workers[index].Allocator = allocator;
+        workers[index].Size = maxSize;
+        workers[index].Operations = operations;
+        workers[index].Window = window;
+        workers[index].Seed = 2654435761u * (index + 1);
+        if (pthread_create(&workers[index].Thread, NULL, StressWorker, &workers[index]) != 0)
+            break;
+        started++;
+    }
+    for (index = 0; index < started; index++)
+    {
+        pthread_join(workers[index].Thread, NULL);
+        *mismatches += workers[index].Mismatches;
+    }
+    double seconds = GetSeconds() - start;
+    // Blocks still waiting to be swapped belong to no thread
+    for (index = 0; index < SHARED_SLOTS; index++)
+    {
+        if (_Shared[index])
+        {
+            if (!CheckBlock(_Shared[index], maxSize))
+                (*mismatches)++;
+            allocator->Free(_Shared[index]);
+            _Shared[index] = NULL;
+        }
+    }
+    free(workers);
+    return (started == threads) ? seconds : -1;
+}
+
+static unsigned RunDoubleFree(const size_t *classSizes, unsigned classCount)
+{
+    unsigned failures = 0;
+    Worker workers[MAX_CLASSES];
+    unsigned index;
+    unsigned started = 0;
+    memset(workers, 0, sizeof(workers));
+    for (index = 0; index < classCount; index++)
+    {
+        workers[index].Size = classSizes[index];
+        workers[index].Operations = DOUBLE_FREE_ROUNDS;
+        if (pthread_create(&workers[index].Thread, NULL, DoubleFreeWorker, &workers[index]) != 0)
+            break;
+        started++;
+    }
+    for (index = 0; index < started; index++)
+    {
+        pthread_join(workers[index].Thread, NULL);
+        if (workers[index].Mismatches > 0)
+            fprintf(stderr, "double free %u: %u rounds failed\n", (unsigned)workers[index].Size, workers[index].Mismatches);
+        failures += workers[index].Mismatches;
+    }
+    return failures + (classCount - started);
+}
+
+static void *StressWorker(void *context)
+{
+    Worker *worker = (Worker *)context;
+    const Allocator *allocator = worker->Allocator;
+    size_t sizeRange = worker->Size - MIN_BLOCK_SIZE + 1;
+    void **blocks = (void **)calloc(worker->Window, sizeof(void *));
+    if (!blocks)
+    {
+        worker->Mismatches++;
+        return NULL;
+    }
+    unsigned seed = worker->Seed;
+    unsigned operation;
+    for (operation = 0; operation < worker->Operations; operation++)
+    {
+        void **slot = &blocks[NextRandom(&seed) % worker->Window];
+        unsigned action = NextRandom(&seed) % 8;
+        size_t size = MIN_BLOCK_SIZE + (NextRandom(&seed) % sizeRange);
+        size_t oldSize = 0;
+        if (*slot)
+        {
+            oldSize = CheckBlock(*slot, worker->Size);
+            if (oldSize == 0)
+            {
+                // Don't hand a damaged block back to the allocator
+                worker->Mismatches++;
+                *slot = NULL;
+            }
+        }
+        if (*slot && (action == 0))
+        {
+            *slot = __atomic_exchange_n(&_Shared[NextRandom(&seed) % SHARED_SLOTS], *slot, __ATOMIC_ACQ_REL);
+        }
+        else if (*slot && (action == 1))
+        {
+            uint8_t *block = (uint8_t *)allocator->Realloc(*slot, size);
+            if (block)
+            {
+                // The stored size must survive, and the check byte too unless it was cut off
+                uint32_t storedSize;
+                memcpy(&storedSize, block, sizeof(storedSize));
+                if ((storedSize != oldSize) || ((size >= oldSize) && (CheckBlock(block, worker->Size) != oldSize)))
+                    worker->Mismatches++;
+                FillBlock(block, size);
+                *slot = block;
+            }
+            else
+            {
+                worker->Mismatches++;
+            }
+        }
+        else
+        {
+            if (*slot)
+                allocator->Free(*slot);
+            *slot = allocator->Alloc(size);
+            if (*slot)
+                FillBlock(*slot, size);
+            else
+                worker->Mismatches++;
+        }
+    }
+    unsigned index;
+    for (index = 0; index < worker->Window; index++)
+    {
+        if (blocks[index])
+        {
+            if (!CheckBlock(blocks[index], worker->Size))
+                worker->Mismatches++;
+            allocator->Free(blocks[index]);
+        }
+    }
+    free(blocks);
+    return NULL;
+}
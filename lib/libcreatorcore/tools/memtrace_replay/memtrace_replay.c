@@ -0,0 +1,852 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+
+/*! \file memtrace_replay.c
+ *  \brief Replays a CREATOR_MEMALLOC_TRACE capture against allocator models to study heap fragmentation off-target.
+ *
+ * Usage: memtrace_replay [options] <trace file>
+ *   -a <allocator>   malloc (host libc), heap (first-fit, address-ordered, coalescing heap like the device libc
+ *                    malloc used by FreeRTOS heap_3), pool (the libcreatorcore size-class pool on top of heap) or all.
+ *                    Default all.
+ *   -s <bytes>       size of the modelled heap (default 459000, the firmware linker heap)
+ *   -i <events>      print a CSV sample every <events> events (single allocator only, default 0 = summary only)
+ *   -x               trace is a console dump ("MT " followed by 40 hex digits per record) instead of binary
+ *
+ * A binary trace is the concatenation of everything Creator_MemTraceDrain handed to its writer.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "creator/core/creator_memalloc.h"
+
+typedef char RecordSizeCheck[(sizeof(CreatorMemTraceRecord) == 20) ? 1 : -1];
+
+#define DEFAULT_HEAP_SIZE       (459000)
+
+#define HEAP_ALIGNMENT          (8)
+#define HEAP_HEADER_SIZE        (8)
+#define HEAP_MINIMUM_BLOCK      (16)
+
+#define POOL_HEADER_SIZE        (8)
+#define POOL_SLAB_SIZE          (1024)
+#define POOL_MAX_BLOCK_SIZE     (256)
+#define POOL_CLASS_COUNT        (8)
+#define POOL_CLASS_HANDLE       (UINT64_C(1) << 63)
+
+typedef struct
+{
+    size_t Footprint;           // bytes of the heap in use or ever used (high-water mark for heap models)
+    size_t FreeBytes;
+    size_t LargestFree;         // 0 if the allocator cannot tell
+} HeapStatistics;
+
+/*
+ * Allocator model. Handles are opaque and never 0; Alloc and Realloc return 0 when out of memory.
+ */
+typedef struct
+{
+    const char *Name;
+    bool (*Initialise)(size_t heapSize);
+    uint64_t (*Alloc)(size_t size);
+    void (*Free)(uint64_t handle);
+    uint64_t (*Realloc)(uint64_t handle, size_t oldSize, size_t size);
+    void (*GetStatistics)(HeapStatistics *statistics);
+    void (*Shutdown)(void);
+} Allocator;
+
+typedef struct
+{
+    uint64_t EventCount;
+    size_t LiveBytes;
+    size_t PeakLiveBytes;
+    size_t PeakFootprint;
+    size_t MinLargestFree;
+    double MaxFragmentation;
+    uint64_t ModelFailures;     // allocations the device served but the model could not
+    uint64_t DeviceFailures;    // allocations that failed on the device
+    uint64_t UnknownFrees;      // frees of blocks allocated before the trace started
+    uint64_t DroppedRecords;
+} ReplayResult;
+
+
+//
+// Live block map: trace address -> model handle and requested size (open addressing)
+//
+
+typedef struct
+{
+    uint32_t Address;
+    bool Used;
+    bool Deleted;
+    uint64_t Handle;
+    size_t Size;
+} LiveBlock;
+
+static LiveBlock *_Blocks = NULL;
+static size_t _BlockCapacity = 0;
+static size_t _BlockCount = 0;
+static size_t _BlockDeleted = 0;
+
+static LiveBlock *FindBlock(uint32_t address, bool forInsert)
+{
+    size_t mask = _BlockCapacity - 1;
+    size_t index = (address * 2654435761u) & mask;
+    LiveBlock *firstDeleted = NULL;
+    while (true)
+    {
+        LiveBlock *block = &_Blocks[index];
+        if (!block->Used)
+        {
+            if (block->Deleted)
+            {
+                if (!firstDeleted)
+                    firstDeleted = block;
+            }
+            else
+                return forInsert ? (firstDeleted ? firstDeleted : block) : NULL;
+        }
+        else if (block->Address == address)
+        {
+            return block;
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+static void ResizeBlocks(size_t capacity)
+{
+    LiveBlock *oldBlocks = _Blocks;
+    size_t oldCapacity = _BlockCapacity;
+    _Blocks = calloc(capacity, sizeof(LiveBlock));
+    if (!_Blocks)
+    {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    _BlockCapacity = capacity;
+    _BlockDeleted = 0;
+    size_t index;
+    for (index = 0; index < oldCapacity; index++)
+    {
+        if (oldBlocks[index].Used)
+            *FindBlock(oldBlocks[index].Address, true) = oldBlocks[index];
+    }
+    free(oldBlocks);
+}
+
+static void PutBlock(uint32_t address, uint64_t handle, size_t size)
+{
+    if ((_BlockCount + _BlockDeleted + 1) * 4 > _BlockCapacity * 3)
+        ResizeBlocks((_BlockCount * 2 > _BlockCapacity) ? _BlockCapacity * 2 : _BlockCapacity);
+    LiveBlock *block = FindBlock(address, false);
+    if (!block)
+    {
+        block = FindBlock(address, true);
+        if (block->Deleted)
+            _BlockDeleted--;
+        _BlockCount++;
+    }
+    block->Address = address;
+    block->Used = true;
+    block->Deleted = false;
+    block->Handle = handle;
+    block->Size = size;
+}
+
+static void RemoveBlock(LiveBlock *block)
+{
+    block->Used = false;
+    block->Deleted = true;
+    _BlockCount--;
+    _BlockDeleted++;
+}
+
+
+//
+// System malloc
+//
+
+static size_t _MallocLive = 0;
+
+static bool Malloc_Initialise(size_t heapSize)
+{
+    (void)heapSize;
+    _MallocLive = 0;
+    return true;
+}
+
+static uint64_t Malloc_Alloc(size_t size)
+{
+    return (uint64_t)(uintptr_t)malloc(size ? size : 1);
+}
+
+static void Malloc_Free(uint64_t handle)
+{
+    free((void *)(uintptr_t)handle);
+}
+
+static uint64_t Malloc_Realloc(uint64_t handle, size_t oldSize, size_t size)
+{
+    (void)oldSize;
+    return (uint64_t)(uintptr_t)realloc((void *)(uintptr_t)handle, size ? size : 1);
+}
+
+static void Malloc_GetStatistics(HeapStatistics *statistics)
+{
+    memset(statistics, 0, sizeof(*statistics));
+#ifdef __GLIBC__
+#if (__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+#else
+    struct mallinfo info = mallinfo();
+#endif
+    statistics->Footprint = info.arena + info.hblkhd;
+    statistics->FreeBytes = info.fordblks;
+#endif
+}
+
+static void Malloc_Shutdown(void)
+{
+}
+
+
+//
+// Heap model: first-fit over an address-ordered free list, coalescing on free
+//
+
+typedef struct
+{
+    size_t Offset;
+    size_t Size;
+} FreeRange;
+
+static FreeRange *_FreeRanges = NULL;
+static size_t _FreeRangeCount = 0;
+static size_t _FreeRangeCapacity = 0;
+static size_t _HeapSize = 0;
+static size_t _HeapHighWater = 0;
+static size_t _HeapUsed = 0;
+
+// Handles are offset + 1 so that offset 0 is a valid block; the block size is kept in a header in front of the payload
+static size_t *_BlockSizes = NULL;      // indexed by offset / HEAP_ALIGNMENT
+
+static size_t HeapBlockSize(size_t size)
+{
+    size_t result = (size + HEAP_HEADER_SIZE + HEAP_ALIGNMENT - 1) & ~(size_t)(HEAP_ALIGNMENT - 1);
+    return (result < HEAP_MINIMUM_BLOCK) ? HEAP_MINIMUM_BLOCK : result;
+}
+
+static void InsertFreeRange(size_t index, size_t offset, size_t size)
+{
+    if (_FreeRangeCount == _FreeRangeCapacity)
+    {
+        _FreeRangeCapacity = _FreeRangeCapacity ? _FreeRangeCapacity * 2 : 64;
+        _FreeRanges = realloc(_FreeRanges, _FreeRangeCapacity * sizeof(FreeRange));
+        if (!_FreeRanges)
+        {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+    memmove(&_FreeRanges[index + 1], &_FreeRanges[index], (_FreeRangeCount - index) * sizeof(FreeRange));
+    _FreeRanges[index].Offset = offset;
+    _FreeRanges[index].Size = size;
+    _FreeRangeCount++;
+}
+
+static void RemoveFreeRange(size_t index)
+{
+    _FreeRangeCount--;
+    memmove(&_FreeRanges[index], &_FreeRanges[index + 1], (_FreeRangeCount - index) * sizeof(FreeRange));
+}
+
+static bool Heap_Initialise(size_t heapSize)
+{
+    _HeapSize = heapSize & ~(size_t)(HEAP_ALIGNMENT - 1);
+    _HeapHighWater = 0;
+    _HeapUsed = 0;
+    _FreeRangeCount = 0;
+    _BlockSizes = calloc(_HeapSize / HEAP_ALIGNMENT, sizeof(size_t));
+    if (!_BlockSizes)
+        return false;
+    InsertFreeRange(0, 0, _HeapSize);
+    return true;
+}
+
+static uint64_t Heap_Alloc(size_t size)
+{
+    size_t blockSize = HeapBlockSize(size);
+    size_t index;
+    for (index = 0; index < _FreeRangeCount; index++)
+    {
+        FreeRange *range = &_FreeRanges[index];
+        if (range->Size >= blockSize)
+        {
+            size_t offset = range->Offset;
+            // split unless the remainder is too small to be a block of its own
+            if (range->Size - blockSize >= HEAP_MINIMUM_BLOCK)
+            {
+                range->Offset += blockSize;
+                range->Size -= blockSize;
+            }
+            else
+            {
+                blockSize = range->Size;
+                RemoveFreeRange(index);
+            }
+            _BlockSizes[offset / HEAP_ALIGNMENT] = blockSize;
+            _HeapUsed += blockSize;
+            if (offset + blockSize > _HeapHighWater)
+                _HeapHighWater = offset + blockSize;
+            return offset + 1;
+        }
+    }
+    return 0;
+}
+
+static void Heap_Free(uint64_t handle)
+{
+    size_t offset = (size_t)(handle - 1);
+    size_t size = _BlockSizes[offset / HEAP_ALIGNMENT];
+    _HeapUsed -= size;
+
+    // binary search for the first free range after the block
+    size_t low = 0, high = _FreeRangeCount;
+    while (low < high)
+    {
+        size_t middle = (low + high) / 2;
+        if (_FreeRanges[middle].Offset < offset)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    bool mergePrevious = (low > 0) && (_FreeRanges[low - 1].Offset + _FreeRanges[low - 1].Size == offset);
+    bool mergeNext = (low < _FreeRangeCount) && (offset + size == _FreeRanges[low].Offset);
+    if (mergePrevious && mergeNext)
+    {
+        _FreeRanges[low - 1].Size += size + _FreeRanges[low].Size;
+        RemoveFreeRange(low);
+    }
+    else if (mergePrevious)
+    {
+        _FreeRanges[low - 1].Size += size;
+    }
+    else if (mergeNext)
+    {
+        _FreeRanges[low].Offset = offset;
+        _FreeRanges[low].Size += size;
+    }
+    else
+    {
+        InsertFreeRange(low, offset, size);
+    }
+}
+
+static uint64_t Heap_Realloc(uint64_t handle, size_t oldSize, size_t size)
+{
+    size_t offset = (size_t)(handle - 1);
+    size_t blockSize = _BlockSizes[offset / HEAP_ALIGNMENT];
+    size_t newBlockSize = HeapBlockSize(size);
+    if (newBlockSize <= blockSize)
+    {
+        // shrink in place, returning the tail if it can stand as a block
+        if (blockSize - newBlockSize >= HEAP_MINIMUM_BLOCK)
+        {
+            _BlockSizes[offset / HEAP_ALIGNMENT] = newBlockSize;
+            _BlockSizes[(offset + newBlockSize) / HEAP_ALIGNMENT] = blockSize - newBlockSize;
+            _HeapUsed += blockSize - newBlockSize;      // Heap_Free subtracts it again
+            Heap_Free(offset + newBlockSize + 1);
+            _HeapUsed -= blockSize - newBlockSize;
+        }
+        return handle;
+    }
+    // grow in place into a directly following free range
+    size_t index;
+    for (index = 0; index < _FreeRangeCount; index++)
+    {
+        FreeRange *range = &_FreeRanges[index];
+        if (range->Offset > offset + blockSize)
+            break;
+        if ((range->Offset == offset + blockSize) && (blockSize + range->Size >= newBlockSize))
+        {
+            size_t extra = newBlockSize - blockSize;
+            if (range->Size - extra >= HEAP_MINIMUM_BLOCK)
+            {
+                range->Offset += extra;
+                range->Size -= extra;
+            }
+            else
+            {
+                extra = range->Size;
+                RemoveFreeRange(index);
+            }
+            _BlockSizes[offset / HEAP_ALIGNMENT] = blockSize + extra;
+            _HeapUsed += extra;
+            if (offset + blockSize + extra > _HeapHighWater)
+                _HeapHighWater = offset + blockSize + extra;
+            return handle;
+        }
+    }
+    (void)oldSize;
+    uint64_t result = Heap_Alloc(size);
+    if (result)
+        Heap_Free(handle);
+    return result;
+}
+
+static void Heap_GetStatistics(HeapStatistics *statistics)
+{
+    size_t index;
+    statistics->Footprint = _HeapHighWater;
+    statistics->FreeBytes = _HeapSize - _HeapUsed;
+    statistics->LargestFree = 0;
+    for (index = 0; index < _FreeRangeCount; index++)
+    {
+        if (_FreeRanges[index].Size > statistics->LargestFree)
+            statistics->LargestFree = _FreeRanges[index].Size;
+    }
+}
+
+static void Heap_Shutdown(void)
+{
+    free(_FreeRanges);
+    _FreeRanges = NULL;
+    _FreeRangeCapacity = 0;
+    _FreeRangeCount = 0;
+    free(_BlockSizes);
+    _BlockSizes = NULL;
+}
+
+
+//
+// Pool model: size classes carved from never-returned slabs, large blocks from the heap model (see mem_pool.c)
+//
+
+static const size_t _ClassSizes[POOL_CLASS_COUNT] = { 16, 32, 48, 64, 96, 128, 192, 256 };
+static size_t _ClassFree[POOL_CLASS_COUNT];
+
+static int PoolClass(size_t size)
+{
+    int result;
+    for (result = 0; result < POOL_CLASS_COUNT; result++)
+    {
+        if (size <= _ClassSizes[result])
+            return result;
+    }
+    return -1;
+}
+
+static bool Pool_Initialise(size_t heapSize)
+{
+    memset(_ClassFree, 0, sizeof(_ClassFree));
+    return Heap_Initialise(heapSize);
+}
+
+static uint64_t Pool_Alloc(size_t size)
+{
+    int sizeClass = PoolClass(size);
+    if (sizeClass < 0)
+    {
+        uint64_t handle = Heap_Alloc(POOL_HEADER_SIZE + size);
+        return handle;
+    }
+    if (_ClassFree[sizeClass] == 0)
+    {
+        size_t blockSize = POOL_HEADER_SIZE + _ClassSizes[sizeClass];
+        size_t blockCount = POOL_SLAB_SIZE / blockSize;
+        if (!Heap_Alloc(blockSize * blockCount))
+            return 0;
+        _ClassFree[sizeClass] = blockCount;
+    }
+    _ClassFree[sizeClass]--;
+    return POOL_CLASS_HANDLE | (uint64_t)sizeClass;
+}
+
+static void Pool_Free(uint64_t handle)
+{
+    if (handle & POOL_CLASS_HANDLE)
+        _ClassFree[handle & ~POOL_CLASS_HANDLE]++;
+    else
+        Heap_Free(handle);
+}
+
+static uint64_t Pool_Realloc(uint64_t handle, size_t oldSize, size_t size)
+{
+    (void)oldSize;
+    if ((handle & POOL_CLASS_HANDLE) && (size <= _ClassSizes[handle & ~POOL_CLASS_HANDLE]))
+        return handle;
+    if (!(handle & POOL_CLASS_HANDLE) && (size > POOL_MAX_BLOCK_SIZE))
+        return Heap_Realloc(handle, oldSize, POOL_HEADER_SIZE + size);
+    uint64_t result = Pool_Alloc(size);
+    if (result)
+        Pool_Free(handle);
+    return result;
+}
+
+static void Pool_GetStatistics(HeapStatistics *statistics)
+{
+    Heap_GetStatistics(statistics);
+}
+
+
+static const Allocator _Allocators[] =
+{
+    { "malloc", Malloc_Initialise, Malloc_Alloc, Malloc_Free, Malloc_Realloc, Malloc_GetStatistics, Malloc_Shutdown },
+    { "heap", Heap_Initialise, Heap_Alloc, Heap_Free, Heap_Realloc, Heap_GetStatistics, Heap_Shutdown },
+    { "pool", Pool_Initialise, Pool_Alloc, Pool_Free, Pool_Realloc, Pool_GetStatistics, Heap_Shutdown },
+};
+
+#define ALLOCATOR_COUNT (sizeof(_Allocators) / sizeof(_Allocators[0]))
+
+
+//
+// Trace loading
+//
+
+static int HexDigit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+static CreatorMemTraceRecord *LoadTrace(const char *path, bool hex, size_t *count)
+{
+    FILE *file = fopen(path, hex ? "r" : "rb");
+    if (!file)
+    {
+        perror(path);
+        return NULL;
+    }
+    size_t capacity = 4096;
+    CreatorMemTraceRecord *records = malloc(capacity * sizeof(CreatorMemTraceRecord));
+    *count = 0;
+    while (records)
+    {
+        if (*count == capacity)
+        {
+            capacity *= 2;
+            records = realloc(records, capacity * sizeof(CreatorMemTraceRecord));
+            if (!records)
+                break;
+        }
+        if (hex)
+        {
+            char line[256];
+            if (!fgets(line, sizeof(line), file))
+                break;
+            const char *text = strstr(line, "MT ");
+            if (!text)
+                continue;
+            text += 3;
+            uint8_t *bytes = (uint8_t *)&records[*count];
+            size_t index;
+            for (index = 0; index < sizeof(CreatorMemTraceRecord); index++)
+            {
+                int high = HexDigit(text[index * 2]);
+                int low = (high < 0) ? -1 : HexDigit(text[index * 2 + 1]);
+                if (low < 0)
+                    break;
+                bytes[index] = (uint8_t)((high << 4) | low);
+            }
+            if (index == sizeof(CreatorMemTraceRecord))
+                (*count)++;
+        }
+        else
+        {
+            if (fread(&records[*count], sizeof(CreatorMemTraceRecord), 1, file) != 1)
+                break;
+            (*count)++;
+        }
+    }
+    fclose(file);
+    if (!records)
+        fprintf(stderr, "out of memory\n");
+    return records;
+}
+
+
+//
+// Replay
+//
+
+static void Sample(const Allocator *allocator, ReplayResult *result, bool print, uint32_t timestamp)
+{
+    HeapStatistics statistics;
+    allocator->GetStatistics(&statistics);
+    double fragmentation = 0.0;
+    if (statistics.LargestFree && statistics.FreeBytes)
+        fragmentation = 1.0 - ((double)statistics.LargestFree / (double)statistics.FreeBytes);
+    if (statistics.Footprint > result->PeakFootprint)
+        result->PeakFootprint = statistics.Footprint;
+    if (statistics.LargestFree && (statistics.LargestFree < result->MinLargestFree))
+        result->MinLargestFree = statistics.LargestFree;
+    if (fragmentation > result->MaxFragmentation)
+        result->MaxFragmentation = fragmentation;
+    if (print)
+    {
+        printf("%llu,%u,%zu,%zu,%zu,%zu,%.4f\n", (unsigned long long)result->EventCount, timestamp, result->LiveBytes,
+                statistics.Footprint, statistics.FreeBytes, statistics.LargestFree, fragmentation);
+    }
+}
+
+static void TrackAlloc(const Allocator *allocator, ReplayResult *result, uint32_t address, size_t size)
+{
+    uint64_t handle = allocator->Alloc(size);
+    if (handle)
+    {
+        PutBlock(address, handle, size);
+        result->LiveBytes += size;
+        if (result->LiveBytes > result->PeakLiveBytes)
+            result->PeakLiveBytes = result->LiveBytes;
+    }
+    else
+    {
+        result->ModelFailures++;
+    }
+}
+
+static void TrackFree(const Allocator *allocator, ReplayResult *result, uint32_t address)
+{
+    LiveBlock *block = FindBlock(address, false);
+    if (block)
+    {
+        allocator->Free(block->Handle);
+        result->LiveBytes -= block->Size;
+        RemoveBlock(block);
+    }
+    else
+    {
+        result->UnknownFrees++;
+    }
+}
+
+static bool Replay(const Allocator *allocator, const CreatorMemTraceRecord *records, size_t count, size_t heapSize,
+        uint64_t interval, ReplayResult *result)
+{
+    memset(result, 0, sizeof(*result));
+    result->MinLargestFree = SIZE_MAX;
+    _BlockCount = 0;
+    ResizeBlocks(1024);
+    if (!allocator->Initialise(heapSize))
+        return false;
+    if (interval)
+        printf("event,time_ms,live_bytes,footprint,free_bytes,largest_free,fragmentation\n");
+
+    size_t index;
+    for (index = 0; index < count; index++)
+    {
+        const CreatorMemTraceRecord *record = &records[index];
+        switch (record->Event)
+        {
+            case CreatorMemTraceEvent_Alloc:
+                if (record->Address)
+                    TrackAlloc(allocator, result, record->Address, record->Size);
+                else
+                    result->DeviceFailures++;
+                break;
+            case CreatorMemTraceEvent_Free:
+                TrackFree(allocator, result, record->Address);
+                break;
+            case CreatorMemTraceEvent_Realloc:
+                if (!record->Address)
+                {
+                    if (record->NewAddress)
+                        TrackAlloc(allocator, result, record->NewAddress, record->Size);
+                    else
+                        result->DeviceFailures++;
+                }
+                else if (!record->NewAddress)
+                {
+                    if (record->Size == 0)
+                        TrackFree(allocator, result, record->Address);     // realloc to 0 frees
+                    else
+                        result->DeviceFailures++;
+                }
+                else
+                {
+                    LiveBlock *block = FindBlock(record->Address, false);
+                    if (block)
+                    {
+                        uint64_t handle = allocator->Realloc(block->Handle, block->Size, record->Size);
+                        if (handle)
+                        {
+                            size_t oldSize = block->Size;
+                            RemoveBlock(block);
+                            PutBlock(record->NewAddress, handle, record->Size);
+                            result->LiveBytes += record->Size - oldSize;
+                            if (result->LiveBytes > result->PeakLiveBytes)
+                                result->PeakLiveBytes = result->LiveBytes;
+                        }
+                        else
+                        {
+                            result->ModelFailures++;
+                        }
+                    }
+                    else
+                    {
+                        // resized a block allocated before the trace started, treat as new
+                        result->UnknownFrees++;
+                        TrackAlloc(allocator, result, record->NewAddress, record->Size);
+                    }
+                }
+                break;
+            case CreatorMemTraceEvent_Dropped:
+                result->DroppedRecords += record->Size;
+                break;
+            default:
+                break;
+        }
+        result->EventCount++;
+        if (interval && ((result->EventCount % interval) == 0))
+            Sample(allocator, result, true, record->Timestamp);
+        else if ((result->EventCount % 64) == 0)
+            Sample(allocator, result, false, record->Timestamp);
+    }
+    Sample(allocator, result, interval != 0, count ? records[count - 1].Timestamp : 0);
+
+    // release whatever is still live so the host allocator model does not leak between runs
+    for (index = 0; index < _BlockCapacity; index++)
+    {
+        if (_Blocks[index].Used)
+            allocator->Free(_Blocks[index].Handle);
+    }
+    allocator->Shutdown();
+    return true;
+}
+
+static void PrintSummary(FILE *stream, const char *name, const ReplayResult *result)
+{
+    fprintf(stream, "%-8s %10llu %12zu %12zu ", name, (unsigned long long)result->EventCount, result->PeakLiveBytes,
+            result->PeakFootprint);
+    if (result->MinLargestFree != SIZE_MAX)
+        fprintf(stream, "%12zu %8.1f%% ", result->MinLargestFree, result->MaxFragmentation * 100.0);
+    else
+        fprintf(stream, "%12s %9s ", "-", "-");
+    fprintf(stream, "%8llu %8llu %8llu %8llu\n", (unsigned long long)result->ModelFailures, (unsigned long long)result->DeviceFailures,
+            (unsigned long long)result->UnknownFrees, (unsigned long long)result->DroppedRecords);
+}
+
+static void Usage(const char *program)
+{
+    fprintf(stderr, "usage: %s [-a malloc|heap|pool|all] [-s heap_size] [-i sample_interval] [-x] trace_file\n", program);
+}
+
+int main(int argc, char **argv)
+{
+    const char *allocatorName = "all";
+    size_t heapSize = DEFAULT_HEAP_SIZE;
+    uint64_t interval = 0;
+    bool hex = false;
+    int option;
+    while ((option = getopt(argc, argv, "a:s:i:x")) != -1)
+    {
+        switch (option)
+        {
+            case 'a':
+                allocatorName = optarg;
+                break;
+            case 's':
+                heapSize = (size_t)strtoull(optarg, NULL, 0);
+                break;
+            case 'i':
+                interval = strtoull(optarg, NULL, 0);
+                break;
+            case 'x':
+                hex = true;
+                break;
+            default:
+                Usage(argv[0]);
+                return 1;
+        }
+    }
+    if (optind != argc - 1)
+    {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    size_t count = 0;
+    CreatorMemTraceRecord *records = LoadTrace(argv[optind], hex, &count);
+    if (!records)
+        return 1;
+    if (count == 0 || records[0].Event != CreatorMemTraceEvent_Start)
+        fprintf(stderr, "warning: trace does not begin with a start record\n");
+    else if (records[0].Size != CREATOR_MEM_TRACE_VERSION)
+        fprintf(stderr, "warning: trace format version %u, expected %u\n", records[0].Size, CREATOR_MEM_TRACE_VERSION);
+
+    bool all = (strcmp(allocatorName, "all") == 0);
+    bool found = false;
+    ReplayResult results[ALLOCATOR_COUNT];
+    size_t index;
+    for (index = 0; index < ALLOCATOR_COUNT; index++)
+    {
+        if (all || (strcmp(allocatorName, _Allocators[index].Name) == 0))
+        {
+            found = true;
+            if (!Replay(&_Allocators[index], records, count, heapSize, all ? 0 : interval, &results[index]))
+            {
+                fprintf(stderr, "%s: failed to initialise a %zu byte heap\n", _Allocators[index].Name, heapSize);
+                return 1;
+            }
+        }
+    }
+    if (!found)
+    {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    // keep stdout a clean CSV when sampling
+    FILE *summary = (!all && interval) ? stderr : stdout;
+    fprintf(summary, "\n%-8s %10s %12s %12s %12s %9s %8s %8s %8s %8s\n", "model", "events", "peak_live", "peak_foot", "min_largest",
+            "max_frag", "mfail", "dfail", "unknown", "dropped");
+    for (index = 0; index < ALLOCATOR_COUNT; index++)
+    {
+        if (all || (strcmp(allocatorName, _Allocators[index].Name) == 0))
+            PrintSummary(summary, _Allocators[index].Name, &results[index]);
+    }
+    for (index = 0; index < ALLOCATOR_COUNT; index++)
+    {
+        if ((all || (strcmp(allocatorName, _Allocators[index].Name) == 0)) && results[index].DroppedRecords)
+        {
+            fprintf(stderr, "warning: %llu records were dropped on the device, drain more often or raise "
+                    "CREATOR_MEMALLOC_TRACE_RECORDS\n", (unsigned long long)results[index].DroppedRecords);
+            break;
+        }
+    }
+    free(records);
+    free(_Blocks);
+    return 0;
+}
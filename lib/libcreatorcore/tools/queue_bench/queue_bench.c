@@ -0,0 +1,212 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+
+/*! \file queue_bench.c
+ *  \brief Measures CreatorQueue throughput under producer/consumer contention, mutex-based against lock-free.
+ *
+ * Usage: queue_bench [options]
+ *   -n <items>       items passed through the queue per run (default 1000000)
+ *   -t <threads>     largest number of producers (and of consumers); 1, 2, 4, ... up to this are run (default 8)
+ *   -c <capacity>    queue capacity, the initial size for the mutex queue (default 1024)
+ *
+ * Every item is a distinct non-NULL value and consumers add up what they receive, so a lost or duplicated item
+ * fails the run. Producers spin (yielding) while the bounded lock-free queue is full.
+ */
+
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "creator/core/creator_memalloc.h"
+#include "creator/core/creator_queue.h"
+#include "creator/core/creator_threading.h"
+#include "ext-dep/creator_threading_private.h"
+
+#define DEFAULT_ITEMS           (1000000)
+#define DEFAULT_MAX_THREADS     (8)
+#define DEFAULT_CAPACITY        (1024)
+#define DEQUEUE_WAIT_TIME       (10)
+
+typedef enum
+{
+    Variant_Mutex,
+    Variant_LockFree,
+    Variant_Max
+} Variant;
+
+static const char *_VariantNames[Variant_Max] = { "mutex", "lockfree" };
+
+typedef struct
+{
+    CreatorQueue Queue;
+    uint Items;
+    uint Producers;
+    volatile uint NextProducer;
+    volatile uint Consumed;
+    volatile uint64_t Checksum;
+    volatile uint64_t FullRetries;
+} Run;
+
+static void Consumer(CreatorThread thread, void *context);
+static double GetSeconds(void);
+static void Producer(CreatorThread thread, void *context);
+static double RunVariant(Variant variant, uint threads, uint items, uint capacity, uint64_t *fullRetries);
+
+int main(int argc, char **argv)
+{
+    uint items = DEFAULT_ITEMS;
+    uint maxThreads = DEFAULT_MAX_THREADS;
+    uint capacity = DEFAULT_CAPACITY;
+    int option;
+    while ((option = getopt(argc, argv, "n:t:c:")) != -1)
+    {
+        switch (option)
+        {
+            case 'n':
+                items = (uint)strtoul(optarg, NULL, 0);
+                break;
+            case 't':
+                maxThreads = (uint)strtoul(optarg, NULL, 0);
+                break;
+            case 'c':
+                capacity = (uint)strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-n items] [-t threads] [-c capacity]\n", argv[0]);
+                return 1;
+        }
+    }
+    if ((items == 0) || (maxThreads == 0) || (capacity == 0))
+    {
+        fprintf(stderr, "items, threads and capacity must be non-zero\n");
+        return 1;
+    }
+    CreatorThread_Initialise();
+    fprintf(stderr, "%ld CPUs online\n", sysconf(_SC_NPROCESSORS_ONLN));
+    printf("queue,producers,consumers,items,seconds,items_per_second,full_retries\n");
+    uint threads = 1;
+    while (true)
+    {
+        Variant variant;
+        for (variant = Variant_Mutex; variant < Variant_Max; variant++)
+        {
+            uint64_t fullRetries = 0;
+            double seconds = RunVariant(variant, threads, items, capacity, &fullRetries);
+            if (seconds < 0)
+                return 1;
+            printf("%s,%u,%u,%u,%.4f,%.0f,%llu\n", _VariantNames[variant], threads, threads, items, seconds,
+                    items / seconds, (unsigned long long)fullRetries);
+            fflush(stdout);
+        }
+        if (threads == maxThreads)
+            break;
+        threads = (threads * 2 < maxThreads) ? threads * 2 : maxThreads;
+    }
+    CreatorThread_Shutdown();
+    return 0;
+}
+
+static void Consumer(CreatorThread thread, void *context)
+{
+    (void)thread;
+    Run *run = (Run*)context;
+    uint64_t checksum = 0;
+    while (__atomic_load_n(&run->Consumed, __ATOMIC_ACQUIRE) < run->Items)
+    {
+        void *item = CreatorQueue_DequeueWaitFor(run->Queue, DEQUEUE_WAIT_TIME);
+        if (item)
+        {
+            checksum += (uintptr_t)item;
+            __atomic_add_fetch(&run->Consumed, 1, __ATOMIC_RELEASE);
+        }
+    }
+    __atomic_add_fetch(&run->Checksum, checksum, __ATOMIC_RELAXED);
+}
+
+static double GetSeconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void Producer(CreatorThread thread, void *context)
+{
+    (void)thread;
+    Run *run = (Run*)context;
+    uint producer = __atomic_fetch_add(&run->NextProducer, 1, __ATOMIC_RELAXED);
+    uint64_t fullRetries = 0;
+    uint index;
+    // Producer p sends p + 1, p + 1 + producers, ... so the values are distinct and never NULL
+    for (index = producer + 1; index <= run->Items; index += run->Producers)
+    {
+        while (!CreatorQueue_Enqueue(run->Queue, (void*)(uintptr_t)index))
+        {
+            fullRetries++;
+            sched_yield();
+        }
+    }
+    __atomic_add_fetch(&run->FullRetries, fullRetries, __ATOMIC_RELAXED);
+}
+
+static double RunVariant(Variant variant, uint threads, uint items, uint capacity, uint64_t *fullRetries)
+{
+    double result = -1;
+    Run run = { 0 };
+    run.Queue = (variant == Variant_LockFree) ? CreatorQueue_NewLockFree(capacity) : CreatorQueue_NewBlocking(capacity);
+    run.Items = items;
+    run.Producers = threads;
+    CreatorThread *workers = (CreatorThread*)Creator_MemAlloc(sizeof(CreatorThread) * threads * 2);
+    if (run.Queue && workers)
+    {
+        double start = GetSeconds();
+        uint index;
+        for (index = 0; index < threads * 2; index++)
+            workers[index] = CreatorThread_New("bench", 0, 0, (index < threads) ? Producer : Consumer, &run);
+        for (index = 0; index < threads * 2; index++)
+        {
+            if (workers[index])
+                CreatorThread_Join(workers[index]);
+            else
+                fprintf(stderr, "%s: could not start thread %u\n", _VariantNames[variant], index);
+        }
+        result = GetSeconds() - start;
+        for (index = 0; index < threads * 2; index++)
+            CreatorThread_Free(&workers[index]);
+
+        uint64_t expected = (uint64_t)items * (items + 1) / 2;
+        if ((run.Consumed != items) || (run.Checksum != expected))
+        {
+            fprintf(stderr, "%s: %u of %u items received, checksum %llu expected %llu\n", _VariantNames[variant],
+                    run.Consumed, items, (unsigned long long)run.Checksum, (unsigned long long)expected);
+            result = -1;
+        }
+        *fullRetries = run.FullRetries;
+    }
+    Creator_MemFree((void **)&workers);
+    CreatorQueue_Free(&run.Queue);
+    return result;
+}
@@ -0,0 +1,238 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+
+/*! \file threadpool_bench.c
+ *  \brief Measures CreatorThreadPool task throughput as the number of worker threads grows.
+ *
+ * Usage: threadpool_bench [options]
+ *   -n <tasks>       tasks per run (default 200000)
+ *   -w <iterations>  busy-work iterations per task, 0 for empty tasks (default 200)
+ *   -t <threads>     largest pool to measure; pools of 1, 2, 4, ... up to this size are run (default 8)
+ *   -b <count>       batch size used by the batch scenario (default 64)
+ *
+ * Scenarios:
+ *   single   the main thread queues every task with CreatorThreadPool_AddTask
+ *   batch    the main thread queues tasks with CreatorThreadPool_AddTasks
+ *   fanout   the main thread queues one task per worker and each of those queues its share of the tasks from inside
+ *            the pool, so the work lands on the local deques and has to be stolen to spread out
+ *
+ * Each line reports tasks per second and the speed-up over the single-thread pool for the same scenario.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "creator/core/creator_memalloc.h"
+#include "creator/core/creator_threading.h"
+#include "creator/core/creator_threadpool.h"
+#include "ext-dep/creator_threading_private.h"
+
+#define DEFAULT_TASKS           (200000)
+#define DEFAULT_WORK            (200)
+#define DEFAULT_MAX_THREADS     (8)
+#define DEFAULT_BATCH_SIZE      (64)
+#define MAX_BATCH_SIZE          (1024)
+
+typedef enum
+{
+    Scenario_Single,
+    Scenario_Batch,
+    Scenario_Fanout,
+    Scenario_Max
+} Scenario;
+
+static const char *_ScenarioNames[Scenario_Max] = { "single", "batch", "fanout" };
+
+typedef struct
+{
+    CreatorThreadPool Pool;
+    CreatorSemaphore Done;
+    volatile int Remaining;
+    volatile uint32_t Sink;
+    uint Work;
+    uint FanoutShare;           // tasks queued by each fanout task
+} Run;
+
+static void BusyTask(void *context);
+static void FanoutTask(void *context);
+static double GetSeconds(void);
+static double RunScenario(Scenario scenario, uint threads, uint tasks, uint work, uint batchSize);
+
+int main(int argc, char **argv)
+{
+    uint tasks = DEFAULT_TASKS;
+    uint work = DEFAULT_WORK;
+    uint maxThreads = DEFAULT_MAX_THREADS;
+    uint batchSize = DEFAULT_BATCH_SIZE;
+    int option;
+    while ((option = getopt(argc, argv, "n:w:t:b:")) != -1)
+    {
+        switch (option)
+        {
+            case 'n':
+                tasks = (uint)strtoul(optarg, NULL, 0);
+                break;
+            case 'w':
+                work = (uint)strtoul(optarg, NULL, 0);
+                break;
+            case 't':
+                maxThreads = (uint)strtoul(optarg, NULL, 0);
+                break;
+            case 'b':
+                batchSize = (uint)strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-n tasks] [-w iterations] [-t threads] [-b batch size]\n", argv[0]);
+                return 1;
+        }
+    }
+    if ((tasks == 0) || (maxThreads == 0) || (batchSize == 0) || (batchSize > MAX_BATCH_SIZE))
+    {
+        fprintf(stderr, "tasks and threads must be non-zero and the batch size 1..%d\n", MAX_BATCH_SIZE);
+        return 1;
+    }
+    CreatorThread_Initialise();
+    fprintf(stderr, "%ld CPUs online\n", sysconf(_SC_NPROCESSORS_ONLN));
+    printf("scenario,threads,tasks,seconds,tasks_per_second,speedup\n");
+    Scenario scenario;
+    for (scenario = Scenario_Single; scenario < Scenario_Max; scenario++)
+    {
+        double baseline = 0;
+        uint threads = 1;
+        while (true)
+        {
+            double seconds = RunScenario(scenario, threads, tasks, work, batchSize);
+            if (seconds < 0)
+            {
+                fprintf(stderr, "%s: failed with %u threads\n", _ScenarioNames[scenario], threads);
+                return 1;
+            }
+            if (threads == 1)
+                baseline = seconds;
+            printf("%s,%u,%u,%.4f,%.0f,%.2f\n", _ScenarioNames[scenario], threads, tasks, seconds, tasks / seconds,
+                    baseline / seconds);
+            fflush(stdout);
+            if (threads == maxThreads)
+                break;
+            threads = (threads * 2 < maxThreads) ? threads * 2 : maxThreads;
+        }
+    }
+    CreatorThread_Shutdown();
+    return 0;
+}
+
+static void BusyTask(void *context)
+{
+    Run *run = (Run*)context;
+    uint32_t value = (uint32_t)(uintptr_t)&value;
+    uint index;
+    for (index = 0; index < run->Work; index++)
+        value = value * 1664525u + 1013904223u;
+    run->Sink += value;
+    if (__sync_sub_and_fetch(&run->Remaining, 1) == 0)
+        CreatorSemaphore_Release(run->Done, 1);
+}
+
+static void FanoutTask(void *context)
+{
+    Run *run = (Run*)context;
+    uint index;
+    for (index = 0; index < run->FanoutShare; index++)
+    {
+        if (!CreatorThreadPool_AddTask(run->Pool, BusyTask, run))
+            BusyTask(run);
+    }
+}
+
+static double GetSeconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static double RunScenario(Scenario scenario, uint threads, uint tasks, uint work, uint batchSize)
+{
+    double result = -1;
+    Run run = { 0 };
+    run.Pool = CreatorThreadPool_New(threads, threads, 0, 0);
+    run.Done = CreatorSemaphore_New(1, 1);
+    run.Work = work;
+    if (run.Pool && run.Done)
+    {
+        // Start the workers before timing, so thread creation is not part of the first run
+        run.Remaining = 1;
+        run.Work = 0;
+        CreatorThreadPool_AddTask(run.Pool, BusyTask, &run);
+        CreatorSemaphore_Wait(run.Done, 1);
+        run.Work = work;
+
+        double start = GetSeconds();
+        if (scenario == Scenario_Fanout)
+        {
+            run.FanoutShare = (tasks + threads - 1) / threads;
+            run.Remaining = (int)(run.FanoutShare * threads);
+            uint index;
+            for (index = 0; index < threads; index++)
+            {
+                if (!CreatorThreadPool_AddTask(run.Pool, FanoutTask, &run))
+                    FanoutTask(&run);
+            }
+        }
+        else
+        {
+            run.Remaining = (int)tasks;
+            CreatorThreadPool_Callback runnables[MAX_BATCH_SIZE];
+            void *contexts[MAX_BATCH_SIZE];
+            uint index;
+            for (index = 0; index < batchSize; index++)
+            {
+                runnables[index] = BusyTask;
+                contexts[index] = &run;
+            }
+            uint pending = tasks;
+            while (pending > 0)
+            {
+                uint count = (scenario == Scenario_Batch) ? batchSize : 1;
+                if (count > pending)
+                    count = pending;
+                uint added = CreatorThreadPool_AddTasks(run.Pool, runnables, contexts, count);
+                if (added == 0)
+                {
+                    // Tasks already queued still reference run, so there is no clean way back
+                    fprintf(stderr, "%s: queuing failed with %u tasks left\n", _ScenarioNames[scenario], pending);
+                    exit(1);
+                }
+                pending -= added;
+            }
+        }
+        CreatorSemaphore_Wait(run.Done, 1);
+        result = GetSeconds() - start;
+    }
+    CreatorThreadPool_Free(&run.Pool);
+    CreatorSemaphore_Free(&run.Done);
+    return result;
+}
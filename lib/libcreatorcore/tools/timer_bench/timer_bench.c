@@ -0,0 +1,221 @@
+/***********************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************************************************************/
+
+/*! \file timer_bench.c
+ *  \brief Measures CreatorTimer dispatch jitter and throughput.
+ *
+ * Usage: timer_bench [options]
+ *   -p <ms>          period of the continuous timers in the jitter runs (default 10)
+ *   -d <ms>          length of each run (default 2000)
+ *   -m <timers>      largest number of concurrent timers; 1, 10, 100, ... up to this are run (default 1000)
+ *
+ * Jitter runs arm that many continuous timers with the same period, started back to back, and record how late each
+ * callback is against its timer's schedule (start + k * period). The throughput run re-arms one 0 ms one-shot timer
+ * from its own callback, which measures the cost of a dispatch round trip.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "creator/core/creator_memalloc.h"
+#include "creator/core/creator_timer.h"
+
+#define DEFAULT_PERIOD          (10)
+#define DEFAULT_DURATION        (2000)
+#define DEFAULT_MAX_TIMERS      (1000)
+#define NANOSECONDS_PER_MS      (1000000LL)
+
+typedef struct
+{
+    CreatorTimer Timer;
+    int64_t Start;
+    int64_t Period;
+} TimerState;
+
+typedef struct
+{
+    int64_t *Lateness;
+    uint Capacity;
+    volatile uint Count;
+    volatile bool Stop;
+} Run;
+
+static Run _Run;
+
+static int CompareLateness(const void *first, const void *second);
+static int64_t GetTime(void);
+static void JitterCallback(CreatorTimer self, void *context);
+static bool RunJitter(uint timers, uint period, uint duration);
+static bool RunThroughput(uint duration);
+static void ThroughputCallback(CreatorTimer self, void *context);
+
+int main(int argc, char **argv)
+{
+    uint period = DEFAULT_PERIOD;
+    uint duration = DEFAULT_DURATION;
+    uint maxTimers = DEFAULT_MAX_TIMERS;
+    int option;
+    while ((option = getopt(argc, argv, "p:d:m:")) != -1)
+    {
+        switch (option)
+        {
+            case 'p':
+                period = (uint)strtoul(optarg, NULL, 0);
+                break;
+            case 'd':
+                duration = (uint)strtoul(optarg, NULL, 0);
+                break;
+            case 'm':
+                maxTimers = (uint)strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-p period ms] [-d duration ms] [-m timers]\n", argv[0]);
+                return 1;
+        }
+    }
+    if ((period == 0) || (duration == 0) || (maxTimers == 0))
+    {
+        fprintf(stderr, "period, duration and timers must be non-zero\n");
+        return 1;
+    }
+    CreatorTimer_Initialise();
+    printf("timers,period_ms,callbacks,expected,mean_late_us,p50_late_us,p99_late_us,max_late_us\n");
+    uint timers = 1;
+    while (true)
+    {
+        if (!RunJitter(timers, period, duration))
+            return 1;
+        if (timers == maxTimers)
+            break;
+        timers = (timers * 10 < maxTimers) ? timers * 10 : maxTimers;
+    }
+    if (!RunThroughput(duration))
+        return 1;
+    CreatorTimer_Shutdown();
+    return 0;
+}
+
+static int CompareLateness(const void *first, const void *second)
+{
+    int64_t a = *(const int64_t*)first;
+    int64_t b = *(const int64_t*)second;
+    return (a > b) - (a < b);
+}
+
+static int64_t GetTime(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000 * NANOSECONDS_PER_MS + now.tv_nsec;
+}
+
+static void JitterCallback(CreatorTimer self, void *context)
+{
+    (void)self;
+    TimerState *state = (TimerState*)context;
+    int64_t now = GetTime();
+    // Nearest scheduled expiry, a missed period is skipped by the dispatcher rather than made up
+    int64_t periods = (now - state->Start + state->Period / 2) / state->Period;
+    if (periods < 1)
+        periods = 1;
+    uint index = __atomic_fetch_add(&_Run.Count, 1, __ATOMIC_RELAXED);
+    if (index < _Run.Capacity)
+        _Run.Lateness[index] = now - (state->Start + periods * state->Period);
+}
+
+static bool RunJitter(uint timers, uint period, uint duration)
+{
+    bool result = false;
+    TimerState *states = (TimerState*)Creator_MemAlloc(sizeof(TimerState) * timers);
+    _Run.Capacity = timers * (duration / period + 2);
+    _Run.Lateness = (int64_t*)Creator_MemAlloc(sizeof(int64_t) * _Run.Capacity);
+    _Run.Count = 0;
+    if (states && _Run.Lateness)
+    {
+        uint index;
+        for (index = 0; index < timers; index++)
+        {
+            states[index].Period = period * NANOSECONDS_PER_MS;
+            states[index].Timer = CreatorTimer_New("bench", period, true, JitterCallback, &states[index]);
+            states[index].Start = GetTime();
+            if (!states[index].Timer || !CreatorTimer_Start(states[index].Timer))
+            {
+                fprintf(stderr, "could not start timer %u\n", index);
+                break;
+            }
+        }
+        if (index == timers)
+        {
+            usleep(duration * 1000);
+            result = true;
+        }
+        for (index = 0; index < timers; index++)
+            CreatorTimer_Free(&states[index].Timer);
+
+        uint count = (_Run.Count < _Run.Capacity) ? _Run.Count : _Run.Capacity;
+        if (result && (count > 0))
+        {
+            int64_t total = 0;
+            for (index = 0; index < count; index++)
+                total += _Run.Lateness[index];
+            qsort(_Run.Lateness, count, sizeof(int64_t), CompareLateness);
+            printf("%u,%u,%u,%u,%.1f,%.1f,%.1f,%.1f\n", timers, period, _Run.Count, timers * (duration / period),
+                    total / 1000.0 / count, _Run.Lateness[count / 2] / 1000.0, _Run.Lateness[(count * 99) / 100] / 1000.0,
+                    _Run.Lateness[count - 1] / 1000.0);
+            fflush(stdout);
+        }
+    }
+    Creator_MemFree((void **)&_Run.Lateness);
+    Creator_MemFree((void **)&states);
+    return result;
+}
+
+static bool RunThroughput(uint duration)
+{
+    bool result = false;
+    _Run.Count = 0;
+    _Run.Stop = false;
+    CreatorTimer timer = CreatorTimer_New("bench", 0, false, ThroughputCallback, NULL);
+    int64_t start = GetTime();
+    if (timer && CreatorTimer_Start(timer))
+    {
+        usleep(duration * 1000);
+        _Run.Stop = true;
+        double seconds = (GetTime() - start) / 1e9;
+        printf("one-shot re-arm: %u callbacks in %.3f s, %.0f per second\n", _Run.Count, seconds, _Run.Count / seconds);
+        result = true;
+    }
+    CreatorTimer_Free(&timer);
+    return result;
+}
+
+static void ThroughputCallback(CreatorTimer self, void *context)
+{
+    (void)context;
+    _Run.Count++;
+    if (!_Run.Stop)
+        CreatorTimer_Start(self);
+}